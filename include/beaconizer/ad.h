@@ -0,0 +1,94 @@
+/*!
+ *	\file		ad.h
+ *	\brief		Advertising data iterator and decoder registry
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_AD_H__
+#define __BEACONIZER_AD_H__
+
+/* AD types */
+#define AD_TYPE_FLAGS               0x01
+#define AD_TYPE_UUID16_SOME         0x02
+#define AD_TYPE_UUID16_ALL          0x03
+#define AD_TYPE_SHORT_NAME          0x08
+#define AD_TYPE_COMPLETE_NAME       0x09
+#define AD_TYPE_TX_POWER            0x0a
+#define AD_TYPE_SERVICE_DATA16      0x16
+#define AD_TYPE_MANUFACTURER        0xff
+
+/* AD field. For fields registered by ID, data starts after the ID */
+typedef struct {
+    uint8_t         type;                   /* AD type */
+    uint16_t        id;                     /* Company or service UUID, 0 when not keyed */
+    const uint8_t  *data;                   /* Field data, points into report */
+    uint8_t         length;                 /* Data length */
+} ad_field_t;
+
+/* Iterator over AD structures */
+typedef struct {
+    const uint8_t  *p;                      /* Next structure */
+    const uint8_t  *end;                    /* End of data */
+} ad_iterator_t;
+
+/* Decoder, returns positive class when field is recognized, 0 otherwise */
+typedef int (*ad_decoder_fn_t) (
+    const ad_field_t   *field,
+    void               *user_data,
+    void               *context);
+
+/* Forward declaration */
+struct ad_registry;
+
+/* Start iteration over advertising data */
+void ad_iterator_init(
+    ad_iterator_t      *it,                 /* Iterator */
+    const uint8_t      *data,               /* Advertising data */
+    const uint16_t      length);            /* Data length */
+
+/* Next AD structure: 1 when field is returned, 0 at the end, negative errno
+ * when data is malformed */
+int ad_iterator_next(
+    ad_iterator_t      *it,                 /* Iterator */
+    ad_field_t         *field);             /* Field */
+
+/* Create empty registry */
+struct ad_registry *ad_registry_new(void);
+
+/* Destroy registry */
+void ad_registry_free(
+    struct ad_registry *registry);          /* Registry */
+
+/* Register decoder for every field of given type not claimed by ID */
+int ad_registry_add(
+    struct ad_registry *registry,           /* Registry */
+    const uint8_t       type,               /* AD type */
+    ad_decoder_fn_t     decoder,            /* Decoder */
+    void               *user_data);         /* User data */
+
+/* Register decoder for manufacturer data company ID or 16-bit service data UUID */
+int ad_registry_add_id(
+    struct ad_registry *registry,           /* Registry */
+    const uint8_t       type,               /* AD_TYPE_MANUFACTURER or AD_TYPE_SERVICE_DATA16 */
+    const uint16_t      id,                 /* Company ID or service UUID */
+    ad_decoder_fn_t     decoder,            /* Decoder */
+    void               *user_data);         /* User data */
+
+/* Classify advertising data in one pass: first positive decoder result,
+ * 0 when nothing matched, negative errno on malformed data */
+int ad_registry_classify(
+    struct ad_registry *registry,           /* Registry */
+    const uint8_t      *data,               /* Advertising data */
+    const uint16_t      length,             /* Data length */
+    void               *context);           /* Passed to decoders */
+
+#endif /* __BEACONIZER_AD_H__ */
+
+/* End of file */
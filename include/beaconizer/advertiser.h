@@ -0,0 +1,83 @@
+/*!
+ *	\file		advertiser.h
+ *	\brief		LE advertising engine on top of HCI channel
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+
+#include <beaconizer/config.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_ADVERTISER_H__
+#define __BEACONIZER_ADVERTISER_H__
+
+/* Advertising data limit for legacy advertising */
+#define ADVERTISER_MAX_DATA         31
+
+/* Advertising types */
+#define ADVERTISER_ADV_IND          0x00
+#define ADVERTISER_ADV_DIRECT_IND   0x01
+#define ADVERTISER_ADV_SCAN_IND     0x02
+#define ADVERTISER_ADV_NONCONN_IND  0x03
+
+/* Forward declarations */
+struct advertiser;
+struct hci_channel;
+
+/* Start/stop completion: status is HCI status or negative errno */
+typedef void (*advertiser_fn_t) (
+    struct advertiser  *adv,
+    int                 status,
+    void               *user_data);
+
+/* Create advertiser on HCI channel */
+struct advertiser *advertiser_new(
+    struct hci_channel *hci);               /* HCI channel */
+
+/* Destroy advertiser. Controller state is left as is, commands in flight
+ * complete silently */
+void advertiser_free(
+    struct advertiser  *adv);               /* Advertiser */
+
+/* Set advertising interval in milliseconds */
+int advertiser_set_interval(
+    struct advertiser  *adv,                /* Advertiser */
+    const uint32_t      min_ms,             /* Minimal interval */
+    const uint32_t      max_ms);            /* Maximal interval */
+
+/* Set advertising type */
+int advertiser_set_type(
+    struct advertiser  *adv,                /* Advertiser */
+    const uint8_t       type);              /* ADVERTISER_ADV_* */
+
+/* Set advertising data, nothing is sent when data is unchanged */
+int advertiser_set_data(
+    struct advertiser  *adv,                /* Advertiser */
+    const uint8_t      *data,               /* AD structures */
+    const uint8_t       length);            /* Data length */
+
+/* Push pending changes and enable advertising. Callback runs once controller
+ * state settles or a command fails */
+int advertiser_start(
+    struct advertiser  *adv,                /* Advertiser */
+    advertiser_fn_t     callback,           /* Completion callback */
+    void               *user_data);         /* User data */
+
+/* Disable advertising */
+int advertiser_stop(
+    struct advertiser  *adv,                /* Advertiser */
+    advertiser_fn_t     callback,           /* Completion callback */
+    void               *user_data);         /* User data */
+
+/* Advertising is enabled on controller */
+int advertiser_is_enabled(
+    struct advertiser  *adv);               /* Advertiser */
+
+#endif /* __BEACONIZER_ADVERTISER_H__ */
+
+/* End of file */
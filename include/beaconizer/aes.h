@@ -0,0 +1,53 @@
+/*!
+ *	\file		aes.h
+ *	\brief		AES-128 block encryption with cached key schedules
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_AES_H__
+#define __BEACONIZER_AES_H__
+
+/* Sizes */
+#define AES128_KEY_SIZE             16
+#define AES128_BLOCK_SIZE           16
+#define AES128_ROUNDS               10
+
+/* Expanded key, same layout for software and AES-NI paths */
+typedef struct {
+    uint8_t         round_key[AES128_ROUNDS + 1][AES128_BLOCK_SIZE];    /* Round keys */
+} aes128_key_t;
+
+/* Expand key once, reuse schedule for every block */
+void aes128_expand(
+    aes128_key_t       *schedule,                   /* Key schedule */
+    const uint8_t       key[AES128_KEY_SIZE]);      /* Cipher key */
+
+/* Encrypt single block, in and out may overlap */
+void aes128_encrypt(
+    const aes128_key_t *schedule,                   /* Key schedule */
+    const uint8_t       in[AES128_BLOCK_SIZE],      /* Plain text */
+    uint8_t             out[AES128_BLOCK_SIZE]);    /* Cipher text */
+
+/* Encrypt independent blocks, each with own key. Blocks are interleaved
+ * when AES-NI is in use */
+void aes128_encrypt_batch(
+    const aes128_key_t *const   schedule[],                 /* Key schedule per block */
+    const uint8_t               in[][AES128_BLOCK_SIZE],    /* Plain text */
+    uint8_t                     out[][AES128_BLOCK_SIZE],   /* Cipher text */
+    const size_t                count);                     /* Number of blocks */
+
+/* Enable or disable AES-NI, returns 1 when hardware path is in use */
+int aes128_use_hardware(
+    const int           enable);                    /* 0 forces software path */
+
+#endif /* __BEACONIZER_AES_H__ */
+
+/* End of file */
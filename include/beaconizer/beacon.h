@@ -0,0 +1,67 @@
+/*!
+ *	\file		beacon.h
+ *	\brief		Beacon advertising payload builders
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_BEACON_H__
+#define __BEACONIZER_BEACON_H__
+
+/* Beacon classes reported by decoders */
+#define BEACON_IBEACON              1
+#define BEACON_EDDYSTONE            2
+#define BEACON_ALTBEACON            3
+
+/* Identifiers */
+#define BEACON_COMPANY_APPLE        0x004c
+#define BEACON_SERVICE_EDDYSTONE    0xfeaa
+#define BEACON_ALTBEACON_CODE       0xbeac
+
+/* iBeacon advertising data length */
+#define IBEACON_PAYLOAD_SIZE        30
+
+/* Forward declaration */
+struct ad_registry;
+
+/* iBeacon payload cache, serialized only when a field changes */
+typedef struct {
+    uint8_t     uuid[16];                       /* Proximity UUID */
+    uint16_t    major;                          /* Major */
+    uint16_t    minor;                          /* Minor */
+    int8_t      power;                          /* Measured power at 1 m, dBm */
+    uint8_t     dirty;                          /* Data must be rebuilt */
+    uint8_t     data[IBEACON_PAYLOAD_SIZE];     /* AD structures */
+} ibeacon_payload_t;
+
+/* Reset cache */
+void ibeacon_payload_init(
+    ibeacon_payload_t  *payload);           /* Payload cache */
+
+/* Update fields, returns 1 when anything changed */
+int ibeacon_payload_update(
+    ibeacon_payload_t  *payload,            /* Payload cache */
+    const uint8_t       uuid[16],           /* Proximity UUID */
+    const uint16_t      major,              /* Major */
+    const uint16_t      minor,              /* Minor */
+    const int8_t        power);             /* Measured power */
+
+/* Serialized payload, rebuilt if dirty */
+const uint8_t *ibeacon_payload_data(
+    ibeacon_payload_t  *payload,            /* Payload cache */
+    uint8_t            *length);            /* Data length */
+
+/* Register iBeacon, Eddystone and AltBeacon decoders, classification
+ * returns BEACON_* */
+int beacon_register_decoders(
+    struct ad_registry *registry);          /* Registry */
+
+#endif /* __BEACONIZER_BEACON_H__ */
+
+/* End of file */
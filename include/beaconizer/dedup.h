@@ -0,0 +1,75 @@
+/*!
+ *	\file		dedup.h
+ *	\brief		Advertising report duplicate suppression
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "beaconizer/scanner.h"
+
+#pragma once
+
+#ifndef __BEACONIZER_DEDUP_H__
+#define __BEACONIZER_DEDUP_H__
+
+/* Defaults */
+#define DEDUP_DEFAULT_CAPACITY      4096    /* Tracked beacons */
+#define DEDUP_DEFAULT_WINDOW        1000    /* One update per second, ms */
+
+/* Counters */
+typedef struct {
+    uint64_t        passed;                 /* Reports delivered */
+    uint64_t        suppressed;             /* Reports dropped as duplicates */
+    uint64_t        evicted;                /* Live entries replaced when table was crowded */
+} dedup_stats_t;
+
+/* Forward declaration */
+struct dedup;
+
+/* Create cache, all memory is allocated here */
+struct dedup *dedup_new(
+    const size_t        capacity,           /* Tracked beacons, DEDUP_DEFAULT_CAPACITY if 0 */
+    const uint32_t      window);            /* Window, ms, 0 passes every report */
+
+/* Destroy cache */
+void dedup_free(
+    struct dedup       *dedup);             /* Cache */
+
+/* Change window, entries are kept */
+void dedup_set_window(
+    struct dedup       *dedup,              /* Cache */
+    const uint32_t      window);            /* Window, ms */
+
+/* Feed report, returns 1 when it should be delivered, 0 when it repeats an
+ * update of the same address and payload within the window */
+int dedup_check(
+    struct dedup       *dedup,              /* Cache */
+    const uint8_t       address_type,       /* Public or random */
+    const uint8_t      *address,            /* 6 bytes, little endian */
+    const uint8_t      *data,               /* AD structures */
+    const uint16_t      length,             /* Data length */
+    const uint64_t      now);               /* Time, ms */
+
+/* Feed scanner report */
+int dedup_check_report(
+    struct dedup               *dedup,      /* Cache */
+    const scanner_report_t     *report,     /* Report */
+    const uint64_t              now);       /* Time, ms */
+
+/* Forget every beacon */
+void dedup_clear(
+    struct dedup       *dedup);             /* Cache */
+
+/* Get counters */
+int dedup_get_stats(
+    const struct dedup *dedup,              /* Cache */
+    dedup_stats_t      *stats);             /* Counters */
+
+#endif /* __BEACONIZER_DEDUP_H__ */
+
+/* End of file */
@@ -0,0 +1,112 @@
+/*!
+ *	\file		eddystone.h
+ *	\brief		Eddystone frame builder and rotation
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_EDDYSTONE_H__
+#define __BEACONIZER_EDDYSTONE_H__
+
+/* Frame types */
+#define EDDYSTONE_UID               0x00
+#define EDDYSTONE_URL               0x10
+#define EDDYSTONE_TLM               0x20
+#define EDDYSTONE_EID               0x30
+
+/* Frame slots in rotation order */
+#define EDDYSTONE_SLOT_UID          0
+#define EDDYSTONE_SLOT_URL          1
+#define EDDYSTONE_SLOT_TLM          2
+#define EDDYSTONE_SLOT_EID          3
+#define EDDYSTONE_SLOTS             4
+
+/* Sizes */
+#define EDDYSTONE_PDU_MAX           31
+#define EDDYSTONE_NAMESPACE_SIZE    10
+#define EDDYSTONE_INSTANCE_SIZE     6
+#define EDDYSTONE_EID_SIZE          8
+#define EDDYSTONE_URL_MAX           17
+
+/* Complete advertising data of one frame */
+typedef struct {
+    uint8_t         data[EDDYSTONE_PDU_MAX];    /* Flags, service list, service data */
+    uint8_t         length;                     /* Data length, 0 when slot is off */
+} eddystone_pdu_t;
+
+/* Eddystone beacon: precomputed frames rotated in place */
+typedef struct {
+    eddystone_pdu_t pdu[EDDYSTONE_SLOTS];   /* Frames */
+    uint8_t         current;                /* Last slot returned */
+    uint32_t        adv_count;              /* TLM advertising PDU count */
+    uint32_t        uptime;                 /* TLM time since power up, 0.1 s */
+} eddystone_t;
+
+/* Reset beacon, every frame is off */
+void eddystone_init(
+    eddystone_t        *beacon);            /* Beacon */
+
+/* UID frame, returns 1 when frame changed */
+int eddystone_set_uid(
+    eddystone_t        *beacon,                             /* Beacon */
+    const int8_t        tx_power,                           /* Ranging data: TX power at 0 m */
+    const uint8_t       ns[EDDYSTONE_NAMESPACE_SIZE],       /* Namespace */
+    const uint8_t       instance[EDDYSTONE_INSTANCE_SIZE]); /* Instance */
+
+/* URL frame, returns 1 when frame changed or negative errno when URL
+ * cannot be encoded */
+int eddystone_set_url(
+    eddystone_t        *beacon,             /* Beacon */
+    const int8_t        tx_power,           /* Ranging data */
+    const char         *url);               /* URL */
+
+/* Unencrypted TLM frame, counters keep running. Returns 1 when frame changed */
+int eddystone_set_tlm(
+    eddystone_t        *beacon,             /* Beacon */
+    const uint16_t      battery_mv,         /* Battery voltage, mV, 0 if unknown */
+    const int16_t       temperature);       /* Temperature, 8.8 fixed point, 0x8000 if unknown */
+
+/* Advance TLM counters, patched in place */
+void eddystone_tlm_tick(
+    eddystone_t        *beacon,             /* Beacon */
+    const uint32_t      adv_count,          /* Advertising PDUs sent since last tick */
+    const uint32_t      uptime);            /* Time since last tick, 0.1 s */
+
+/* EID frame, returns 1 when frame changed */
+int eddystone_set_eid(
+    eddystone_t        *beacon,                     /* Beacon */
+    const int8_t        tx_power,                   /* Ranging data */
+    const uint8_t       eid[EDDYSTONE_EID_SIZE]);   /* Ephemeral ID */
+
+/* Turn frame slot off */
+void eddystone_clear(
+    eddystone_t        *beacon,             /* Beacon */
+    const uint8_t       slot);              /* EDDYSTONE_SLOT_* */
+
+/* Next enabled frame in rotation, NULL when every slot is off */
+const uint8_t *eddystone_next(
+    eddystone_t        *beacon,             /* Beacon */
+    uint8_t            *length);            /* Data length */
+
+/* Encode URL, returns encoded length or negative errno */
+int eddystone_url_encode(
+    const char         *url,                /* URL */
+    uint8_t            *out);               /* Scheme byte plus up to EDDYSTONE_URL_MAX bytes */
+
+/* Decode URL, returns string length or negative errno */
+int eddystone_url_decode(
+    const uint8_t      *data,               /* Scheme byte and encoded URL */
+    const uint8_t       length,             /* Data length */
+    char               *out,                /* Output */
+    const size_t        size);              /* Output size */
+
+#endif /* __BEACONIZER_EDDYSTONE_H__ */
+
+/* End of file */
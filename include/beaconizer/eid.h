@@ -0,0 +1,69 @@
+/*!
+ *	\file		eid.h
+ *	\brief		Eddystone-EID generation and resolution
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_EID_H__
+#define __BEACONIZER_EID_H__
+
+/* Sizes */
+#define EID_KEY_SIZE                16
+#define EID_SIZE                    8
+
+/* Rotation period is 2^exponent seconds */
+#define EID_EXPONENT_MAX            15
+
+/* Forward declaration */
+struct eid_engine;
+
+/* Compute EID of beacon time counter */
+int eid_compute(
+    const uint8_t       ik[EID_KEY_SIZE],   /* Identity key */
+    const uint8_t       exponent,           /* Rotation period exponent */
+    const uint32_t      counter,            /* Beacon time counter, s */
+    uint8_t             eid[EID_SIZE]);     /* Ephemeral ID */
+
+/* Create empty resolver */
+struct eid_engine *eid_engine_new(void);
+
+/* Destroy resolver */
+void eid_engine_free(
+    struct eid_engine  *engine);            /* Resolver */
+
+/* Register beacon, returns beacon ID or negative errno. EIDs are computed by
+ * the next eid_engine_update() */
+int eid_engine_add(
+    struct eid_engine  *engine,             /* Resolver */
+    const uint8_t       ik[EID_KEY_SIZE],   /* Identity key */
+    const uint8_t       exponent,           /* Rotation period exponent */
+    const uint32_t      clock,              /* Beacon time counter at resolver time 0 */
+    void               *user_data);         /* User data */
+
+/* Move resolver to time now, EIDs of previous, current and next period of
+ * every beacon are indexed. Returns number of EIDs computed */
+int eid_engine_update(
+    struct eid_engine  *engine,             /* Resolver */
+    const uint32_t      now);               /* Resolver time, s */
+
+/* Resolve EID, returns beacon ID or -ENOENT */
+int eid_engine_lookup(
+    const struct eid_engine    *engine,     /* Resolver */
+    const uint8_t               eid[EID_SIZE],  /* Ephemeral ID */
+    void                      **user_data); /* User data, may be NULL */
+
+/* Number of registered beacons */
+size_t eid_engine_count(
+    const struct eid_engine    *engine);    /* Resolver */
+
+#endif /* __BEACONIZER_EID_H__ */
+
+/* End of file */
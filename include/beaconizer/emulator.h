@@ -0,0 +1,98 @@
+/*!
+ *	\file		emulator.h
+ *	\brief		HCI controller emulator for hardware-free testing
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_EMULATOR_H__
+#define __BEACONIZER_EMULATOR_H__
+
+/* Identity reported by Read Local Version */
+#define EMULATOR_HCI_VERSION        0x09    /* Core 5.0 */
+#define EMULATOR_MANUFACTURER       0x05f1  /* Linux Foundation */
+
+/* Limits */
+#define EMULATOR_MAX_PER_EVENT      6       /* 30 octet reports fitting one event */
+#define EMULATOR_MAX_PENDING        256     /* Commands in flight */
+#define EMULATOR_MAX_SETS           16      /* Extended advertising sets */
+
+/* Defaults */
+#define EMULATOR_DEFAULT_CREDITS    1       /* Num_HCI_Command_Packets */
+#define EMULATOR_DEFAULT_DEVICES    1000    /* Distinct advertisers */
+
+/* Emulator set up */
+typedef struct {
+    uint8_t         credits;                /* Commands controller buffers */
+    uint32_t        latency;                /* Command completion delay, us */
+    uint32_t        rate;                   /* Reports per second, 0 as fast as host reads */
+    uint8_t         per_event;              /* Reports per LE Advertising Report event */
+    uint32_t        devices;                /* Distinct iBeacons advertising */
+    uint8_t         sets;                   /* Extended advertising sets, 0 for legacy only controller */
+} emulator_config_t;
+
+/* Counters */
+typedef struct {
+    uint64_t        commands;               /* Commands received */
+    uint64_t        overruns;               /* Commands sent without credit */
+    uint64_t        unknown;                /* Commands answered as unknown */
+    uint64_t        events;                 /* Advertising report events sent */
+    uint64_t        reports;                /* Advertising reports sent */
+    uint64_t        stalls;                 /* Waits for host to drain socket */
+    uint64_t        adv_data;               /* Advertising data updates, legacy and extended */
+} emulator_stats_t;
+
+/* Forward declarations */
+struct emulator;
+struct loop;
+
+/* Fill config with defaults */
+void emulator_config_init(
+    emulator_config_t      *config);        /* Config */
+
+/* Create controller on a socket pair. Commands tools send are answered,
+ * everything else completes with Unknown HCI Command */
+struct emulator *emulator_new_in(
+    struct loop                *loop,       /* Loop */
+    const emulator_config_t    *config);    /* Config */
+
+/* Create controller in default loop */
+struct emulator *emulator_new(
+    const emulator_config_t    *config);    /* Config */
+
+/* Close both socket ends. HCI channel on the host end must go first */
+void emulator_free(
+    struct emulator    *emulator);          /* Controller */
+
+/* Host end of socket pair, works as HCI socket. Owned by emulator */
+int emulator_get_descriptor(
+    struct emulator    *emulator);          /* Controller */
+
+/* Start or stop reports as LE Set Scan Enable does */
+int emulator_set_scanning(
+    struct emulator    *emulator,           /* Controller */
+    const int           enable);            /* Scan enable */
+
+/* Scanning is enabled */
+int emulator_is_scanning(
+    struct emulator    *emulator);          /* Controller */
+
+/* Advertising is enabled, legacy or on any extended set */
+int emulator_is_advertising(
+    struct emulator    *emulator);          /* Controller */
+
+/* Get counters */
+int emulator_get_stats(
+    struct emulator    *emulator,           /* Controller */
+    emulator_stats_t   *stats);             /* Counters */
+
+#endif /* __BEACONIZER_EMULATOR_H__ */
+
+/* End of file */
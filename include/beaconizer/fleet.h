@@ -0,0 +1,114 @@
+/*!
+ *	\file		fleet.h
+ *	\brief		Virtual beacon fleet, many identities time-sliced on one controller
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "beaconizer/config.h"
+
+#pragma once
+
+#ifndef __BEACONIZER_FLEET_H__
+#define __BEACONIZER_FLEET_H__
+
+/* Limits */
+#define FLEET_MAX_DATA              31      /* Legacy advertising PDU payload */
+#define FLEET_MAX_SETS              16      /* Extended advertising sets used at once */
+
+/* Defaults */
+#define FLEET_DEFAULT_SLOT          100     /* Time identity stays on air, ms */
+#define FLEET_DEFAULT_INTERVAL      20      /* Advertising interval, ms */
+
+/* Fleet set up */
+typedef struct {
+    uint32_t        slot;                   /* Time identity stays on air, ms */
+    uint32_t        interval;               /* Advertising interval, ms, cut to slot */
+    uint8_t         sets;                   /* Extended advertising sets wanted, 0 keeps legacy advertising */
+} fleet_config_t;
+
+/* Counters */
+typedef struct {
+    uint8_t         sets;                   /* Sets rotating, 0 for legacy advertising */
+    uint64_t        rotations;              /* Identity switches completed */
+    uint64_t        overruns;               /* Switches skipped, previous one still in flight */
+    uint64_t        failures;               /* Switches controller rejected */
+    uint64_t        elapsed;                /* Time rotating, us */
+    uint64_t        lateness;               /* Mean switch completion after slot start, us */
+    uint64_t        lateness_max;           /* Worst switch completion after slot start, us */
+    uint64_t        jitter;                 /* Standard deviation of lateness, us */
+} fleet_stats_t;
+
+/* Forward declarations */
+struct fleet;
+struct hci_channel;
+struct loop;
+
+/* Start/stop completion: status is HCI status or negative errno */
+typedef void (*fleet_fn_t) (
+    struct fleet       *fleet,
+    int                 status,
+    void               *user_data);
+
+/* Fill config with defaults */
+void fleet_config_init(
+    fleet_config_t     *config);            /* Config */
+
+/* Create fleet on HCI channel, slot timer runs in loop */
+struct fleet *fleet_new_in(
+    struct loop            *loop,           /* Loop */
+    struct hci_channel     *hci,            /* HCI channel */
+    const fleet_config_t   *config);        /* Config */
+
+/* Create fleet in default loop */
+struct fleet *fleet_new(
+    struct hci_channel     *hci,            /* HCI channel */
+    const fleet_config_t   *config);        /* Config */
+
+/* Destroy fleet. Controller state is left as is, commands in flight
+ * complete silently */
+void fleet_free(
+    struct fleet       *fleet);             /* Fleet */
+
+/* Add identity, returns its index or negative errno. Not allowed while
+ * rotating */
+int fleet_add(
+    struct fleet       *fleet,              /* Fleet */
+    const uint8_t      *data,               /* AD structures */
+    const uint8_t       length);            /* Data length */
+
+/* Identities added */
+size_t fleet_count(
+    struct fleet       *fleet);             /* Fleet */
+
+/* Pick legacy or extended advertising, build command of every identity and
+ * start rotating. Callback runs once advertising is enabled or set up fails */
+int fleet_start(
+    struct fleet       *fleet,              /* Fleet */
+    fleet_fn_t          callback,           /* Completion callback */
+    void               *user_data);         /* User data */
+
+/* Stop rotating and disable advertising. Stop while starting replaces start
+ * callback and waits for set up to settle, -EBUSY while stop is in flight */
+int fleet_stop(
+    struct fleet       *fleet,              /* Fleet */
+    fleet_fn_t          callback,           /* Completion callback */
+    void               *user_data);         /* User data */
+
+/* Identities are being rotated */
+int fleet_is_running(
+    struct fleet       *fleet);             /* Fleet */
+
+/* Get counters */
+int fleet_get_stats(
+    struct fleet       *fleet,              /* Fleet */
+    fleet_stats_t      *stats);             /* Counters */
+
+#endif /* __BEACONIZER_FLEET_H__ */
+
+/* End of file */
@@ -0,0 +1,116 @@
+/*!
+ *	\file		gateway.h
+ *	\brief		Multi-adapter scanning, one loop thread per controller
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_GATEWAY_H__
+#define __BEACONIZER_GATEWAY_H__
+
+/* Limits */
+#define GATEWAY_MAX_ADAPTERS        16      /* Kernel HCI_MAX_DEV */
+#define GATEWAY_MAX_DATA            31      /* Legacy advertising data */
+
+/* Defaults */
+#define GATEWAY_DEFAULT_QUEUE       4096    /* Reports queued per adapter */
+#define GATEWAY_DEFAULT_TIMEOUT     1000    /* HCI command deadline, ms */
+#define GATEWAY_CPU_ANY             -1      /* Thread is not pinned */
+
+/* Adapter */
+typedef struct {
+    int             index;                  /* HCI device index, -1 to use descriptor */
+    int             fd;                     /* Open HCI socket when index is -1, not closed */
+    int             cpu;                    /* CPU to pin adapter thread to */
+} gateway_adapter_t;
+
+/* Gateway set up */
+typedef struct {
+    uint32_t        queue;                  /* Reports queued per adapter, rounded up to power of two */
+    uint32_t        timeout;                /* HCI command deadline, ms */
+    uint8_t         type;                   /* SCANNER_PASSIVE or SCANNER_ACTIVE */
+    uint32_t        interval;               /* Scan interval, ms */
+    uint32_t        window;                 /* Scan window, ms */
+} gateway_config_t;
+
+/* Report copied out of adapter thread */
+typedef struct {
+    uint8_t         adapter;                /* Position in adapter list */
+    uint8_t         event_type;             /* ADV_IND, ADV_NONCONN_IND, ... */
+    uint8_t         address_type;           /* Public or random */
+    int8_t          rssi;                   /* RSSI, dBm */
+    uint8_t         address[6];             /* Little endian */
+    uint8_t         length;                 /* Data length */
+    uint8_t         data[GATEWAY_MAX_DATA]; /* AD structures */
+    uint8_t         reserved[6];            /* Pads report to 48 bytes */
+} gateway_report_t;
+
+/* Adapter counters */
+typedef struct {
+    int             status;                 /* 0 scanning, HCI status or negative errno */
+    uint8_t         hci_version;            /* Read Local Version result */
+    uint64_t        reports;                /* Reports queued downstream */
+    uint64_t        drops;                  /* Reports dropped on full queue */
+    uint64_t        oversize;               /* Reports dropped, data exceeds GATEWAY_MAX_DATA */
+} gateway_stats_t;
+
+/* Report callback, runs in gateway loop */
+typedef void (*gateway_fn_t) (
+    const gateway_report_t *report,
+    void                   *user_data);
+
+/* Forward declarations */
+struct gateway;
+struct loop;
+
+/* Fill config with defaults */
+void gateway_config_init(
+    gateway_config_t       *config);        /* Config */
+
+/* List HCI devices which are up with one request, returns count or negative errno */
+int gateway_probe(
+    int                    *index,          /* Device indexes */
+    const size_t            max);           /* Array size */
+
+/* Start one scanning thread per adapter. Adapters are opened and probed in
+ * parallel, reports are delivered in loop thread */
+struct gateway *gateway_new_in(
+    struct loop                *loop,       /* Loop */
+    const gateway_config_t     *config,     /* Config */
+    const gateway_adapter_t    *adapter,    /* Adapters */
+    const size_t                count,      /* Adapter count */
+    gateway_fn_t                callback,   /* Report callback */
+    void                       *user_data); /* User data */
+
+/* Start gateway in default loop */
+struct gateway *gateway_new(
+    const gateway_config_t     *config,     /* Config */
+    const gateway_adapter_t    *adapter,    /* Adapters */
+    const size_t                count,      /* Adapter count */
+    gateway_fn_t                callback,   /* Report callback */
+    void                       *user_data); /* User data */
+
+/* Stop scanning and join adapter threads. Reports still queued are dropped */
+void gateway_free(
+    struct gateway     *gateway);           /* Gateway */
+
+/* Adapters whose start up settled */
+size_t gateway_ready(
+    struct gateway     *gateway);           /* Gateway */
+
+/* Get adapter counters */
+int gateway_get_stats(
+    struct gateway     *gateway,            /* Gateway */
+    const size_t        adapter,            /* Position in adapter list */
+    gateway_stats_t    *stats);             /* Counters */
+
+#endif /* __BEACONIZER_GATEWAY_H__ */
+
+/* End of file */
@@ -0,0 +1,173 @@
+/*!
+ *	\file		hci.h
+ *	\brief		Asynchronous HCI command channel on top of the loop
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+
+#include <beaconizer/config.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_HCI_H__
+#define __BEACONIZER_HCI_H__
+
+/* Packet types */
+#define BT_HCI_COMMAND_PKT                  0x01
+#define BT_HCI_EVENT_PKT                    0x04
+
+/* Sizes */
+#define BT_HCI_COMMAND_HDR_SIZE             3
+#define BT_HCI_EVENT_HDR_SIZE               2
+#define BT_HCI_MAX_PARAM_SIZE               255
+#define BT_HCI_MAX_PACKET_SIZE              (1 + BT_HCI_COMMAND_HDR_SIZE + BT_HCI_MAX_PARAM_SIZE)
+
+/* Events */
+#define BT_HCI_EVT_CMD_COMPLETE             0x0e
+#define BT_HCI_EVT_CMD_STATUS               0x0f
+#define BT_HCI_EVT_LE_META                  0x3e
+
+/* LE Meta subevents */
+#define BT_HCI_EVT_LE_ADV_REPORT            0x02
+#define BT_HCI_EVT_LE_EXT_ADV_REPORT        0x0d
+
+/* Commands */
+#define BT_HCI_CMD_NOP                      0x0000
+#define BT_HCI_CMD_RESET                    0x0c03
+#define BT_HCI_CMD_READ_LOCAL_VERSION       0x1001
+#define BT_HCI_CMD_LE_READ_LOCAL_FEATURES   0x2003
+#define BT_HCI_CMD_LE_SET_ADV_PARAMETERS    0x2006
+#define BT_HCI_CMD_LE_SET_ADV_DATA          0x2008
+#define BT_HCI_CMD_LE_SET_ADV_ENABLE        0x200a
+#define BT_HCI_CMD_LE_SET_SCAN_PARAMETERS   0x200b
+#define BT_HCI_CMD_LE_SET_SCAN_ENABLE       0x200c
+#define BT_HCI_CMD_LE_SET_EXT_ADV_PARAMS    0x2036
+#define BT_HCI_CMD_LE_SET_EXT_ADV_DATA      0x2037
+#define BT_HCI_CMD_LE_SET_EXT_ADV_ENABLE    0x2039
+#define BT_HCI_CMD_LE_READ_NUM_ADV_SETS     0x203b
+
+/* LE features */
+#define BT_HCI_LE_FEATURE_EXT_ADV           12  /* LE Extended Advertising bit */
+
+/* Status codes */
+#define BT_HCI_SUCCESS                      0x00
+#define BT_HCI_ERR_UNSPECIFIED              0x1f
+
+/* Command completion: status is HCI status code from controller or
+ * negative errno when command could not be sent. Parameters are return
+ * parameters of Command Complete, status byte included */
+typedef void (*hci_complete_fn_t) (
+    uint16_t        opcode,
+    int             status,
+    const uint8_t  *param,
+    uint8_t         length,
+    void           *user_data);
+
+/* Kernel HCI socket filter, same layout as BlueZ struct hci_filter */
+typedef struct {
+    uint32_t        type_mask;              /* Packet types passed */
+    uint32_t        event_mask[2];          /* Event codes passed */
+    uint16_t        opcode;                 /* Command Complete/Status opcode, 0 for any */
+} hci_filter_t;
+
+/* Channel counters */
+typedef struct {
+    uint64_t        wakeups;                /* Read handler runs */
+    uint64_t        delivered;              /* Events read from socket */
+    uint64_t        consumed;               /* Events used by channel or handlers */
+    uint64_t        timeouts;               /* Commands failed on deadline */
+} hci_channel_stats_t;
+
+/* Event handler: parameters point into channel receive buffer and are valid
+ * only during the call */
+typedef void (*hci_event_fn_t) (
+    uint8_t         event,
+    const uint8_t  *param,
+    uint8_t         length,
+    void           *user_data);
+
+/* Forward declarations */
+struct hci_channel;
+struct loop;
+
+/* Create HCI channel on open HCI socket. Descriptor is switched to non-blocking
+ * mode and is not closed by the channel */
+struct hci_channel *hci_channel_new_in(
+    struct loop        *loop,               /* Loop */
+    const int           fd);                /* HCI socket */
+
+/* Create HCI channel in default loop */
+struct hci_channel *hci_channel_new(
+    const int           fd);                /* HCI socket */
+
+/* Destroy HCI channel, commands not completed are dropped without callback.
+ * Must not be called from channel callbacks */
+void hci_channel_free(
+    struct hci_channel *hci);               /* HCI channel */
+
+/* Queue command. Commands are sent in order as controller credits allow,
+ * callback runs on Command Complete or Command Status */
+int hci_channel_send(
+    struct hci_channel *hci,                /* HCI channel */
+    const uint16_t      opcode,             /* Command opcode */
+    const void         *param,              /* Parameters */
+    const uint8_t       length,             /* Parameters length */
+    hci_complete_fn_t   callback,           /* Completion callback */
+    void               *user_data,          /* User data */
+    destructor_t        destructor);        /* Destructor */
+
+/* Register handler for controller event, returns handler ID or 0 on error.
+ * Command Complete and Command Status are consumed by the channel itself */
+unsigned int hci_channel_register(
+    struct hci_channel *hci,                /* HCI channel */
+    const uint8_t       event,              /* Event code */
+    hci_event_fn_t      callback,           /* Handler */
+    void               *user_data,          /* User data */
+    destructor_t        destructor);        /* Destructor */
+
+/* Register handler for LE Meta subevent, parameters start with subevent code */
+unsigned int hci_channel_register_le(
+    struct hci_channel *hci,                /* HCI channel */
+    const uint8_t       subevent,           /* LE Meta subevent code */
+    hci_event_fn_t      callback,           /* Handler */
+    void               *user_data,          /* User data */
+    destructor_t        destructor);        /* Destructor */
+
+/* Drop event handler, safe from handlers */
+int hci_channel_unregister(
+    struct hci_channel *hci,                /* HCI channel */
+    const unsigned int  id);                /* Handler ID */
+
+/* Install kernel filter on HCI socket passing only events handlers consume,
+ * kept up to date as handlers come and go. Disabling passes every event */
+int hci_channel_set_filter(
+    struct hci_channel *hci,                /* HCI channel */
+    const int           enable);            /* Enable filtering */
+
+/* Filter matching current handlers */
+int hci_channel_get_filter(
+    struct hci_channel *hci,                /* HCI channel */
+    hci_filter_t       *filter);            /* Filter */
+
+/* Fail commands not completed within timeout after being sent with -ETIMEDOUT,
+ * 0 waits forever. Applies to commands sent afterwards */
+int hci_channel_set_timeout(
+    struct hci_channel *hci,                /* HCI channel */
+    const uint32_t      timeout);           /* Deadline, ms */
+
+/* Read channel counters */
+int hci_channel_get_stats(
+    struct hci_channel *hci,                /* HCI channel */
+    hci_channel_stats_t *stats);            /* Counters */
+
+/* Commands queued or waiting for completion */
+size_t hci_channel_pending(
+    struct hci_channel *hci);               /* HCI channel */
+
+#endif /* __BEACONIZER_HCI_H__ */
+
+/* End of file */
@@ -17,6 +17,7 @@
 
 /* Forward declaration */
 struct io;
+struct loop;
 
 /* I/O channel callback */
 typedef int (*io_callback_fn_t)(struct io *io, void *user_data);
@@ -24,6 +25,11 @@ typedef int (*io_callback_fn_t)(struct io *io, void *user_data);
 /* I/O channel destroy callback */
 typedef void (*io_destroy_fn_t)(void *data);
 
+/* Create and initialize new I/O channel in a loop using existing socket */
+struct io *io_new_in(
+    struct loop        *loop,
+    int                 fd);
+
 /* Create and initialize new I/O channel using existing socket */
 struct io *io_new(
     int                 fd);
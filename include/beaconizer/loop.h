@@ -7,6 +7,9 @@
  *	\version	1.0
  */
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <beaconizer/config.h>
 
 #pragma once
@@ -14,38 +17,149 @@
 #ifndef __BEACONIZER_LOOP_H__
 #define __BEACONIZER_LOOP_H__
 
-/* Initialize loop */
-int loop_init(void);
+/* Descriptor to watch, used for bulk registration */
+typedef struct {
+    int                 sd;                 /* Socket descriptor */
+    uint32_t            event_mask;         /* EPoll mask */
+    event_fn_t          callback;           /* Callback on epoll action */
+    void               *user_data;          /* User data */
+    destructor_t        destructor;         /* Destructor */
+} loop_sd_t;
+
+/* Loop statistics */
+typedef struct {
+    uint64_t            wakeups;            /* Wakeups with events */
+    uint64_t            events;             /* Events dispatched */
+    uint64_t            run_time;           /* Time spent running, nanoseconds */
+    double              wakeup_rate;        /* Wakeups per second of run time */
+} loop_stats_t;
+
+/* Loop instance. Every loop must be used from a single thread */
+struct loop;
+
+/* Create new loop instance */
+struct loop *loop_new(void);
+
+/* Destroy loop instance. Must not be called from the loop's own callbacks.
+ * Every io, timer, HCI channel, scanner, advertiser and fleet created on the
+ * loop should be freed first: their memory comes from loop pools, which are
+ * then kept until the last such object is freed */
+void loop_free(
+    struct loop        *loop);              /* Loop */
+
+/* Default loop instance used by calls without explicit loop */
+struct loop *loop_default(void);
 
 /* Add descriptor to watch */
-int loop_add_sd(
+int loop_add_sd_in(
+    struct loop        *loop,               /* Loop */
     const int           sd,                 /* Socket descriptor */
     const uint32_t      event_mask,         /* EPoll mask */
     event_fn_t          callback,           /* Callback on epoll action */
     void               *user_data,          /* User data */
     destructor_t        destructor);        /* Destructor */
 
+/* Add several descriptors to watch at once. Either all or none are added */
+int loop_add_many_in(
+    struct loop        *loop,               /* Loop */
+    const loop_sd_t    *sds,                /* Descriptors */
+    const size_t        count);             /* Descriptor count */
+
 /* Modify watched descriptor */
-int loop_modify_sd(
+int loop_modify_sd_in(
+    struct loop        *loop,               /* Loop */
     const int           sd,                 /* Socket descriptor */
     uint32_t            event_mask);        /* EPoll mask */
 
 /* Remove watched descriptor */
-int loop_remove_sd(
+int loop_remove_sd_in(
+    struct loop        *loop,               /* Loop */
     const int           sd);                /* Socket descriptor */
 
+/* Post task to loop. The only call which is safe from any thread. Tasks
+ * still queued when the loop is freed are dropped with their destructor.
+ * Nothing is queued on error */
+int loop_post_in(
+    struct loop        *loop,               /* Loop */
+    task_fn_t           callback,           /* Task to run in loop thread */
+    void               *user_data,          /* User data */
+    destructor_t        destructor);        /* Destructor of dropped task */
+
 /* Run loop */
-void loop_run(void);
+void loop_run_in(
+    struct loop        *loop);              /* Loop */
 
 /* Quit loop immediately */
-void loop_quit(void);
+void loop_quit_in(
+    struct loop        *loop);              /* Loop */
 
 /* Quit loop and set success */
-void loop_exit_success(void);
+void loop_exit_success_in(
+    struct loop        *loop);              /* Loop */
 
 /* Quit loop and set failure */
+void loop_exit_failure_in(
+    struct loop        *loop);              /* Loop */
+
+/* Read loop statistics, counted since loop set up or last reset */
+int loop_get_stats_in(
+    struct loop        *loop,               /* Loop */
+    loop_stats_t       *stats);             /* Statistics */
+
+/* Start new statistics window */
+void loop_reset_stats_in(
+    struct loop        *loop);              /* Loop */
+
+/* Initialize default loop */
+int loop_init(void);
+
+/* Add descriptor to watch in default loop */
+int loop_add_sd(
+    const int           sd,                 /* Socket descriptor */
+    const uint32_t      event_mask,         /* EPoll mask */
+    event_fn_t          callback,           /* Callback on epoll action */
+    void               *user_data,          /* User data */
+    destructor_t        destructor);        /* Destructor */
+
+/* Add several descriptors to watch in default loop at once */
+int loop_add_many(
+    const loop_sd_t    *sds,                /* Descriptors */
+    const size_t        count);             /* Descriptor count */
+
+/* Modify watched descriptor in default loop */
+int loop_modify_sd(
+    const int           sd,                 /* Socket descriptor */
+    uint32_t            event_mask);        /* EPoll mask */
+
+/* Remove watched descriptor from default loop */
+int loop_remove_sd(
+    const int           sd);                /* Socket descriptor */
+
+/* Post task to default loop from any thread */
+int loop_post(
+    task_fn_t           callback,           /* Task to run in loop thread */
+    void               *user_data,          /* User data */
+    destructor_t        destructor);        /* Destructor of dropped task */
+
+/* Run default loop */
+void loop_run(void);
+
+/* Quit default loop immediately */
+void loop_quit(void);
+
+/* Quit default loop and set success */
+void loop_exit_success(void);
+
+/* Quit default loop and set failure */
 void loop_exit_failure(void);
 
+/* Read default loop statistics */
+int loop_get_stats(
+    loop_stats_t       *stats);             /* Statistics */
+
+/* Start new default loop statistics window */
+void loop_reset_stats(void);
+
 #endif /* __BEACONIZER_LOOP_H__ */
 
 /* End of file */
\ No newline at end of file
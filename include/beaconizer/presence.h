@@ -0,0 +1,107 @@
+/*!
+ *	\file		presence.h
+ *	\brief		Beacon presence events
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "beaconizer/tracker.h"
+
+#pragma once
+
+#ifndef __BEACONIZER_PRESENCE_H__
+#define __BEACONIZER_PRESENCE_H__
+
+/* Events */
+#define PRESENCE_ENTER              1       /* Beacon appeared */
+#define PRESENCE_DWELL              2       /* Beacon stayed for dwell time */
+#define PRESENCE_EXIT               3       /* Beacon lost */
+
+/* Defaults */
+#define PRESENCE_DEFAULT_CAPACITY   4096    /* Beacons present at once */
+#define PRESENCE_DEFAULT_ENTER      -80     /* Enter threshold, dBm */
+#define PRESENCE_DEFAULT_EXIT       -90     /* Exit threshold, dBm */
+#define PRESENCE_DEFAULT_LOST       10000   /* Lost after, ms */
+
+/* Engine set up */
+typedef struct {
+    size_t          capacity;               /* Beacons, PRESENCE_DEFAULT_CAPACITY if 0 */
+    int8_t          enter_rssi;             /* Sighting at or above enters */
+    int8_t          exit_rssi;              /* Sightings below do not keep beacon present */
+    uint32_t        lost;                   /* Exit after no sighting for, ms */
+    uint32_t        dwell;                  /* Dwell event after, ms, 0 disables it */
+} presence_config_t;
+
+/* Counters */
+typedef struct {
+    uint64_t        sightings;              /* Sightings fed */
+    uint64_t        entered;                /* Enter events */
+    uint64_t        dwelled;                /* Dwell events */
+    uint64_t        exited;                 /* Exit events */
+    uint64_t        dropped;                /* Enters lost to full table */
+} presence_stats_t;
+
+/* Event callback, duration is time present so far, ms */
+typedef void (*presence_fn_t) (
+    const int               event,
+    const tracker_key_t    *key,
+    const uint64_t          duration,
+    void                   *user_data);
+
+/* Forward declarations */
+struct loop;
+struct presence;
+
+/* Fill config with defaults */
+void presence_config_init(
+    presence_config_t      *config);        /* Config */
+
+/* Create engine. Lost deadlines share one loop timer and sighting times must
+ * be CLOCK_MONOTONIC ms. NULL loop leaves expiry to presence_expire() */
+struct presence *presence_new_in(
+    struct loop                *loop,       /* Loop or NULL */
+    const presence_config_t    *config,     /* Config */
+    presence_fn_t               callback,   /* Event callback */
+    void                       *user_data); /* User data */
+
+/* Create engine in default loop */
+struct presence *presence_new(
+    const presence_config_t    *config,     /* Config */
+    presence_fn_t               callback,   /* Event callback */
+    void                       *user_data); /* User data */
+
+/* Destroy engine, no exit events are emitted. Must not be called from
+ * engine callback */
+void presence_free(
+    struct presence    *presence);          /* Engine */
+
+/* Feed decoded sighting. Returns 1 when beacon is present after it, 0 when
+ * not, -ENOSPC when enter was dropped */
+int presence_sighting(
+    struct presence        *presence,       /* Engine */
+    const tracker_key_t    *key,            /* Beacon */
+    const int8_t            rssi,           /* RSSI, dBm */
+    const uint64_t          now);           /* Time, ms */
+
+/* Emit exits due at now, returns number of them */
+size_t presence_expire(
+    struct presence    *presence,           /* Engine */
+    const uint64_t      now);               /* Time, ms */
+
+/* Beacons present */
+size_t presence_count(
+    const struct presence  *presence);      /* Engine */
+
+/* Get counters */
+int presence_get_stats(
+    const struct presence  *presence,       /* Engine */
+    presence_stats_t       *stats);         /* Counters */
+
+#endif /* __BEACONIZER_PRESENCE_H__ */
+
+/* End of file */
@@ -0,0 +1,73 @@
+/*!
+ *	\file		reassembly.h
+ *	\brief		Extended advertising fragment reassembly
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "beaconizer/scanner.h"
+
+#pragma once
+
+#ifndef __BEACONIZER_REASSEMBLY_H__
+#define __BEACONIZER_REASSEMBLY_H__
+
+/* Defaults */
+#define REASSEMBLY_DEFAULT_CAPACITY     8       /* Payloads assembled at once */
+#define REASSEMBLY_DEFAULT_TIMEOUT      1000    /* Fragment chain lifetime, ms */
+
+/* Counters */
+typedef struct {
+    uint64_t        direct;                 /* Complete reports passed without copy */
+    uint64_t        fragments;              /* Fragments buffered */
+    uint64_t        reassembled;            /* Payloads assembled from fragments */
+    uint64_t        truncated;              /* Chains controller gave up on */
+    uint64_t        timeouts;               /* Chains dropped on timeout */
+    uint64_t        overflows;              /* Chains dropped on full pool or size */
+} reassembly_stats_t;
+
+/* Forward declaration */
+struct reassembly;
+
+/* Create reassembler, every buffer is allocated here */
+struct reassembly *reassembly_new(
+    const size_t        capacity,           /* Chains, REASSEMBLY_DEFAULT_CAPACITY if 0 */
+    const uint32_t      timeout,            /* Chain lifetime, ms */
+    scanner_fn_t        callback,           /* Complete payload callback */
+    void               *user_data);         /* User data */
+
+/* Destroy reassembler, partial payloads are dropped */
+void reassembly_free(
+    struct reassembly  *reassembly);        /* Reassembler */
+
+/* Feed report or fragment keyed by address and SID. Complete report with no
+ * chain pending for its key goes to callback as is. Returns 1 when payload
+ * was delivered, 0 when fragment was buffered, negative errno when chain
+ * was dropped */
+int reassembly_push(
+    struct reassembly      *reassembly,     /* Reassembler */
+    const scanner_report_t *report,         /* Report */
+    const uint64_t          now);           /* Time, ms */
+
+/* Drop chains older than timeout, returns chains dropped */
+size_t reassembly_expire(
+    struct reassembly  *reassembly,         /* Reassembler */
+    const uint64_t      now);               /* Time, ms */
+
+/* Chains being assembled */
+size_t reassembly_pending(
+    struct reassembly  *reassembly);        /* Reassembler */
+
+/* Get counters */
+int reassembly_get_stats(
+    struct reassembly  *reassembly,         /* Reassembler */
+    reassembly_stats_t *stats);             /* Counters */
+
+#endif /* __BEACONIZER_REASSEMBLY_H__ */
+
+/* End of file */
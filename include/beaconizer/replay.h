@@ -0,0 +1,93 @@
+/*!
+ *	\file		replay.h
+ *	\brief		HCI capture replay
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_REPLAY_H__
+#define __BEACONIZER_REPLAY_H__
+
+/* Speeds */
+#define REPLAY_FAST                 0.0     /* As fast as the reader takes packets */
+#define REPLAY_REALTIME             1.0     /* Capture timing */
+
+/* Capture formats */
+#define REPLAY_BTSNOOP_H1           1001    /* btsnoop, packet type in flags */
+#define REPLAY_BTSNOOP_H4           1002    /* btsnoop, UART framing */
+#define REPLAY_PCAP_H4_PHDR         201     /* LINKTYPE_BLUETOOTH_HCI_H4_WITH_PHDR */
+
+/* Counters */
+typedef struct {
+    uint64_t        packets;                /* Packets written */
+    uint64_t        bytes;                  /* Bytes written */
+    uint64_t        stalls;                 /* Waits for reader to drain socket */
+    uint64_t        commands;               /* Host packets read and dropped */
+} replay_stats_t;
+
+/* Forward declarations */
+struct loop;
+struct replay;
+
+/* Replay finished: status is EXIT_SUCCESS or negative errno */
+typedef void (*replay_done_fn_t) (
+    struct replay      *replay,
+    int                 status,
+    void               *user_data);
+
+/* Map capture and index packets sent by controller. Packets are written to
+ * a socket pair, the other end of which acts as HCI socket. Returns NULL
+ * with errno set on failure */
+struct replay *replay_open_in(
+    struct loop        *loop,               /* Loop */
+    const char         *path);              /* btsnoop or pcap file */
+
+/* Open capture in default loop */
+struct replay *replay_open(
+    const char         *path);              /* btsnoop or pcap file */
+
+/* Unmap capture and close both socket ends. Must not be called from done
+ * callback */
+void replay_free(
+    struct replay      *replay);            /* Replay */
+
+/* Host end of socket pair, e.g. for hci_channel_new_in(). Owned by replay */
+int replay_get_descriptor(
+    struct replay      *replay);            /* Replay */
+
+/* Capture format, REPLAY_BTSNOOP_* or REPLAY_PCAP_* */
+int replay_get_format(
+    struct replay      *replay);            /* Replay */
+
+/* Controller packets in capture */
+size_t replay_packets(
+    struct replay      *replay);            /* Replay */
+
+/* Start replay. Speed scales capture timing, REPLAY_FAST ignores it. Paced
+ * packets go out with timer wheel resolution */
+int replay_start(
+    struct replay      *replay,             /* Replay */
+    const double        speed,              /* Speed factor */
+    const unsigned int  repeat,             /* Passes over capture, at least 1 */
+    replay_done_fn_t    callback,           /* Completion callback or NULL */
+    void               *user_data);         /* User data */
+
+/* Stop replay without callback */
+int replay_stop(
+    struct replay      *replay);            /* Replay */
+
+/* Get counters */
+int replay_get_stats(
+    struct replay      *replay,             /* Replay */
+    replay_stats_t     *stats);             /* Counters */
+
+#endif /* __BEACONIZER_REPLAY_H__ */
+
+/* End of file */
@@ -0,0 +1,87 @@
+/*!
+ *	\file		rpa.h
+ *	\brief		Resolvable Private Address resolution
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_RPA_H__
+#define __BEACONIZER_RPA_H__
+
+/* Sizes */
+#define RPA_IRK_SIZE                16
+#define RPA_ADDRESS_SIZE            6
+
+/* Defaults */
+#define RPA_DEFAULT_TTL             900     /* Controller default RPA timeout, s */
+#define RPA_DEFAULT_CACHE           4096    /* Cached addresses */
+
+/* Resolver counters */
+typedef struct {
+    uint64_t        resolved;               /* Addresses resolved from cache */
+    uint64_t        rejected;               /* Unknown addresses answered from cache */
+    uint64_t        scans;                  /* Cache misses, IRK list walked */
+    uint64_t        computed;               /* ah() evaluations */
+} rpa_resolver_stats_t;
+
+/* Forward declaration */
+struct rpa_resolver;
+
+/* Address is resolvable private, address is little endian as on air */
+int rpa_is_resolvable(
+    const uint8_t       address[RPA_ADDRESS_SIZE]); /* Device address */
+
+/* Random address hash function ah() */
+uint32_t rpa_hash(
+    const uint8_t       irk[RPA_IRK_SIZE],  /* IRK, most significant octet first */
+    const uint32_t      prand);             /* 24-bit random part */
+
+/* Generate resolvable private address from 22 random bits */
+void rpa_generate(
+    const uint8_t       irk[RPA_IRK_SIZE],          /* IRK, most significant octet first */
+    const uint32_t      random,                     /* Random bits */
+    uint8_t             address[RPA_ADDRESS_SIZE]); /* Device address */
+
+/* Create resolver, results are cached for ttl seconds */
+struct rpa_resolver *rpa_resolver_new(
+    const uint32_t      ttl,                /* Cache lifetime, s, RPA_DEFAULT_TTL if 0 */
+    const size_t        cache);             /* Cache size, RPA_DEFAULT_CACHE if 0 */
+
+/* Destroy resolver */
+void rpa_resolver_free(
+    struct rpa_resolver    *resolver);      /* Resolver */
+
+/* Register IRK, returns identity ID or negative errno. Cached negative
+ * results are dropped */
+int rpa_resolver_add(
+    struct rpa_resolver    *resolver,               /* Resolver */
+    const uint8_t           irk[RPA_IRK_SIZE],      /* IRK, most significant octet first */
+    void                   *user_data);             /* User data */
+
+/* Resolve address, returns identity ID, -ENOENT when no IRK matches or
+ * -EINVAL when address is not resolvable private */
+int rpa_resolver_resolve(
+    struct rpa_resolver    *resolver,                   /* Resolver */
+    const uint8_t           address[RPA_ADDRESS_SIZE],  /* Device address */
+    const uint32_t          now,                        /* Time, s */
+    void                  **user_data);                 /* User data, may be NULL */
+
+/* Number of registered IRKs */
+size_t rpa_resolver_count(
+    const struct rpa_resolver  *resolver);  /* Resolver */
+
+/* Get counters */
+int rpa_resolver_get_stats(
+    const struct rpa_resolver  *resolver,   /* Resolver */
+    rpa_resolver_stats_t       *stats);     /* Counters */
+
+#endif /* __BEACONIZER_RPA_H__ */
+
+/* End of file */
@@ -0,0 +1,121 @@
+/*!
+ *	\file		scanner.h
+ *	\brief		LE scanner on top of HCI channel
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+
+#include <beaconizer/config.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_SCANNER_H__
+#define __BEACONIZER_SCANNER_H__
+
+/* Scan types */
+#define SCANNER_PASSIVE             0x00
+#define SCANNER_ACTIVE              0x01
+
+/* Extended report data status */
+#define SCANNER_DATA_COMPLETE       0x00
+#define SCANNER_DATA_MORE           0x01    /* Fragment, more data to come */
+#define SCANNER_DATA_TRUNCATED      0x02    /* Controller gave up on the rest */
+
+/* Extended report fields not present */
+#define SCANNER_SID_NONE            0xff
+#define SCANNER_TX_POWER_NONE       127
+
+/* Longest extended advertising data */
+#define SCANNER_MAX_EXT_DATA        1650
+
+/* Advertising report. Pointers refer to the event buffer, or reassembly
+ * buffer for fragmented payloads, and are valid only during the callback */
+typedef struct {
+    uint8_t         event_type;             /* ADV_IND, ... or extended properties */
+    uint8_t         extended;               /* From LE Extended Advertising Report */
+    uint8_t         status;                 /* SCANNER_DATA_* */
+    uint8_t         sid;                    /* Advertising set ID */
+    uint8_t         address_type;           /* Public or random */
+    int8_t          rssi;                   /* RSSI, dBm */
+    int8_t          tx_power;               /* TX power, dBm */
+    uint16_t        length;                 /* Data length */
+    const uint8_t  *address;                /* 6 bytes, little endian */
+    const uint8_t  *data;                   /* AD structures */
+} scanner_report_t;
+
+/* Forward declarations */
+struct hci_channel;
+struct scanner;
+
+/* Report callback */
+typedef void (*scanner_fn_t) (
+    const scanner_report_t *report,
+    void                   *user_data);
+
+/* Start/stop completion: status is HCI status or negative errno */
+typedef void (*scanner_done_fn_t) (
+    struct scanner     *scanner,
+    int                 status,
+    void               *user_data);
+
+/* Parse LE Advertising Report parameters in place, subevent code included.
+ * Returns number of reports or negative errno on malformed event */
+int scanner_parse_reports(
+    const uint8_t      *param,              /* Event parameters */
+    const uint8_t       length,             /* Parameters length */
+    scanner_fn_t        callback,           /* Report callback */
+    void               *user_data);         /* User data */
+
+/* Parse LE Extended Advertising Report parameters in place, subevent code
+ * included. Fragments are passed as they are with status telling whether
+ * more data follows. Returns number of reports or negative errno on
+ * malformed event */
+int scanner_parse_ext_reports(
+    const uint8_t      *param,              /* Event parameters */
+    const uint8_t       length,             /* Parameters length */
+    scanner_fn_t        callback,           /* Report callback */
+    void               *user_data);         /* User data */
+
+/* Create scanner on HCI channel. Extended reports are reassembled, payloads
+ * in one piece are delivered from event buffer as legacy reports are */
+struct scanner *scanner_new(
+    struct hci_channel *hci,                /* HCI channel */
+    scanner_fn_t        callback,           /* Report callback */
+    void               *user_data);         /* User data */
+
+/* Destroy scanner. Controller state is left as is. Safe from report
+ * callback, rest of reports in the event are dropped */
+void scanner_free(
+    struct scanner     *scanner);           /* Scanner */
+
+/* Set scan parameters, interval and window in milliseconds */
+int scanner_set_parameters(
+    struct scanner     *scanner,            /* Scanner */
+    const uint8_t       type,               /* SCANNER_PASSIVE or SCANNER_ACTIVE */
+    const uint32_t      interval_ms,        /* Scan interval */
+    const uint32_t      window_ms,          /* Scan window */
+    const uint8_t       filter_duplicates); /* Controller duplicate filter */
+
+/* Enable scanning */
+int scanner_start(
+    struct scanner     *scanner,            /* Scanner */
+    scanner_done_fn_t   callback,           /* Completion callback */
+    void               *user_data);         /* User data */
+
+/* Disable scanning */
+int scanner_stop(
+    struct scanner     *scanner,            /* Scanner */
+    scanner_done_fn_t   callback,           /* Completion callback */
+    void               *user_data);         /* User data */
+
+/* Reports delivered since creation */
+uint64_t scanner_report_count(
+    struct scanner     *scanner);           /* Scanner */
+
+#endif /* __BEACONIZER_SCANNER_H__ */
+
+/* End of file */
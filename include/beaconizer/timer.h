@@ -14,6 +14,73 @@
 #ifndef __BEACONIZER_TIMER_H__
 #define __BEACONIZER_TIMER_H__
 
+/* Forward declaration */
+struct loop;
+
+/* Create timing wheel timer, fires once after timeout (tick resolution) */
+int create_timer_in(
+    struct loop        *loop,               /* Loop */
+    struct timespec    *timeout,            /* Time interval */
+    timer_fn_t          callback,           /* Callback */
+    void               *user_data,          /* User data */
+    destructor_t        destructor);        /* Destructor */
+
+/* Create timer backed by own timerfd, for high precision timeouts */
+int create_precise_timer_in(
+    struct loop        *loop,               /* Loop */
+    struct timespec    *timeout,            /* Time interval */
+    timer_fn_t          callback,           /* Callback */
+    void               *user_data,          /* User data */
+    destructor_t        destructor);        /* Destructor */
+
+/* Create periodic timing wheel timer, armed once */
+int create_periodic_timer_in(
+    struct loop        *loop,               /* Loop */
+    struct timespec    *period,             /* Period */
+    periodic_fn_t       callback,           /* Callback */
+    void               *user_data,          /* User data */
+    destructor_t        destructor);        /* Destructor */
+
+/* Create periodic timer backed by own timerfd */
+int create_precise_periodic_timer_in(
+    struct loop        *loop,               /* Loop */
+    struct timespec    *period,             /* Period */
+    periodic_fn_t       callback,           /* Callback */
+    void               *user_data,          /* User data */
+    destructor_t        destructor);        /* Destructor */
+
+/* Re-arm existing loop timer, NULL timeout reuses the last one. Periodic timers restart their phase */
+int modify_timer_in(
+    struct loop        *loop,               /* Loop */
+    const int           id,                 /* Timer ID */
+    struct timespec    *timeout);           /* Time interval */
+
+/* Stop loop timer, handle stays valid for modify */
+int cancel_timer_in(
+    struct loop        *loop,               /* Loop */
+    const int           id);                /* Timer ID */
+
+/* Remove loop event timer */
+int destroy_timer_in(
+    struct loop        *loop,               /* Loop */
+    const int           id);                /* Timer ID */
+
+/* Let timer fire up to slack late, so wake ups of nearby timers are merged.
+ * Not supported by precise timers */
+int set_timer_slack_in(
+    struct loop        *loop,               /* Loop */
+    const int           id,                 /* Timer ID */
+    struct timespec    *slack);             /* Allowed lateness */
+
+/* Set slack of wheel timers created later in loop */
+int set_default_timer_slack_in(
+    struct loop        *loop,               /* Loop */
+    struct timespec    *slack);             /* Allowed lateness */
+
+/* Set process timer slack, see PR_SET_TIMERSLACK. Zero restores default */
+int set_process_timer_slack(
+    struct timespec    *slack);             /* Allowed lateness */
+
 /* Create timer and add it to event processing */
 int create_timer(
     struct timespec    *timeout,            /* Time interval */
@@ -21,11 +88,45 @@ int create_timer(
     void               *user_data,          /* User data */
     destructor_t        destructor);        /* Destructor */
 
+/* Create timer backed by own timerfd */
+int create_precise_timer(
+    struct timespec    *timeout,            /* Time interval */
+    timer_fn_t          callback,           /* Callback */
+    void               *user_data,          /* User data */
+    destructor_t        destructor);        /* Destructor */
+
+/* Create periodic timer */
+int create_periodic_timer(
+    struct timespec    *period,             /* Period */
+    periodic_fn_t       callback,           /* Callback */
+    void               *user_data,          /* User data */
+    destructor_t        destructor);        /* Destructor */
+
+/* Create periodic timer backed by own timerfd */
+int create_precise_periodic_timer(
+    struct timespec    *period,             /* Period */
+    periodic_fn_t       callback,           /* Callback */
+    void               *user_data,          /* User data */
+    destructor_t        destructor);        /* Destructor */
+
 /* Modify existing timer */
 int modify_timer(
     const int           id,                 /* Timer ID */
     struct timespec    *timeout);           /* Time interval */
 
+/* Stop timer */
+int cancel_timer(
+    const int           id);                /* Timer ID */
+
+/* Set timer slack */
+int set_timer_slack(
+    const int           id,                 /* Timer ID */
+    struct timespec    *slack);             /* Allowed lateness */
+
+/* Set slack of timers created later */
+int set_default_timer_slack(
+    struct timespec    *slack);             /* Allowed lateness */
+
 /* Remove event timer */
 int destroy_timer(
     const int           id);                /* Timer ID */
@@ -0,0 +1,148 @@
+/*!
+ *	\file		tracker.h
+ *	\brief		Beacon tracking table
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_TRACKER_H__
+#define __BEACONIZER_TRACKER_H__
+
+/* Key kinds */
+#define TRACKER_KEY_IBEACON         1       /* UUID, major, minor */
+#define TRACKER_KEY_EDDYSTONE       2       /* Namespace, instance */
+
+/* RSSI filters */
+#define TRACKER_FILTER_EMA          0       /* Exponential moving average */
+#define TRACKER_FILTER_KALMAN       1       /* Scalar Kalman filter */
+
+/* Defaults */
+#define TRACKER_DEFAULT_ALPHA       0.25f   /* EMA weight of new sample */
+#define TRACKER_DEFAULT_Q           0.05f   /* Kalman process noise, dBm^2 */
+#define TRACKER_DEFAULT_R           4.0f    /* Kalman measurement noise, dBm^2 */
+#define TRACKER_DEFAULT_PATH_LOSS   2.0f    /* Free space */
+
+/* Beacon identity, zero padded */
+typedef struct {
+    uint64_t        word[3];                /* Kind in first octet, ID after it */
+} tracker_key_t;
+
+/* Beacon state snapshot */
+typedef struct {
+    tracker_key_t   key;                    /* Identity */
+    uint64_t        last_seen;              /* Time of last report, ms */
+    uint32_t        packets;                /* Reports seen */
+    float           rssi;                   /* Smoothed RSSI, dBm */
+    int8_t          measured_power;         /* RSSI at 1 m from last frame, dBm */
+    float           distance;               /* Estimated distance, m */
+} tracker_entry_t;
+
+/* Counters */
+typedef struct {
+    uint64_t        updates;                /* Reports applied */
+    uint64_t        inserted;               /* Beacons added */
+    uint64_t        evicted;                /* Beacons aged out */
+    uint64_t        dropped;                /* Reports of new beacons lost to full table */
+} tracker_stats_t;
+
+/* Forward declarations */
+struct loop;
+struct tracker;
+
+/* iBeacon key */
+void tracker_key_ibeacon(
+    tracker_key_t      *key,                /* Key */
+    const uint8_t       uuid[16],           /* Proximity UUID */
+    const uint16_t      major,              /* Major */
+    const uint16_t      minor);             /* Minor */
+
+/* Eddystone UID key */
+void tracker_key_eddystone(
+    tracker_key_t      *key,                /* Key */
+    const uint8_t       ns[10],             /* Namespace */
+    const uint8_t       instance[6]);       /* Instance */
+
+/* Create table, every array is allocated here */
+struct tracker *tracker_new(
+    const size_t        capacity);          /* Tracked beacons */
+
+/* Destroy table, sweep timer must be stopped before */
+void tracker_free(
+    struct tracker     *tracker);           /* Table */
+
+/* Select RSSI filter. EMA takes weight in a, Kalman takes process noise in a
+ * and measurement noise in b */
+int tracker_set_filter(
+    struct tracker     *tracker,            /* Table */
+    const int           filter,             /* TRACKER_FILTER_* */
+    const float         a,                  /* First parameter */
+    const float         b);                 /* Second parameter */
+
+/* Path loss exponent of distance estimate */
+void tracker_set_path_loss(
+    struct tracker     *tracker,            /* Table */
+    const float         exponent);          /* 2 in free space, 2.5-4 indoors */
+
+/* Apply report, returns row or -ENOSPC when beacon is new and table is
+ * full. Rows stay valid until next sweep */
+int tracker_update(
+    struct tracker         *tracker,        /* Table */
+    const tracker_key_t    *key,            /* Beacon */
+    const int8_t            rssi,           /* Received RSSI, dBm */
+    const int8_t            measured_power, /* RSSI at 1 m, dBm */
+    const uint64_t          now);           /* Time, ms */
+
+/* Row of beacon or -ENOENT */
+int tracker_find(
+    const struct tracker   *tracker,        /* Table */
+    const tracker_key_t    *key);           /* Beacon */
+
+/* Snapshot of row */
+int tracker_get(
+    const struct tracker   *tracker,        /* Table */
+    const int               row,            /* Row */
+    tracker_entry_t        *entry);         /* Snapshot */
+
+/* Drop beacons not seen for max_age, returns number dropped */
+size_t tracker_sweep(
+    struct tracker     *tracker,            /* Table */
+    const uint64_t      now,                /* Time, ms */
+    const uint64_t      max_age);           /* Age limit, ms */
+
+/* Sweep periodically on loop timer, report times must be CLOCK_MONOTONIC ms.
+ * Returns timer ID or negative errno */
+int tracker_start_sweep_in(
+    struct loop        *loop,               /* Loop */
+    struct tracker     *tracker,            /* Table */
+    const uint32_t      period,             /* Sweep period, ms */
+    const uint64_t      max_age);           /* Age limit, ms */
+
+/* Sweep on default loop */
+int tracker_start_sweep(
+    struct tracker     *tracker,            /* Table */
+    const uint32_t      period,             /* Sweep period, ms */
+    const uint64_t      max_age);           /* Age limit, ms */
+
+/* Beacons tracked */
+size_t tracker_count(
+    const struct tracker   *tracker);       /* Table */
+
+/* Bytes allocated per tracked beacon at full capacity */
+size_t tracker_footprint(
+    const struct tracker   *tracker);       /* Table */
+
+/* Get counters */
+int tracker_get_stats(
+    const struct tracker   *tracker,        /* Table */
+    tracker_stats_t        *stats);         /* Counters */
+
+#endif /* __BEACONIZER_TRACKER_H__ */
+
+/* End of file */
@@ -0,0 +1,255 @@
+/*!
+ *	\file		ad.c
+ *	\brief		Advertising data iterator and decoder registry
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "beaconizer/ad.h"
+#include "beaconizer/utility.h"
+
+/* Buckets per keyed type, IDs rarely collide */
+#define AD_ID_BUCKETS               64
+
+/* Keyed types */
+#define AD_KEY_MANUFACTURER         0
+#define AD_KEY_SERVICE_DATA16       1
+#define AD_KEY_COUNT                2
+
+/* Decoder registered by ID */
+typedef struct ad_keyed {
+    struct ad_keyed    *next;           /* Next in bucket */
+    uint16_t            id;             /* Company or service UUID */
+    ad_decoder_fn_t     decoder;        /* Decoder */
+    void               *user_data;      /* User data */
+} ad_keyed_t;
+
+/* Jump table entry per AD type */
+typedef struct {
+    ad_decoder_fn_t     decoder;        /* Decoder for whole type */
+    void               *user_data;      /* User data */
+    int8_t              key;            /* Keyed table index, -1 if none */
+} ad_slot_t;
+
+/* Decoder registry */
+struct ad_registry {
+    ad_slot_t           slot[256];                          /* Indexed by AD type */
+    ad_keyed_t         *bucket[AD_KEY_COUNT][AD_ID_BUCKETS];    /* Indexed by ID hash */
+};
+
+/* Bucket of ID */
+static inline unsigned int ad_hash(
+    const uint16_t      id) {
+    return (id ^ (id >> 6)) & (AD_ID_BUCKETS - 1);
+}
+
+/* Start iteration */
+void ad_iterator_init(
+    ad_iterator_t      *it,
+    const uint8_t      *data,
+    const uint16_t      length) {
+
+    it->p = data;
+    it->end = data + length;
+}
+
+/* Next AD structure */
+int ad_iterator_next(
+    ad_iterator_t      *it,
+    ad_field_t         *field) {
+
+    uint8_t size;
+
+    if (it->p >= it->end) {
+        return 0;
+    }
+
+    /* Zero length terminates significant part */
+    size = it->p[0];
+    if (0 == size) {
+        it->p = it->end;
+        return 0;
+    }
+
+    if (size >= it->end - it->p) {
+        it->p = it->end;
+        return -EBADMSG;
+    }
+
+    field->type = it->p[1];
+    field->id = 0;
+    field->data = it->p + 2;
+    field->length = size - 1;
+
+    it->p += size + 1;
+
+    return 1;
+}
+
+/* Create registry */
+struct ad_registry *ad_registry_new(void) {
+
+    struct ad_registry *registry = calloc(1, sizeof(struct ad_registry));
+
+    if (NULL == registry) {
+        return NULL;
+    }
+
+    for (size_t i = 0; 256 > i; ++i) {
+        registry->slot[i].key = -1;
+    }
+
+    return registry;
+}
+
+/* Destroy registry */
+void ad_registry_free(
+    struct ad_registry *registry) {
+
+    ad_keyed_t *keyed;
+
+    if (NULL == registry) {
+        return;
+    }
+
+    for (size_t k = 0; AD_KEY_COUNT > k; ++k) {
+        for (size_t i = 0; AD_ID_BUCKETS > i; ++i) {
+            while (NULL != (keyed = registry->bucket[k][i])) {
+                registry->bucket[k][i] = keyed->next;
+                free(keyed);
+            }
+        }
+    }
+
+    free(registry);
+}
+
+/* Register decoder by AD type */
+int ad_registry_add(
+    struct ad_registry *registry,
+    const uint8_t       type,
+    ad_decoder_fn_t     decoder,
+    void               *user_data) {
+
+    if (NULL == registry || NULL == decoder) {
+        return -EINVAL;
+    }
+
+    if (NULL != registry->slot[type].decoder) {
+        return -EEXIST;
+    }
+
+    registry->slot[type].decoder = decoder;
+    registry->slot[type].user_data = user_data;
+
+    return EXIT_SUCCESS;
+}
+
+/* Register decoder by ID */
+int ad_registry_add_id(
+    struct ad_registry *registry,
+    const uint8_t       type,
+    const uint16_t      id,
+    ad_decoder_fn_t     decoder,
+    void               *user_data) {
+
+    ad_keyed_t *keyed, **bucket;
+    int8_t key;
+
+    if (NULL == registry || NULL == decoder) {
+        return -EINVAL;
+    }
+
+    switch (type) {
+        case AD_TYPE_MANUFACTURER:      key = AD_KEY_MANUFACTURER;      break;
+        case AD_TYPE_SERVICE_DATA16:    key = AD_KEY_SERVICE_DATA16;    break;
+        default:
+            return -EINVAL;
+    }
+
+    bucket = &registry->bucket[key][ad_hash(id)];
+
+    for (keyed = *bucket; NULL != keyed; keyed = keyed->next) {
+        if (id == keyed->id) {
+            return -EEXIST;
+        }
+    }
+
+    keyed = malloc(sizeof(ad_keyed_t));
+    if (NULL == keyed) {
+        return -ENOMEM;
+    }
+
+    keyed->id = id;
+    keyed->decoder = decoder;
+    keyed->user_data = user_data;
+    keyed->next = *bucket;
+    *bucket = keyed;
+
+    registry->slot[type].key = key;
+
+    return EXIT_SUCCESS;
+}
+
+/* Classify advertising data */
+int ad_registry_classify(
+    struct ad_registry *registry,
+    const uint8_t      *data,
+    const uint16_t      length,
+    void               *context) {
+
+    const ad_slot_t *slot;
+    const ad_keyed_t *keyed;
+    ad_iterator_t it;
+    ad_field_t field, sub;
+    int result;
+
+    if (NULL == registry || (0 != length && NULL == data)) {
+        return -EINVAL;
+    }
+
+    ad_iterator_init(&it, data, length);
+
+    while (0 < (result = ad_iterator_next(&it, &field))) {
+
+        slot = &registry->slot[field.type];
+
+        /* Company or service decoder first */
+        if (0 <= slot->key && 2 <= field.length) {
+
+            sub.type = field.type;
+            sub.id = get_le16(field.data);
+            sub.data = field.data + 2;
+            sub.length = field.length - 2;
+
+            for (keyed = registry->bucket[slot->key][ad_hash(sub.id)]; NULL != keyed; keyed = keyed->next) {
+                if (sub.id == keyed->id) {
+                    result = keyed->decoder(&sub, keyed->user_data, context);
+                    if (0 < result) {
+                        return result;
+                    }
+                    break;
+                }
+            }
+        }
+
+        if (NULL != slot->decoder) {
+            result = slot->decoder(&field, slot->user_data, context);
+            if (0 < result) {
+                return result;
+            }
+        }
+    }
+
+    return result;
+}
+
+ /* End of file */
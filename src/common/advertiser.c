@@ -0,0 +1,372 @@
+/*!
+ *	\file		advertiser.c
+ *	\brief		LE advertising engine on top of HCI channel
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/advertiser.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/utility.h"
+
+#include "hci_batch.h"
+
+/* Interval limits in 0.625 ms units */
+#define ADV_INTERVAL_MIN            0x0020
+#define ADV_INTERVAL_MAX            0x4000
+
+/* Parameters not pushed to controller yet */
+#define ADV_DIRTY_PARAMS            0x01
+#define ADV_DIRTY_DATA              0x02
+
+/* LE Set Advertising Parameters length */
+#define ADV_PARAMS_SIZE             15
+
+/* Advertiser */
+struct advertiser {
+    hci_batch_t         batch;          /* Commands in flight and controller state */
+
+    /* Wanted configuration */
+    uint16_t            interval_min;   /* Minimal interval */
+    uint16_t            interval_max;   /* Maximal interval */
+    uint8_t             type;           /* Advertising type */
+    uint8_t             length;         /* Data length */
+    uint8_t             data[ADVERTISER_MAX_DATA];  /* Data */
+    uint8_t             dirty;          /* ADV_DIRTY_* */
+
+    /* Start/stop completion */
+    advertiser_fn_t     callback;
+    void               *user_data;
+};
+
+static void advertiser_step(
+    struct advertiser  *adv);
+
+/* Last reference is gone */
+static void advertiser_release(
+    void               *owner) {
+    free(owner);
+}
+
+/* Command rejected, retry on next start */
+static void advertiser_rejected(
+    void               *owner,
+    const uint16_t      opcode) {
+
+    struct advertiser *adv = owner;
+
+    if (BT_HCI_CMD_LE_SET_ADV_PARAMETERS == opcode) {
+        adv->dirty |= ADV_DIRTY_PARAMS;
+    } else if (BT_HCI_CMD_LE_SET_ADV_DATA == opcode) {
+        adv->dirty |= ADV_DIRTY_DATA;
+    }
+}
+
+/* Report settled state once */
+static void advertiser_notify(
+    struct advertiser  *adv,
+    const int           status) {
+
+    advertiser_fn_t callback = adv->callback;
+
+    if (NULL == callback) {
+        return;
+    }
+
+    adv->callback = NULL;
+    callback(adv, status, adv->user_data);
+}
+
+/* Report settled state with first error of last batch */
+static void advertiser_settle(
+    struct advertiser  *adv) {
+    advertiser_notify(adv, hci_batch_take_status(&adv->batch));
+}
+
+/* Batch answered */
+static void advertiser_settled(
+    void               *owner,
+    const uint16_t      opcode,
+    const int           status,
+    const uint8_t      *param,
+    const uint8_t       length) {
+
+    struct advertiser *adv = owner;
+
+    if (hci_batch_rollback(&adv->batch)) {
+        advertiser_settle(adv);
+        return;
+    }
+
+    advertiser_step(adv);
+}
+
+/* Batch hooks */
+static const hci_batch_ops_t advertiser_ops = {
+    .release    = advertiser_release,
+    .rejected   = advertiser_rejected,
+    .settled    = advertiser_settled
+};
+
+/* Enable or disable advertising */
+static int advertiser_send_enable(
+    struct advertiser  *adv,
+    const uint8_t       enable) {
+
+    return hci_batch_send_enable(&adv->batch, BT_HCI_CMD_LE_SET_ADV_ENABLE, &enable, sizeof(enable), enable);
+}
+
+/* Push advertising parameters */
+static int advertiser_send_params(
+    struct advertiser  *adv) {
+
+    uint8_t param[ADV_PARAMS_SIZE];
+
+    memset(param, 0, sizeof(param));
+
+    put_le16(adv->interval_min, param);
+    put_le16(adv->interval_max, param + 2);
+    param[4] = adv->type;
+    /* Own and peer address types and peer address are zero */
+    param[13] = 0x07;   /* All channels */
+    param[14] = 0x00;   /* No white list filter */
+
+    adv->dirty &= ~ADV_DIRTY_PARAMS;
+
+    return hci_batch_send(&adv->batch, BT_HCI_CMD_LE_SET_ADV_PARAMETERS, param, sizeof(param));
+}
+
+/* Push advertising data */
+static int advertiser_send_data(
+    struct advertiser  *adv) {
+
+    uint8_t param[1 + ADVERTISER_MAX_DATA];
+
+    memset(param, 0, sizeof(param));
+
+    param[0] = adv->length;
+    memcpy(param + 1, adv->data, adv->length);
+
+    adv->dirty &= ~ADV_DIRTY_DATA;
+
+    return hci_batch_send(&adv->batch, BT_HCI_CMD_LE_SET_ADV_DATA, param, sizeof(param));
+}
+
+/* Issue next commands towards wanted state. Commands not depending on each
+ * other's result go out as one batch, channel pipelines them up to the
+ * controller credits */
+static void advertiser_step(
+    struct advertiser  *adv) {
+
+    hci_batch_t *batch = &adv->batch;
+    int result = EXIT_SUCCESS;
+
+    if (batch->busy) {
+        return;
+    }
+
+    hci_batch_begin(batch);
+
+    if (batch->wanted) {
+
+        /* Parameters can only change while disabled */
+        if ((adv->dirty & ADV_DIRTY_PARAMS) && batch->enabled) {
+            result = advertiser_send_enable(adv, 0);
+        } else {
+            if (adv->dirty & ADV_DIRTY_PARAMS) {
+                result = advertiser_send_params(adv);
+            }
+            if (0 <= result && (adv->dirty & ADV_DIRTY_DATA)) {
+                result = advertiser_send_data(adv);
+            }
+            if (0 <= result && !batch->enabled) {
+                result = advertiser_send_enable(adv, 1);
+            }
+        }
+
+    } else if (batch->enabled) {
+        result = advertiser_send_enable(adv, 0);
+    }
+
+    if (0 > result) {
+        hci_batch_fail(batch, result);
+    }
+
+    /* Nothing to do or nothing could be sent */
+    if (0 == batch->busy) {
+        advertiser_settle(adv);
+    }
+}
+
+/* Create advertiser */
+struct advertiser *advertiser_new(
+    struct hci_channel *hci) {
+
+    struct advertiser *adv;
+
+    if (NULL == hci) {
+        return NULL;
+    }
+
+    adv = calloc(1, sizeof(struct advertiser));
+    if (NULL == adv) {
+        return NULL;
+    }
+
+    hci_batch_init(&adv->batch, hci, &advertiser_ops, adv);
+    adv->interval_min = ADV_INTERVAL_MIN * 5;   /* 100 ms */
+    adv->interval_max = ADV_INTERVAL_MIN * 5;
+    adv->type = ADVERTISER_ADV_NONCONN_IND;
+    adv->dirty = ADV_DIRTY_PARAMS | ADV_DIRTY_DATA;
+
+    return adv;
+}
+
+/* Destroy advertiser */
+void advertiser_free(
+    struct advertiser  *adv) {
+
+    if (NULL == adv) {
+        return;
+    }
+
+    adv->callback = NULL;
+
+    hci_batch_release(&adv->batch);
+}
+
+/* Set advertising interval */
+int advertiser_set_interval(
+    struct advertiser  *adv,
+    const uint32_t      min_ms,
+    const uint32_t      max_ms) {
+
+    uint16_t min, max;
+
+    if (NULL == adv || min_ms > max_ms) {
+        return -EINVAL;
+    }
+
+    min = (uint16_t) hci_interval(min_ms, ADV_INTERVAL_MIN, ADV_INTERVAL_MAX);
+    max = (uint16_t) hci_interval(max_ms, ADV_INTERVAL_MIN, ADV_INTERVAL_MAX);
+
+    if (min == adv->interval_min && max == adv->interval_max) {
+        return EXIT_SUCCESS;
+    }
+
+    adv->interval_min = min;
+    adv->interval_max = max;
+    adv->dirty |= ADV_DIRTY_PARAMS;
+
+    if (adv->batch.wanted) {
+        advertiser_step(adv);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Set advertising type */
+int advertiser_set_type(
+    struct advertiser  *adv,
+    const uint8_t       type) {
+
+    if (NULL == adv || ADVERTISER_ADV_NONCONN_IND < type) {
+        return -EINVAL;
+    }
+
+    if (type == adv->type) {
+        return EXIT_SUCCESS;
+    }
+
+    adv->type = type;
+    adv->dirty |= ADV_DIRTY_PARAMS;
+
+    if (adv->batch.wanted) {
+        advertiser_step(adv);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Set advertising data */
+int advertiser_set_data(
+    struct advertiser  *adv,
+    const uint8_t      *data,
+    const uint8_t       length) {
+
+    if (NULL == adv || ADVERTISER_MAX_DATA < length || (0 != length && NULL == data)) {
+        return -EINVAL;
+    }
+
+    if (length == adv->length && (0 == length || 0 == memcmp(data, adv->data, length))) {
+        return EXIT_SUCCESS;
+    }
+
+    if (0 != length) {
+        memcpy(adv->data, data, length);
+    }
+    adv->length = length;
+    adv->dirty |= ADV_DIRTY_DATA;
+
+    if (adv->batch.wanted) {
+        advertiser_step(adv);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Enable advertising */
+int advertiser_start(
+    struct advertiser  *adv,
+    advertiser_fn_t     callback,
+    void               *user_data) {
+
+    if (NULL == adv) {
+        return -EINVAL;
+    }
+
+    adv->batch.wanted = 1;
+    adv->callback = callback;
+    adv->user_data = user_data;
+
+    advertiser_step(adv);
+
+    return EXIT_SUCCESS;
+}
+
+/* Disable advertising */
+int advertiser_stop(
+    struct advertiser  *adv,
+    advertiser_fn_t     callback,
+    void               *user_data) {
+
+    if (NULL == adv) {
+        return -EINVAL;
+    }
+
+    adv->batch.wanted = 0;
+    adv->callback = callback;
+    adv->user_data = user_data;
+
+    advertiser_step(adv);
+
+    return EXIT_SUCCESS;
+}
+
+/* Advertising state */
+int advertiser_is_enabled(
+    struct advertiser  *adv) {
+    return (NULL == adv) ? 0 : adv->batch.enabled;
+}
+
+ /* End of file */
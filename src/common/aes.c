@@ -0,0 +1,245 @@
+/*!
+ *	\file		aes.c
+ *	\brief		AES-128 block encryption with cached key schedules
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "beaconizer/aes.h"
+
+/* AES-NI is compiled in per function, no global compiler flags needed */
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define AES128_HAVE_NI
+#include <wmmintrin.h>
+#endif
+
+/* Blocks in flight on AES-NI path */
+#define AES128_INTERLEAVE           4
+
+/* FIPS-197 S-box */
+static const uint8_t aes_sbox[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+/* Round constants */
+static const uint8_t aes_rcon[AES128_ROUNDS] = {
+    0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36
+};
+
+/* Hardware path: -1 until detected. Accessed atomically, first encryption
+ * of any thread may detect it */
+static int aes128_hardware = -1;
+
+/* Multiply by x in GF(2^8) */
+static inline uint8_t aes_xtime(
+    const uint8_t       x) {
+    return (uint8_t) ((x << 1) ^ ((x >> 7) * 0x1b));
+}
+
+/* CPU has AES instructions */
+static int aes128_detect(void) {
+
+#if defined(AES128_HAVE_NI)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("aes") ? 1 : 0;
+#else
+    return 0;
+#endif
+}
+
+/* Byte oriented encryption */
+static void aes128_encrypt_soft(
+    const aes128_key_t *schedule,
+    const uint8_t      *in,
+    uint8_t            *out) {
+
+    uint8_t s[AES128_BLOCK_SIZE], t[AES128_BLOCK_SIZE];
+    uint8_t a0, a1, a2, a3, x;
+
+    for (size_t i = 0; AES128_BLOCK_SIZE > i; ++i) {
+        s[i] = in[i] ^ schedule->round_key[0][i];
+    }
+
+    for (size_t round = 1; AES128_ROUNDS >= round; ++round) {
+
+        /* SubBytes and ShiftRows, state is column major */
+        for (size_t c = 0; 4 > c; ++c) {
+            for (size_t r = 0; 4 > r; ++r) {
+                t[4 * c + r] = aes_sbox[s[4 * ((c + r) & 3) + r]];
+            }
+        }
+
+        /* MixColumns, skipped in the last round */
+        if (AES128_ROUNDS > round) {
+            for (size_t c = 0; 4 > c; ++c) {
+                a0 = t[4 * c];
+                a1 = t[4 * c + 1];
+                a2 = t[4 * c + 2];
+                a3 = t[4 * c + 3];
+                x = a0 ^ a1 ^ a2 ^ a3;
+                s[4 * c]     = a0 ^ x ^ aes_xtime(a0 ^ a1);
+                s[4 * c + 1] = a1 ^ x ^ aes_xtime(a1 ^ a2);
+                s[4 * c + 2] = a2 ^ x ^ aes_xtime(a2 ^ a3);
+                s[4 * c + 3] = a3 ^ x ^ aes_xtime(a3 ^ a0);
+            }
+        } else {
+            memcpy(s, t, sizeof(s));
+        }
+
+        for (size_t i = 0; AES128_BLOCK_SIZE > i; ++i) {
+            s[i] ^= schedule->round_key[round][i];
+        }
+    }
+
+    memcpy(out, s, sizeof(s));
+}
+
+#if defined(AES128_HAVE_NI)
+
+/* Round key */
+#define AES128_RK(s, r)             _mm_loadu_si128((const __m128i *) (s)->round_key[r])
+
+/* AES-NI, independent blocks are interleaved to hide instruction latency */
+__attribute__((target("aes,sse2")))
+static void aes128_encrypt_ni(
+    const aes128_key_t *const   schedule[],
+    const uint8_t               in[][AES128_BLOCK_SIZE],
+    uint8_t                     out[][AES128_BLOCK_SIZE],
+    const size_t                count) {
+
+    __m128i b[AES128_INTERLEAVE];
+    size_t i = 0;
+
+    for (; count >= i + AES128_INTERLEAVE; i += AES128_INTERLEAVE) {
+
+        for (size_t j = 0; AES128_INTERLEAVE > j; ++j) {
+            b[j] = _mm_xor_si128(_mm_loadu_si128((const __m128i *) in[i + j]), AES128_RK(schedule[i + j], 0));
+        }
+
+        for (size_t r = 1; AES128_ROUNDS > r; ++r) {
+            for (size_t j = 0; AES128_INTERLEAVE > j; ++j) {
+                b[j] = _mm_aesenc_si128(b[j], AES128_RK(schedule[i + j], r));
+            }
+        }
+
+        for (size_t j = 0; AES128_INTERLEAVE > j; ++j) {
+            b[j] = _mm_aesenclast_si128(b[j], AES128_RK(schedule[i + j], AES128_ROUNDS));
+            _mm_storeu_si128((__m128i *) out[i + j], b[j]);
+        }
+    }
+
+    for (; count > i; ++i) {
+
+        b[0] = _mm_xor_si128(_mm_loadu_si128((const __m128i *) in[i]), AES128_RK(schedule[i], 0));
+        for (size_t r = 1; AES128_ROUNDS > r; ++r) {
+            b[0] = _mm_aesenc_si128(b[0], AES128_RK(schedule[i], r));
+        }
+        b[0] = _mm_aesenclast_si128(b[0], AES128_RK(schedule[i], AES128_ROUNDS));
+        _mm_storeu_si128((__m128i *) out[i], b[0]);
+    }
+}
+
+#endif
+
+/* Expand key */
+void aes128_expand(
+    aes128_key_t       *schedule,
+    const uint8_t       key[AES128_KEY_SIZE]) {
+
+    uint8_t *w = schedule->round_key[0];
+    uint8_t t[4], u;
+
+    memcpy(w, key, AES128_KEY_SIZE);
+
+    for (size_t i = AES128_KEY_SIZE; sizeof(schedule->round_key) > i; i += 4) {
+
+        memcpy(t, w + i - 4, sizeof(t));
+
+        /* RotWord, SubWord and Rcon once per round key */
+        if (0 == i % AES128_KEY_SIZE) {
+            u = t[0];
+            t[0] = aes_sbox[t[1]] ^ aes_rcon[i / AES128_KEY_SIZE - 1];
+            t[1] = aes_sbox[t[2]];
+            t[2] = aes_sbox[t[3]];
+            t[3] = aes_sbox[u];
+        }
+
+        for (size_t j = 0; 4 > j; ++j) {
+            w[i + j] = w[i + j - AES128_KEY_SIZE] ^ t[j];
+        }
+    }
+}
+
+/* Encrypt block */
+void aes128_encrypt(
+    const aes128_key_t *schedule,
+    const uint8_t       in[AES128_BLOCK_SIZE],
+    uint8_t             out[AES128_BLOCK_SIZE]) {
+
+    aes128_encrypt_batch(&schedule, (const uint8_t (*)[AES128_BLOCK_SIZE]) in, (uint8_t (*)[AES128_BLOCK_SIZE]) out, 1);
+}
+
+/* Encrypt blocks */
+void aes128_encrypt_batch(
+    const aes128_key_t *const   schedule[],
+    const uint8_t               in[][AES128_BLOCK_SIZE],
+    uint8_t                     out[][AES128_BLOCK_SIZE],
+    const size_t                count) {
+
+    int hardware = __atomic_load_n(&aes128_hardware, __ATOMIC_RELAXED);
+    int undetected = -1;
+
+    /* Explicit aes128_use_hardware() choice made meanwhile is kept */
+    if (0 > hardware) {
+        hardware = aes128_detect();
+        if (!__atomic_compare_exchange_n(&aes128_hardware, &undetected, hardware, 0,
+                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            hardware = undetected;
+        }
+    }
+
+#if defined(AES128_HAVE_NI)
+    if (hardware) {
+        aes128_encrypt_ni(schedule, in, out, count);
+        return;
+    }
+#endif
+
+    for (size_t i = 0; count > i; ++i) {
+        aes128_encrypt_soft(schedule[i], in[i], out[i]);
+    }
+}
+
+/* Select implementation */
+int aes128_use_hardware(
+    const int           enable) {
+
+    const int hardware = enable ? aes128_detect() : 0;
+
+    __atomic_store_n(&aes128_hardware, hardware, __ATOMIC_RELAXED);
+
+    return hardware;
+}
+
+ /* End of file */
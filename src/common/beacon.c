@@ -0,0 +1,147 @@
+/*!
+ *	\file		beacon.c
+ *	\brief		Beacon advertising payload builders
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "beaconizer/ad.h"
+#include "beaconizer/beacon.h"
+#include "beaconizer/utility.h"
+
+/* Flags: LE General Discoverable, BR/EDR not supported */
+static const uint8_t ibeacon_prefix[] = {
+    0x02, 0x01, 0x06,                   /* Flags */
+    0x1a, 0xff,                         /* Manufacturer specific data */
+    0x4c, 0x00,                         /* Apple */
+    0x02, 0x15                          /* iBeacon, 21 bytes follow */
+};
+
+/* Reset cache */
+void ibeacon_payload_init(
+    ibeacon_payload_t  *payload) {
+
+    memset(payload, 0, sizeof(ibeacon_payload_t));
+    payload->dirty = 1;
+}
+
+/* Update fields */
+int ibeacon_payload_update(
+    ibeacon_payload_t  *payload,
+    const uint8_t       uuid[16],
+    const uint16_t      major,
+    const uint16_t      minor,
+    const int8_t        power) {
+
+    if (0 == memcmp(payload->uuid, uuid, sizeof(payload->uuid))
+        && major == payload->major
+        && minor == payload->minor
+        && power == payload->power) {
+        return 0;
+    }
+
+    memcpy(payload->uuid, uuid, sizeof(payload->uuid));
+    payload->major = major;
+    payload->minor = minor;
+    payload->power = power;
+    payload->dirty = 1;
+
+    return 1;
+}
+
+/* Serialized payload */
+const uint8_t *ibeacon_payload_data(
+    ibeacon_payload_t  *payload,
+    uint8_t            *length) {
+
+    uint8_t *p = payload->data;
+
+    if (payload->dirty) {
+
+        memcpy(p, ibeacon_prefix, sizeof(ibeacon_prefix));
+        p += sizeof(ibeacon_prefix);
+
+        memcpy(p, payload->uuid, sizeof(payload->uuid));
+        p += sizeof(payload->uuid);
+
+        put_be16(payload->major, p);
+        put_be16(payload->minor, p + 2);
+        p[4] = (uint8_t) payload->power;
+
+        payload->dirty = 0;
+    }
+
+    if (NULL != length) {
+        *length = IBEACON_PAYLOAD_SIZE;
+    }
+
+    return payload->data;
+}
+
+/* Apple manufacturer data: iBeacon type and length, UUID, major, minor, power */
+static int ibeacon_decoder(
+    const ad_field_t   *field,
+    void               *user_data,
+    void               *context) {
+
+    if (23 > field->length || 0x0215 != get_be16(field->data)) {
+        return 0;
+    }
+
+    return BEACON_IBEACON;
+}
+
+/* Eddystone service data: UID, URL, TLM or EID frame */
+static int eddystone_decoder(
+    const ad_field_t   *field,
+    void               *user_data,
+    void               *context) {
+
+    if (0 == field->length || 0 != (field->data[0] & 0x0f) || 0x30 < field->data[0]) {
+        return 0;
+    }
+
+    return BEACON_EDDYSTONE;
+}
+
+/* Any company: beacon code, ID, reference RSSI, reserved */
+static int altbeacon_decoder(
+    const ad_field_t   *field,
+    void               *user_data,
+    void               *context) {
+
+    if (26 > field->length || BEACON_ALTBEACON_CODE != get_be16(field->data + 2)) {
+        return 0;
+    }
+
+    return BEACON_ALTBEACON;
+}
+
+/* Register beacon decoders */
+int beacon_register_decoders(
+    struct ad_registry *registry) {
+
+    int result;
+
+    result = ad_registry_add_id(registry, AD_TYPE_MANUFACTURER, BEACON_COMPANY_APPLE, ibeacon_decoder, NULL);
+    if (EXIT_SUCCESS != result) {
+        return result;
+    }
+
+    result = ad_registry_add_id(registry, AD_TYPE_SERVICE_DATA16, BEACON_SERVICE_EDDYSTONE, eddystone_decoder, NULL);
+    if (EXIT_SUCCESS != result) {
+        return result;
+    }
+
+    return ad_registry_add(registry, AD_TYPE_MANUFACTURER, altbeacon_decoder, NULL);
+}
+
+ /* End of file */
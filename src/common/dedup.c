@@ -0,0 +1,201 @@
+/*!
+ *	\file		dedup.c
+ *	\brief		Advertising report duplicate suppression
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "beaconizer/dedup.h"
+
+/* Slots probed per report, bounds lookup cost */
+#define DEDUP_PROBE                 8
+
+/* Entry holds a beacon */
+#define DEDUP_USED                  (UINT64_C(1) << 63)
+
+/* Tracked beacon */
+typedef struct {
+    uint64_t            address;                /* Type, address and DEDUP_USED, 0 when free */
+    uint32_t            payload;                /* Payload hash */
+    uint64_t            emitted;                /* Time of last delivered report, ms */
+} dedup_entry_t;
+
+/* Cache */
+struct dedup {
+    dedup_entry_t      *entry;                  /* Open addressing table */
+    size_t              mask;                   /* Table size - 1 */
+    uint32_t            window;                 /* Window, ms */
+    dedup_stats_t       stats;                  /* Counters */
+};
+
+/* FNV-1a */
+static inline uint32_t dedup_hash(
+    const uint8_t      *data,
+    const uint16_t      length) {
+
+    uint32_t hash = 2166136261u;
+
+    for (size_t i = 0; length > i; ++i) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+
+    return hash;
+}
+
+/* Create cache */
+struct dedup *dedup_new(
+    const size_t        capacity,
+    const uint32_t      window) {
+
+    struct dedup *dedup;
+    size_t size = DEDUP_PROBE;
+
+    while (size < (capacity ? capacity : DEDUP_DEFAULT_CAPACITY)) {
+        size <<= 1;
+    }
+
+    dedup = calloc(1, sizeof(struct dedup));
+    if (NULL == dedup) {
+        return NULL;
+    }
+
+    dedup->entry = calloc(size, sizeof(dedup_entry_t));
+    if (NULL == dedup->entry) {
+        free(dedup);
+        return NULL;
+    }
+
+    dedup->mask = size - 1;
+    dedup->window = window;
+
+    return dedup;
+}
+
+/* Destroy cache */
+void dedup_free(
+    struct dedup       *dedup) {
+
+    if (NULL == dedup) {
+        return;
+    }
+
+    free(dedup->entry);
+    free(dedup);
+}
+
+/* Change window */
+void dedup_set_window(
+    struct dedup       *dedup,
+    const uint32_t      window) {
+
+    if (NULL != dedup) {
+        dedup->window = window;
+    }
+}
+
+/* Feed report */
+int dedup_check(
+    struct dedup       *dedup,
+    const uint8_t       address_type,
+    const uint8_t      *address,
+    const uint8_t      *data,
+    const uint16_t      length,
+    const uint64_t      now) {
+
+    dedup_entry_t *entry, *victim = NULL;
+    uint64_t key = DEDUP_USED | ((uint64_t) address_type << 48);
+    uint32_t payload;
+    size_t slot;
+
+    if (0 == dedup->window) {
+        dedup->stats.passed++;
+        return 1;
+    }
+
+    for (size_t i = 0; 6 > i; ++i) {
+        key |= (uint64_t) address[i] << (8 * i);
+    }
+
+    payload = dedup_hash(data, length);
+
+    /* Fixed neighbourhood, no tombstones: stale entries are simply reused */
+    slot = (size_t) ((key * UINT64_C(0x9e3779b97f4a7c15)) >> 32) ^ payload;
+
+    for (size_t i = 0; DEDUP_PROBE > i; ++i) {
+
+        entry = &dedup->entry[(slot + i) & dedup->mask];
+
+        if (key == entry->address && payload == entry->payload) {
+
+            if (dedup->window > now - entry->emitted) {
+                dedup->stats.suppressed++;
+                return 0;
+            }
+
+            entry->emitted = now;
+            dedup->stats.passed++;
+            return 1;
+        }
+
+        /* Prefer free slot, then expired one, then the oldest */
+        if (0 == entry->address) {
+            if (NULL == victim || 0 != victim->address) {
+                victim = entry;
+            }
+        } else if (NULL == victim || (0 != victim->address && entry->emitted < victim->emitted)) {
+            victim = entry;
+        }
+    }
+
+    if (0 != victim->address && dedup->window > now - victim->emitted) {
+        dedup->stats.evicted++;
+    }
+
+    victim->address = key;
+    victim->payload = payload;
+    victim->emitted = now;
+    dedup->stats.passed++;
+
+    return 1;
+}
+
+/* Feed scanner report */
+int dedup_check_report(
+    struct dedup               *dedup,
+    const scanner_report_t     *report,
+    const uint64_t              now) {
+    return dedup_check(dedup, report->address_type, report->address, report->data, report->length, now);
+}
+
+/* Forget every beacon */
+void dedup_clear(
+    struct dedup       *dedup) {
+
+    if (NULL != dedup) {
+        memset(dedup->entry, 0, (dedup->mask + 1) * sizeof(dedup_entry_t));
+    }
+}
+
+/* Get counters */
+int dedup_get_stats(
+    const struct dedup *dedup,
+    dedup_stats_t      *stats) {
+
+    if (NULL == dedup || NULL == stats) {
+        return -EINVAL;
+    }
+
+    *stats = dedup->stats;
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
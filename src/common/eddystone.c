@@ -0,0 +1,309 @@
+/*!
+ *	\file		eddystone.c
+ *	\brief		Eddystone frame builder and rotation
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "beaconizer/eddystone.h"
+#include "beaconizer/utility.h"
+
+/* Flags and complete 16-bit service list with Eddystone UUID */
+static const uint8_t eddystone_header[] = {
+    0x02, 0x01, 0x06,
+    0x03, 0x03, 0xaa, 0xfe
+};
+
+/* Service data header: length, type, UUID */
+#define EDDYSTONE_FRAME_OFFSET      (sizeof(eddystone_header) + 4)
+
+/* TLM counters inside PDU */
+#define EDDYSTONE_TLM_ADV_OFFSET    (EDDYSTONE_FRAME_OFFSET + 6)
+#define EDDYSTONE_TLM_SEC_OFFSET    (EDDYSTONE_FRAME_OFFSET + 10)
+#define EDDYSTONE_TLM_SIZE          14
+
+/* URL schemes */
+static const char *const eddystone_scheme[] = {
+    "http://www.",
+    "https://www.",
+    "http://",
+    "https://"
+};
+
+/* URL expansions, those with trailing slash first */
+static const char *const eddystone_expansion[] = {
+    ".com/", ".org/", ".edu/", ".net/", ".info/", ".biz/", ".gov/",
+    ".com",  ".org",  ".edu",  ".net",  ".info",  ".biz",  ".gov"
+};
+
+#define EDDYSTONE_SCHEMES           (sizeof(eddystone_scheme) / sizeof(eddystone_scheme[0]))
+#define EDDYSTONE_EXPANSIONS        (sizeof(eddystone_expansion) / sizeof(eddystone_expansion[0]))
+
+/* Put frame into slot PDU, returns 1 if PDU changed */
+static int eddystone_build(
+    eddystone_t        *beacon,
+    const uint8_t       slot,
+    const uint8_t      *frame,
+    const uint8_t       size) {
+
+    eddystone_pdu_t *pdu = &beacon->pdu[slot];
+    const uint8_t length = EDDYSTONE_FRAME_OFFSET + size;
+
+    if (length == pdu->length && 0 == memcmp(pdu->data + EDDYSTONE_FRAME_OFFSET, frame, size)) {
+        return 0;
+    }
+
+    memcpy(pdu->data, eddystone_header, sizeof(eddystone_header));
+    pdu->data[sizeof(eddystone_header)] = size + 3;
+    pdu->data[sizeof(eddystone_header) + 1] = 0x16;
+    pdu->data[sizeof(eddystone_header) + 2] = 0xaa;
+    pdu->data[sizeof(eddystone_header) + 3] = 0xfe;
+    memcpy(pdu->data + EDDYSTONE_FRAME_OFFSET, frame, size);
+    pdu->length = length;
+
+    return 1;
+}
+
+/* Reset beacon */
+void eddystone_init(
+    eddystone_t        *beacon) {
+    memset(beacon, 0, sizeof(eddystone_t));
+    beacon->current = EDDYSTONE_SLOTS - 1;
+}
+
+/* UID frame */
+int eddystone_set_uid(
+    eddystone_t        *beacon,
+    const int8_t        tx_power,
+    const uint8_t       ns[EDDYSTONE_NAMESPACE_SIZE],
+    const uint8_t       instance[EDDYSTONE_INSTANCE_SIZE]) {
+
+    uint8_t frame[2 + EDDYSTONE_NAMESPACE_SIZE + EDDYSTONE_INSTANCE_SIZE + 2];
+
+    frame[0] = EDDYSTONE_UID;
+    frame[1] = (uint8_t) tx_power;
+    memcpy(frame + 2, ns, EDDYSTONE_NAMESPACE_SIZE);
+    memcpy(frame + 2 + EDDYSTONE_NAMESPACE_SIZE, instance, EDDYSTONE_INSTANCE_SIZE);
+    frame[sizeof(frame) - 2] = 0x00;
+    frame[sizeof(frame) - 1] = 0x00;
+
+    return eddystone_build(beacon, EDDYSTONE_SLOT_UID, frame, sizeof(frame));
+}
+
+/* URL frame */
+int eddystone_set_url(
+    eddystone_t        *beacon,
+    const int8_t        tx_power,
+    const char         *url) {
+
+    uint8_t frame[3 + EDDYSTONE_URL_MAX];
+    int length;
+
+    /* Scheme and encoded URL follow TX power */
+    length = eddystone_url_encode(url, frame + 2);
+    if (0 > length) {
+        return length;
+    }
+
+    frame[0] = EDDYSTONE_URL;
+    frame[1] = (uint8_t) tx_power;
+
+    return eddystone_build(beacon, EDDYSTONE_SLOT_URL, frame, (uint8_t) (2 + length));
+}
+
+/* TLM frame */
+int eddystone_set_tlm(
+    eddystone_t        *beacon,
+    const uint16_t      battery_mv,
+    const int16_t       temperature) {
+
+    /* Unencrypted */
+    uint8_t frame[EDDYSTONE_TLM_SIZE] = { EDDYSTONE_TLM, 0x00 };
+
+    put_be16(battery_mv, frame + 2);
+    put_be16((uint16_t) temperature, frame + 4);
+    put_be32(beacon->adv_count, frame + 6);
+    put_be32(beacon->uptime, frame + 10);
+
+    return eddystone_build(beacon, EDDYSTONE_SLOT_TLM, frame, sizeof(frame));
+}
+
+/* Advance TLM counters */
+void eddystone_tlm_tick(
+    eddystone_t        *beacon,
+    const uint32_t      adv_count,
+    const uint32_t      uptime) {
+
+    eddystone_pdu_t *pdu = &beacon->pdu[EDDYSTONE_SLOT_TLM];
+
+    beacon->adv_count += adv_count;
+    beacon->uptime += uptime;
+
+    if (0 == pdu->length) {
+        return;
+    }
+
+    /* Only the counters change */
+    put_be32(beacon->adv_count, pdu->data + EDDYSTONE_TLM_ADV_OFFSET);
+    put_be32(beacon->uptime, pdu->data + EDDYSTONE_TLM_SEC_OFFSET);
+}
+
+/* EID frame */
+int eddystone_set_eid(
+    eddystone_t        *beacon,
+    const int8_t        tx_power,
+    const uint8_t       eid[EDDYSTONE_EID_SIZE]) {
+
+    uint8_t frame[2 + EDDYSTONE_EID_SIZE];
+
+    frame[0] = EDDYSTONE_EID;
+    frame[1] = (uint8_t) tx_power;
+    memcpy(frame + 2, eid, EDDYSTONE_EID_SIZE);
+
+    return eddystone_build(beacon, EDDYSTONE_SLOT_EID, frame, sizeof(frame));
+}
+
+/* Turn slot off */
+void eddystone_clear(
+    eddystone_t        *beacon,
+    const uint8_t       slot) {
+
+    if (EDDYSTONE_SLOTS > slot) {
+        beacon->pdu[slot].length = 0;
+    }
+}
+
+/* Next frame in rotation */
+const uint8_t *eddystone_next(
+    eddystone_t        *beacon,
+    uint8_t            *length) {
+
+    uint8_t slot = beacon->current;
+
+    for (size_t i = 0; EDDYSTONE_SLOTS > i; ++i) {
+
+        slot = (slot + 1) % EDDYSTONE_SLOTS;
+
+        if (0 != beacon->pdu[slot].length) {
+            beacon->current = slot;
+            *length = beacon->pdu[slot].length;
+            return beacon->pdu[slot].data;
+        }
+    }
+
+    *length = 0;
+
+    return NULL;
+}
+
+/* Encode URL */
+int eddystone_url_encode(
+    const char         *url,
+    uint8_t            *out) {
+
+    const char *p = url;
+    size_t i, size, length = 0;
+
+    if (NULL == url || NULL == out) {
+        return -EINVAL;
+    }
+
+    /* www variants come first in table */
+    for (i = 0; EDDYSTONE_SCHEMES > i; ++i) {
+        size = strlen(eddystone_scheme[i]);
+        if (0 == strncmp(p, eddystone_scheme[i], size)) {
+            break;
+        }
+    }
+
+    if (EDDYSTONE_SCHEMES == i) {
+        return -EINVAL;
+    }
+
+    out[0] = (uint8_t) i;
+    p += size;
+
+    while ('\0' != *p) {
+
+        if (EDDYSTONE_URL_MAX == length) {
+            return -E2BIG;
+        }
+
+        for (i = 0; EDDYSTONE_EXPANSIONS > i; ++i) {
+            size = strlen(eddystone_expansion[i]);
+            if (0 == strncmp(p, eddystone_expansion[i], size)) {
+                break;
+            }
+        }
+
+        if (EDDYSTONE_EXPANSIONS > i) {
+            out[1 + length++] = (uint8_t) i;
+            p += size;
+            continue;
+        }
+
+        /* Only graphic characters survive */
+        if (0x21 > (uint8_t) *p || 0x7e < (uint8_t) *p) {
+            return -EINVAL;
+        }
+
+        out[1 + length++] = (uint8_t) *p++;
+    }
+
+    return (int) (1 + length);
+}
+
+/* Decode URL */
+int eddystone_url_decode(
+    const uint8_t      *data,
+    const uint8_t       length,
+    char               *out,
+    const size_t        size) {
+
+    size_t used = 0, n;
+    const char *s;
+
+    if (NULL == data || NULL == out || 0 == length || EDDYSTONE_SCHEMES <= data[0]) {
+        return -EINVAL;
+    }
+
+    for (size_t i = 0; length > i; ++i) {
+
+        if (0 == i) {
+            s = eddystone_scheme[data[0]];
+        } else if (EDDYSTONE_EXPANSIONS > data[i]) {
+            s = eddystone_expansion[data[i]];
+        } else if (0x21 <= data[i] && 0x7e >= data[i]) {
+            if (used + 1 >= size) {
+                return -ENOSPC;
+            }
+            out[used++] = (char) data[i];
+            continue;
+        } else {
+            return -EBADMSG;
+        }
+
+        n = strlen(s);
+        if (used + n >= size) {
+            return -ENOSPC;
+        }
+
+        memcpy(out + used, s, n);
+        used += n;
+    }
+
+    out[used] = '\0';
+
+    return (int) used;
+}
+
+ /* End of file */
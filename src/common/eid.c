@@ -0,0 +1,462 @@
+/*!
+ *	\file		eid.c
+ *	\brief		Eddystone-EID generation and resolution
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "beaconizer/aes.h"
+#include "beaconizer/eid.h"
+
+/* Previous, current and next period */
+#define EID_WINDOW                  3
+
+/* Blocks per AES batch */
+#define EID_BATCH                   64
+
+/* Index entry is free */
+#define EID_EMPTY                   UINT32_MAX
+
+/* Smallest index */
+#define EID_INDEX_MIN               64
+
+/* Registered beacon */
+typedef struct {
+    aes128_key_t        identity;               /* Identity key schedule */
+    aes128_key_t        temporary;              /* Temporary key schedule of tk_epoch */
+    uint64_t            eid[EID_WINDOW];        /* EIDs of period - 1, period, period + 1 */
+    void               *user_data;              /* User data */
+    uint32_t            clock;                  /* Beacon time counter at resolver time 0 */
+    uint32_t            period;                 /* Current period */
+    uint16_t            tk_epoch;               /* Time counter >> 16 of temporary key */
+    uint8_t             exponent;               /* Rotation period exponent */
+    uint8_t             has_tk;                 /* Temporary key is cached */
+    uint8_t             valid;                  /* EIDs are computed */
+    uint8_t             pending;                /* Window EIDs not indexed yet, bit per EID */
+} eid_key_t;
+
+/* Index entry */
+typedef struct {
+    uint64_t            eid;                    /* Ephemeral ID */
+    uint32_t            key;                    /* Beacon, EID_EMPTY if free */
+} eid_slot_t;
+
+/* Pending EID computations */
+typedef struct {
+    const aes128_key_t *schedule[EID_BATCH];
+    uint8_t             in[EID_BATCH][AES128_BLOCK_SIZE];
+    uint8_t             out[EID_BATCH][AES128_BLOCK_SIZE];
+    uint64_t           *dest[EID_BATCH];
+    size_t              count;
+} eid_batch_t;
+
+/* Resolver */
+struct eid_engine {
+    eid_key_t          *key;                    /* Beacons */
+    size_t              count;                  /* Beacons in use */
+    size_t              size;                   /* Beacons allocated */
+    eid_slot_t         *index;                  /* Open addressing index by EID */
+    size_t              mask;                   /* Index size - 1 */
+};
+
+/* Temporary key derivation block: zeros, salt, zeros, upper half of counter */
+static void eid_tk_block(
+    uint8_t             block[AES128_BLOCK_SIZE],
+    const uint16_t      epoch) {
+
+    memset(block, 0, AES128_BLOCK_SIZE);
+    block[11] = 0xff;
+    block[14] = (uint8_t) (epoch >> 8);
+    block[15] = (uint8_t) epoch;
+}
+
+/* EID block: zeros, exponent, counter with lowest exponent bits cleared */
+static void eid_block(
+    uint8_t             block[AES128_BLOCK_SIZE],
+    const uint8_t       exponent,
+    const uint32_t      counter) {
+
+    const uint32_t quantized = counter & ~((UINT32_C(1) << exponent) - 1);
+
+    memset(block, 0, AES128_BLOCK_SIZE);
+    block[11] = exponent;
+    block[12] = (uint8_t) (quantized >> 24);
+    block[13] = (uint8_t) (quantized >> 16);
+    block[14] = (uint8_t) (quantized >> 8);
+    block[15] = (uint8_t) quantized;
+}
+
+/* Temporary key schedule of epoch */
+static void eid_temporary(
+    const aes128_key_t *identity,
+    const uint16_t      epoch,
+    aes128_key_t       *schedule) {
+
+    uint8_t block[AES128_BLOCK_SIZE], tk[AES128_KEY_SIZE];
+
+    eid_tk_block(block, epoch);
+    aes128_encrypt(identity, block, tk);
+    aes128_expand(schedule, tk);
+}
+
+/* Encrypt pending blocks */
+static void eid_batch_flush(
+    eid_batch_t        *batch) {
+
+    aes128_encrypt_batch(batch->schedule, (const uint8_t (*)[AES128_BLOCK_SIZE]) batch->in, batch->out, batch->count);
+
+    for (size_t i = 0; batch->count > i; ++i) {
+        memcpy(batch->dest[i], batch->out[i], EID_SIZE);
+    }
+
+    batch->count = 0;
+}
+
+/* Queue EID of counter, cached temporary key is batched */
+static void eid_batch_add(
+    eid_batch_t        *batch,
+    eid_key_t          *key,
+    const uint32_t      counter,
+    uint64_t           *dest) {
+
+    const uint16_t epoch = (uint16_t) (counter >> 16);
+    uint8_t block[AES128_BLOCK_SIZE];
+    aes128_key_t scratch;
+
+    /* Adjacent period across temporary key boundary */
+    if (epoch != key->tk_epoch) {
+        eid_temporary(&key->identity, epoch, &scratch);
+        eid_block(block, key->exponent, counter);
+        aes128_encrypt(&scratch, block, block);
+        memcpy(dest, block, EID_SIZE);
+        return;
+    }
+
+    batch->schedule[batch->count] = &key->temporary;
+    eid_block(batch->in[batch->count], key->exponent, counter);
+    batch->dest[batch->count] = dest;
+
+    if (EID_BATCH == ++batch->count) {
+        eid_batch_flush(batch);
+    }
+}
+
+/* Index EID of beacon */
+static void eid_index_insert(
+    struct eid_engine  *engine,
+    const uint64_t      eid,
+    const uint32_t      key) {
+
+    size_t i;
+
+    /* EIDs are AES output, low bits are uniform already */
+    for (i = eid & engine->mask; EID_EMPTY != engine->index[i].key; i = (i + 1) & engine->mask);
+
+    engine->index[i].eid = eid;
+    engine->index[i].key = key;
+}
+
+/* Drop EID of beacon with backward shift, lookups need no tombstones */
+static void eid_index_remove(
+    struct eid_engine  *engine,
+    const uint64_t      eid,
+    const uint32_t      key) {
+
+    const size_t mask = engine->mask;
+    eid_slot_t *index = engine->index;
+    size_t i, j, home;
+
+    for (i = eid & mask; eid != index[i].eid || key != index[i].key; i = (i + 1) & mask) {
+        if (EID_EMPTY == index[i].key) {
+            return;
+        }
+    }
+
+    for (j = i;;) {
+
+        j = (j + 1) & mask;
+        if (EID_EMPTY == index[j].key) {
+            break;
+        }
+
+        /* Entry may move to i only if its home is not in (i, j] */
+        home = index[j].eid & mask;
+        if ((i < j) ? (home <= i || home > j) : (home <= i && home > j)) {
+            index[i] = index[j];
+            i = j;
+        }
+    }
+
+    index[i].key = EID_EMPTY;
+}
+
+/* Rebuild index from computed EIDs */
+static int eid_index_rebuild(
+    struct eid_engine  *engine) {
+
+    size_t size = EID_INDEX_MIN, i;
+    eid_slot_t *index;
+
+    /* Load factor stays below one half */
+    while (size < engine->count * EID_WINDOW * 2) {
+        size <<= 1;
+    }
+
+    if (NULL == engine->index || size > engine->mask + 1) {
+
+        index = malloc(size * sizeof(eid_slot_t));
+        if (NULL == index) {
+            return -ENOMEM;
+        }
+
+        free(engine->index);
+        engine->index = index;
+        engine->mask = size - 1;
+    }
+
+    for (i = 0; engine->mask >= i; ++i) {
+        engine->index[i].key = EID_EMPTY;
+    }
+
+    for (size_t k = 0; engine->count > k; ++k) {
+
+        engine->key[k].pending = 0;
+
+        if (!engine->key[k].valid) {
+            continue;
+        }
+
+        for (size_t w = 0; EID_WINDOW > w; ++w) {
+            eid_index_insert(engine, engine->key[k].eid[w], (uint32_t) k);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Compute EID */
+int eid_compute(
+    const uint8_t       ik[EID_KEY_SIZE],
+    const uint8_t       exponent,
+    const uint32_t      counter,
+    uint8_t             eid[EID_SIZE]) {
+
+    aes128_key_t identity, temporary;
+    uint8_t block[AES128_BLOCK_SIZE];
+
+    if (EID_EXPONENT_MAX < exponent) {
+        return -EINVAL;
+    }
+
+    aes128_expand(&identity, ik);
+    eid_temporary(&identity, (uint16_t) (counter >> 16), &temporary);
+
+    eid_block(block, exponent, counter);
+    aes128_encrypt(&temporary, block, block);
+    memcpy(eid, block, EID_SIZE);
+
+    return EXIT_SUCCESS;
+}
+
+/* Create resolver */
+struct eid_engine *eid_engine_new(void) {
+    return calloc(1, sizeof(struct eid_engine));
+}
+
+/* Destroy resolver */
+void eid_engine_free(
+    struct eid_engine  *engine) {
+
+    if (NULL == engine) {
+        return;
+    }
+
+    free(engine->index);
+    free(engine->key);
+    free(engine);
+}
+
+/* Register beacon */
+int eid_engine_add(
+    struct eid_engine  *engine,
+    const uint8_t       ik[EID_KEY_SIZE],
+    const uint8_t       exponent,
+    const uint32_t      clock,
+    void               *user_data) {
+
+    eid_key_t *key;
+    size_t size;
+
+    if (NULL == engine || NULL == ik || EID_EXPONENT_MAX < exponent) {
+        return -EINVAL;
+    }
+
+    if (INT32_MAX <= engine->count) {
+        return -ENOSPC;
+    }
+
+    if (engine->count == engine->size) {
+
+        size = engine->size ? engine->size * 2 : 16;
+        key = realloc(engine->key, size * sizeof(eid_key_t));
+        if (NULL == key) {
+            return -ENOMEM;
+        }
+
+        engine->key = key;
+        engine->size = size;
+    }
+
+    key = &engine->key[engine->count];
+    memset(key, 0, sizeof(eid_key_t));
+
+    /* Identity key is expanded once for the lifetime of beacon */
+    aes128_expand(&key->identity, ik);
+    key->exponent = exponent;
+    key->clock = clock;
+    key->user_data = user_data;
+
+    return (int) engine->count++;
+}
+
+/* Move resolver to time now */
+int eid_engine_update(
+    struct eid_engine  *engine,
+    const uint32_t      now) {
+
+    eid_batch_t batch;
+    eid_key_t *key;
+    uint32_t period;
+    uint16_t epoch;
+    int computed = 0, rebuild;
+
+    if (NULL == engine) {
+        return -EINVAL;
+    }
+
+    batch.count = 0;
+
+    /* Index is patched in place unless beacons were added beyond its load */
+    rebuild = NULL == engine->index || engine->count * EID_WINDOW * 2 > engine->mask + 1;
+
+    for (size_t k = 0; engine->count > k; ++k) {
+
+        key = &engine->key[k];
+        period = (key->clock + now) >> key->exponent;
+
+        if (key->valid && period == key->period) {
+            continue;
+        }
+
+        /* Temporary key changes every 2^16 s only */
+        epoch = (uint16_t) ((period << key->exponent) >> 16);
+        if (!key->has_tk || epoch != key->tk_epoch) {
+            eid_temporary(&key->identity, epoch, &key->temporary);
+            key->tk_epoch = epoch;
+            key->has_tk = 1;
+        }
+
+        /* Window slides by one period, two EIDs are reused */
+        if (key->valid && period == key->period + 1) {
+            if (!rebuild) {
+                eid_index_remove(engine, key->eid[0], (uint32_t) k);
+            }
+            key->eid[0] = key->eid[1];
+            key->eid[1] = key->eid[2];
+            eid_batch_add(&batch, key, (period + 1) << key->exponent, &key->eid[2]);
+            key->pending = 1 << 2;
+            computed += 1;
+        } else if (key->valid && period + 1 == key->period) {
+            if (!rebuild) {
+                eid_index_remove(engine, key->eid[2], (uint32_t) k);
+            }
+            key->eid[2] = key->eid[1];
+            key->eid[1] = key->eid[0];
+            eid_batch_add(&batch, key, (period - 1) << key->exponent, &key->eid[0]);
+            key->pending = 1 << 0;
+            computed += 1;
+        } else {
+            for (uint32_t w = 0; EID_WINDOW > w; ++w) {
+                if (key->valid && !rebuild) {
+                    eid_index_remove(engine, key->eid[w], (uint32_t) k);
+                }
+                eid_batch_add(&batch, key, (period + w - 1) << key->exponent, &key->eid[w]);
+            }
+            key->pending = (1 << EID_WINDOW) - 1;
+            computed += EID_WINDOW;
+        }
+
+        key->period = period;
+        key->valid = 1;
+    }
+
+    if (0 == computed) {
+        return 0;
+    }
+
+    eid_batch_flush(&batch);
+
+    if (rebuild) {
+        return (EXIT_SUCCESS == eid_index_rebuild(engine)) ? computed : -ENOMEM;
+    }
+
+    /* Only EIDs of rolled beacons go in */
+    for (size_t k = 0; engine->count > k; ++k) {
+
+        key = &engine->key[k];
+
+        for (uint32_t w = 0; 0 != key->pending; ++w) {
+            if (key->pending & (1 << w)) {
+                eid_index_insert(engine, key->eid[w], (uint32_t) k);
+                key->pending &= (uint8_t) ~(1 << w);
+            }
+        }
+    }
+
+    return computed;
+}
+
+/* Resolve EID */
+int eid_engine_lookup(
+    const struct eid_engine    *engine,
+    const uint8_t               eid[EID_SIZE],
+    void                      **user_data) {
+
+    uint64_t value;
+
+    if (NULL == engine || NULL == engine->index) {
+        return -ENOENT;
+    }
+
+    memcpy(&value, eid, EID_SIZE);
+
+    for (size_t i = value & engine->mask; EID_EMPTY != engine->index[i].key; i = (i + 1) & engine->mask) {
+
+        if (value == engine->index[i].eid) {
+
+            if (NULL != user_data) {
+                *user_data = engine->key[engine->index[i].key].user_data;
+            }
+
+            return (int) engine->index[i].key;
+        }
+    }
+
+    return -ENOENT;
+}
+
+/* Number of beacons */
+size_t eid_engine_count(
+    const struct eid_engine    *engine) {
+    return (NULL != engine) ? engine->count : 0;
+}
+
+ /* End of file */
@@ -0,0 +1,581 @@
+/*!
+ *	\file		emulator.c
+ *	\brief		HCI controller emulator for hardware-free testing
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/emulator.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+
+#include "loop_private.h"
+
+/* Status of commands nobody implements */
+#define EMULATOR_UNKNOWN_COMMAND    0x01
+
+/* Report layout: type, address type, address, length, data, RSSI */
+#define EMULATOR_DATA_SIZE          30
+#define EMULATOR_REPORT_SIZE        (9 + EMULATOR_DATA_SIZE + 1)
+#define EMULATOR_MAJOR              (9 + 25)
+#define EMULATOR_RSSI               (9 + EMULATOR_DATA_SIZE)
+
+/* Longest reply: Command Complete of Read Local Version */
+#define EMULATOR_REPLY_SIZE         (1 + BT_HCI_EVENT_HDR_SIZE + 3 + 9)
+
+/* Command completion on its way */
+typedef struct {
+    uint64_t            due;                /* Send time, ns */
+    uint8_t             size;               /* Packet size */
+    uint8_t             packet[EMULATOR_REPLY_SIZE];    /* Command Complete */
+} emulator_reply_t;
+
+/* Controller */
+struct emulator {
+    struct loop        *loop;               /* Loop */
+    int                 sd[2];              /* Controller end, host end */
+    emulator_config_t   config;             /* Set up */
+    int                 scanning;           /* Scan enabled */
+    int                 advertising;        /* Advertising enabled */
+    uint32_t            adv_sets;           /* Extended advertising sets enabled, bit per handle */
+    uint32_t            events;             /* Epoll mask in use */
+
+    /* Replies in order of arrival, also the commands holding a credit */
+    emulator_reply_t    reply[EMULATOR_MAX_PENDING];
+    size_t              head;               /* Oldest reply */
+    size_t              pending;            /* Replies queued */
+    int                 reply_timer;        /* Latency timer */
+
+    /* Reports */
+    int                 report_timer;       /* Rate timer, 0 when not running */
+    uint64_t            start;              /* Scan start, ns */
+    uint64_t            sent;               /* Reports since scan start */
+    uint32_t            device;             /* Next advertiser */
+    size_t              event_size;         /* Event size */
+    uint8_t             event[BT_HCI_MAX_PACKET_SIZE];  /* Event template */
+
+    emulator_stats_t    stats;              /* Counters */
+};
+
+/* iBeacon advertising data, major and minor patched per report */
+static const uint8_t emulator_data[EMULATOR_DATA_SIZE] = {
+    0x02, 0x01, 0x06, 0x1a, 0xff, 0x4c, 0x00, 0x02, 0x15,
+    0xe2, 0xc5, 0x6d, 0xb5, 0xdf, 0xfb, 0x48, 0xd2,
+    0xb0, 0x60, 0xd0, 0xf5, 0xa7, 0x10, 0x96, 0xe0,
+    0x00, 0x00, 0x00, 0x00, 0xc5
+};
+
+/* Change epoll mask when needed */
+static inline void emulator_watch(
+    struct emulator    *emulator,
+    const uint32_t      events) {
+
+    if (emulator->events != events) {
+        emulator->events = events;
+        loop_modify_sd_in(emulator->loop, emulator->sd[0], events);
+    }
+}
+
+/* Next report event: advertisers take turns, RSSI wanders */
+static void emulator_fill(
+    struct emulator    *emulator) {
+
+    uint8_t *report = emulator->event + 5;
+    uint32_t device;
+
+    for (size_t i = 0; emulator->config.per_event > i; ++i, report += EMULATOR_REPORT_SIZE) {
+
+        device = emulator->device;
+        emulator->device = (device + 1 == emulator->config.devices) ? 0 : device + 1;
+
+        report[2] = (uint8_t) device;
+        report[3] = (uint8_t) (device >> 8);
+        report[4] = (uint8_t) (device >> 16);
+        report[EMULATOR_MAJOR] = (uint8_t) (device >> 24);
+        report[EMULATOR_MAJOR + 1] = (uint8_t) (device >> 16);
+        report[EMULATOR_MAJOR + 2] = (uint8_t) (device >> 8);
+        report[EMULATOR_MAJOR + 3] = (uint8_t) device;
+        report[EMULATOR_RSSI] = (uint8_t) (-40 - (int) ((emulator->sent + i) % 50));
+    }
+}
+
+/* Write due replies, then reports. Returns when done or socket is full */
+static void emulator_flush(
+    struct emulator    *emulator) {
+
+    emulator_reply_t *reply;
+    struct timespec ts;
+    uint64_t now = clock_ns(), due;
+
+    /* Completions go first, the host waits for them */
+    while (0 != emulator->pending) {
+
+        reply = &emulator->reply[emulator->head];
+
+        if (reply->due > now) {
+            ts.tv_sec = (time_t) ((reply->due - now) / 1000000000ULL);
+            ts.tv_nsec = (long) ((reply->due - now) % 1000000000ULL);
+            modify_timer_in(emulator->loop, emulator->reply_timer, &ts);
+            break;
+        }
+
+        /* Credits free once this command leaves the buffer */
+        reply->packet[3] = (emulator->config.credits >= emulator->pending)
+            ? (uint8_t) (emulator->config.credits - emulator->pending + 1) : 0;
+
+        if (0 > write(emulator->sd[0], reply->packet, reply->size)) {
+            if (EAGAIN == errno || EWOULDBLOCK == errno) {
+                emulator->stats.stalls++;
+                emulator_watch(emulator, EPOLLIN | EPOLLOUT);
+            }
+            return;
+        }
+
+        emulator->head = (emulator->head + 1) % EMULATOR_MAX_PENDING;
+        emulator->pending--;
+    }
+
+    if (!emulator->scanning) {
+        emulator_watch(emulator, EPOLLIN);
+        return;
+    }
+
+    /* Unlimited rate keeps the socket full */
+    due = (0 == emulator->config.rate) ? UINT64_MAX
+        : (uint64_t) ((double) (now - emulator->start) * emulator->config.rate / 1e9);
+
+    while (emulator->sent < due) {
+
+        emulator_fill(emulator);
+
+        if (0 > write(emulator->sd[0], emulator->event, emulator->event_size)) {
+            if (EAGAIN == errno || EWOULDBLOCK == errno) {
+                emulator->stats.stalls++;
+                emulator_watch(emulator, EPOLLIN | EPOLLOUT);
+            }
+            return;
+        }
+
+        emulator->sent += emulator->config.per_event;
+        emulator->stats.events++;
+        emulator->stats.reports += emulator->config.per_event;
+    }
+
+    emulator_watch(emulator, EPOLLIN);
+}
+
+/* Queue Command Complete */
+static void emulator_reply(
+    struct emulator    *emulator,
+    const uint8_t      *command,
+    const uint8_t      *param,
+    const uint8_t       length) {
+
+    emulator_reply_t *reply;
+
+    if (EMULATOR_MAX_PENDING == emulator->pending) {
+        emulator->stats.overruns++;
+        return;
+    }
+
+    reply = &emulator->reply[(emulator->head + emulator->pending++) % EMULATOR_MAX_PENDING];
+    reply->due = clock_ns() + (uint64_t) emulator->config.latency * 1000;
+    reply->size = (uint8_t) (1 + BT_HCI_EVENT_HDR_SIZE + 3 + length);
+    reply->packet[0] = BT_HCI_EVENT_PKT;
+    reply->packet[1] = BT_HCI_EVT_CMD_COMPLETE;
+    reply->packet[2] = (uint8_t) (3 + length);
+    reply->packet[4] = command[1];
+    reply->packet[5] = command[2];
+    memcpy(reply->packet + 6, param, length);
+}
+
+/* Run extended advertising command, returns HCI status */
+static uint8_t emulator_ext_advertising(
+    struct emulator    *emulator,
+    const uint16_t      opcode,
+    const uint8_t      *param,
+    const uint8_t       length) {
+
+    const uint8_t sets = emulator->config.sets;
+
+    switch (opcode) {
+
+        /* Handle, properties, intervals, addresses, PHYs, SID */
+        case BT_HCI_CMD_LE_SET_EXT_ADV_PARAMS:
+            return (25 > length || sets <= param[0]) ? BT_HCI_ERR_UNSPECIFIED : BT_HCI_SUCCESS;
+
+        /* Handle, operation, fragment preference, length, data */
+        case BT_HCI_CMD_LE_SET_EXT_ADV_DATA:
+            if (4 > length || sets <= param[0] || 4 + (size_t) param[3] > length) {
+                return BT_HCI_ERR_UNSPECIFIED;
+            }
+            emulator->stats.adv_data++;
+            return BT_HCI_SUCCESS;
+
+        /* Enable, number of sets, then handle, duration, maximal events per set */
+        case BT_HCI_CMD_LE_SET_EXT_ADV_ENABLE:
+            if (2 > length || 2 + (size_t) param[1] * 4 > length) {
+                return BT_HCI_ERR_UNSPECIFIED;
+            }
+
+            /* Disabling with no sets stops every set */
+            if (0 == param[1]) {
+                if (param[0]) {
+                    return BT_HCI_ERR_UNSPECIFIED;
+                }
+                emulator->adv_sets = 0;
+                return BT_HCI_SUCCESS;
+            }
+
+            for (size_t i = 0; param[1] > i; ++i) {
+                if (sets <= param[2 + i * 4]) {
+                    return BT_HCI_ERR_UNSPECIFIED;
+                }
+            }
+
+            for (size_t i = 0; param[1] > i; ++i) {
+                if (param[0]) {
+                    emulator->adv_sets |= 1U << param[2 + i * 4];
+                } else {
+                    emulator->adv_sets &= ~(1U << param[2 + i * 4]);
+                }
+            }
+            return BT_HCI_SUCCESS;
+
+        default:
+            return EMULATOR_UNKNOWN_COMMAND;
+    }
+}
+
+/* Run command */
+static void emulator_command(
+    struct emulator    *emulator,
+    const uint8_t      *command,
+    const size_t        size) {
+
+    const uint8_t version[9] = {
+        BT_HCI_SUCCESS, EMULATOR_HCI_VERSION, 0x00, 0x00, EMULATOR_HCI_VERSION,
+        (uint8_t) EMULATOR_MANUFACTURER, (uint8_t) (EMULATOR_MANUFACTURER >> 8), 0x00, 0x00
+    };
+    uint8_t features[9] = { BT_HCI_SUCCESS };
+    uint8_t reply[2] = { BT_HCI_SUCCESS };
+    uint8_t status = BT_HCI_SUCCESS;
+    uint16_t opcode;
+
+    if (1 + BT_HCI_COMMAND_HDR_SIZE > size || BT_HCI_COMMAND_PKT != command[0]
+        || 1 + BT_HCI_COMMAND_HDR_SIZE + (size_t) command[3] > size) {
+        return;
+    }
+
+    emulator->stats.commands++;
+    if (emulator->pending >= emulator->config.credits) {
+        emulator->stats.overruns++;
+    }
+
+    opcode = (uint16_t) (command[1] | (command[2] << 8));
+
+    switch (opcode) {
+
+        case BT_HCI_CMD_READ_LOCAL_VERSION:
+            emulator_reply(emulator, command, version, sizeof(version));
+            return;
+
+        case BT_HCI_CMD_LE_READ_LOCAL_FEATURES:
+            if (0 != emulator->config.sets) {
+                features[1 + BT_HCI_LE_FEATURE_EXT_ADV / 8] |= 1 << (BT_HCI_LE_FEATURE_EXT_ADV % 8);
+            }
+            emulator_reply(emulator, command, features, sizeof(features));
+            return;
+
+        case BT_HCI_CMD_RESET:
+            emulator_set_scanning(emulator, 0);
+            emulator->advertising = 0;
+            emulator->adv_sets = 0;
+            break;
+
+        case BT_HCI_CMD_LE_SET_SCAN_ENABLE:
+            if (1 > command[3]) {
+                status = BT_HCI_ERR_UNSPECIFIED;
+                break;
+            }
+            emulator_set_scanning(emulator, 0 != command[4]);
+            break;
+
+        case BT_HCI_CMD_LE_SET_ADV_ENABLE:
+            if (1 > command[3]) {
+                status = BT_HCI_ERR_UNSPECIFIED;
+                break;
+            }
+            emulator->advertising = (0 != command[4]);
+            break;
+
+        case BT_HCI_CMD_LE_SET_ADV_DATA:
+            emulator->stats.adv_data++;
+            break;
+
+        case BT_HCI_CMD_NOP:
+        case BT_HCI_CMD_LE_SET_ADV_PARAMETERS:
+        case BT_HCI_CMD_LE_SET_SCAN_PARAMETERS:
+            break;
+
+        /* Only controllers configured with sets know these */
+        case BT_HCI_CMD_LE_READ_NUM_ADV_SETS:
+        case BT_HCI_CMD_LE_SET_EXT_ADV_PARAMS:
+        case BT_HCI_CMD_LE_SET_EXT_ADV_DATA:
+        case BT_HCI_CMD_LE_SET_EXT_ADV_ENABLE:
+            if (0 == emulator->config.sets) {
+                emulator->stats.unknown++;
+                status = EMULATOR_UNKNOWN_COMMAND;
+                break;
+            }
+
+            if (BT_HCI_CMD_LE_READ_NUM_ADV_SETS == opcode) {
+                reply[1] = emulator->config.sets;
+                emulator_reply(emulator, command, reply, sizeof(reply));
+                return;
+            }
+
+            status = emulator_ext_advertising(emulator, opcode, command + 4, command[3]);
+
+            /* Status and selected TX power */
+            if (BT_HCI_CMD_LE_SET_EXT_ADV_PARAMS == opcode) {
+                reply[0] = status;
+                emulator_reply(emulator, command, reply, sizeof(reply));
+                return;
+            }
+            break;
+
+        default:
+            emulator->stats.unknown++;
+            status = EMULATOR_UNKNOWN_COMMAND;
+            break;
+    }
+
+    emulator_reply(emulator, command, &status, 1);
+}
+
+/* Controller end of socket pair */
+static void emulator_event(
+    int                 sd,
+    uint32_t            event_mask,
+    void               *user_data) {
+
+    struct emulator *emulator = user_data;
+    uint8_t packet[BT_HCI_MAX_PACKET_SIZE];
+    ssize_t result;
+
+    if (event_mask & EPOLLIN) {
+        while (0 < (result = read(sd, packet, sizeof(packet)))) {
+            emulator_command(emulator, packet, (size_t) result);
+        }
+    }
+
+    emulator_flush(emulator);
+}
+
+/* Latency or rate timer */
+static void emulator_timer(
+    int                 id,
+    void               *user_data) {
+    emulator_flush(user_data);
+}
+
+/* Rate timer */
+static void emulator_tick(
+    int                 id,
+    uint64_t            expired,
+    void               *user_data) {
+    emulator_flush(user_data);
+}
+
+/* Fill config with defaults */
+void emulator_config_init(
+    emulator_config_t      *config) {
+
+    memset(config, 0, sizeof(emulator_config_t));
+    config->credits = EMULATOR_DEFAULT_CREDITS;
+    config->per_event = 1;
+    config->devices = EMULATOR_DEFAULT_DEVICES;
+}
+
+/* Create controller */
+struct emulator *emulator_new_in(
+    struct loop                *loop,
+    const emulator_config_t    *config) {
+
+    struct emulator *emulator;
+    struct timespec ts = { 0, 0 };
+    uint8_t *report;
+
+    if (NULL == loop || NULL == config || 0 == config->credits || 0 == config->devices
+        || 0 == config->per_event || EMULATOR_MAX_PER_EVENT < config->per_event
+        || EMULATOR_MAX_SETS < config->sets) {
+        return NULL;
+    }
+
+    emulator = calloc(1, sizeof(struct emulator));
+    if (NULL == emulator) {
+        return NULL;
+    }
+
+    emulator->loop = loop;
+    emulator->config = *config;
+    emulator->events = EPOLLIN;
+
+    /* Fixed part of every report event */
+    emulator->event[0] = BT_HCI_EVENT_PKT;
+    emulator->event[1] = BT_HCI_EVT_LE_META;
+    emulator->event[2] = (uint8_t) (2 + config->per_event * EMULATOR_REPORT_SIZE);
+    emulator->event[3] = BT_HCI_EVT_LE_ADV_REPORT;
+    emulator->event[4] = config->per_event;
+    emulator->event_size = 3 + emulator->event[2];
+
+    for (size_t i = 0; config->per_event > i; ++i) {
+        report = emulator->event + 5 + i * EMULATOR_REPORT_SIZE;
+        report[0] = 0x03;                   /* ADV_NONCONN_IND */
+        report[1] = 0x01;                   /* Random address */
+        report[5] = 0x00;
+        report[6] = 0x00;
+        report[7] = 0xc0;                   /* Static random */
+        report[8] = EMULATOR_DATA_SIZE;
+        memcpy(report + 9, emulator_data, EMULATOR_DATA_SIZE);
+    }
+
+    if (0 > socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, emulator->sd)) {
+        free(emulator);
+        return NULL;
+    }
+
+    if (0 != loop_add_sd_in(loop, emulator->sd[0], EPOLLIN, emulator_event, emulator, NULL)) {
+        close(emulator->sd[0]);
+        close(emulator->sd[1]);
+        free(emulator);
+        return NULL;
+    }
+
+    /* Latency timer stays idle until a reply waits */
+    emulator->reply_timer = create_timer_in(loop, &ts, emulator_timer, emulator, NULL);
+    if (0 >= emulator->reply_timer || EXIT_SUCCESS != cancel_timer_in(loop, emulator->reply_timer)) {
+        emulator_free(emulator);
+        return NULL;
+    }
+
+    return emulator;
+}
+
+/* Create controller in default loop */
+struct emulator *emulator_new(
+    const emulator_config_t    *config) {
+    return emulator_new_in(loop_default(), config);
+}
+
+/* Destroy controller */
+void emulator_free(
+    struct emulator    *emulator) {
+
+    if (NULL == emulator) {
+        return;
+    }
+
+    if (0 < emulator->report_timer) {
+        destroy_timer_in(emulator->loop, emulator->report_timer);
+    }
+
+    if (0 < emulator->reply_timer) {
+        destroy_timer_in(emulator->loop, emulator->reply_timer);
+    }
+
+    loop_remove_sd_in(emulator->loop, emulator->sd[0]);
+    close(emulator->sd[0]);
+    close(emulator->sd[1]);
+    free(emulator);
+}
+
+/* Host end of socket pair */
+int emulator_get_descriptor(
+    struct emulator    *emulator) {
+    return (NULL != emulator) ? emulator->sd[1] : -EINVAL;
+}
+
+/* Start or stop reports */
+int emulator_set_scanning(
+    struct emulator    *emulator,
+    const int           enable) {
+
+    struct timespec tick = { 0, __TIMER_WHEEL_TICK_USEC * 1000 };
+
+    if (NULL == emulator) {
+        return -EINVAL;
+    }
+
+    if (!enable) {
+        if (0 < emulator->report_timer) {
+            destroy_timer_in(emulator->loop, emulator->report_timer);
+            emulator->report_timer = 0;
+        }
+        emulator->scanning = 0;
+        return EXIT_SUCCESS;
+    }
+
+    if (emulator->scanning) {
+        return EXIT_SUCCESS;
+    }
+
+    /* Paced reports are topped up every wheel tick */
+    if (0 != emulator->config.rate) {
+        emulator->report_timer = create_periodic_timer_in(emulator->loop, &tick, emulator_tick, emulator, NULL);
+        if (0 >= emulator->report_timer) {
+            emulator->report_timer = 0;
+            return -EIO;
+        }
+    }
+
+    emulator->scanning = 1;
+    emulator->start = clock_ns();
+    emulator->sent = 0;
+
+    emulator_watch(emulator, EPOLLIN | EPOLLOUT);
+
+    return EXIT_SUCCESS;
+}
+
+/* Scanning is enabled */
+int emulator_is_scanning(
+    struct emulator    *emulator) {
+    return (NULL != emulator) && emulator->scanning;
+}
+
+/* Advertising is enabled */
+int emulator_is_advertising(
+    struct emulator    *emulator) {
+    return (NULL != emulator) && (emulator->advertising || 0 != emulator->adv_sets);
+}
+
+/* Get counters */
+int emulator_get_stats(
+    struct emulator    *emulator,
+    emulator_stats_t   *stats) {
+
+    if (NULL == emulator || NULL == stats) {
+        return -EINVAL;
+    }
+
+    *stats = emulator->stats;
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -0,0 +1,758 @@
+/*!
+ *	\file		fleet.c
+ *	\brief		Virtual beacon fleet, many identities time-sliced on one controller
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/fleet.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+#include "beaconizer/utility.h"
+
+#include "hci_batch.h"
+#include "loop_private.h"
+
+/* Interval limits in 0.625 ms units */
+#define FLEET_INTERVAL_MIN          0x0020
+#define FLEET_INTERVAL_MAX          0x4000
+
+/* Command parameters */
+#define FLEET_PARAMS_SIZE           15      /* LE Set Advertising Parameters */
+#define FLEET_EXT_PARAMS_SIZE       25      /* LE Set Extended Advertising Parameters */
+#define FLEET_EXT_DATA_HDR_SIZE     4       /* Handle, operation, fragment preference, length */
+#define FLEET_EXT_ENABLE_HDR_SIZE   2       /* Enable, number of sets */
+#define FLEET_EXT_ENABLE_SET_SIZE   4       /* Handle, duration, maximal events */
+
+/* Legacy ADV_NONCONN_IND on extended set */
+#define FLEET_EXT_PROPERTIES        0x0010
+
+/* Prebuilt command: parameters length, then parameters */
+#define FLEET_PDU_STRIDE            (1 + FLEET_EXT_DATA_HDR_SIZE + FLEET_MAX_DATA)
+
+/* Identities allocated first, table doubles after */
+#define FLEET_INITIAL               16
+
+/* States */
+#define FLEET_IDLE                  0
+#define FLEET_PROBING               1       /* Asking for extended advertising */
+#define FLEET_STARTING              2       /* Set up batch in flight */
+#define FLEET_RUNNING               3       /* Rotating */
+#define FLEET_STOPPING              4       /* Disable in flight */
+
+/* Identity as added */
+typedef struct {
+    uint8_t             length;         /* Data length */
+    uint8_t             data[FLEET_MAX_DATA];   /* AD structures */
+} fleet_identity_t;
+
+/* Advertising set rotating its share of identities */
+typedef struct {
+    struct fleet       *fleet;          /* Owner */
+    size_t              current;        /* Identity on air */
+    uint8_t             busy;           /* Switch in flight */
+    uint64_t            due;            /* Slot start of switch in flight, ns */
+} fleet_set_t;
+
+/* Fleet */
+struct fleet {
+    hci_batch_t         batch;          /* Set up and tear down commands, owner reference */
+    struct loop        *loop;           /* Loop */
+    fleet_config_t      config;         /* Set up */
+
+    /* Identities */
+    fleet_identity_t   *identity;       /* Identities */
+    size_t              count;          /* Identities added */
+    size_t              capacity;       /* Identities allocated */
+
+    /* Schedule */
+    uint8_t            *pdu;            /* Data command of every identity, FLEET_PDU_STRIDE each */
+    uint16_t            opcode;         /* Data command opcode */
+    uint8_t             sets;           /* Extended sets, 0 for legacy advertising */
+    size_t              lanes;          /* Identities on air at once */
+    fleet_set_t         set[FLEET_MAX_SETS];
+    int                 timer;          /* Slot timer, 0 when not running */
+    uint64_t            slot;           /* Slot, ns */
+    uint64_t            due;            /* Current slot start, ns */
+    uint64_t            start;          /* Rotation start, ns */
+    uint64_t            stop;           /* Rotation stop, ns */
+    double              sum;            /* Lateness sum, us */
+    double              squares;        /* Lateness squares sum, us^2 */
+
+    /* Set up and tear down */
+    int                 state;          /* FLEET_* */
+    uint8_t             pending;        /* Stop requested while setting up */
+
+    fleet_stats_t       stats;          /* Counters */
+
+    /* Start/stop completion */
+    fleet_fn_t          callback;
+    void               *user_data;
+};
+
+/* Last reference is gone */
+static void fleet_release(
+    void               *owner) {
+
+    struct fleet *fleet = owner;
+
+    free(fleet->identity);
+    free(fleet->pdu);
+    free(fleet);
+}
+
+/* Drop reference held by switch */
+static void fleet_set_unref(
+    void               *user_data) {
+
+    fleet_set_t *set = user_data;
+
+    hci_batch_unref(&set->fleet->batch);
+}
+
+/* Report settled state once */
+static void fleet_notify(
+    struct fleet       *fleet,
+    const int           status) {
+
+    fleet_fn_t callback = fleet->callback;
+
+    if (NULL == callback) {
+        return;
+    }
+
+    fleet->callback = NULL;
+    callback(fleet, status, fleet->user_data);
+}
+
+/* Enable or disable advertising, every set at once */
+static int fleet_send_enable(
+    struct fleet       *fleet,
+    const uint8_t       enable) {
+
+    uint8_t param[FLEET_EXT_ENABLE_HDR_SIZE + FLEET_MAX_SETS * FLEET_EXT_ENABLE_SET_SIZE];
+
+    if (0 == fleet->sets) {
+        return hci_batch_send_enable(&fleet->batch, BT_HCI_CMD_LE_SET_ADV_ENABLE, &enable, sizeof(enable), enable);
+    }
+
+    memset(param, 0, sizeof(param));
+    param[0] = enable;
+
+    /* No sets listed disables all of them */
+    if (!enable) {
+        return hci_batch_send_enable(&fleet->batch, BT_HCI_CMD_LE_SET_EXT_ADV_ENABLE, param,
+            FLEET_EXT_ENABLE_HDR_SIZE, enable);
+    }
+
+    /* Duration and maximal events are zero: run until disabled */
+    param[1] = fleet->sets;
+    for (uint8_t i = 0; fleet->sets > i; ++i) {
+        param[FLEET_EXT_ENABLE_HDR_SIZE + i * FLEET_EXT_ENABLE_SET_SIZE] = i;
+    }
+
+    return hci_batch_send_enable(&fleet->batch, BT_HCI_CMD_LE_SET_EXT_ADV_ENABLE, param,
+        (uint8_t) (FLEET_EXT_ENABLE_HDR_SIZE + fleet->sets * FLEET_EXT_ENABLE_SET_SIZE), enable);
+}
+
+/* Push advertising parameters of set */
+static int fleet_send_params(
+    struct fleet       *fleet,
+    const uint8_t       handle) {
+
+    const uint32_t interval = hci_interval(
+        fleet->config.interval < fleet->config.slot ? fleet->config.interval : fleet->config.slot,
+        FLEET_INTERVAL_MIN, FLEET_INTERVAL_MAX);
+    uint8_t param[FLEET_EXT_PARAMS_SIZE];
+
+    memset(param, 0, sizeof(param));
+
+    if (0 == fleet->sets) {
+        put_le16((uint16_t) interval, param);
+        put_le16((uint16_t) interval, param + 2);
+        param[4] = 0x03;    /* ADV_NONCONN_IND */
+        /* Own and peer address types and peer address are zero */
+        param[13] = 0x07;   /* All channels */
+        param[14] = 0x00;   /* No white list filter */
+
+        return hci_batch_send(&fleet->batch, BT_HCI_CMD_LE_SET_ADV_PARAMETERS, param, FLEET_PARAMS_SIZE);
+    }
+
+    param[0] = handle;
+    put_le16(FLEET_EXT_PROPERTIES, param + 1);
+    put_le24(interval, param + 3);
+    put_le24(interval, param + 6);
+    param[9] = 0x07;    /* All channels */
+    /* Public address, no peer, no filter */
+    param[19] = 0x7f;   /* No TX power preference */
+    param[20] = 0x01;   /* LE 1M primary PHY */
+    param[22] = 0x01;   /* LE 1M secondary PHY */
+    param[23] = handle; /* SID */
+
+    return hci_batch_send(&fleet->batch, BT_HCI_CMD_LE_SET_EXT_ADV_PARAMS, param, FLEET_EXT_PARAMS_SIZE);
+}
+
+/* Build data command of every identity, set handle included */
+static int fleet_build(
+    struct fleet       *fleet) {
+
+    uint8_t *pdu;
+
+    free(fleet->pdu);
+    fleet->pdu = malloc(fleet->count * FLEET_PDU_STRIDE);
+    if (NULL == fleet->pdu) {
+        return -ENOMEM;
+    }
+
+    for (size_t i = 0; fleet->count > i; ++i) {
+
+        pdu = fleet->pdu + i * FLEET_PDU_STRIDE;
+        memset(pdu, 0, FLEET_PDU_STRIDE);
+
+        /* Legacy data command has fixed length */
+        if (0 == fleet->sets) {
+            pdu[0] = 1 + FLEET_MAX_DATA;
+            pdu[1] = fleet->identity[i].length;
+            memcpy(pdu + 2, fleet->identity[i].data, fleet->identity[i].length);
+            continue;
+        }
+
+        pdu[0] = (uint8_t) (FLEET_EXT_DATA_HDR_SIZE + fleet->identity[i].length);
+        pdu[1] = (uint8_t) (i % fleet->sets);   /* Handle */
+        pdu[2] = 0x03;                          /* Complete data */
+        pdu[3] = 0x01;                          /* No fragmentation */
+        pdu[4] = fleet->identity[i].length;
+        memcpy(pdu + 5, fleet->identity[i].data, fleet->identity[i].length);
+    }
+
+    fleet->opcode = fleet->sets ? BT_HCI_CMD_LE_SET_EXT_ADV_DATA : BT_HCI_CMD_LE_SET_ADV_DATA;
+
+    return EXIT_SUCCESS;
+}
+
+/* Identity switch completion */
+static void fleet_switched(
+    uint16_t            opcode,
+    int                 status,
+    const uint8_t      *param,
+    uint8_t             length,
+    void               *user_data) {
+
+    fleet_set_t *set = user_data;
+    struct fleet *fleet = set->fleet;
+    uint64_t lateness;
+
+    set->busy = 0;
+
+    if (fleet->batch.released) {
+        return;
+    }
+
+    if (BT_HCI_SUCCESS != status) {
+        fleet->stats.failures++;
+        return;
+    }
+
+    lateness = (clock_ns() - set->due) / 1000;
+
+    fleet->stats.rotations++;
+    fleet->sum += (double) lateness;
+    fleet->squares += (double) lateness * (double) lateness;
+    if (fleet->stats.lateness_max < lateness) {
+        fleet->stats.lateness_max = lateness;
+    }
+}
+
+/* Slot start: every set moves to its next identity */
+static void fleet_tick(
+    int                 id,
+    uint64_t            expired,
+    void               *user_data) {
+
+    struct fleet *fleet = user_data;
+    fleet_set_t *set;
+    const uint8_t *pdu;
+    size_t next;
+
+    /* Slots missed while loop was busy */
+    fleet->due += expired * fleet->slot;
+    if (1 < expired) {
+        fleet->stats.overruns += (expired - 1) * fleet->lanes;
+    }
+
+    for (size_t i = 0; fleet->lanes > i; ++i) {
+
+        set = &fleet->set[i];
+
+        if (set->busy) {
+            fleet->stats.overruns++;
+            continue;
+        }
+
+        /* Set owns every lanes-th identity */
+        next = set->current + fleet->lanes;
+        if (fleet->count <= next) {
+            next = i;
+        }
+
+        if (next == set->current) {
+            continue;
+        }
+
+        pdu = fleet->pdu + next * FLEET_PDU_STRIDE;
+
+        set->current = next;
+        set->due = fleet->due;
+        set->busy = 1;
+        hci_batch_ref(&fleet->batch);
+
+        if (0 > hci_channel_send(fleet->batch.hci, fleet->opcode, pdu + 1, pdu[0],
+                fleet_switched, set, fleet_set_unref)) {
+            set->busy = 0;
+            hci_batch_unref(&fleet->batch);
+            fleet->stats.failures++;
+        }
+    }
+}
+
+/* Advertising is up, start slot timer */
+static int fleet_run(
+    struct fleet       *fleet) {
+
+    struct timespec period = {
+        .tv_sec = fleet->config.slot / 1000,
+        .tv_nsec = (long) (fleet->config.slot % 1000) * 1000000L
+    };
+    int id;
+
+    fleet->slot = (uint64_t) fleet->config.slot * 1000000ULL;
+    fleet->start = clock_ns();
+    fleet->due = fleet->start;
+
+    /* Single identity has nothing to rotate */
+    if (fleet->lanes == fleet->count) {
+        fleet->state = FLEET_RUNNING;
+        return EXIT_SUCCESS;
+    }
+
+    id = create_precise_periodic_timer_in(fleet->loop, &period, fleet_tick, fleet, NULL);
+    if (0 > id) {
+        return id;
+    }
+
+    fleet->timer = id;
+    fleet->state = FLEET_RUNNING;
+
+    return EXIT_SUCCESS;
+}
+
+/* Disable advertising, notify once it is off */
+static void fleet_teardown(
+    struct fleet       *fleet) {
+
+    int result;
+
+    if (0 != fleet->timer) {
+        destroy_timer_in(fleet->loop, fleet->timer);
+        fleet->timer = 0;
+    }
+
+    fleet->stop = clock_ns();
+    fleet->state = FLEET_STOPPING;
+
+    result = fleet_send_enable(fleet, 0);
+    if (0 > result) {
+        hci_batch_fail(&fleet->batch, result);
+        fleet->state = FLEET_IDLE;
+        fleet_notify(fleet, fleet->batch.status);
+    }
+}
+
+/* Send set up batch: parameters and first identity of every set, then enable.
+ * None depends on result of another, channel pipelines them */
+static void fleet_setup(
+    struct fleet       *fleet,
+    const uint8_t       sets) {
+
+    const uint8_t *pdu;
+    int result;
+
+    fleet->sets = sets;
+    fleet->lanes = sets ? sets : 1;
+    fleet->stats.sets = sets;
+    fleet->state = FLEET_STARTING;
+
+    result = fleet_build(fleet);
+
+    for (size_t i = 0; fleet->lanes > i && 0 <= result; ++i) {
+
+        pdu = fleet->pdu + i * FLEET_PDU_STRIDE;
+
+        fleet->set[i].fleet = fleet;
+        fleet->set[i].current = i;
+        fleet->set[i].busy = 0;
+
+        result = fleet_send_params(fleet, (uint8_t) i);
+        if (0 <= result) {
+            result = hci_batch_send(&fleet->batch, fleet->opcode, pdu + 1, pdu[0]);
+        }
+    }
+
+    if (0 <= result) {
+        result = fleet_send_enable(fleet, 1);
+    }
+
+    if (0 > result) {
+        hci_batch_fail(&fleet->batch, result);
+    }
+
+    /* Nothing could be sent */
+    if (0 == fleet->batch.busy) {
+        fleet->state = FLEET_IDLE;
+        fleet_notify(fleet, fleet->batch.status);
+    }
+}
+
+/* Extended advertising probe: features first, then number of sets */
+static void fleet_probed(
+    struct fleet       *fleet,
+    const uint16_t      opcode,
+    const int           status,
+    const uint8_t      *param,
+    const uint8_t       length) {
+
+    const uint8_t bit = BT_HCI_LE_FEATURE_EXT_ADV;
+    size_t sets;
+
+    /* Anything but a clear yes keeps legacy advertising */
+    if (BT_HCI_SUCCESS != status) {
+        fleet_setup(fleet, 0);
+        return;
+    }
+
+    if (BT_HCI_CMD_LE_READ_LOCAL_FEATURES == opcode) {
+
+        if (9 > length || !(param[1 + bit / 8] & (1 << (bit % 8)))
+            || 0 > hci_batch_send(&fleet->batch, BT_HCI_CMD_LE_READ_NUM_ADV_SETS, NULL, 0)) {
+            fleet_setup(fleet, 0);
+        }
+        return;
+    }
+
+    sets = (2 > length) ? 0 : param[1];
+    if (fleet->config.sets < sets) {
+        sets = fleet->config.sets;
+    }
+    if (fleet->count < sets) {
+        sets = fleet->count;
+    }
+
+    fleet_setup(fleet, (uint8_t) sets);
+}
+
+/* Set up or tear down batch answered */
+static void fleet_settled(
+    void               *owner,
+    const uint16_t      opcode,
+    const int           status,
+    const uint8_t      *param,
+    const uint8_t       length) {
+
+    struct fleet *fleet = owner;
+    int result;
+
+    if (FLEET_PROBING == fleet->state) {
+
+        /* Refused probe only means legacy advertising */
+        hci_batch_take_status(&fleet->batch);
+
+        /* Nothing is on air yet */
+        if (fleet->pending) {
+            fleet->pending = 0;
+            fleet->state = FLEET_IDLE;
+            fleet_notify(fleet, BT_HCI_SUCCESS);
+            return;
+        }
+
+        fleet_probed(fleet, opcode, status, param, length);
+        return;
+    }
+
+    /* Stop came in while setting up: whatever batch enabled goes off */
+    if (FLEET_STARTING == fleet->state && fleet->pending) {
+
+        fleet->pending = 0;
+        hci_batch_take_status(&fleet->batch);
+
+        if (fleet->batch.enabled) {
+            fleet_teardown(fleet);
+            return;
+        }
+
+        fleet->state = FLEET_IDLE;
+        fleet_notify(fleet, BT_HCI_SUCCESS);
+        return;
+    }
+
+    if (FLEET_STARTING == fleet->state && BT_HCI_SUCCESS == fleet->batch.status) {
+
+        result = fleet_run(fleet);
+        if (EXIT_SUCCESS == result) {
+            fleet_notify(fleet, BT_HCI_SUCCESS);
+            return;
+        }
+
+        hci_batch_fail(&fleet->batch, result);
+    }
+
+    /* Enable went through ahead of failed command, roll it back */
+    if (FLEET_STARTING == fleet->state && fleet->batch.enabled) {
+        fleet_teardown(fleet);
+        return;
+    }
+
+    fleet->state = FLEET_IDLE;
+    fleet_notify(fleet, fleet->batch.status);
+}
+
+/* Batch hooks */
+static const hci_batch_ops_t fleet_ops = {
+    .release    = fleet_release,
+    .rejected   = NULL,
+    .settled    = fleet_settled
+};
+
+/* Fill config with defaults */
+void fleet_config_init(
+    fleet_config_t     *config) {
+
+    memset(config, 0, sizeof(fleet_config_t));
+    config->slot = FLEET_DEFAULT_SLOT;
+    config->interval = FLEET_DEFAULT_INTERVAL;
+}
+
+/* Create fleet */
+struct fleet *fleet_new_in(
+    struct loop            *loop,
+    struct hci_channel     *hci,
+    const fleet_config_t   *config) {
+
+    struct fleet *fleet;
+
+    if (NULL == loop || NULL == hci || NULL == config || 0 == config->slot
+        || FLEET_MAX_SETS < config->sets) {
+        return NULL;
+    }
+
+    fleet = calloc(1, sizeof(struct fleet));
+    if (NULL == fleet) {
+        return NULL;
+    }
+
+    hci_batch_init(&fleet->batch, hci, &fleet_ops, fleet);
+    fleet->loop = loop;
+    fleet->config = *config;
+    fleet->lanes = 1;
+
+    return fleet;
+}
+
+/* Create fleet in default loop */
+struct fleet *fleet_new(
+    struct hci_channel     *hci,
+    const fleet_config_t   *config) {
+    return fleet_new_in(loop_default(), hci, config);
+}
+
+/* Destroy fleet */
+void fleet_free(
+    struct fleet       *fleet) {
+
+    if (NULL == fleet) {
+        return;
+    }
+
+    if (0 != fleet->timer) {
+        destroy_timer_in(fleet->loop, fleet->timer);
+        fleet->timer = 0;
+    }
+
+    fleet->callback = NULL;
+
+    hci_batch_release(&fleet->batch);
+}
+
+/* Add identity */
+int fleet_add(
+    struct fleet       *fleet,
+    const uint8_t      *data,
+    const uint8_t       length) {
+
+    fleet_identity_t *identity;
+    size_t capacity;
+
+    if (NULL == fleet || FLEET_MAX_DATA < length || (0 != length && NULL == data)) {
+        return -EINVAL;
+    }
+
+    if (FLEET_IDLE != fleet->state) {
+        return -EBUSY;
+    }
+
+    if (fleet->capacity == fleet->count) {
+
+        capacity = fleet->capacity ? fleet->capacity * 2 : FLEET_INITIAL;
+        identity = realloc(fleet->identity, capacity * sizeof(fleet_identity_t));
+        if (NULL == identity) {
+            return -ENOMEM;
+        }
+
+        fleet->identity = identity;
+        fleet->capacity = capacity;
+    }
+
+    identity = &fleet->identity[fleet->count];
+    identity->length = length;
+    if (0 != length) {
+        memcpy(identity->data, data, length);
+    }
+
+    return (int) fleet->count++;
+}
+
+/* Identities added */
+size_t fleet_count(
+    struct fleet       *fleet) {
+    return (NULL == fleet) ? 0 : fleet->count;
+}
+
+/* Start rotating */
+int fleet_start(
+    struct fleet       *fleet,
+    fleet_fn_t          callback,
+    void               *user_data) {
+
+    int result;
+
+    if (NULL == fleet || 0 == fleet->count) {
+        return -EINVAL;
+    }
+
+    if (FLEET_IDLE != fleet->state) {
+        return -EBUSY;
+    }
+
+    fleet->callback = callback;
+    fleet->user_data = user_data;
+    fleet->batch.status = BT_HCI_SUCCESS;
+    fleet->pending = 0;
+    fleet->sum = 0;
+    fleet->squares = 0;
+    fleet->start = 0;
+    fleet->stop = 0;
+    memset(&fleet->stats, 0, sizeof(fleet_stats_t));
+
+    if (0 == fleet->config.sets) {
+        fleet_setup(fleet, 0);
+        return EXIT_SUCCESS;
+    }
+
+    /* Legacy and extended commands must not be mixed: ask before using any */
+    fleet->state = FLEET_PROBING;
+
+    result = hci_batch_send(&fleet->batch, BT_HCI_CMD_LE_READ_LOCAL_FEATURES, NULL, 0);
+    if (0 > result) {
+        fleet->state = FLEET_IDLE;
+        fleet->callback = NULL;
+        return result;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Stop rotating */
+int fleet_stop(
+    struct fleet       *fleet,
+    fleet_fn_t          callback,
+    void               *user_data) {
+
+    if (NULL == fleet) {
+        return -EINVAL;
+    }
+
+    if (FLEET_IDLE == fleet->state) {
+        if (NULL != callback) {
+            callback(fleet, BT_HCI_SUCCESS, user_data);
+        }
+        return EXIT_SUCCESS;
+    }
+
+    if (FLEET_STOPPING == fleet->state) {
+        return -EBUSY;
+    }
+
+    fleet->callback = callback;
+    fleet->user_data = user_data;
+
+    /* Set up batch settles first, start callback is dropped */
+    if (FLEET_RUNNING != fleet->state) {
+        fleet->pending = 1;
+        return EXIT_SUCCESS;
+    }
+
+    fleet->batch.status = BT_HCI_SUCCESS;
+
+    fleet_teardown(fleet);
+
+    return EXIT_SUCCESS;
+}
+
+/* Rotation state */
+int fleet_is_running(
+    struct fleet       *fleet) {
+    return (NULL != fleet) && FLEET_RUNNING == fleet->state;
+}
+
+/* Get counters */
+int fleet_get_stats(
+    struct fleet       *fleet,
+    fleet_stats_t      *stats) {
+
+    double mean, variance;
+    uint64_t stop;
+
+    if (NULL == fleet || NULL == stats) {
+        return -EINVAL;
+    }
+
+    *stats = fleet->stats;
+
+    if (0 != fleet->start) {
+        stop = (FLEET_RUNNING == fleet->state) ? clock_ns() : fleet->stop;
+        stats->elapsed = (stop - fleet->start) / 1000;
+    }
+
+    if (0 != stats->rotations) {
+        mean = fleet->sum / (double) stats->rotations;
+        variance = fleet->squares / (double) stats->rotations - mean * mean;
+        stats->lateness = (uint64_t) mean;
+        stats->jitter = (uint64_t) sqrt(0 < variance ? variance : 0);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
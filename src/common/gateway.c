@@ -0,0 +1,638 @@
+/*!
+ *	\file		gateway.c
+ *	\brief		Multi-adapter scanning, one loop thread per controller
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/gateway.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/scanner.h"
+
+/* Kernel HCI socket, same values as BlueZ headers */
+#define GATEWAY_AF_BLUETOOTH        31
+#define GATEWAY_BTPROTO_HCI         1
+#define GATEWAY_HCI_CHANNEL_RAW     0
+#define GATEWAY_HCIGETDEVLIST       _IOR('H', 210, int)
+#define GATEWAY_HCI_UP              0       /* Device flag bit */
+
+/* Queue limits */
+#define GATEWAY_MIN_QUEUE           16
+#define GATEWAY_MAX_QUEUE           (1U << 24)
+
+/* Producer and consumer counters live on own cache lines */
+#define GATEWAY_CACHE_LINE          64
+
+/* Kernel struct sockaddr_hci */
+typedef struct {
+    sa_family_t         family;
+    uint16_t            dev;
+    uint16_t            channel;
+} gateway_sockaddr_t;
+
+/* Kernel struct hci_dev_list_req */
+typedef struct {
+    uint16_t            dev_num;
+    struct {
+        uint16_t        dev_id;
+        uint32_t        dev_opt;
+    } dev_req[GATEWAY_MAX_ADAPTERS];
+} gateway_dev_list_t;
+
+/* Adapter thread with its report ring */
+typedef struct {
+    struct gateway     *gateway;        /* Owner */
+    gateway_adapter_t   adapter;        /* Set up */
+    uint8_t             number;         /* Position in adapter list */
+    struct loop        *loop;           /* Adapter loop */
+    pthread_t           thread;         /* Adapter thread */
+    int                 running;        /* Thread was started */
+    int                 wake;           /* eventfd() waking adapter thread to stop */
+    int                 stop;           /* Stop requested, written by owner thread */
+    int                 stopping;       /* Stop is under way, adapter thread only */
+    int                 fd;             /* HCI socket */
+    struct hci_channel *hci;            /* HCI channel */
+    struct scanner     *scanner;        /* Scanner */
+    gateway_report_t   *ring;           /* Single producer single consumer ring */
+    uint32_t            mask;           /* Ring size minus one */
+
+    /* Written by adapter thread, read anywhere */
+    int                 status;         /* Start up result */
+    int                 ready;          /* Start up settled */
+    uint8_t             version;        /* HCI version */
+
+    /* Producer side */
+    uint32_t            head __attribute__ ((aligned (GATEWAY_CACHE_LINE)));   /* Next slot to fill */
+    uint32_t            limit;          /* Head value meaning full as tail was seen last */
+    uint64_t            reports;        /* Reports queued */
+    uint64_t            drops;          /* Reports dropped */
+    uint64_t            oversize;       /* Reports too long for slot */
+
+    /* Consumer side */
+    uint32_t            tail __attribute__ ((aligned (GATEWAY_CACHE_LINE)));   /* Next slot to deliver */
+} gateway_port_t;
+
+/* Gateway */
+struct gateway {
+    struct loop        *loop;           /* Consumer loop */
+    gateway_config_t    config;         /* Set up */
+    gateway_fn_t        callback;       /* Report callback */
+    void               *user_data;      /* User data */
+    int                 fd;             /* eventfd() waking consumer */
+    int                 signalled;      /* Wake up is pending */
+    size_t              count;          /* Adapters */
+    gateway_port_t     *port;           /* Adapters */
+};
+
+/* Wake consumer unless wake up is already pending */
+static void gateway_wake(
+    struct gateway     *gateway) {
+
+    const uint64_t value = 1;
+
+    /* Pairs with fence in gateway_drain(): either consumer sees new head or
+     * producer sees flag cleared */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (0 != __atomic_load_n(&gateway->signalled, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    if (0 == __atomic_exchange_n(&gateway->signalled, 1, __ATOMIC_ACQ_REL)) {
+        if (sizeof(value) != write(gateway->fd, &value, sizeof(value))) {
+            __atomic_store_n(&gateway->signalled, 0, __ATOMIC_RELEASE);
+        }
+    }
+}
+
+/* Queue report, adapter thread */
+static void gateway_report(
+    const scanner_report_t *report,
+    void                   *user_data) {
+
+    gateway_port_t *port = user_data;
+    gateway_report_t *slot;
+
+    /* Cut AD structures would reach consumer as malformed data */
+    if (GATEWAY_MAX_DATA < report->length) {
+        __atomic_store_n(&port->oversize, port->oversize + 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    /* Consumer position is read only when ring looks full */
+    if (port->head == port->limit) {
+        port->limit = __atomic_load_n(&port->tail, __ATOMIC_ACQUIRE) + port->mask + 1;
+        if (port->head == port->limit) {
+            __atomic_store_n(&port->drops, port->drops + 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+
+    slot = &port->ring[port->head & port->mask];
+    slot->adapter = port->number;
+    slot->event_type = report->event_type;
+    slot->address_type = report->address_type;
+    slot->rssi = report->rssi;
+    memcpy(slot->address, report->address, sizeof(slot->address));
+    slot->length = (uint8_t) report->length;
+    memcpy(slot->data, report->data, slot->length);
+
+    __atomic_store_n(&port->head, port->head + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&port->reports, port->reports + 1, __ATOMIC_RELAXED);
+
+    gateway_wake(port->gateway);
+}
+
+/* Deliver queued reports, consumer loop */
+static void gateway_drain(
+    int                 sd,
+    uint32_t            event_mask,
+    void               *user_data) {
+
+    struct gateway *gateway = user_data;
+    gateway_port_t *port;
+    uint32_t tail, head;
+    uint64_t value;
+
+    if (sizeof(value) != read(sd, &value, sizeof(value)) && EAGAIN != errno) {
+        return;
+    }
+
+    __atomic_store_n(&gateway->signalled, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    for (size_t i = 0; gateway->count > i; ++i) {
+
+        port = &gateway->port[i];
+        tail = port->tail;
+        head = __atomic_load_n(&port->head, __ATOMIC_ACQUIRE);
+
+        while (tail != head) {
+            gateway->callback(&port->ring[tail & port->mask], gateway->user_data);
+            tail++;
+        }
+
+        /* Slots go back to producer in one store */
+        __atomic_store_n(&port->tail, tail, __ATOMIC_RELEASE);
+    }
+}
+
+/* Record start up result */
+static void gateway_settle(
+    gateway_port_t     *port,
+    const int           status) {
+
+    if (0 == __atomic_load_n(&port->ready, __ATOMIC_ACQUIRE)) {
+        __atomic_store_n(&port->status, status, __ATOMIC_RELAXED);
+        __atomic_store_n(&port->ready, 1, __ATOMIC_RELEASE);
+    }
+
+    if (BT_HCI_SUCCESS != status) {
+        loop_quit_in(port->loop);
+    }
+}
+
+/* Probe result */
+static void gateway_version(
+    uint16_t            opcode,
+    int                 status,
+    const uint8_t      *param,
+    uint8_t             length,
+    void               *user_data) {
+
+    gateway_port_t *port = user_data;
+
+    if (BT_HCI_SUCCESS != status || 2 > length) {
+        gateway_settle(port, (BT_HCI_SUCCESS != status) ? status : -EPROTO);
+        return;
+    }
+
+    __atomic_store_n(&port->version, param[1], __ATOMIC_RELAXED);
+}
+
+/* Scanning started */
+static void gateway_started(
+    struct scanner     *scanner,
+    int                 status,
+    void               *user_data) {
+    gateway_settle(user_data, status);
+}
+
+/* Scanning stopped */
+static void gateway_stopped(
+    struct scanner     *scanner,
+    int                 status,
+    void               *user_data) {
+
+    gateway_port_t *port = user_data;
+
+    loop_quit_in(port->loop);
+}
+
+/* Stop requested by gateway_free(). Wake up descriptor is allocated up front
+ * and only this thread touches its loop */
+static void gateway_stop(
+    int                 sd,
+    uint32_t            event_mask,
+    void               *user_data) {
+
+    gateway_port_t *port = user_data;
+    uint64_t value;
+
+    if (sizeof(value) != read(sd, &value, sizeof(value)) && EAGAIN != errno) {
+        return;
+    }
+
+    if (0 == __atomic_load_n(&port->stop, __ATOMIC_ACQUIRE) || port->stopping) {
+        return;
+    }
+
+    port->stopping = 1;
+
+    if (NULL == port->scanner || EXIT_SUCCESS != scanner_stop(port->scanner, gateway_stopped, port)) {
+        loop_quit_in(port->loop);
+    }
+}
+
+/* Open raw HCI socket */
+static int gateway_open(
+    const int           index) {
+
+    gateway_sockaddr_t addr;
+    int fd, result;
+
+    fd = socket(GATEWAY_AF_BLUETOOTH, SOCK_RAW | SOCK_CLOEXEC, GATEWAY_BTPROTO_HCI);
+    if (0 > fd) {
+        return -errno;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.family = GATEWAY_AF_BLUETOOTH;
+    addr.dev = (uint16_t) index;
+    addr.channel = GATEWAY_HCI_CHANNEL_RAW;
+
+    if (0 > bind(fd, (struct sockaddr *) &addr, sizeof(addr))) {
+        result = -errno;
+        close(fd);
+        return result;
+    }
+
+    return fd;
+}
+
+/* Bring adapter up, runs in its own thread */
+static int gateway_setup(
+    gateway_port_t     *port) {
+
+    const gateway_config_t *config = &port->gateway->config;
+    cpu_set_t set;
+    int result;
+
+    if (GATEWAY_CPU_ANY != port->adapter.cpu) {
+
+        CPU_ZERO(&set);
+        CPU_SET(port->adapter.cpu, &set);
+
+        result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (0 != result) {
+            return -result;
+        }
+    }
+
+    if (0 <= port->adapter.index) {
+        port->fd = gateway_open(port->adapter.index);
+        if (0 > port->fd) {
+            return port->fd;
+        }
+    } else {
+        port->fd = port->adapter.fd;
+    }
+
+    port->hci = hci_channel_new_in(port->loop, port->fd);
+    port->scanner = scanner_new(port->hci, gateway_report, port);
+    if (NULL == port->hci || NULL == port->scanner) {
+        return -ENOMEM;
+    }
+
+    /* Stop asked for before this point is still pending on descriptor */
+    result = loop_add_sd_in(port->loop, port->wake, EPOLLIN, gateway_stop, port, NULL);
+    if (EXIT_SUCCESS != result) {
+        return result;
+    }
+
+    /* Raw HCI socket passes nothing without filter */
+    result = hci_channel_set_filter(port->hci, 1);
+    if (EXIT_SUCCESS != result && 0 <= port->adapter.index) {
+        return result;
+    }
+
+    result = hci_channel_set_timeout(port->hci, config->timeout);
+    if (EXIT_SUCCESS != result) {
+        return result;
+    }
+
+    result = scanner_set_parameters(port->scanner, config->type, config->interval, config->window, 0);
+    if (EXIT_SUCCESS != result) {
+        return result;
+    }
+
+    /* Probe and scan set up are pipelined */
+    result = hci_channel_send(port->hci, BT_HCI_CMD_READ_LOCAL_VERSION, NULL, 0, gateway_version, port, NULL);
+    if (EXIT_SUCCESS != result) {
+        return result;
+    }
+
+    return scanner_start(port->scanner, gateway_started, port);
+}
+
+/* Adapter thread */
+static void *gateway_thread(
+    void               *user_data) {
+
+    gateway_port_t *port = user_data;
+    int result;
+
+    result = gateway_setup(port);
+    if (EXIT_SUCCESS == result) {
+        loop_run_in(port->loop);
+    } else {
+        gateway_settle(port, result);
+    }
+
+    scanner_free(port->scanner);
+    hci_channel_free(port->hci);
+    port->scanner = NULL;
+    port->hci = NULL;
+
+    if (0 <= port->adapter.index && 0 <= port->fd) {
+        close(port->fd);
+    }
+    port->fd = -1;
+
+    return NULL;
+}
+
+/* Fill config with defaults */
+void gateway_config_init(
+    gateway_config_t       *config) {
+
+    memset(config, 0, sizeof(gateway_config_t));
+    config->queue = GATEWAY_DEFAULT_QUEUE;
+    config->timeout = GATEWAY_DEFAULT_TIMEOUT;
+    config->type = SCANNER_PASSIVE;
+    config->interval = 10;
+    config->window = 10;
+}
+
+/* List HCI devices which are up */
+int gateway_probe(
+    int                    *index,
+    const size_t            max) {
+
+    gateway_dev_list_t list;
+    int fd, result, count = 0;
+
+    if (NULL == index && 0 != max) {
+        return -EINVAL;
+    }
+
+    fd = socket(GATEWAY_AF_BLUETOOTH, SOCK_RAW | SOCK_CLOEXEC, GATEWAY_BTPROTO_HCI);
+    if (0 > fd) {
+        return -errno;
+    }
+
+    memset(&list, 0, sizeof(list));
+    list.dev_num = GATEWAY_MAX_ADAPTERS;
+
+    /* Every device in one request instead of devinfo per index */
+    if (0 > ioctl(fd, GATEWAY_HCIGETDEVLIST, &list)) {
+        result = -errno;
+        close(fd);
+        return result;
+    }
+
+    close(fd);
+
+    for (size_t i = 0; list.dev_num > i && GATEWAY_MAX_ADAPTERS > i && max > (size_t) count; ++i) {
+        if (list.dev_req[i].dev_opt & (1U << GATEWAY_HCI_UP)) {
+            index[count++] = list.dev_req[i].dev_id;
+        }
+    }
+
+    return count;
+}
+
+/* Start gateway */
+struct gateway *gateway_new_in(
+    struct loop                *loop,
+    const gateway_config_t     *config,
+    const gateway_adapter_t    *adapter,
+    const size_t                count,
+    gateway_fn_t                callback,
+    void                       *user_data) {
+
+    struct gateway *gateway;
+    gateway_port_t *port;
+    uint32_t size = GATEWAY_MIN_QUEUE;
+
+    if (NULL == loop || NULL == config || NULL == adapter || NULL == callback
+        || 0 == count || GATEWAY_MAX_ADAPTERS < count || GATEWAY_MAX_QUEUE < config->queue) {
+        return NULL;
+    }
+
+    for (size_t i = 0; count > i; ++i) {
+        if (0 > adapter[i].index && 0 > adapter[i].fd) {
+            return NULL;
+        }
+    }
+
+    while (size < config->queue) {
+        size <<= 1;
+    }
+
+    gateway = calloc(1, sizeof(struct gateway));
+    if (NULL == gateway) {
+        return NULL;
+    }
+
+    gateway->loop = loop;
+    gateway->config = *config;
+    gateway->callback = callback;
+    gateway->user_data = user_data;
+    gateway->fd = -1;
+
+    gateway->port = aligned_alloc(GATEWAY_CACHE_LINE, count * sizeof(gateway_port_t));
+    if (NULL == gateway->port) {
+        free(gateway);
+        return NULL;
+    }
+
+    memset(gateway->port, 0, count * sizeof(gateway_port_t));
+    gateway->count = count;
+
+    /* Ports not set up yet have nothing to close */
+    for (size_t i = 0; count > i; ++i) {
+        gateway->port[i].wake = -1;
+    }
+
+    for (size_t i = 0; count > i; ++i) {
+
+        port = &gateway->port[i];
+        port->gateway = gateway;
+        port->adapter = adapter[i];
+        port->number = (uint8_t) i;
+        port->fd = -1;
+        port->mask = size - 1;
+        port->limit = size;
+
+        port->loop = loop_new();
+        port->ring = malloc(size * sizeof(gateway_report_t));
+        port->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (NULL == port->loop || NULL == port->ring || 0 > port->wake) {
+            gateway_free(gateway);
+            return NULL;
+        }
+    }
+
+    gateway->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (0 > gateway->fd || EXIT_SUCCESS != loop_add_sd_in(loop, gateway->fd, EPOLLIN, gateway_drain, gateway, NULL)) {
+        gateway_free(gateway);
+        return NULL;
+    }
+
+    /* Adapters are opened and probed concurrently */
+    for (size_t i = 0; count > i; ++i) {
+
+        port = &gateway->port[i];
+
+        if (0 != pthread_create(&port->thread, NULL, gateway_thread, port)) {
+            gateway_free(gateway);
+            return NULL;
+        }
+
+        port->running = 1;
+    }
+
+    return gateway;
+}
+
+/* Start gateway in default loop */
+struct gateway *gateway_new(
+    const gateway_config_t     *config,
+    const gateway_adapter_t    *adapter,
+    const size_t                count,
+    gateway_fn_t                callback,
+    void                       *user_data) {
+    return gateway_new_in(loop_default(), config, adapter, count, callback, user_data);
+}
+
+/* Stop gateway */
+void gateway_free(
+    struct gateway     *gateway) {
+
+    const uint64_t value = 1;
+    gateway_port_t *port;
+
+    if (NULL == gateway) {
+        return;
+    }
+
+    /* Stop every adapter first so they wind down together. Nothing here can
+     * fail: thread that already quit just ignores the wake up */
+    for (size_t i = 0; gateway->count > i; ++i) {
+        port = &gateway->port[i];
+        if (port->running) {
+            __atomic_store_n(&port->stop, 1, __ATOMIC_RELEASE);
+            if (sizeof(value) != write(port->wake, &value, sizeof(value))) {
+                /* Counter is already non-zero, thread wakes up anyway */
+            }
+        }
+    }
+
+    for (size_t i = 0; gateway->count > i; ++i) {
+
+        port = &gateway->port[i];
+
+        if (port->running) {
+            pthread_join(port->thread, NULL);
+        }
+
+        if (NULL != port->loop) {
+            loop_free(port->loop);
+        }
+
+        if (0 <= port->wake) {
+            close(port->wake);
+        }
+
+        free(port->ring);
+    }
+
+    if (0 <= gateway->fd) {
+        loop_remove_sd_in(gateway->loop, gateway->fd);
+        close(gateway->fd);
+    }
+
+    free(gateway->port);
+    free(gateway);
+}
+
+/* Adapters whose start up settled */
+size_t gateway_ready(
+    struct gateway     *gateway) {
+
+    size_t ready = 0;
+
+    if (NULL == gateway) {
+        return 0;
+    }
+
+    for (size_t i = 0; gateway->count > i; ++i) {
+        ready += (0 != __atomic_load_n(&gateway->port[i].ready, __ATOMIC_ACQUIRE));
+    }
+
+    return ready;
+}
+
+/* Get adapter counters */
+int gateway_get_stats(
+    struct gateway     *gateway,
+    const size_t        adapter,
+    gateway_stats_t    *stats) {
+
+    gateway_port_t *port;
+
+    if (NULL == gateway || NULL == stats || gateway->count <= adapter) {
+        return -EINVAL;
+    }
+
+    port = &gateway->port[adapter];
+
+    stats->status = __atomic_load_n(&port->status, __ATOMIC_RELAXED);
+    stats->hci_version = __atomic_load_n(&port->version, __ATOMIC_RELAXED);
+    stats->reports = __atomic_load_n(&port->reports, __ATOMIC_RELAXED);
+    stats->drops = __atomic_load_n(&port->drops, __ATOMIC_RELAXED);
+    stats->oversize = __atomic_load_n(&port->oversize, __ATOMIC_RELAXED);
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -0,0 +1,867 @@
+/*!
+ *	\file		hci.c
+ *	\brief		Asynchronous HCI command channel on top of the loop
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/io.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+#include "beaconizer/utility.h"
+
+#include "loop_private.h"
+
+/* Kernel HCI socket options */
+#define HCI_SOCKET_LEVEL                    0       /* SOL_HCI */
+#define HCI_SOCKET_FILTER                   2       /* HCI_FILTER */
+
+/* Command waiting to be sent or completed */
+typedef struct hci_command {
+    struct hci_command *next;           /* Next command */
+    hci_complete_fn_t   callback;       /* Completion callback */
+    void               *user_data;      /* User data */
+    destructor_t        destructor;     /* Destructor */
+    uint64_t            deadline;       /* Completion deadline, ms, 0 for none */
+    uint16_t            opcode;         /* Opcode */
+    uint16_t            size;           /* Packet size */
+    uint8_t             packet[];       /* Packet ready for wire */
+} hci_command_t;
+
+/* Command list */
+typedef struct {
+    hci_command_t      *head;           /* First command */
+    hci_command_t      *tail;           /* Last command */
+    size_t              count;          /* Commands in list */
+} hci_list_t;
+
+/* Event handler */
+typedef struct hci_handler {
+    struct hci_handler *next;           /* Next handler */
+    unsigned int        id;             /* Handler ID, 0 when removed */
+    uint8_t             event;          /* Event code */
+    uint8_t             subevent;       /* LE Meta subevent, 0 for any */
+    hci_event_fn_t      callback;       /* Handler */
+    void               *user_data;      /* User data */
+    destructor_t        destructor;     /* Destructor */
+} hci_handler_t;
+
+/* HCI channel */
+struct hci_channel {
+    struct loop        *loop;           /* Loop */
+    struct io          *io;             /* I/O channel */
+    int                 fd;             /* HCI socket */
+    uint8_t             credits;        /* Commands controller accepts now */
+    int                 writing;        /* Waiting for socket to become writable */
+    hci_list_t          queue;          /* Not sent yet */
+    hci_list_t          sent;           /* Waiting for completion */
+    uint32_t            timeout;        /* Command deadline, ms, 0 for none */
+    int                 timer;          /* Deadline timer */
+    uint64_t            armed;          /* Deadline timer is armed to */
+    hci_handler_t      *handler;        /* Event handlers */
+    unsigned int        handler_id;     /* Last handler ID */
+    int                 dispatching;    /* Handlers are running */
+    int                 removed;        /* Handlers removed while dispatching */
+    int                 filtering;      /* Kernel filter installed */
+    hci_filter_t        filter;         /* Installed filter */
+    hci_channel_stats_t stats;          /* Counters */
+    uint8_t             buffer[BT_HCI_MAX_PACKET_SIZE];     /* Receive buffer */
+};
+
+/* Append command to list */
+static inline void list_push(
+    hci_list_t         *list,
+    hci_command_t      *command) {
+
+    command->next = NULL;
+
+    if (NULL == list->tail) {
+        list->head = command;
+    } else {
+        list->tail->next = command;
+    }
+
+    list->tail = command;
+    list->count++;
+}
+
+/* Take first command from list */
+static inline hci_command_t *list_pop(
+    hci_list_t         *list) {
+
+    hci_command_t *command = list->head;
+
+    if (NULL != command) {
+        list->head = command->next;
+        if (NULL == list->head) {
+            list->tail = NULL;
+        }
+        list->count--;
+    }
+
+    return command;
+}
+
+/* Take oldest command with given opcode from list */
+static hci_command_t *list_take(
+    hci_list_t         *list,
+    const uint16_t      opcode) {
+
+    hci_command_t *prev = NULL, *command;
+
+    for (command = list->head; NULL != command; prev = command, command = command->next) {
+
+        if (opcode != command->opcode) {
+            continue;
+        }
+
+        if (NULL == prev) {
+            list->head = command->next;
+        } else {
+            prev->next = command->next;
+        }
+
+        if (list->tail == command) {
+            list->tail = prev;
+        }
+
+        list->count--;
+
+        return command;
+    }
+
+    return NULL;
+}
+
+/* Release command */
+static void command_free(
+    struct hci_channel *hci,
+    hci_command_t      *command) {
+
+    if (NULL != command->destructor) {
+        command->destructor(command->user_data);
+    }
+
+    loop_release(hci->loop, command, sizeof(hci_command_t) + command->size);
+}
+
+/* Complete command and release it */
+static void command_complete(
+    struct hci_channel *hci,
+    hci_command_t      *command,
+    const int           status,
+    const uint8_t      *param,
+    const uint8_t       length) {
+
+    if (NULL != command->callback) {
+        command->callback(command->opcode, status, param, length, command->user_data);
+    }
+
+    command_free(hci, command);
+}
+
+static int hci_write(
+    struct io          *io,
+    void               *user_data);
+
+/* Monotonic time in milliseconds */
+static inline uint64_t hci_now(void) {
+    return clock_ns() / 1000000;
+}
+
+/* Arm deadline timer to oldest command in flight */
+static void hci_arm(
+    struct hci_channel *hci) {
+
+    struct timespec ts = { 0, 0 };
+    const hci_command_t *command = hci->sent.head;
+    uint64_t now;
+
+    if (0 >= hci->timer) {
+        return;
+    }
+
+    /* Sent list is in send order, so head has earliest deadline */
+    while (NULL != command && 0 == command->deadline) {
+        command = command->next;
+    }
+
+    if (NULL == command) {
+        if (0 != hci->armed) {
+            cancel_timer_in(hci->loop, hci->timer);
+            hci->armed = 0;
+        }
+        return;
+    }
+
+    if (command->deadline == hci->armed) {
+        return;
+    }
+
+    now = hci_now();
+    if (command->deadline > now) {
+        ts.tv_sec = (time_t) ((command->deadline - now) / 1000);
+        ts.tv_nsec = (long) ((command->deadline - now) % 1000) * 1000000;
+    }
+
+    modify_timer_in(hci->loop, hci->timer, &ts);
+    hci->armed = command->deadline;
+}
+
+/* Send queued commands while controller has credits */
+static void hci_flush(
+    struct hci_channel *hci) {
+
+    hci_command_t *command;
+    uint64_t now = 0;
+    ssize_t result;
+
+    while (0 < hci->credits && NULL != hci->queue.head) {
+
+        command = hci->queue.head;
+
+        result = write(hci->fd, command->packet, command->size);
+        if (0 > result) {
+
+            /* Wait for socket */
+            if (EAGAIN == errno || EWOULDBLOCK == errno) {
+                if (!hci->writing) {
+                    hci->writing = io_set_write_handler(hci->io, hci_write, hci, NULL);
+                }
+                break;
+            }
+
+            if (EINTR == errno) {
+                continue;
+            }
+
+            /* Command is lost */
+            command_complete(hci, list_pop(&hci->queue), -errno, NULL, 0);
+            continue;
+        }
+
+        /* Clock starts when controller gets the command */
+        if (0 != hci->timeout) {
+            if (0 == now) {
+                now = hci_now();
+            }
+            command->deadline = now + hci->timeout;
+        }
+
+        list_push(&hci->sent, list_pop(&hci->queue));
+        hci->credits--;
+    }
+
+    hci_arm(hci);
+}
+
+/* Deadline timer: fail commands controller did not answer */
+static void hci_timeout(
+    int                 id,
+    void               *user_data) {
+
+    struct hci_channel *hci = user_data;
+    const uint64_t now = hci_now();
+    hci_command_t *command, **p = &hci->sent.head, *prev = NULL;
+
+    hci->armed = 0;
+
+    while (NULL != (command = *p)) {
+
+        if (0 == command->deadline || now < command->deadline) {
+            prev = command;
+            p = &command->next;
+            continue;
+        }
+
+        *p = command->next;
+        if (hci->sent.tail == command) {
+            hci->sent.tail = prev;
+        }
+        hci->sent.count--;
+        hci->stats.timeouts++;
+
+        /* Credit of lost command never comes back, late completion is ignored */
+        if (0 == hci->credits) {
+            hci->credits = 1;
+        }
+
+        command_complete(hci, command, -ETIMEDOUT, NULL, 0);
+
+        /* Callbacks may have sent more commands */
+        p = &hci->sent.head;
+        prev = NULL;
+    }
+
+    hci_flush(hci);
+}
+
+/* Socket became writable */
+static int hci_write(
+    struct io          *io,
+    void               *user_data) {
+
+    struct hci_channel *hci = user_data;
+
+    hci->writing = 0;
+    hci_flush(hci);
+
+    /* Keep handler only while still blocked */
+    return hci->writing;
+}
+
+/* Release handler */
+static void handler_free(
+    struct hci_channel *hci,
+    hci_handler_t      *handler) {
+
+    if (NULL != handler->destructor) {
+        handler->destructor(handler->user_data);
+    }
+
+    loop_release(hci->loop, handler, sizeof(hci_handler_t));
+}
+
+/* Drop handlers removed during dispatch */
+static void handler_sweep(
+    struct hci_channel *hci) {
+
+    hci_handler_t **p = &hci->handler, *handler;
+
+    while (NULL != (handler = *p)) {
+        if (0 == handler->id) {
+            *p = handler->next;
+            handler_free(hci, handler);
+        } else {
+            p = &handler->next;
+        }
+    }
+
+    hci->removed = 0;
+}
+
+/* Hand event to registered handlers, returns 1 if anyone took it */
+static int hci_dispatch(
+    struct hci_channel *hci,
+    const uint8_t       code,
+    const uint8_t      *param,
+    const uint8_t       length) {
+
+    const uint8_t subevent = (BT_HCI_EVT_LE_META == code && 0 != length) ? param[0] : 0;
+    hci_handler_t *handler;
+    int consumed = 0;
+
+    hci->dispatching++;
+
+    for (handler = hci->handler; NULL != handler; handler = handler->next) {
+
+        if (code != handler->event || 0 == handler->id) {
+            continue;
+        }
+
+        if (0 != handler->subevent && subevent != handler->subevent) {
+            continue;
+        }
+
+        handler->callback(code, param, length, handler->user_data);
+        consumed = 1;
+    }
+
+    if (0 == --hci->dispatching && hci->removed) {
+        handler_sweep(hci);
+    }
+
+    return consumed;
+}
+
+/* Compute filter from handlers */
+static void filter_build(
+    struct hci_channel *hci,
+    hci_filter_t       *filter) {
+
+    hci_handler_t *handler;
+
+    memset(filter, 0, sizeof(hci_filter_t));
+
+    filter->type_mask = 1U << BT_HCI_EVENT_PKT;
+
+    /* Channel always waits for command results */
+    filter->event_mask[BT_HCI_EVT_CMD_COMPLETE >> 5] |= 1U << (BT_HCI_EVT_CMD_COMPLETE & 31);
+    filter->event_mask[BT_HCI_EVT_CMD_STATUS >> 5] |= 1U << (BT_HCI_EVT_CMD_STATUS & 31);
+
+    for (handler = hci->handler; NULL != handler; handler = handler->next) {
+        if (0 != handler->id) {
+            filter->event_mask[(handler->event & 63) >> 5] |= 1U << (handler->event & 31);
+        }
+    }
+}
+
+/* Reinstall kernel filter if handlers changed it */
+static int filter_update(
+    struct hci_channel *hci) {
+
+    hci_filter_t filter;
+
+    if (!hci->filtering) {
+        return EXIT_SUCCESS;
+    }
+
+    filter_build(hci, &filter);
+
+    if (0 == memcmp(&filter, &hci->filter, sizeof(filter))) {
+        return EXIT_SUCCESS;
+    }
+
+    if (0 > setsockopt(hci->fd, HCI_SOCKET_LEVEL, HCI_SOCKET_FILTER, &filter, sizeof(filter))) {
+        return -errno;
+    }
+
+    hci->filter = filter;
+
+    return EXIT_SUCCESS;
+}
+
+/* Handle Command Complete and Command Status */
+static void hci_process_event(
+    struct hci_channel *hci,
+    const uint8_t      *event,
+    const size_t        size) {
+
+    const uint8_t code = event[0];
+    const uint8_t *param = event + BT_HCI_EVENT_HDR_SIZE;
+    const size_t length = event[1];
+    hci_command_t *command;
+    uint16_t opcode;
+
+    hci->stats.delivered++;
+
+    if (BT_HCI_EVENT_HDR_SIZE + length > size) {
+        return;
+    }
+
+    switch (code) {
+
+        case BT_HCI_EVT_CMD_COMPLETE: {
+
+            if (3 > length) {
+                return;
+            }
+
+            hci->credits = param[0];
+            hci->stats.consumed++;
+            opcode = get_le16(param + 1);
+
+            command = list_take(&hci->sent, opcode);
+            if (NULL != command) {
+                command_complete(hci, command,
+                    (3 < length) ? param[3] : BT_HCI_SUCCESS,
+                    param + 3,
+                    (uint8_t) (length - 3));
+            }
+
+            } break;
+
+        case BT_HCI_EVT_CMD_STATUS: {
+
+            if (4 > length) {
+                return;
+            }
+
+            hci->credits = param[1];
+            hci->stats.consumed++;
+            opcode = get_le16(param + 2);
+
+            command = list_take(&hci->sent, opcode);
+            if (NULL != command) {
+                command_complete(hci, command, param[0], NULL, 0);
+            }
+
+            } break;
+
+        default:
+            hci->stats.consumed += hci_dispatch(hci, code, param, (uint8_t) length);
+            return;
+    }
+}
+
+/* Socket is readable: drain it */
+static int hci_read(
+    struct io          *io,
+    void               *user_data) {
+
+    struct hci_channel *hci = user_data;
+    ssize_t result;
+
+    hci->stats.wakeups++;
+
+    /* Channel stays alive while loop may stop in a callback */
+    while (0 <= io_get_descriptor(hci->io)) {
+
+        result = read(hci->fd, hci->buffer, sizeof(hci->buffer));
+        if (0 > result) {
+            if (EINTR == errno) {
+                continue;
+            }
+            break;
+        }
+
+        if (0 == result) {
+            break;
+        }
+
+        if (BT_HCI_EVENT_PKT == hci->buffer[0] && 1 + BT_HCI_EVENT_HDR_SIZE <= result) {
+            hci_process_event(hci, hci->buffer + 1, (size_t) result - 1);
+        }
+    }
+
+    if (0 <= io_get_descriptor(hci->io)) {
+        hci_flush(hci);
+    }
+
+    return 1;
+}
+
+/* Create HCI channel */
+struct hci_channel *hci_channel_new_in(
+    struct loop        *loop,
+    const int           fd) {
+
+    struct hci_channel *hci;
+    int flags;
+
+    if (NULL == loop || 0 > fd) {
+        return NULL;
+    }
+
+    flags = fcntl(fd, F_GETFL);
+    if (0 > flags || 0 > fcntl(fd, F_SETFL, flags | O_NONBLOCK)) {
+        return NULL;
+    }
+
+    hci = calloc(1, sizeof(struct hci_channel));
+    if (NULL == hci) {
+        return NULL;
+    }
+
+    hci->loop = loop;
+    hci->fd = fd;
+    hci->credits = 1;
+
+    hci->io = io_new_in(loop, fd);
+    if (NULL == hci->io) {
+        free(hci);
+        return NULL;
+    }
+
+    if (!io_set_read_handler(hci->io, hci_read, hci, NULL)) {
+        io_destroy(hci->io);
+        free(hci);
+        return NULL;
+    }
+
+    return hci;
+}
+
+/* Create HCI channel in default loop */
+struct hci_channel *hci_channel_new(
+    const int           fd) {
+    return hci_channel_new_in(loop_default(), fd);
+}
+
+/* Destroy HCI channel */
+void hci_channel_free(
+    struct hci_channel *hci) {
+
+    hci_command_t *command;
+    hci_handler_t *handler;
+
+    if (NULL == hci) {
+        return;
+    }
+
+    while (NULL != (command = list_pop(&hci->queue))) {
+        command_free(hci, command);
+    }
+
+    while (NULL != (command = list_pop(&hci->sent))) {
+        command_free(hci, command);
+    }
+
+    while (NULL != hci->handler) {
+        handler = hci->handler;
+        hci->handler = handler->next;
+        handler_free(hci, handler);
+    }
+
+    if (0 < hci->timer) {
+        destroy_timer_in(hci->loop, hci->timer);
+    }
+
+    io_destroy(hci->io);
+    free(hci);
+}
+
+/* Queue command */
+int hci_channel_send(
+    struct hci_channel *hci,
+    const uint16_t      opcode,
+    const void         *param,
+    const uint8_t       length,
+    hci_complete_fn_t   callback,
+    void               *user_data,
+    destructor_t        destructor) {
+
+    const uint16_t size = 1 + BT_HCI_COMMAND_HDR_SIZE + length;
+    hci_command_t *command;
+
+    if (NULL == hci || (0 != length && NULL == param)) {
+        return -EINVAL;
+    }
+
+    command = loop_alloc(hci->loop, sizeof(hci_command_t) + size);
+    if (NULL == command) {
+        return -ENOMEM;
+    }
+
+    command->callback = callback;
+    command->user_data = user_data;
+    command->destructor = destructor;
+    command->deadline = 0;
+    command->opcode = opcode;
+    command->size = size;
+
+    /* Serialize once */
+    command->packet[0] = BT_HCI_COMMAND_PKT;
+    put_le16(opcode, command->packet + 1);
+    command->packet[3] = length;
+    if (0 != length) {
+        memcpy(command->packet + 1 + BT_HCI_COMMAND_HDR_SIZE, param, length);
+    }
+
+    list_push(&hci->queue, command);
+    hci_flush(hci);
+
+    return EXIT_SUCCESS;
+}
+
+/* Add handler */
+static unsigned int handler_add(
+    struct hci_channel *hci,
+    const uint8_t       event,
+    const uint8_t       subevent,
+    hci_event_fn_t      callback,
+    void               *user_data,
+    destructor_t        destructor) {
+
+    hci_handler_t *handler, **p;
+
+    if (NULL == hci || NULL == callback
+        || BT_HCI_EVT_CMD_COMPLETE == event || BT_HCI_EVT_CMD_STATUS == event) {
+        return 0;
+    }
+
+    handler = loop_alloc(hci->loop, sizeof(hci_handler_t));
+    if (NULL == handler) {
+        return 0;
+    }
+
+    if (0 == ++hci->handler_id) {
+        hci->handler_id = 1;
+    }
+
+    handler->next = NULL;
+    handler->id = hci->handler_id;
+    handler->event = event;
+    handler->subevent = subevent;
+    handler->callback = callback;
+    handler->user_data = user_data;
+    handler->destructor = destructor;
+
+    /* Keep registration order */
+    for (p = &hci->handler; NULL != *p; p = &(*p)->next);
+    *p = handler;
+
+    filter_update(hci);
+
+    return handler->id;
+}
+
+/* Register event handler */
+unsigned int hci_channel_register(
+    struct hci_channel *hci,
+    const uint8_t       event,
+    hci_event_fn_t      callback,
+    void               *user_data,
+    destructor_t        destructor) {
+    return handler_add(hci, event, 0, callback, user_data, destructor);
+}
+
+/* Register LE Meta subevent handler */
+unsigned int hci_channel_register_le(
+    struct hci_channel *hci,
+    const uint8_t       subevent,
+    hci_event_fn_t      callback,
+    void               *user_data,
+    destructor_t        destructor) {
+
+    if (0 == subevent) {
+        return 0;
+    }
+
+    return handler_add(hci, BT_HCI_EVT_LE_META, subevent, callback, user_data, destructor);
+}
+
+/* Drop event handler */
+int hci_channel_unregister(
+    struct hci_channel *hci,
+    const unsigned int  id) {
+
+    hci_handler_t **p, *handler;
+
+    if (NULL == hci || 0 == id) {
+        return -EINVAL;
+    }
+
+    for (p = &hci->handler; NULL != (handler = *p); p = &handler->next) {
+
+        if (id != handler->id) {
+            continue;
+        }
+
+        /* List is being walked: free later */
+        if (hci->dispatching) {
+            handler->id = 0;
+            hci->removed = 1;
+        } else {
+            *p = handler->next;
+            handler_free(hci, handler);
+        }
+
+        filter_update(hci);
+
+        return EXIT_SUCCESS;
+    }
+
+    return -ENOENT;
+}
+
+/* Enable or disable kernel filter */
+int hci_channel_set_filter(
+    struct hci_channel *hci,
+    const int           enable) {
+
+    hci_filter_t filter;
+    int result;
+
+    if (NULL == hci) {
+        return -EINVAL;
+    }
+
+    if (enable) {
+        hci->filtering = 1;
+        memset(&hci->filter, 0, sizeof(hci_filter_t));
+
+        result = filter_update(hci);
+        if (EXIT_SUCCESS != result) {
+            hci->filtering = 0;
+        }
+
+        return result;
+    }
+
+    /* Pass every event */
+    memset(&filter, 0, sizeof(filter));
+    filter.type_mask = 1U << BT_HCI_EVENT_PKT;
+    filter.event_mask[0] = filter.event_mask[1] = UINT32_MAX;
+
+    hci->filtering = 0;
+
+    if (0 > setsockopt(hci->fd, HCI_SOCKET_LEVEL, HCI_SOCKET_FILTER, &filter, sizeof(filter))) {
+        return -errno;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Filter matching current handlers */
+int hci_channel_get_filter(
+    struct hci_channel *hci,
+    hci_filter_t       *filter) {
+
+    if (NULL == hci || NULL == filter) {
+        return -EINVAL;
+    }
+
+    filter_build(hci, filter);
+
+    return EXIT_SUCCESS;
+}
+
+/* Set command deadline */
+int hci_channel_set_timeout(
+    struct hci_channel *hci,
+    const uint32_t      timeout) {
+
+    struct timespec ts = { .tv_sec = 1, .tv_nsec = 0 };
+    int timer;
+
+    if (NULL == hci) {
+        return -EINVAL;
+    }
+
+    /* Timer stays idle until first command goes out */
+    if (0 != timeout && 0 >= hci->timer) {
+
+        timer = create_timer_in(hci->loop, &ts, hci_timeout, hci, NULL);
+        if (0 >= timer) {
+            return (0 > timer) ? timer : -EIO;
+        }
+
+        if (EXIT_SUCCESS != cancel_timer_in(hci->loop, timer)) {
+            destroy_timer_in(hci->loop, timer);
+            return -EIO;
+        }
+
+        hci->timer = timer;
+    }
+
+    hci->timeout = timeout;
+
+    return EXIT_SUCCESS;
+}
+
+/* Read channel counters */
+int hci_channel_get_stats(
+    struct hci_channel *hci,
+    hci_channel_stats_t *stats) {
+
+    if (NULL == hci || NULL == stats) {
+        return -EINVAL;
+    }
+
+    *stats = hci->stats;
+
+    return EXIT_SUCCESS;
+}
+
+/* Commands in flight */
+size_t hci_channel_pending(
+    struct hci_channel *hci) {
+    return (NULL == hci) ? 0 : hci->queue.count + hci->sent.count;
+}
+
+ /* End of file */
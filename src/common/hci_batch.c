@@ -0,0 +1,152 @@
+/*!
+ *	\file		hci_batch.c
+ *	\brief		Batches of HCI commands driving controller towards wanted state
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/hci.h"
+
+#include "hci_batch.h"
+
+/* Command completion */
+static void hci_batch_complete(
+    uint16_t            opcode,
+    int                 status,
+    const uint8_t      *param,
+    uint8_t             length,
+    void               *user_data) {
+
+    hci_batch_t *batch = user_data;
+
+    batch->busy--;
+
+    if (batch->released) {
+        return;
+    }
+
+    if (BT_HCI_SUCCESS != status) {
+
+        if (NULL != batch->ops->rejected) {
+            batch->ops->rejected(batch->owner, opcode);
+        }
+
+        hci_batch_fail(batch, status);
+
+    } else if (batch->enable_opcode == opcode) {
+        batch->enabled = batch->enabling;
+    }
+
+    /* Rest of batch still in flight */
+    if (0 != batch->busy) {
+        return;
+    }
+
+    batch->ops->settled(batch->owner, opcode, status, param, length);
+}
+
+/* Set up batch */
+void hci_batch_init(
+    hci_batch_t            *batch,
+    struct hci_channel     *hci,
+    const hci_batch_ops_t  *ops,
+    void                   *owner) {
+
+    batch->hci = hci;
+    batch->ops = ops;
+    batch->owner = owner;
+    batch->reference_count = 1;
+    batch->released = 0;
+    batch->busy = 0;
+    batch->wanted = 0;
+    batch->enabled = 0;
+    batch->enabling = 0;
+    batch->previous = 0;
+    batch->enable_opcode = 0;
+    batch->status = BT_HCI_SUCCESS;
+}
+
+/* Take reference */
+void hci_batch_ref(
+    hci_batch_t            *batch) {
+    batch->reference_count++;
+}
+
+/* Drop reference */
+void hci_batch_unref(
+    void                   *user_data) {
+
+    hci_batch_t *batch = user_data;
+
+    if (0 == --batch->reference_count) {
+        batch->ops->release(batch->owner);
+    }
+}
+
+/* Owner is gone */
+void hci_batch_release(
+    hci_batch_t            *batch) {
+
+    batch->released = 1;
+
+    hci_batch_unref(batch);
+}
+
+/* Send command as part of current batch */
+int hci_batch_send(
+    hci_batch_t            *batch,
+    const uint16_t          opcode,
+    const void             *param,
+    const uint8_t           length) {
+
+    int result;
+
+    batch->busy++;
+    batch->reference_count++;
+
+    result = hci_channel_send(batch->hci, opcode, param, length,
+        hci_batch_complete, batch, hci_batch_unref);
+    if (0 > result) {
+        batch->busy--;
+        batch->reference_count--;
+    }
+
+    return result;
+}
+
+/* Send enable command */
+int hci_batch_send_enable(
+    hci_batch_t            *batch,
+    const uint16_t          opcode,
+    const void             *param,
+    const uint8_t           length,
+    const uint8_t           enable) {
+
+    batch->enabling = enable;
+    batch->enable_opcode = opcode;
+
+    return hci_batch_send(batch, opcode, param, length);
+}
+
+/* Undo enable of failed batch */
+int hci_batch_rollback(
+    hci_batch_t            *batch) {
+
+    if (BT_HCI_SUCCESS == batch->status) {
+        return 0;
+    }
+
+    batch->wanted = batch->enabled && batch->previous;
+
+    return batch->wanted == batch->enabled;
+}
+
+ /* End of file */
@@ -0,0 +1,145 @@
+/*!
+ *	\file		hci_batch.h
+ *	\brief		Batches of HCI commands driving controller towards wanted state
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "beaconizer/hci.h"
+
+#pragma once
+
+#ifndef __BEACONIZER_HCI_BATCH_H__
+#define __BEACONIZER_HCI_BATCH_H__
+
+/* Owner hooks */
+typedef struct {
+
+    /* Last reference is gone, free owner */
+    void (*release) (
+        void               *owner);
+
+    /* Command rejected, owner marks what must be sent again. May be NULL */
+    void (*rejected) (
+        void               *owner,
+        const uint16_t      opcode);
+
+    /* Every command of batch is answered, last completion is passed on */
+    void (*settled) (
+        void               *owner,
+        const uint16_t      opcode,
+        const int           status,
+        const uint8_t      *param,
+        const uint8_t       length);
+} hci_batch_ops_t;
+
+/* Commands not depending on each other's result go out together, channel
+ * pipelines them. Owner stays allocated while any of them is in flight */
+typedef struct {
+    struct hci_channel     *hci;            /* HCI channel */
+    const hci_batch_ops_t  *ops;            /* Owner hooks */
+    void                   *owner;          /* Passed to hooks */
+    int                     reference_count;    /* Owner plus commands in flight */
+    int                     released;       /* Owner is gone */
+    uint8_t                 busy;           /* Commands in flight */
+    uint8_t                 wanted;         /* Enable requested */
+    uint8_t                 enabled;        /* Enabled on controller */
+    uint8_t                 enabling;       /* Value of enable command in flight */
+    uint8_t                 previous;       /* Enabled before current batch */
+    uint16_t                enable_opcode;  /* Opcode of last enable command */
+    int                     status;         /* First error of current batch */
+} hci_batch_t;
+
+/* Set up batch holding owner reference */
+void hci_batch_init(
+    hci_batch_t            *batch,          /* Batch */
+    struct hci_channel     *hci,            /* HCI channel */
+    const hci_batch_ops_t  *ops,            /* Owner hooks */
+    void                   *owner);         /* Owner */
+
+/* Take reference */
+void hci_batch_ref(
+    hci_batch_t            *batch);         /* Batch */
+
+/* Drop reference, owner is released with the last one */
+void hci_batch_unref(
+    void                   *batch);         /* Batch */
+
+/* Owner is gone: completions are swallowed, reference is dropped */
+void hci_batch_release(
+    hci_batch_t            *batch);         /* Batch */
+
+/* Send command as part of current batch */
+int hci_batch_send(
+    hci_batch_t            *batch,          /* Batch */
+    const uint16_t          opcode,         /* Opcode */
+    const void             *param,          /* Parameters */
+    const uint8_t           length);        /* Parameters length */
+
+/* Send enable command, its success updates enabled state */
+int hci_batch_send_enable(
+    hci_batch_t            *batch,          /* Batch */
+    const uint16_t          opcode,         /* Opcode */
+    const void             *param,          /* Parameters */
+    const uint8_t           length,         /* Parameters length */
+    const uint8_t           enable);        /* Value being sent */
+
+/* After failed batch enable queued behind rejected command is undone. Returns
+ * 1 when controller already is where that leaves it */
+int hci_batch_rollback(
+    hci_batch_t            *batch);         /* Batch */
+
+/* Start new batch */
+static inline void hci_batch_begin(
+    hci_batch_t            *batch) {
+    batch->previous = batch->enabled;
+}
+
+/* Keep first error of batch */
+static inline void hci_batch_fail(
+    hci_batch_t            *batch,
+    const int               status) {
+
+    if (BT_HCI_SUCCESS == batch->status) {
+        batch->status = status;
+    }
+}
+
+/* First error of last batch, batch is clean again */
+static inline int hci_batch_take_status(
+    hci_batch_t            *batch) {
+
+    const int status = batch->status;
+
+    batch->status = BT_HCI_SUCCESS;
+
+    return status;
+}
+
+/* Milliseconds to 0.625 ms units within controller limits */
+static inline uint32_t hci_interval(
+    const uint32_t          ms,
+    const uint32_t          min,
+    const uint32_t          max) {
+
+    const uint64_t units = (uint64_t) ms * 8 / 5;
+
+    if (min > units) {
+        return min;
+    }
+
+    if (max < units) {
+        return max;
+    }
+
+    return (uint32_t) units;
+}
+
+#endif /* __BEACONIZER_HCI_BATCH_H__ */
+
+/* End of file */
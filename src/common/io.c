@@ -20,9 +20,13 @@
 #include "beaconizer/io.h"
 #include "beaconizer/utility.h"
 
+#include "loop_private.h"
+
 typedef struct io {
     int                 reference_count;
 
+    struct loop        *loop;
+
     int                 descriptor;
     uint32_t            events;
     int8_t              close_on_destroy;
@@ -65,7 +69,7 @@ static void io_unref(
     if (__sync_sub_and_fetch(&data->reference_count, 1))
         return;
 
-    free(data);
+    loop_release(data->loop, data, sizeof(io_t));
 }
 
 /* Clean up */
@@ -106,7 +110,7 @@ static void io_process_event(
         _io->write_callback = NULL;
 
         if (!_io->disconnect_callback) {
-            loop_remove_sd(_io->descriptor);
+            loop_remove_sd_in(_io->loop, _io->descriptor);
             io_unref(_io);
             return;
         }
@@ -122,7 +126,7 @@ static void io_process_event(
 
             _io->events &= ~EPOLLRDHUP;
 
-            loop_modify_sd(_io->descriptor, _io->events);
+            loop_modify_sd_in(_io->loop, _io->descriptor, _io->events);
         }
     }
 
@@ -138,7 +142,7 @@ static void io_process_event(
 
             _io->events &= ~EPOLLIN;
 
-            loop_modify_sd(_io->descriptor, _io->events);
+            loop_modify_sd_in(_io->loop, _io->descriptor, _io->events);
         }
     }
 
@@ -155,7 +159,7 @@ static void io_process_event(
 
             _io->events &= ~EPOLLOUT;
 
-            loop_modify_sd(_io->descriptor, _io->events);
+            loop_modify_sd_in(_io->loop, _io->descriptor, _io->events);
         }
     }
 
@@ -163,28 +167,39 @@ static void io_process_event(
 }
 
 /* Create and initialize new I/O channel using existing socket */
-io_t *io_new(
+io_t *io_new_in(
+    struct loop *loop,
     int descriptor) {
 
     io_t *_io = NULL;
 
-    if (0 > descriptor)
+    if (NULL == loop || 0 > descriptor)
+        return NULL;
+
+    _io = loop_alloc(loop, sizeof(io_t));
+    if (NULL == _io)
         return NULL;
 
-    _io = malloc(sizeof(io_t));
     memset(_io, 0, sizeof(io_t));
+    _io->loop = loop;
     _io->descriptor = descriptor;
     _io->events = 0;
     _io->close_on_destroy = 0;
 
-    if (0 > loop_add_sd(_io->descriptor, _io->events, io_process_event, _io, io_destroy_callback)) {
-        free(_io);
+    if (0 > loop_add_sd_in(loop, _io->descriptor, _io->events, io_process_event, _io, io_destroy_callback)) {
+        loop_release(loop, _io, sizeof(io_t));
         return NULL;
     }
 
     return io_ref(_io);
 }
 
+/* Create and initialize new I/O channel in default loop */
+io_t *io_new(
+    int descriptor) {
+    return io_new_in(loop_default(), descriptor);
+}
+
 /* Extract descriptor */
 int io_get_descriptor(io_t *_io) {
 
@@ -234,7 +249,7 @@ int io_set_read_handler(
     if (events == _io->events)
         return 1;
 
-    if (loop_modify_sd(_io->descriptor, events) < 0)
+    if (loop_modify_sd_in(_io->loop, _io->descriptor, events) < 0)
         return 0;
 
     _io->events = events;
@@ -269,7 +284,7 @@ int io_set_write_handler(
     if (events == _io->events)
         return 1;
 
-    if (loop_modify_sd(_io->descriptor, events) < 0)
+    if (loop_modify_sd_in(_io->loop, _io->descriptor, events) < 0)
         return 0;
 
     _io->events = events;
@@ -304,7 +319,7 @@ int io_set_disconnect_handler(
     if (events == _io->events)
         return 1;
 
-    if (0 > loop_modify_sd(_io->descriptor, events))
+    if (0 > loop_modify_sd_in(_io->loop, _io->descriptor, events))
         return 0;
 
     _io->events = events;
@@ -354,7 +369,7 @@ void io_destroy(
     data->write_callback = NULL;
     data->disconnect_callback = NULL;
 
-    loop_remove_sd(data->descriptor);
+    loop_remove_sd_in(data->loop, data->descriptor);
 
     io_unref(data);
 }
@@ -13,13 +13,23 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <sched.h>
+#include <time.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 #include "beaconizer/config.h"
 #include "beaconizer/loop.h"
 #include "beaconizer/watchdog.h"
 
-#define ENTRY_CHANGE   4
+#include "loop_private.h"
+#include "pool.h"
+
+#define ENTRY_CHANGE   4           /* Initial entry storage size */
+#define BATCH_MIN      8           /* Smallest epoll() event batch */
+#define BATCH_IDLE     16          /* Underused wakeups before batch shrinks */
+#define POOL_CLASSES   4           /* Object pools of 32, 64, 128 and 256 bytes */
+#define POOL_SHIFT     5           /* Smallest pooled object is 1 << POOL_SHIFT */
 
 /* Loop entry type */
 typedef struct {
@@ -35,19 +45,71 @@ typedef struct {
     size_t              count;          /* Allocated entry count */
     size_t              top;            /* Current entry. Always point to the top */  
     event_entry_t     **entry;          /* Pointer to entry */
+
+    size_t              index_count;    /* Allocated index slots */
+    size_t             *index;          /* Descriptor to entry position + 1, 0 if not watched */
 } storage_t;
 
 typedef struct epoll_event epoll_event_t;
 
+/* Event batch */
+typedef struct {
+    epoll_event_t      *event;          /* Events returned by epoll_wait() */
+    size_t              size;           /* Batch size */
+    size_t              idle;           /* Wakeups in a row using less than a quarter of batch */
+    int                 count;          /* Events in the current batch */
+    int                 current;        /* Event being dispatched */
+} batch_t;
+
+/* Posted task */
+typedef struct task {
+    struct task        *next;           /* Next task in queue */
+    task_fn_t           callback;       /* Task callback */
+    void               *user_data;      /* Custom user data */
+    destructor_t        destructor;     /* Clean up of task dropped at quit */
+} task_t;
+
+/* Lock-free multi-producer single-consumer task queue */
+typedef struct {
+    task_t             *head;           /* Last pushed task, producers side */
+    task_t             *tail;           /* Next task to run, loop side */
+    task_t              stub;           /* Stub keeping queue never empty */
+    int                 fd;             /* eventfd() to wake up the loop */
+    int                 signalled;      /* Wake up is pending */
+    int                 posting;        /* Producers inside loop_post_in() */
+    int                 closed;         /* Queue does not accept tasks */
+} post_queue_t;
+
+/* Loop statistics */
+typedef struct {
+    uint64_t            wakeups;        /* epoll_wait() returns with events */
+    uint64_t            events;         /* Events dispatched */
+    uint64_t            run_time;       /* Time spent running before start, ns */
+    uint64_t            start;          /* Current run or window start, ns, 0 if not running */
+} stats_t;
+
 /* Loop control structure */
-static struct {
+struct loop {
     int             fd;             /* epoll() descriptor */
     
     int             terminate;      /* Loop termination flag */
     int             status;         /* Exit status */
 
     storage_t       storage;        /* Entry storage */
-} __s_data = {
+    batch_t         batch;          /* Event batch */
+    post_queue_t    post;           /* Tasks posted from other threads */
+
+    struct timers  *timers;         /* Timer state, see timer.c */
+
+    stats_t         stats;          /* Loop statistics */
+
+    pool_t          pool[POOL_CLASSES];     /* Object pools by size */
+    size_t          live;           /* Pooled objects not released yet */
+    int             orphaned;       /* Freed with objects live, last release frees it */
+};
+
+/* Default loop */
+static struct loop __s_data = {
     .fd             = -1,
 
     .terminate      = 0,
@@ -56,122 +118,536 @@ static struct {
     .storage        = {
         .count      = 0,
         .top        = 0,
-        .entry      = NULL
+        .entry      = NULL,
+
+        .index_count = 0,
+        .index      = NULL
+    },
+
+    .batch          = {
+        .event      = NULL,
+        .size       = 0,
+        .idle       = 0,
+        .count      = 0,
+        .current    = 0
+    },
+
+    .post           = {
+        .head       = NULL,
+        .tail       = NULL,
+        .fd         = -1,
+        .signalled  = 0,
+        .posting    = 0,
+        .closed     = 1
+    },
+
+    .timers         = NULL,
+
+    .stats          = {
+        .wakeups    = 0,
+        .events     = 0,
+        .run_time   = 0,
+        .start      = 0
     }
 };
 
-/* Initialize loop */
-int loop_init(void) {
+/* Pool serving objects of given size, POOL_CLASSES if too large */
+static inline size_t pool_class(
+    const size_t        size) {
 
-    size_t i;
+    size_t i = 0;
 
-    /* Create epoll() descriptor */
-    __s_data.fd = epoll_create1(EPOLL_CLOEXEC);
-    if ( 0 > __s_data.fd) {
-        return (0 > errno ? errno : -errno);
+    while (POOL_CLASSES > i && ((size_t) 1 << (POOL_SHIFT + i)) < size) {
+        ++i;
     }
 
-    /* Allocate storage */
-    __s_data.storage.entry = malloc(sizeof(event_entry_t *) * ENTRY_CHANGE);
-    if (NULL == __s_data.storage.entry) {
-        return (0 > ENOMEM ? ENOMEM : -ENOMEM);
+    return i;
+}
+
+/* Allocate object from loop pools */
+void *loop_alloc(
+    struct loop        *loop,
+    const size_t        size) {
+
+    const size_t i = pool_class(size);
+
+    if (POOL_CLASSES == i) {
+        return malloc(size);
+    }
+
+    void *object;
+
+    if (0 == loop->pool[i].size) {
+        pool_init(&loop->pool[i], (size_t) 1 << (POOL_SHIFT + i));
     }
 
-    /* Initialize storage */
-    __s_data.storage.count = ENTRY_CHANGE;
-    for (i = 0; __s_data.storage.count > i; i++) {
-        __s_data.storage.entry[i] = NULL;
+    object = pool_get(&loop->pool[i]);
+    if (NULL != object) {
+        loop->live++;
     }
 
-    /* Initialize watchdog */
-    watchdog_init();
+    return object;
+}
+
+/* Release pools and loop itself */
+static void loop_destroy(
+    struct loop        *loop) {
+
+    for (size_t i = 0; POOL_CLASSES > i; ++i) {
+        pool_destroy(&loop->pool[i]);
+    }
+
+    free(loop);
+}
+
+/* Return object to loop pools */
+void loop_release(
+    struct loop        *loop,
+    void               *object,
+    const size_t        size) {
+
+    const size_t i = pool_class(size);
+
+    if (POOL_CLASSES == i) {
+        free(object);
+        return;
+    }
+
+    pool_put(&loop->pool[i], object);
+
+    /* Last object of loop freed while they were still out */
+    if (0 == --loop->live && loop->orphaned) {
+        loop_destroy(loop);
+    }
+}
+
+/* Find entry position by descriptor, -1 if not watched */
+static inline ssize_t storage_find(
+    struct loop        *loop,
+    const int           sd) {
+
+    if ((size_t) sd >= loop->storage.index_count) {
+        return -1;
+    }
+
+    return (ssize_t) loop->storage.index[sd] - 1;
+}
+
+/* Make descriptor index large enough to hold sd */
+static int storage_index_reserve(
+    struct loop        *loop,
+    const int           sd) {
+
+    size_t count = loop->storage.index_count;
+    size_t *p;
+
+    if ((size_t) sd < count) {
+        return EXIT_SUCCESS;
+    }
+
+    /* Descriptors are allocated lowest first, so double to stay amortised */
+    if (0 == count) {
+        count = __MAX_LOOP_ENTRIES;
+    }
+    while ((size_t) sd >= count) {
+        count <<= 1;
+    }
+
+    p = realloc(loop->storage.index, sizeof(size_t) * count);
+    if (NULL == p) {
+        return (0 > ENOMEM ? ENOMEM : -ENOMEM);
+    }
+
+    memset(p + loop->storage.index_count, 0, sizeof(size_t) * (count - loop->storage.index_count));
+
+    loop->storage.index = p;
+    loop->storage.index_count = count;
 
     return EXIT_SUCCESS;
 }
 
-/* Add descriptor to watch */
-int loop_add_sd(
-    const int           sd,
-    const uint32_t      event_mask,
-    event_fn_t           callback,
-    void                *user_data,
-    destructor_t        destructor) {
+/* Make entry storage large enough to hold count more entries */
+static int storage_reserve(
+    struct loop        *loop,
+    const size_t        count) {
 
-    event_entry_t        *p_data = NULL;
-    struct epoll_event  event;
-    int                 error = EXIT_SUCCESS;
-    size_t              i;
+    size_t size = loop->storage.count;
+    event_entry_t **p;
+
+    if (loop->storage.top + count <= size) {
+        return EXIT_SUCCESS;
+    }
+
+    /* Grow geometrically to keep registration amortised O(1) */
+    if (ENTRY_CHANGE > size) {
+        size = ENTRY_CHANGE;
+    }
+    while (loop->storage.top + count > size) {
+        size <<= 1;
+    }
+
+    p = realloc(loop->storage.entry, sizeof(event_entry_t *) * size);
+    if (NULL == p) {
+        return (0 > ENOMEM ? ENOMEM : -ENOMEM);
+    }
+
+    memset(p + loop->storage.count, 0, sizeof(event_entry_t *) * (size - loop->storage.count));
+
+    loop->storage.entry = p;
+    loop->storage.count = size;
+
+    return EXIT_SUCCESS;
+}
+
+/* Check registration */
+static inline int storage_check(
+    struct loop        *loop,
+    const loop_sd_t    *sd) {
 
     /* Exit if socket descriptor is wrong */
-    if (0 > sd) {
+    if (0 > sd->sd) {
         return (0 > EINVAL ? EINVAL : -EINVAL);
     }
 
     /* Exit if callback is NULL */
-    if (NULL == callback) {
+    if (NULL == sd->callback) {
         return (0 > EINVAL ? EINVAL : -EINVAL);
     }
 
-    /* Reallocate if no free memory */
-    if (__s_data.storage.count <= (__s_data.storage.top + 1)) {
-
-        event_entry_t** ep = malloc(sizeof(event_entry_t *) * (__s_data.storage.count + ENTRY_CHANGE));
-        if (NULL == ep) {
-            return (0 > ENOMEM ? ENOMEM : -ENOMEM);
-        }
-
-        for (i = 0; __s_data.storage.count > i; ++i) {
-            ep[i] = __s_data.storage.entry[i];
-            __s_data.storage.entry[i] = NULL;
-        }
+    /* Exit if descriptor is already watched */
+    if (0 <= storage_find(loop, sd->sd)) {
+        return (0 > EEXIST ? EEXIST : -EEXIST);
+    }
 
-        __s_data.storage.count += ENTRY_CHANGE;
+    return EXIT_SUCCESS;
+}
 
-        do {
-            ep[i++] = NULL;
-        } while (__s_data.storage.count > i);
+/* Register descriptor, storage and index must be already reserved */
+static int storage_insert(
+    struct loop        *loop,
+    const loop_sd_t    *sd) {
 
-        free(__s_data.storage.entry);
-        __s_data.storage.entry = ep;
-    }
+    event_entry_t      *p_data = NULL;
+    struct epoll_event  event;
 
     /* Allocate loop entry */
-    p_data = malloc(sizeof(*p_data));
+    p_data = loop_alloc(loop, sizeof(*p_data));
     if (NULL == p_data) {
         return (0 > ENOMEM ? ENOMEM : -ENOMEM);
     }
 
     /* Fill loop entry */
-    p_data->sd          = sd;
-    p_data->event_mask  = event_mask;
-    p_data->callback    = callback;
-    p_data->destructor     = destructor;
-    p_data->user_data   = user_data;
+    p_data->sd          = sd->sd;
+    p_data->event_mask  = sd->event_mask;
+    p_data->callback    = sd->callback;
+    p_data->destructor  = sd->destructor;
+    p_data->user_data   = sd->user_data;
 
     /* Fill epoll() event entry */
-    event.events        = event_mask;
+    memset(&event, 0, sizeof(event));
+    event.events        = sd->event_mask;
     event.data.ptr      = p_data;
 
     /* Add epoll entry */
-    if (0 != epoll_ctl(__s_data.fd, EPOLL_CTL_ADD, p_data->sd, &event)) {
-        free(p_data);
-        return errno;
+    if (0 != epoll_ctl(loop->fd, EPOLL_CTL_ADD, p_data->sd, &event)) {
+        loop_release(loop, p_data, sizeof(*p_data));
+        return -errno;
     }
 
     /* Store loop entry on success */
-    __s_data.storage.entry[__s_data.storage.top++] = p_data;
+    loop->storage.index[sd->sd] = loop->storage.top + 1;
+    loop->storage.entry[loop->storage.top++] = p_data;
+
+    return EXIT_SUCCESS;
+}
+
+/* Push task, safe from any thread */
+static inline void post_push(
+    post_queue_t       *queue,
+    task_t             *task) {
+
+    task_t *prev;
+
+    __atomic_store_n(&task->next, NULL, __ATOMIC_RELAXED);
+    prev = __atomic_exchange_n(&queue->head, task, __ATOMIC_ACQ_REL);
+    __atomic_store_n(&prev->next, task, __ATOMIC_RELEASE);
+}
+
+/* Pop task, loop thread only. Returns NULL when the queue is empty and
+ * sets *busy when a producer is in the middle of a push */
+static inline task_t *post_pop(
+    post_queue_t       *queue,
+    int                *busy) {
+
+    task_t *tail = queue->tail;
+    task_t *next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+
+    *busy = 0;
+
+    /* Skip stub */
+    if (&queue->stub == tail) {
+        if (NULL == next) {
+            *busy = (&queue->stub != __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE));
+            return NULL;
+        }
+        queue->tail = next;
+        tail = next;
+        next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    }
+
+    if (NULL != next) {
+        queue->tail = next;
+        return tail;
+    }
+
+    /* Last task is not linked yet */
+    if (tail != __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE)) {
+        *busy = 1;
+        return NULL;
+    }
+
+    /* Put stub back to release the last task */
+    post_push(queue, &queue->stub);
+
+    next = __atomic_load_n(&tail->next, __ATOMIC_ACQUIRE);
+    if (NULL != next) {
+        queue->tail = next;
+        return tail;
+    }
+
+    *busy = 1;
+    return NULL;
+}
+
+/* Run every posted task on a single wake up */
+static void post_dispatch(
+    int                 sd,
+    uint32_t            event_mask,
+    void               *user_data) {
+
+    struct loop *loop = user_data;
+    task_t *task;
+    uint64_t value;
+    int busy;
+
+    if (sizeof(value) != read(sd, &value, sizeof(value)) && EAGAIN != errno) {
+        return;
+    }
+
+    /* Producers posting from now on must wake us up again */
+    __atomic_store_n(&loop->post.signalled, 0, __ATOMIC_SEQ_CST);
+
+    while (0 == loop->terminate) {
+
+        task = post_pop(&loop->post, &busy);
+        if (NULL == task) {
+            if (busy) {
+                sched_yield();
+                continue;
+            }
+            break;
+        }
+
+        task->callback(task->user_data);
+        free(task);
+    }
+}
+
+/* Set up task queue */
+static int post_setup(
+    struct loop        *loop) {
+
+    int error;
+
+    loop->post.stub.next = NULL;
+    loop->post.head = &loop->post.stub;
+    loop->post.tail = &loop->post.stub;
+    loop->post.signalled = 0;
+
+    loop->post.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (0 > loop->post.fd) {
+        return -errno;
+    }
+
+    error = loop_add_sd_in(loop, loop->post.fd, EPOLLIN, post_dispatch, loop, NULL);
+    if (EXIT_SUCCESS != error) {
+        return error;
+    }
+
+    __atomic_store_n(&loop->post.closed, 0, __ATOMIC_SEQ_CST);
+
+    return EXIT_SUCCESS;
+}
+
+/* Drop tasks never run and close queue */
+static void post_cleanup(
+    struct loop        *loop) {
+
+    task_t *task;
+    int busy;
+
+    /* Stop accepting tasks and wait for producers still posting */
+    __atomic_store_n(&loop->post.closed, 1, __ATOMIC_SEQ_CST);
+    while (0 != __atomic_load_n(&loop->post.posting, __ATOMIC_SEQ_CST)) {
+        sched_yield();
+    }
+
+    if (NULL != loop->post.head) {
+        while (NULL != (task = post_pop(&loop->post, &busy)) || busy) {
+            if (NULL != task && NULL != task->destructor) {
+                task->destructor(task->user_data);
+            }
+            free(task);
+        }
+    }
+
+    if (0 <= loop->post.fd) {
+        close(loop->post.fd);
+        loop->post.fd = -1;
+    }
+}
+
+/* Set up loop */
+static int loop_setup(
+    struct loop        *loop) {
+
+    int error;
+
+    /* Reset state left by previous run */
+    loop->terminate = 0;
+    memset(&loop->stats, 0, sizeof(loop->stats));
+
+    /* Create epoll() descriptor */
+    loop->fd = epoll_create1(EPOLL_CLOEXEC);
+    if ( 0 > loop->fd) {
+        return (0 > errno ? errno : -errno);
+    }
+
+    /* Allocate storage */
+    error = storage_reserve(loop, ENTRY_CHANGE);
+    if (EXIT_SUCCESS != error) {
+        return error;
+    }
+
+    /* Set up cross-thread task queue */
+    return post_setup(loop);
+}
+
+/* Add descriptor to watch */
+int loop_add_sd_in(
+    struct loop        *loop,
+    const int           sd,
+    const uint32_t      event_mask,
+    event_fn_t          callback,
+    void               *user_data,
+    destructor_t        destructor) {
+
+    const loop_sd_t     entry = {
+        .sd             = sd,
+        .event_mask     = event_mask,
+        .callback       = callback,
+        .user_data      = user_data,
+        .destructor     = destructor
+    };
+    int                 error = EXIT_SUCCESS;
+
+    /* Check arguments */
+    error = storage_check(loop, &entry);
+    if (EXIT_SUCCESS != error) {
+        return error;
+    }
+
+    /* Make room in descriptor index */
+    error = storage_index_reserve(loop, sd);
+    if (EXIT_SUCCESS != error) {
+        return error;
+    }
+
+    /* Make room in entry storage */
+    error = storage_reserve(loop, 1);
+    if (EXIT_SUCCESS != error) {
+        return error;
+    }
+
+    return storage_insert(loop, &entry);
+}
+
+/* Add several descriptors to watch */
+int loop_add_many_in(
+    struct loop        *loop,
+    const loop_sd_t    *sds,
+    const size_t        count) {
+
+    int                 error = EXIT_SUCCESS;
+    int                 max_sd = -1;
+    size_t              i;
+
+    if (NULL == sds && 0 != count) {
+        return (0 > EINVAL ? EINVAL : -EINVAL);
+    }
+
+    /* Check everything before touching the loop */
+    for (i = 0; count > i; ++i) {
+
+        error = storage_check(loop, &sds[i]);
+        if (EXIT_SUCCESS != error) {
+            return error;
+        }
+
+        if (sds[i].sd > max_sd) {
+            max_sd = sds[i].sd;
+        }
+    }
+
+    if (0 == count) {
+        return EXIT_SUCCESS;
+    }
+
+    /* Reserve once */
+    error = storage_index_reserve(loop, max_sd);
+    if (EXIT_SUCCESS != error) {
+        return error;
+    }
+
+    error = storage_reserve(loop, count);
+    if (EXIT_SUCCESS != error) {
+        return error;
+    }
+
+    /* Register in one pass */
+    for (i = 0; count > i; ++i) {
+
+        error = storage_insert(loop, &sds[i]);
+        if (EXIT_SUCCESS == error) {
+            continue;
+        }
+
+        /* Roll back what was added, without calling destructors */
+        while (i--) {
+            event_entry_t *p_entry = loop->storage.entry[--loop->storage.top];
+
+            loop->storage.entry[loop->storage.top] = NULL;
+            loop->storage.index[p_entry->sd] = 0;
+
+            epoll_ctl(loop->fd, EPOLL_CTL_DEL, p_entry->sd, NULL);
+            loop_release(loop, p_entry, sizeof(*p_entry));
+        }
+
+        return error;
+    }
 
     return EXIT_SUCCESS;
 }
 
 /* Modify watched descriptor */
-int loop_modify_sd(
+int loop_modify_sd_in(
+    struct loop        *loop,
     const int           sd,
     uint32_t            event_mask) {
 
     event_entry_t *p_entry = NULL;
     struct epoll_event event;
-    size_t i;
+    ssize_t position;
     int error = EXIT_SUCCESS;
 
     /* Exit if socket descriptor is wrong */
@@ -180,23 +656,19 @@ int loop_modify_sd(
     }
 
     /* Find entry */
-    for (i = 0; __s_data.storage.top > i; ++i) {
-        if (sd == __s_data.storage.entry[i]->sd) {
-            p_entry = __s_data.storage.entry[i];
-            break;
-        }
-    }
+    position = storage_find(loop, sd);
 
     /* Entry not found. Exit! */
-    if (NULL == p_entry) {
+    if (0 > position) {
         return (0 > ENXIO ? ENXIO : -ENXIO);
     }
+    p_entry = loop->storage.entry[position];
 
     memset(&event, 0, sizeof(event));
     event.events = event_mask;
     event.data.ptr = p_entry;
 
-    error = epoll_ctl(__s_data.fd, EPOLL_CTL_MOD, p_entry->sd, &event);
+    error = epoll_ctl(loop->fd, EPOLL_CTL_MOD, p_entry->sd, &event);
     if (0 > error) {
         return error;
     }
@@ -207,12 +679,13 @@ int loop_modify_sd(
 }
 
 /* Remove watched descriptor */
-int loop_remove_sd(
+int loop_remove_sd_in(
+    struct loop        *loop,
     const int           sd) {
 
-    size_t i, entry_to_delete = 0;
-    event_entry_t *p_entry = NULL;
-    int error = EXIT_SUCCESS;
+    event_entry_t *p_entry = NULL, *p_last = NULL;
+    ssize_t position;
+    int i, error = EXIT_SUCCESS;
 
     /* Exit if socket descriptor is wrong */
     if (0 > sd) {
@@ -220,28 +693,32 @@ int loop_remove_sd(
     }
 
     /* Find entry */
-    for (i = 0; __s_data.storage.top > i; ++i) {
-        if (sd == __s_data.storage.entry[i]->sd) {
-            p_entry = __s_data.storage.entry[i];
-            entry_to_delete = i;
-            break;
-        }
-    }
+    position = storage_find(loop, sd);
 
     /* Entry not found */
-    if (NULL == p_entry) {
+    if (0 > position) {
         return (0 > ENXIO ? ENXIO : -ENXIO);
     }
+    p_entry = loop->storage.entry[position];
 
-    /* Shift entries */
-    for (i = entry_to_delete; __s_data.storage.top > (i + 2); ++i) {
-        __s_data.storage.entry[i] = __s_data.storage.entry[i + 1];
+    /* Move the top entry into the hole */
+    loop->storage.top--;
+    p_last = loop->storage.entry[loop->storage.top];
+    loop->storage.entry[position] = p_last;
+    loop->storage.index[p_last->sd] = position + 1;
+
+    loop->storage.entry[loop->storage.top] = NULL;
+    loop->storage.index[sd] = 0;
+
+    /* Drop events of this entry not yet dispatched */
+    for (i = loop->batch.current + 1; loop->batch.count > i; ++i) {
+        if (p_entry == loop->batch.event[i].data.ptr) {
+            loop->batch.event[i].data.ptr = NULL;
+        }
     }
-    __s_data.storage.top--;
-    __s_data.storage.entry[__s_data.storage.top] = NULL;
 
     /* Remove entry from epoll() queue */
-    error = epoll_ctl(__s_data.fd, EPOLL_CTL_DEL, p_entry->sd, NULL);
+    error = epoll_ctl(loop->fd, EPOLL_CTL_DEL, p_entry->sd, NULL);
 
     /* Call destructor */
     if (NULL != p_entry->destructor) {
@@ -249,99 +726,426 @@ int loop_remove_sd(
     }
 
     /* Clean up */
-    free(p_entry);
+    loop_release(loop, p_entry, sizeof(*p_entry));
 
     return error;
 }
 
+/* Resize event batch */
+static int batch_resize(
+    struct loop        *loop,
+    const size_t        size) {
+
+    epoll_event_t *p = realloc(loop->batch.event, sizeof(epoll_event_t) * size);
+    if (NULL == p) {
+        return (0 > ENOMEM ? ENOMEM : -ENOMEM);
+    }
+
+    loop->batch.event = p;
+    loop->batch.size = size;
+    loop->batch.idle = 0;
+
+    return EXIT_SUCCESS;
+}
+
+/* Adapt event batch to the last wakeup */
+static inline void batch_adapt(
+    struct loop        *loop) {
+
+    size_t size = loop->batch.size;
+
+    /* Batch is full, more events are likely pending */
+    if ((size_t) loop->batch.count == size) {
+        if (__MAX_EPOLL_EVENTS > size) {
+            size <<= 1;
+            batch_resize(loop, __MAX_EPOLL_EVENTS < size ? __MAX_EPOLL_EVENTS : size);
+        }
+        return;
+    }
+
+    /* Batch is mostly empty for a while */
+    if ((size_t) loop->batch.count < (size >> 2)) {
+        if (BATCH_IDLE <= ++loop->batch.idle) {
+            size >>= 1;
+            batch_resize(loop, BATCH_MIN > size ? BATCH_MIN : size);
+        }
+        return;
+    }
+
+    loop->batch.idle = 0;
+}
+
 /* Run loop */
-void loop_run(void) {
+void loop_run_in(
+    struct loop        *loop) {
+
+    event_entry_t *p_entry = NULL;
+
+    /* Start with a small batch */
+    if (EXIT_SUCCESS != batch_resize(loop, BATCH_MIN < __MAX_EPOLL_EVENTS ? BATCH_MIN : __MAX_EPOLL_EVENTS)) {
+        return;
+    }
 
-    size_t i;
-    int count;
-    struct epoll_event* event_pool = malloc(sizeof(struct epoll_event) * __s_data.storage.count);
+    loop->stats.start = clock_ns();
 
     /* Loop */
-    while (0 == __s_data.terminate) {
+    while (0 == loop->terminate) {
  
         /* Wait for events */
-        count = epoll_wait(__s_data.fd, event_pool, __s_data.storage.top, -1);
+        loop->batch.count = epoll_wait(loop->fd, loop->batch.event, loop->batch.size, -1);
 
         /* Nothing to process */
-        if (0 > count)
-            continue;
+        if (0 > loop->batch.count) {
+            loop->batch.count = 0;
+            if (EINTR == errno) {
+                continue;
+            }
+            break;
+        }
+
+        loop->stats.wakeups++;
+        loop->stats.events += loop->batch.count;
+
+        /* Process events. Callbacks may remove entries or stop the loop */
+        for (loop->batch.current = 0;
+             loop->batch.count > loop->batch.current;
+             loop->batch.current++) {
 
-        /* Process events */
-        for (i = 0; count > i; i++) {
-            event_entry_t *p_entry = event_pool[i].data.ptr;
-            p_entry->callback(p_entry->sd, event_pool[i].events, p_entry->user_data);
+            p_entry = loop->batch.event[loop->batch.current].data.ptr;
+            if (NULL == p_entry) {
+                continue;
+            }
+
+            p_entry->callback(
+                p_entry->sd,
+                loop->batch.event[loop->batch.current].events,
+                p_entry->user_data);
         }
+
+        /* Grow or shrink batch */
+        batch_adapt(loop);
+        loop->batch.count = 0;
     }
 
-    free(event_pool);
+    free(loop->batch.event);
+    loop->batch.event = NULL;
+    loop->batch.size = 0;
+    loop->batch.count = 0;
+
+    loop->stats.run_time += clock_ns() - loop->stats.start;
+    loop->stats.start = 0;
 }
 
 /* Loop clean up */
-static void loop_cleanup() {
+static void loop_cleanup(
+    struct loop        *loop) {
 
     event_entry_t *p_data = NULL;
 
     /* Done! */
-    __s_data.terminate = 1;
+    loop->terminate = 1;
+
+    /* Do not dispatch the rest of the batch */
+    loop->batch.count = 0;
 
     /* Clean up loop entries */
-    if (NULL != __s_data.storage.entry) {
+    if (NULL != loop->storage.entry) {
 
         /* Free entries */
-        for (size_t i = 0; __s_data.storage.top > i; ++i) {
-            p_data = __s_data.storage.entry[i];
-            __s_data.storage.entry[i] = NULL;
+        for (size_t i = 0; loop->storage.top > i; ++i) {
+            p_data = loop->storage.entry[i];
+            loop->storage.entry[i] = NULL;
 
             if (NULL != p_data) {
 
-                epoll_ctl(__s_data.fd, EPOLL_CTL_DEL, p_data->sd, NULL);
+                epoll_ctl(loop->fd, EPOLL_CTL_DEL, p_data->sd, NULL);
 
                 if (NULL != p_data->destructor) {
                     p_data->destructor(p_data->user_data);
                 }
 
-                free(p_data);
+                loop_release(loop, p_data, sizeof(*p_data));
             }
         }
 
-        free(__s_data.storage.entry);
+        free(loop->storage.entry);
 
-        __s_data.storage.top = 0;
-        __s_data.storage.count = 0;
-        __s_data.storage.entry = NULL;
+        loop->storage.top = 0;
+        loop->storage.count = 0;
+        loop->storage.entry = NULL;
     }
 
+    /* Clean up descriptor index */
+    free(loop->storage.index);
+    loop->storage.index = NULL;
+    loop->storage.index_count = 0;
+
+    /* Clean up task queue */
+    post_cleanup(loop);
+
+    /* Clean up timers left */
+    timers_free(loop->timers);
+    loop->timers = NULL;
+
     /* Close epoll descriptor() if open */
-    if (0 <= __s_data.fd) {
-        close(__s_data.fd);
-        __s_data.fd = -1;
+    if (0 <= loop->fd) {
+        close(loop->fd);
+        loop->fd = -1;
     }
 
     /* Shutdown watchdog */
-    watchdog_exit();
+    if (&__s_data == loop) {
+        watchdog_exit();
+    }
+}
+
+/* Post task to loop from any thread */
+int loop_post_in(
+    struct loop        *loop,
+    task_fn_t           callback,
+    void               *user_data,
+    destructor_t        destructor) {
+
+    const uint64_t value = 1;
+    task_t *task;
+
+    if (NULL == loop || NULL == callback) {
+        return (0 > EINVAL ? EINVAL : -EINVAL);
+    }
+
+    task = malloc(sizeof(task_t));
+    if (NULL == task) {
+        return (0 > ENOMEM ? ENOMEM : -ENOMEM);
+    }
+
+    task->callback = callback;
+    task->user_data = user_data;
+    task->destructor = destructor;
+
+    /* Keep the queue open while posting */
+    __atomic_add_fetch(&loop->post.posting, 1, __ATOMIC_SEQ_CST);
+
+    if (0 != __atomic_load_n(&loop->post.closed, __ATOMIC_SEQ_CST)) {
+        __atomic_sub_fetch(&loop->post.posting, 1, __ATOMIC_SEQ_CST);
+        free(task);
+        return (0 > ENOTCONN ? ENOTCONN : -ENOTCONN);
+    }
+
+    post_push(&loop->post, task);
+
+    /* Only the first post after the loop drained the queue wakes it up. Task
+     * is queued already: full counter still wakes the loop, on any other
+     * failure the next post tries again */
+    if (0 == __atomic_exchange_n(&loop->post.signalled, 1, __ATOMIC_SEQ_CST)) {
+        if (sizeof(value) != write(loop->post.fd, &value, sizeof(value)) && EAGAIN != errno) {
+            __atomic_store_n(&loop->post.signalled, 0, __ATOMIC_SEQ_CST);
+        }
+    }
+
+    __atomic_sub_fetch(&loop->post.posting, 1, __ATOMIC_SEQ_CST);
+
+    return EXIT_SUCCESS;
+}
+
+/* Create new loop instance */
+struct loop *loop_new(void) {
+
+    struct loop *loop = calloc(1, sizeof(struct loop));
+    if (NULL == loop) {
+        return NULL;
+    }
+
+    loop->fd = -1;
+    loop->status = EXIT_SUCCESS;
+    loop->post.fd = -1;
+    loop->post.closed = 1;
+
+    if (EXIT_SUCCESS != loop_setup(loop)) {
+        loop_cleanup(loop);
+        free(loop);
+        return NULL;
+    }
+
+    return loop;
+}
+
+/* Destroy loop instance */
+void loop_free(
+    struct loop        *loop) {
+
+    if (NULL == loop) {
+        return;
+    }
+
+    loop_cleanup(loop);
+
+    /* Default loop is static, its objects may outlive a run */
+    if (&__s_data == loop) {
+        return;
+    }
+
+    /* Objects still out would be released into freed pools: pools stay
+     * until the last of them comes back */
+    if (0 != loop->live) {
+        loop->orphaned = 1;
+        return;
+    }
+
+    loop_destroy(loop);
+}
+
+/* Default loop instance */
+struct loop *loop_default(void) {
+    return &__s_data;
+}
+
+/* Per-loop timer state */
+struct timers **loop_get_timers(
+    struct loop        *loop) {
+    return &loop->timers;
+}
+
+/* Read loop statistics */
+int loop_get_stats_in(
+    struct loop        *loop,
+    loop_stats_t       *stats) {
+
+    if (NULL == loop || NULL == stats) {
+        return (0 > EINVAL ? EINVAL : -EINVAL);
+    }
+
+    stats->wakeups = loop->stats.wakeups;
+    stats->events = loop->stats.events;
+    stats->run_time = loop->stats.run_time;
+
+    if (0 != loop->stats.start) {
+        stats->run_time += clock_ns() - loop->stats.start;
+    }
+
+    stats->wakeup_rate = (0 == stats->run_time) ? 0.0 : (double) stats->wakeups * 1e9 / (double) stats->run_time;
+
+    return EXIT_SUCCESS;
+}
+
+/* Start new statistics window */
+void loop_reset_stats_in(
+    struct loop        *loop) {
+
+    loop->stats.wakeups = 0;
+    loop->stats.events = 0;
+    loop->stats.run_time = 0;
+
+    if (0 != loop->stats.start) {
+        loop->stats.start = clock_ns();
+    }
 }
 
 /* Quit loop immediately */
-void loop_quit(void) {
-    watchdog_notify("STOPPING=1");
-    loop_cleanup();
+void loop_quit_in(
+    struct loop        *loop) {
+
+    if (&__s_data == loop) {
+        watchdog_notify("STOPPING=1");
+    }
+
+    loop_cleanup(loop);
 }
 
 /* Quit loop and set success */
-void loop_exit_success(void) {
-    loop_cleanup();
-    __s_data.status = EXIT_SUCCESS;
+void loop_exit_success_in(
+    struct loop        *loop) {
+    loop_cleanup(loop);
+    loop->status = EXIT_SUCCESS;
 }
 
 /* Quit loop and set failure */
+void loop_exit_failure_in(
+    struct loop        *loop) {
+    loop_cleanup(loop);
+    loop->status = EXIT_FAILURE;
+}
+
+/* Initialize default loop */
+int loop_init(void) {
+
+    int error = loop_setup(&__s_data);
+    if (EXIT_SUCCESS != error) {
+        return error;
+    }
+
+    /* Initialize watchdog */
+    watchdog_init();
+
+    return EXIT_SUCCESS;
+}
+
+/* Add descriptor to watch in default loop */
+int loop_add_sd(
+    const int           sd,
+    const uint32_t      event_mask,
+    event_fn_t          callback,
+    void               *user_data,
+    destructor_t        destructor) {
+    return loop_add_sd_in(&__s_data, sd, event_mask, callback, user_data, destructor);
+}
+
+/* Add several descriptors to watch in default loop */
+int loop_add_many(
+    const loop_sd_t    *sds,
+    const size_t        count) {
+    return loop_add_many_in(&__s_data, sds, count);
+}
+
+/* Modify watched descriptor in default loop */
+int loop_modify_sd(
+    const int           sd,
+    uint32_t            event_mask) {
+    return loop_modify_sd_in(&__s_data, sd, event_mask);
+}
+
+/* Remove watched descriptor from default loop */
+int loop_remove_sd(
+    const int           sd) {
+    return loop_remove_sd_in(&__s_data, sd);
+}
+
+/* Post task to default loop from any thread */
+int loop_post(
+    task_fn_t           callback,
+    void               *user_data,
+    destructor_t        destructor) {
+    return loop_post_in(&__s_data, callback, user_data, destructor);
+}
+
+/* Run default loop */
+void loop_run(void) {
+    loop_run_in(&__s_data);
+}
+
+/* Quit default loop immediately */
+void loop_quit(void) {
+    loop_quit_in(&__s_data);
+}
+
+/* Quit default loop and set success */
+void loop_exit_success(void) {
+    loop_exit_success_in(&__s_data);
+}
+
+/* Quit default loop and set failure */
 void loop_exit_failure(void) {
-    loop_cleanup();
-    __s_data.status = EXIT_FAILURE;
- }
+    loop_exit_failure_in(&__s_data);
+}
+
+/* Read default loop statistics */
+int loop_get_stats(
+    loop_stats_t       *stats) {
+    return loop_get_stats_in(&__s_data, stats);
+}
+
+/* Start new default loop statistics window */
+void loop_reset_stats(void) {
+    loop_reset_stats_in(&__s_data);
+}
 
- /* End of file */
\ No newline at end of file
+ /* End of file */
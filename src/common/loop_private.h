@@ -0,0 +1,55 @@
+/*!
+ *	\file		loop_private.h
+ *	\brief		Loop internals shared between library modules
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_LOOP_PRIVATE_H__
+#define __BEACONIZER_LOOP_PRIVATE_H__
+
+/* Forward declarations */
+struct loop;
+struct timers;
+
+/* Monotonic clock in nanoseconds */
+static inline uint64_t clock_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Allocate object from loop pools. Only from the loop thread; objects must
+ * be released before loop_free() */
+void *loop_alloc(
+    struct loop        *loop,
+    const size_t        size);
+
+/* Return object allocated by loop_alloc() with the same size */
+void loop_release(
+    struct loop        *loop,
+    void               *object,
+    const size_t        size);
+
+/* Per-loop timer state, created by timer.c on demand */
+struct timers **loop_get_timers(
+    struct loop        *loop);
+
+/* Release timer state. Called by loop clean up after all entries are gone */
+void timers_free(
+    struct timers      *timers);
+
+#endif /* __BEACONIZER_LOOP_PRIVATE_H__ */
+
+/* End of file */
@@ -0,0 +1,115 @@
+/*!
+ *	\file		pool.c
+ *	\brief		Fixed size object pool, single thread
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+
+#define SLAB_FIRST      16          /* Objects in first slab */
+#define SLAB_MAX        1024        /* Largest slab, in objects */
+
+/* Slab header, objects follow */
+struct pool_slab {
+    struct pool_slab   *next;       /* Next slab */
+    max_align_t         data[];     /* Objects */
+};
+
+/* Set up pool */
+void pool_init(
+    pool_t             *pool,
+    const size_t        size) {
+
+    const size_t align = sizeof(max_align_t);
+
+    memset(pool, 0, sizeof(pool_t));
+
+    /* Objects keep free list link and malloc() alignment */
+    pool->size = (size < sizeof(void *) ? sizeof(void *) : size);
+    pool->size = (pool->size + align - 1) / align * align;
+    pool->slab_count = SLAB_FIRST;
+}
+
+/* Add slab to pool */
+static int pool_grow(
+    pool_t             *pool) {
+
+    struct pool_slab *slab;
+    char *object;
+    size_t i;
+
+    slab = malloc(sizeof(struct pool_slab) + pool->slab_count * pool->size);
+    if (NULL == slab) {
+        return -1;
+    }
+
+    slab->next = pool->slab;
+    pool->slab = slab;
+
+    /* Chain objects to the free list */
+    object = (char *) slab->data;
+    for (i = 0; pool->slab_count > i; ++i, object += pool->size) {
+        *(void **) object = pool->free;
+        pool->free = object;
+    }
+
+    /* Grow geometrically */
+    if (SLAB_MAX > pool->slab_count) {
+        pool->slab_count *= 2;
+    }
+
+    return 0;
+}
+
+/* Take object */
+void *pool_get(
+    pool_t             *pool) {
+
+    void *object;
+
+    if (NULL == pool->free && 0 != pool_grow(pool)) {
+        return NULL;
+    }
+
+    object = pool->free;
+    pool->free = *(void **) object;
+
+    return object;
+}
+
+/* Return object */
+void pool_put(
+    pool_t             *pool,
+    void               *object) {
+
+    if (NULL == object) {
+        return;
+    }
+
+    *(void **) object = pool->free;
+    pool->free = object;
+}
+
+/* Release slabs */
+void pool_destroy(
+    pool_t             *pool) {
+
+    struct pool_slab *slab;
+
+    while (NULL != (slab = pool->slab)) {
+        pool->slab = slab->next;
+        free(slab);
+    }
+
+    pool->free = NULL;
+    pool->slab_count = SLAB_FIRST;
+}
+
+ /* End of file */
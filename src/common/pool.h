@@ -0,0 +1,49 @@
+/*!
+ *	\file		pool.h
+ *	\brief		Fixed size object pool, single thread
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+
+#pragma once
+
+#ifndef __BEACONIZER_POOL_H__
+#define __BEACONIZER_POOL_H__
+
+/* Slab of objects */
+struct pool_slab;
+
+/* Object pool. Objects come from slabs and go back to a free list, slabs
+ * are only released by pool_destroy() */
+typedef struct {
+    size_t              size;               /* Object size, 0 if not set up */
+    size_t              slab_count;         /* Objects in next slab */
+    void               *free;               /* Free objects */
+    struct pool_slab   *slab;               /* Allocated slabs */
+} pool_t;
+
+/* Set up pool of objects of given size */
+void pool_init(
+    pool_t             *pool,               /* Pool */
+    const size_t        size);              /* Object size */
+
+/* Take object from pool, NULL if out of memory */
+void *pool_get(
+    pool_t             *pool);              /* Pool */
+
+/* Return object to pool */
+void pool_put(
+    pool_t             *pool,               /* Pool */
+    void               *object);            /* Object */
+
+/* Release all slabs. Objects still in use become invalid */
+void pool_destroy(
+    pool_t             *pool);              /* Pool */
+
+#endif /* __BEACONIZER_POOL_H__ */
+
+/* End of file */
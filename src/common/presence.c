@@ -0,0 +1,399 @@
+/*!
+ *	\file		presence.c
+ *	\brief		Beacon presence events
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/presence.h"
+#include "beaconizer/timer.h"
+
+#include "loop_private.h"
+#include "tracker_private.h"
+
+/* No node */
+#define PRESENCE_NONE               UINT32_MAX
+
+/* Present beacon */
+typedef struct {
+    tracker_key_t       key;                /* Identity */
+    uint64_t            entered;            /* Enter time, ms */
+    uint64_t            seen;               /* Last sighting keeping it present, ms */
+    uint32_t            prev;               /* Older in lost queue */
+    uint32_t            next;               /* Newer in lost queue, next free */
+    uint32_t            hash;               /* Key hash */
+    uint8_t             dwelled;            /* Dwell event emitted */
+} presence_node_t;
+
+/* Engine. Every beacon has the same lost timeout, so ordering the queue by
+ * last sighting orders it by deadline too: re-arming is moving the node to
+ * the tail and only the head deadline is ever armed on the loop timer */
+struct presence {
+    struct loop        *loop;               /* Loop or NULL */
+    int                 timer;              /* Lost timer, 0 until created */
+    presence_config_t   config;             /* Set up */
+    presence_fn_t       callback;           /* Event callback */
+    void               *user_data;          /* User data */
+
+    presence_node_t    *node;               /* Nodes */
+    uint32_t            free;               /* Free node list */
+    uint32_t            head;               /* Oldest sighting */
+    uint32_t            tail;               /* Newest sighting */
+    size_t              count;              /* Beacons present */
+
+    uint32_t           *index;              /* Node + 1, 0 when free */
+    size_t              mask;               /* Index size - 1 */
+
+    presence_stats_t    stats;              /* Counters */
+};
+
+/* Index slot of key, or the free slot where it belongs */
+static inline size_t presence_probe(
+    const struct presence  *presence,
+    const tracker_key_t    *key,
+    const uint32_t          hash) {
+
+    const presence_node_t *node;
+    size_t i = hash & presence->mask;
+
+    while (0 != presence->index[i]) {
+
+        node = &presence->node[presence->index[i] - 1];
+        if (hash == node->hash && 0 == memcmp(&node->key, key, sizeof(tracker_key_t))) {
+            break;
+        }
+
+        i = (i + 1) & presence->mask;
+    }
+
+    return i;
+}
+
+/* Unlink node from lost queue */
+static inline void queue_unlink(
+    struct presence    *presence,
+    const uint32_t      n) {
+
+    presence_node_t *node = &presence->node[n];
+
+    if (PRESENCE_NONE != node->prev) {
+        presence->node[node->prev].next = node->next;
+    } else {
+        presence->head = node->next;
+    }
+
+    if (PRESENCE_NONE != node->next) {
+        presence->node[node->next].prev = node->prev;
+    } else {
+        presence->tail = node->prev;
+    }
+}
+
+/* Append node to lost queue */
+static inline void queue_push(
+    struct presence    *presence,
+    const uint32_t      n) {
+
+    presence->node[n].prev = presence->tail;
+    presence->node[n].next = PRESENCE_NONE;
+
+    if (PRESENCE_NONE != presence->tail) {
+        presence->node[presence->tail].next = n;
+    } else {
+        presence->head = n;
+    }
+
+    presence->tail = n;
+}
+
+/* Key hash of node in index slot */
+static uint32_t presence_slot_hash(
+    const void         *table,
+    const size_t        slot) {
+
+    const struct presence *presence = table;
+
+    return presence->node[presence->index[slot] - 1].hash;
+}
+
+/* Arm lost timer to head deadline */
+static void presence_arm(
+    struct presence    *presence,
+    const uint64_t      now) {
+
+    struct timespec ts = { 0, 0 };
+    uint64_t deadline;
+
+    if (NULL == presence->loop) {
+        return;
+    }
+
+    if (PRESENCE_NONE == presence->head) {
+        if (0 < presence->timer) {
+            cancel_timer_in(presence->loop, presence->timer);
+        }
+        return;
+    }
+
+    deadline = presence->node[presence->head].seen + presence->config.lost;
+    if (deadline > now) {
+        ts.tv_sec = (time_t) ((deadline - now) / 1000);
+        ts.tv_nsec = (long) ((deadline - now) % 1000) * 1000000;
+    }
+
+    if (0 < presence->timer) {
+        modify_timer_in(presence->loop, presence->timer, &ts);
+    }
+}
+
+/* Lost timer */
+static void presence_timer(
+    int                 id,
+    void               *user_data) {
+
+    presence_expire(user_data, clock_ns() / 1000000);
+}
+
+/* Fill config with defaults */
+void presence_config_init(
+    presence_config_t      *config) {
+
+    memset(config, 0, sizeof(presence_config_t));
+    config->capacity = PRESENCE_DEFAULT_CAPACITY;
+    config->enter_rssi = PRESENCE_DEFAULT_ENTER;
+    config->exit_rssi = PRESENCE_DEFAULT_EXIT;
+    config->lost = PRESENCE_DEFAULT_LOST;
+}
+
+/* Create engine */
+struct presence *presence_new_in(
+    struct loop                *loop,
+    const presence_config_t    *config,
+    presence_fn_t               callback,
+    void                       *user_data) {
+
+    struct presence *presence;
+    struct timespec ts;
+    size_t capacity, size = 16;
+
+    if (NULL == config || NULL == callback || config->exit_rssi > config->enter_rssi || 0 == config->lost) {
+        return NULL;
+    }
+
+    capacity = config->capacity ? config->capacity : PRESENCE_DEFAULT_CAPACITY;
+    if (UINT32_MAX / 2 <= capacity) {
+        return NULL;
+    }
+
+    /* Load factor stays below one half */
+    while (size < capacity * 2) {
+        size <<= 1;
+    }
+
+    presence = calloc(1, sizeof(struct presence));
+    if (NULL == presence) {
+        return NULL;
+    }
+
+    presence->loop = loop;
+    presence->config = *config;
+    presence->config.capacity = capacity;
+    presence->callback = callback;
+    presence->user_data = user_data;
+    presence->head = PRESENCE_NONE;
+    presence->tail = PRESENCE_NONE;
+    presence->mask = size - 1;
+
+    presence->node = malloc(capacity * sizeof(presence_node_t));
+    presence->index = calloc(size, sizeof(uint32_t));
+
+    if (NULL == presence->node || NULL == presence->index) {
+        presence_free(presence);
+        return NULL;
+    }
+
+    for (size_t i = 0; capacity > i; ++i) {
+        presence->node[i].next = (uint32_t) i + 1;
+    }
+    presence->node[capacity - 1].next = PRESENCE_NONE;
+
+    /* Timer stays idle until first enter */
+    if (NULL != loop) {
+
+        ts.tv_sec = config->lost / 1000;
+        ts.tv_nsec = (long) (config->lost % 1000) * 1000000;
+
+        presence->timer = create_timer_in(loop, &ts, presence_timer, presence, NULL);
+        if (0 >= presence->timer || EXIT_SUCCESS != cancel_timer_in(loop, presence->timer)) {
+            presence_free(presence);
+            return NULL;
+        }
+    }
+
+    return presence;
+}
+
+/* Create engine in default loop */
+struct presence *presence_new(
+    const presence_config_t    *config,
+    presence_fn_t               callback,
+    void                       *user_data) {
+    return presence_new_in(loop_default(), config, callback, user_data);
+}
+
+/* Destroy engine */
+void presence_free(
+    struct presence    *presence) {
+
+    if (NULL == presence) {
+        return;
+    }
+
+    if (NULL != presence->loop && 0 < presence->timer) {
+        destroy_timer_in(presence->loop, presence->timer);
+    }
+
+    free(presence->node);
+    free(presence->index);
+    free(presence);
+}
+
+/* Feed sighting */
+int presence_sighting(
+    struct presence        *presence,
+    const tracker_key_t    *key,
+    const int8_t            rssi,
+    const uint64_t          now) {
+
+    const uint32_t hash = key_hash(key);
+    const size_t i = presence_probe(presence, key, hash);
+    presence_node_t *node;
+    uint32_t n;
+
+    presence->stats.sightings++;
+
+    /* Present beacon: sightings in the hysteresis band keep it */
+    if (0 != presence->index[i]) {
+
+        if (presence->config.exit_rssi > rssi) {
+            return 1;
+        }
+
+        n = presence->index[i] - 1;
+        node = &presence->node[n];
+        node->seen = now;
+
+        if (presence->tail != n) {
+            queue_unlink(presence, n);
+            queue_push(presence, n);
+        }
+
+        if (0 != presence->config.dwell && !node->dwelled && now - node->entered >= presence->config.dwell) {
+            node->dwelled = 1;
+            presence->stats.dwelled++;
+            presence->callback(PRESENCE_DWELL, &node->key, now - node->entered, presence->user_data);
+        }
+
+        return 1;
+    }
+
+    if (presence->config.enter_rssi > rssi) {
+        return 0;
+    }
+
+    if (PRESENCE_NONE == presence->free) {
+        presence->stats.dropped++;
+        return -ENOSPC;
+    }
+
+    n = presence->free;
+    node = &presence->node[n];
+    presence->free = node->next;
+
+    node->key = *key;
+    node->entered = now;
+    node->seen = now;
+    node->hash = hash;
+    node->dwelled = 0;
+    presence->index[i] = n + 1;
+    presence->count++;
+
+    queue_push(presence, n);
+    if (presence->head == n) {
+        presence_arm(presence, now);
+    }
+
+    presence->stats.entered++;
+    presence->callback(PRESENCE_ENTER, &node->key, 0, presence->user_data);
+
+    return 1;
+}
+
+/* Emit due exits */
+size_t presence_expire(
+    struct presence    *presence,
+    const uint64_t      now) {
+
+    presence_node_t *node;
+    tracker_key_t key;
+    uint64_t duration;
+    size_t exited = 0;
+    uint32_t n;
+
+    while (PRESENCE_NONE != (n = presence->head)
+           && presence->node[n].seen + presence->config.lost <= now) {
+
+        node = &presence->node[n];
+        key = node->key;
+        duration = node->seen - node->entered;
+
+        /* Node is released before callback, which may feed sightings */
+        queue_unlink(presence, n);
+        index_remove(presence->index, presence->mask, presence_probe(presence, &node->key, node->hash),
+            presence_slot_hash, NULL, presence);
+        node->next = presence->free;
+        presence->free = n;
+        presence->count--;
+
+        presence->stats.exited++;
+        exited++;
+        presence->callback(PRESENCE_EXIT, &key, duration, presence->user_data);
+    }
+
+    presence_arm(presence, now);
+
+    return exited;
+}
+
+/* Beacons present */
+size_t presence_count(
+    const struct presence  *presence) {
+    return (NULL != presence) ? presence->count : 0;
+}
+
+/* Get counters */
+int presence_get_stats(
+    const struct presence  *presence,
+    presence_stats_t       *stats) {
+
+    if (NULL == presence || NULL == stats) {
+        return -EINVAL;
+    }
+
+    *stats = presence->stats;
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -0,0 +1,290 @@
+/*!
+ *	\file		reassembly.c
+ *	\brief		Extended advertising fragment reassembly
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "beaconizer/reassembly.h"
+
+/* Chain being assembled */
+typedef struct {
+    uint8_t             used;           /* Slot holds chain */
+    uint8_t             address_type;   /* Key: address type */
+    uint8_t             address[6];     /* Key: address */
+    uint8_t             sid;            /* Key: advertising set ID */
+    uint8_t             event_type;     /* First fragment header */
+    int8_t              tx_power;
+    uint16_t            length;         /* Data collected */
+    uint64_t            start;          /* First fragment time, ms */
+    uint8_t            *data;           /* Buffer in pool */
+} reassembly_chain_t;
+
+/* Reassembler */
+struct reassembly {
+    reassembly_chain_t *chain;          /* Chains */
+    size_t              capacity;       /* Chains */
+    size_t              pending;        /* Chains in use */
+    uint32_t            timeout;        /* Chain lifetime, ms */
+    uint8_t            *buffer;         /* Data of every chain */
+    scanner_fn_t        callback;       /* Payload callback */
+    void               *user_data;      /* User data */
+    reassembly_stats_t  stats;          /* Counters */
+};
+
+/* Chain of address and SID */
+static reassembly_chain_t *reassembly_find(
+    struct reassembly      *reassembly,
+    const scanner_report_t *report) {
+
+    reassembly_chain_t *chain;
+
+    for (size_t i = 0; reassembly->capacity > i; ++i) {
+
+        chain = &reassembly->chain[i];
+
+        if (chain->used && report->sid == chain->sid && report->address_type == chain->address_type
+            && 0 == memcmp(report->address, chain->address, sizeof(chain->address))) {
+            return chain;
+        }
+    }
+
+    return NULL;
+}
+
+/* Free chain slot */
+static inline void reassembly_release(
+    struct reassembly  *reassembly,
+    reassembly_chain_t *chain) {
+
+    chain->used = 0;
+    reassembly->pending--;
+}
+
+/* Take free slot, old chains make room */
+static reassembly_chain_t *reassembly_alloc(
+    struct reassembly      *reassembly,
+    const scanner_report_t *report,
+    const uint64_t          now) {
+
+    reassembly_chain_t *chain = NULL;
+
+    if (reassembly->capacity == reassembly->pending) {
+        reassembly_expire(reassembly, now);
+    }
+
+    for (size_t i = 0; reassembly->capacity > i && NULL == chain; ++i) {
+        if (!reassembly->chain[i].used) {
+            chain = &reassembly->chain[i];
+        }
+    }
+
+    if (NULL == chain) {
+        return NULL;
+    }
+
+    chain->used = 1;
+    chain->address_type = report->address_type;
+    memcpy(chain->address, report->address, sizeof(chain->address));
+    chain->sid = report->sid;
+    chain->event_type = report->event_type;
+    chain->tx_power = report->tx_power;
+    chain->length = 0;
+    chain->start = now;
+
+    reassembly->pending++;
+
+    return chain;
+}
+
+/* Create reassembler */
+struct reassembly *reassembly_new(
+    const size_t        capacity,
+    const uint32_t      timeout,
+    scanner_fn_t        callback,
+    void               *user_data) {
+
+    struct reassembly *reassembly;
+
+    if (NULL == callback) {
+        return NULL;
+    }
+
+    reassembly = calloc(1, sizeof(struct reassembly));
+    if (NULL == reassembly) {
+        return NULL;
+    }
+
+    reassembly->capacity = capacity ? capacity : REASSEMBLY_DEFAULT_CAPACITY;
+    reassembly->timeout = timeout;
+    reassembly->callback = callback;
+    reassembly->user_data = user_data;
+
+    reassembly->chain = calloc(reassembly->capacity, sizeof(reassembly_chain_t));
+    reassembly->buffer = malloc(reassembly->capacity * SCANNER_MAX_EXT_DATA);
+
+    if (NULL == reassembly->chain || NULL == reassembly->buffer) {
+        reassembly_free(reassembly);
+        return NULL;
+    }
+
+    for (size_t i = 0; reassembly->capacity > i; ++i) {
+        reassembly->chain[i].data = reassembly->buffer + i * SCANNER_MAX_EXT_DATA;
+    }
+
+    return reassembly;
+}
+
+/* Destroy reassembler */
+void reassembly_free(
+    struct reassembly  *reassembly) {
+
+    if (NULL == reassembly) {
+        return;
+    }
+
+    free(reassembly->chain);
+    free(reassembly->buffer);
+    free(reassembly);
+}
+
+/* Feed report or fragment */
+int reassembly_push(
+    struct reassembly      *reassembly,
+    const scanner_report_t *report,
+    const uint64_t          now) {
+
+    reassembly_chain_t *chain = NULL;
+    scanner_report_t payload;
+
+    if (NULL == reassembly || NULL == report || (0 != report->length && NULL == report->data)) {
+        return -EINVAL;
+    }
+
+    /* Nothing pending: no lookup at all */
+    if (0 != reassembly->pending) {
+        chain = reassembly_find(reassembly, report);
+    }
+
+    /* Rest of chain never came */
+    if (NULL != chain && now - chain->start > reassembly->timeout) {
+        reassembly_release(reassembly, chain);
+        reassembly->stats.timeouts++;
+        chain = NULL;
+    }
+
+    if (NULL == chain) {
+
+        /* Fast path: payload in one piece stays in event buffer */
+        if (SCANNER_DATA_COMPLETE == report->status) {
+            reassembly->stats.direct++;
+            reassembly->callback(report, reassembly->user_data);
+            return 1;
+        }
+
+        if (SCANNER_DATA_TRUNCATED == report->status) {
+            reassembly->stats.truncated++;
+            return -ECANCELED;
+        }
+
+        chain = reassembly_alloc(reassembly, report, now);
+        if (NULL == chain) {
+            reassembly->stats.overflows++;
+            return -ENOBUFS;
+        }
+    }
+
+    if (SCANNER_MAX_EXT_DATA - chain->length < report->length) {
+        reassembly_release(reassembly, chain);
+        reassembly->stats.overflows++;
+        return -EMSGSIZE;
+    }
+
+    memcpy(chain->data + chain->length, report->data, report->length);
+    chain->length += report->length;
+    reassembly->stats.fragments++;
+
+    switch (report->status) {
+
+        case SCANNER_DATA_MORE:
+            return 0;
+
+        case SCANNER_DATA_COMPLETE:
+
+            /* Header of first fragment, RSSI of last */
+            payload = *report;
+            payload.event_type = chain->event_type;
+            payload.tx_power = chain->tx_power;
+            payload.data = chain->data;
+            payload.length = chain->length;
+
+            reassembly->stats.reassembled++;
+            reassembly->callback(&payload, reassembly->user_data);
+
+            /* Buffer stays valid through callback */
+            reassembly_release(reassembly, chain);
+            return 1;
+
+        default:
+            reassembly_release(reassembly, chain);
+            reassembly->stats.truncated++;
+            return -ECANCELED;
+    }
+}
+
+/* Drop old chains */
+size_t reassembly_expire(
+    struct reassembly  *reassembly,
+    const uint64_t      now) {
+
+    reassembly_chain_t *chain;
+    size_t count = 0;
+
+    if (NULL == reassembly) {
+        return 0;
+    }
+
+    for (size_t i = 0; reassembly->capacity > i && 0 != reassembly->pending; ++i) {
+
+        chain = &reassembly->chain[i];
+
+        if (chain->used && now - chain->start > reassembly->timeout) {
+            reassembly_release(reassembly, chain);
+            count++;
+        }
+    }
+
+    reassembly->stats.timeouts += count;
+
+    return count;
+}
+
+/* Chains being assembled */
+size_t reassembly_pending(
+    struct reassembly  *reassembly) {
+    return (NULL == reassembly) ? 0 : reassembly->pending;
+}
+
+/* Get counters */
+int reassembly_get_stats(
+    struct reassembly  *reassembly,
+    reassembly_stats_t *stats) {
+
+    if (NULL == reassembly || NULL == stats) {
+        return -EINVAL;
+    }
+
+    *stats = reassembly->stats;
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
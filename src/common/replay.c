@@ -0,0 +1,547 @@
+/*!
+ *	\file		replay.c
+ *	\brief		HCI capture replay
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/replay.h"
+#include "beaconizer/timer.h"
+
+#include "loop_private.h"
+
+/* File layouts */
+#define BTSNOOP_HDR_SIZE            16
+#define BTSNOOP_REC_SIZE            24
+#define BTSNOOP_FLAG_RECEIVED       0x01
+#define BTSNOOP_FLAG_CONTROL        0x02
+#define PCAP_HDR_SIZE               24
+#define PCAP_REC_SIZE               16
+#define PCAP_PHDR_SIZE              4
+
+/* H4 packet types missing from hci.h */
+#define REPLAY_ACL_PKT              0x02
+
+/* Indexed controller packet */
+typedef struct {
+    size_t              offset;             /* Packet in mapping */
+    uint32_t            length;             /* Packet length */
+    uint8_t             type;               /* H4 type to prepend, 0 when in packet */
+    uint64_t            time;               /* Since first packet, ns */
+} replay_record_t;
+
+/* Replay */
+struct replay {
+    struct loop        *loop;               /* Loop */
+    int                 sd[2];              /* Controller end, host end */
+    int                 timer;              /* Pacing timer */
+    int                 format;             /* Capture format */
+
+    const uint8_t      *map;                /* Capture mapping */
+    size_t              size;               /* Mapping size */
+    replay_record_t    *record;             /* Controller packets */
+    size_t              count;              /* Packets */
+    uint64_t            span;               /* Capture duration, ns */
+
+    int                 running;            /* Replay in progress */
+    double              speed;              /* Speed factor */
+    unsigned int        repeat;             /* Passes */
+    unsigned int        pass;               /* Current pass */
+    size_t              next;               /* Next packet */
+    uint64_t            start;              /* Start, ns */
+    replay_done_fn_t    callback;           /* Completion callback */
+    void               *user_data;          /* User data */
+
+    replay_stats_t      stats;              /* Counters */
+};
+
+/* Read big endian word */
+static inline uint32_t get_be32(
+    const uint8_t      *p) {
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | p[3];
+}
+
+/* Read word of capture byte order */
+static inline uint32_t get_u32(
+    const uint8_t      *p,
+    const int           swap) {
+    return swap ? get_be32(p) : ((uint32_t) p[3] << 24) | ((uint32_t) p[2] << 16) | ((uint32_t) p[1] << 8) | p[0];
+}
+
+/* Walk btsnoop records, index them when record is not NULL */
+static size_t index_btsnoop(
+    struct replay      *replay,
+    replay_record_t    *record) {
+
+    const uint8_t *p;
+    size_t offset = BTSNOOP_HDR_SIZE, count = 0;
+    uint64_t time, first = 0;
+    uint32_t length, flags;
+
+    while (offset + BTSNOOP_REC_SIZE <= replay->size) {
+
+        p = replay->map + offset;
+        length = get_be32(p + 4);
+        flags = get_be32(p + 8);
+
+        if (replay->size - offset - BTSNOOP_REC_SIZE < length) {
+            break;
+        }
+
+        offset += BTSNOOP_REC_SIZE;
+
+        /* Microseconds since year 0 */
+        time = ((uint64_t) get_be32(p + 16) << 32 | get_be32(p + 20)) * 1000;
+
+        if (0 != (flags & BTSNOOP_FLAG_RECEIVED) && 0 != length && get_be32(p) == length) {
+
+            if (NULL != record) {
+                if (0 == count) {
+                    first = time;
+                }
+                record[count].offset = offset;
+                record[count].length = length;
+                record[count].time = (time > first) ? time - first : 0;
+                record[count].type = (REPLAY_BTSNOOP_H4 == replay->format) ? 0
+                    : (0 != (flags & BTSNOOP_FLAG_CONTROL)) ? BT_HCI_EVENT_PKT : REPLAY_ACL_PKT;
+            }
+
+            count++;
+        }
+
+        offset += length;
+    }
+
+    return count;
+}
+
+/* Walk pcap records, index them when record is not NULL */
+static size_t index_pcap(
+    struct replay      *replay,
+    replay_record_t    *record,
+    const int           swap,
+    const uint64_t      fraction) {
+
+    const uint8_t *p;
+    size_t offset = PCAP_HDR_SIZE, count = 0;
+    uint64_t time, first = 0;
+    uint32_t length;
+
+    while (offset + PCAP_REC_SIZE <= replay->size) {
+
+        p = replay->map + offset;
+        length = get_u32(p + 8, swap);
+
+        if (replay->size - offset - PCAP_REC_SIZE < length) {
+            break;
+        }
+
+        offset += PCAP_REC_SIZE;
+        time = (uint64_t) get_u32(p, swap) * 1000000000ULL + (uint64_t) get_u32(p + 4, swap) * fraction;
+
+        /* Direction header is big endian whatever the file order is */
+        if (PCAP_PHDR_SIZE < length && get_u32(p + 12, swap) == length && 0 != get_be32(replay->map + offset)) {
+
+            if (NULL != record) {
+                if (0 == count) {
+                    first = time;
+                }
+                record[count].offset = offset + PCAP_PHDR_SIZE;
+                record[count].length = length - PCAP_PHDR_SIZE;
+                record[count].time = (time > first) ? time - first : 0;
+                record[count].type = 0;
+            }
+
+            count++;
+        }
+
+        offset += length;
+    }
+
+    return count;
+}
+
+/* Recognize capture and index it */
+static int replay_index(
+    struct replay      *replay) {
+
+    const uint8_t *p = replay->map;
+    uint64_t fraction = 1000;
+    uint32_t magic;
+    int swap = 0;
+
+    if (BTSNOOP_HDR_SIZE <= replay->size && 0 == memcmp(p, "btsnoop\0", 8)) {
+
+        replay->format = (int) get_be32(p + 12);
+        if (1 != get_be32(p + 8)
+            || (REPLAY_BTSNOOP_H1 != replay->format && REPLAY_BTSNOOP_H4 != replay->format)) {
+            return -ENOTSUP;
+        }
+
+        replay->count = index_btsnoop(replay, NULL);
+        replay->record = malloc((replay->count ? replay->count : 1) * sizeof(replay_record_t));
+        if (NULL == replay->record) {
+            return -ENOMEM;
+        }
+        index_btsnoop(replay, replay->record);
+
+    } else if (PCAP_HDR_SIZE <= replay->size) {
+
+        magic = get_u32(p, 0);
+        switch (magic) {
+            case 0xa1b2c3d4: break;
+            case 0xa1b23c4d: fraction = 1; break;
+            case 0xd4c3b2a1: swap = 1; break;
+            case 0x4d3cb2a1: swap = 1; fraction = 1; break;
+            default:
+                return -ENOTSUP;
+        }
+
+        replay->format = (int) get_u32(p + 20, swap);
+        if (REPLAY_PCAP_H4_PHDR != replay->format) {
+            return -ENOTSUP;
+        }
+
+        replay->count = index_pcap(replay, NULL, swap, fraction);
+        replay->record = malloc((replay->count ? replay->count : 1) * sizeof(replay_record_t));
+        if (NULL == replay->record) {
+            return -ENOMEM;
+        }
+        index_pcap(replay, replay->record, swap, fraction);
+
+    } else {
+        return -ENOTSUP;
+    }
+
+    replay->span = replay->count ? replay->record[replay->count - 1].time : 0;
+
+    return EXIT_SUCCESS;
+}
+
+/* Replay finished */
+static void replay_finish(
+    struct replay      *replay,
+    const int           status) {
+
+    replay->running = 0;
+    cancel_timer_in(replay->loop, replay->timer);
+    loop_modify_sd_in(replay->loop, replay->sd[0], EPOLLIN);
+
+    if (NULL != replay->callback) {
+        replay->callback(replay, status, replay->user_data);
+    }
+}
+
+/* Write packets due, wait for socket space or the next deadline */
+static void replay_pump(
+    struct replay      *replay) {
+
+    const replay_record_t *record;
+    struct iovec iov[2];
+    struct timespec ts;
+    uint64_t now = 0, due;
+    ssize_t result;
+
+    if (REPLAY_FAST != replay->speed) {
+        now = clock_ns();
+    }
+
+    while (replay->running && replay->repeat > replay->pass) {
+
+        record = &replay->record[replay->next];
+
+        if (REPLAY_FAST != replay->speed) {
+
+            due = replay->start + (uint64_t) ((double) ((replay->span * replay->pass) + record->time) / replay->speed);
+            if (due > now) {
+                ts.tv_sec = (time_t) ((due - now) / 1000000000ULL);
+                ts.tv_nsec = (long) ((due - now) % 1000000000ULL);
+                modify_timer_in(replay->loop, replay->timer, &ts);
+                loop_modify_sd_in(replay->loop, replay->sd[0], EPOLLIN);
+                return;
+            }
+        }
+
+        /* Packet goes straight from the mapping */
+        iov[0].iov_base = (void *) &record->type;
+        iov[0].iov_len = (0 != record->type) ? 1 : 0;
+        iov[1].iov_base = (void *) (replay->map + record->offset);
+        iov[1].iov_len = record->length;
+
+        result = writev(replay->sd[0], iov, 2);
+        if (0 > result) {
+
+            if (EINTR == errno) {
+                continue;
+            }
+
+            if (EAGAIN == errno || EWOULDBLOCK == errno) {
+                replay->stats.stalls++;
+                loop_modify_sd_in(replay->loop, replay->sd[0], EPOLLIN | EPOLLOUT);
+                return;
+            }
+
+            replay_finish(replay, -errno);
+            return;
+        }
+
+        replay->stats.packets++;
+        replay->stats.bytes += (uint64_t) result;
+
+        if (replay->count == ++replay->next) {
+            replay->next = 0;
+            replay->pass++;
+        }
+    }
+
+    if (replay->running) {
+        replay_finish(replay, EXIT_SUCCESS);
+    }
+}
+
+/* Controller end of socket pair */
+static void replay_event(
+    int                 sd,
+    uint32_t            event_mask,
+    void               *user_data) {
+
+    struct replay *replay = user_data;
+    uint8_t packet[BT_HCI_MAX_PACKET_SIZE];
+
+    /* Host commands have nobody to answer them */
+    if (event_mask & EPOLLIN) {
+        while (0 < read(sd, packet, sizeof(packet))) {
+            replay->stats.commands++;
+        }
+    }
+
+    if ((event_mask & EPOLLOUT) && replay->running) {
+        replay_pump(replay);
+    }
+}
+
+/* Pacing timer */
+static void replay_timer(
+    int                 id,
+    void               *user_data) {
+
+    struct replay *replay = user_data;
+
+    if (replay->running) {
+        replay_pump(replay);
+    }
+}
+
+/* Open capture */
+struct replay *replay_open_in(
+    struct loop        *loop,
+    const char         *path) {
+
+    struct replay *replay;
+    struct timespec ts = { 0, 0 };
+    struct stat st;
+    int fd, result;
+
+    if (NULL == loop || NULL == path) {
+        errno = EINVAL;
+        return NULL;
+    }
+
+    replay = calloc(1, sizeof(struct replay));
+    if (NULL == replay) {
+        return NULL;
+    }
+
+    replay->loop = loop;
+    replay->sd[0] = -1;
+    replay->sd[1] = -1;
+    replay->map = MAP_FAILED;
+
+    errno = 0;
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (0 > fd) {
+        replay_free(replay);
+        return NULL;
+    }
+
+    if (0 != fstat(fd, &st) || 0 == st.st_size) {
+        result = (0 == errno) ? ENOTSUP : errno;
+        close(fd);
+        replay_free(replay);
+        errno = result;
+        return NULL;
+    }
+
+    replay->size = (size_t) st.st_size;
+    replay->map = mmap(NULL, replay->size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (MAP_FAILED == replay->map) {
+        replay_free(replay);
+        return NULL;
+    }
+
+    madvise((void *) replay->map, replay->size, MADV_SEQUENTIAL);
+
+    result = replay_index(replay);
+    if (EXIT_SUCCESS != result) {
+        replay_free(replay);
+        errno = -result;
+        return NULL;
+    }
+
+    if (0 > socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, replay->sd)) {
+        replay_free(replay);
+        return NULL;
+    }
+
+    if (0 != loop_add_sd_in(loop, replay->sd[0], EPOLLIN, replay_event, replay, NULL)) {
+        close(replay->sd[0]);
+        replay->sd[0] = -1;
+        replay_free(replay);
+        errno = EIO;
+        return NULL;
+    }
+
+    /* Pacing timer stays idle until start */
+    replay->timer = create_timer_in(loop, &ts, replay_timer, replay, NULL);
+    if (0 >= replay->timer || EXIT_SUCCESS != cancel_timer_in(loop, replay->timer)) {
+        replay_free(replay);
+        errno = EIO;
+        return NULL;
+    }
+
+    return replay;
+}
+
+/* Open capture in default loop */
+struct replay *replay_open(
+    const char         *path) {
+    return replay_open_in(loop_default(), path);
+}
+
+/* Release replay */
+void replay_free(
+    struct replay      *replay) {
+
+    if (NULL == replay) {
+        return;
+    }
+
+    if (0 < replay->timer) {
+        destroy_timer_in(replay->loop, replay->timer);
+    }
+
+    if (0 <= replay->sd[0]) {
+        loop_remove_sd_in(replay->loop, replay->sd[0]);
+        close(replay->sd[0]);
+    }
+
+    if (0 <= replay->sd[1]) {
+        close(replay->sd[1]);
+    }
+
+    if (MAP_FAILED != replay->map) {
+        munmap((void *) replay->map, replay->size);
+    }
+
+    free(replay->record);
+    free(replay);
+}
+
+/* Host end of socket pair */
+int replay_get_descriptor(
+    struct replay      *replay) {
+    return (NULL != replay) ? replay->sd[1] : -EINVAL;
+}
+
+/* Capture format */
+int replay_get_format(
+    struct replay      *replay) {
+    return (NULL != replay) ? replay->format : -EINVAL;
+}
+
+/* Controller packets */
+size_t replay_packets(
+    struct replay      *replay) {
+    return (NULL != replay) ? replay->count : 0;
+}
+
+/* Start replay */
+int replay_start(
+    struct replay      *replay,
+    const double        speed,
+    const unsigned int  repeat,
+    replay_done_fn_t    callback,
+    void               *user_data) {
+
+    struct timespec ts = { 0, 0 };
+
+    if (NULL == replay || 0.0 > speed || 0 == repeat) {
+        return -EINVAL;
+    }
+
+    if (replay->running) {
+        return -EBUSY;
+    }
+
+    replay->speed = speed;
+    replay->repeat = (0 != replay->count) ? repeat : 0;
+    replay->pass = 0;
+    replay->next = 0;
+    replay->start = clock_ns();
+    replay->callback = callback;
+    replay->user_data = user_data;
+    replay->running = 1;
+
+    /* First packets go out from the loop, as all the others */
+    return modify_timer_in(replay->loop, replay->timer, &ts);
+}
+
+/* Stop replay */
+int replay_stop(
+    struct replay      *replay) {
+
+    if (NULL == replay) {
+        return -EINVAL;
+    }
+
+    replay->running = 0;
+    cancel_timer_in(replay->loop, replay->timer);
+
+    return loop_modify_sd_in(replay->loop, replay->sd[0], EPOLLIN);
+}
+
+/* Get counters */
+int replay_get_stats(
+    struct replay      *replay,
+    replay_stats_t     *stats) {
+
+    if (NULL == replay || NULL == stats) {
+        return -EINVAL;
+    }
+
+    *stats = replay->stats;
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
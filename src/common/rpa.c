@@ -0,0 +1,318 @@
+/*!
+ *	\file		rpa.c
+ *	\brief		Resolvable Private Address resolution
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "beaconizer/aes.h"
+#include "beaconizer/rpa.h"
+
+/* IRKs per AES batch */
+#define RPA_BATCH                   64
+
+/* Cached address */
+typedef struct {
+    uint64_t            address;                /* Address, 0 when free */
+    uint32_t            stamp;                  /* Time of resolution */
+    uint32_t            generation;             /* IRK count when resolved */
+    int32_t             id;                     /* Identity, -1 when no IRK matched */
+} rpa_entry_t;
+
+/* Resolver */
+struct rpa_resolver {
+    aes128_key_t       *irk;                    /* IRK schedules */
+    const aes128_key_t **schedule;              /* Batch view of IRK schedules */
+    void              **user_data;              /* User data per IRK */
+    size_t              count;                  /* IRKs in use */
+    size_t              size;                   /* IRKs allocated */
+    rpa_entry_t        *cache;                  /* Direct mapped address cache */
+    size_t              mask;                   /* Cache size - 1 */
+    uint32_t            ttl;                    /* Cache lifetime, s */
+    rpa_resolver_stats_t    stats;              /* Counters */
+    uint8_t             in[RPA_BATCH][AES128_BLOCK_SIZE];   /* Replicated ah() input */
+    uint8_t             out[RPA_BATCH][AES128_BLOCK_SIZE];  /* ah() output */
+};
+
+/* ah() input: 13 zero octets and prand, most significant octet first */
+static void rpa_block(
+    uint8_t             block[AES128_BLOCK_SIZE],
+    const uint32_t      prand) {
+
+    memset(block, 0, AES128_BLOCK_SIZE);
+    block[13] = (uint8_t) (prand >> 16);
+    block[14] = (uint8_t) (prand >> 8);
+    block[15] = (uint8_t) prand;
+}
+
+/* Lowest 24 bits of ah() output */
+static inline uint32_t rpa_result(
+    const uint8_t       block[AES128_BLOCK_SIZE]) {
+    return ((uint32_t) block[13] << 16) | ((uint32_t) block[14] << 8) | block[15];
+}
+
+/* Address as integer */
+static inline uint64_t rpa_address(
+    const uint8_t       address[RPA_ADDRESS_SIZE]) {
+
+    uint64_t value = 0;
+
+    for (size_t i = RPA_ADDRESS_SIZE; 0 < i; --i) {
+        value = (value << 8) | address[i - 1];
+    }
+
+    return value;
+}
+
+/* Address is resolvable private */
+int rpa_is_resolvable(
+    const uint8_t       address[RPA_ADDRESS_SIZE]) {
+    return 0x40 == (address[5] & 0xc0);
+}
+
+/* ah() */
+uint32_t rpa_hash(
+    const uint8_t       irk[RPA_IRK_SIZE],
+    const uint32_t      prand) {
+
+    aes128_key_t schedule;
+    uint8_t block[AES128_BLOCK_SIZE];
+
+    aes128_expand(&schedule, irk);
+    rpa_block(block, prand);
+    aes128_encrypt(&schedule, block, block);
+
+    return rpa_result(block);
+}
+
+/* Generate address */
+void rpa_generate(
+    const uint8_t       irk[RPA_IRK_SIZE],
+    const uint32_t      random,
+    uint8_t             address[RPA_ADDRESS_SIZE]) {
+
+    const uint32_t prand = (random & 0x3fffff) | 0x400000;
+    const uint32_t hash = rpa_hash(irk, prand);
+
+    address[0] = (uint8_t) hash;
+    address[1] = (uint8_t) (hash >> 8);
+    address[2] = (uint8_t) (hash >> 16);
+    address[3] = (uint8_t) prand;
+    address[4] = (uint8_t) (prand >> 8);
+    address[5] = (uint8_t) (prand >> 16);
+}
+
+/* Create resolver */
+struct rpa_resolver *rpa_resolver_new(
+    const uint32_t      ttl,
+    const size_t        cache) {
+
+    struct rpa_resolver *resolver;
+    size_t size = 1;
+
+    while (size < (cache ? cache : RPA_DEFAULT_CACHE)) {
+        size <<= 1;
+    }
+
+    resolver = calloc(1, sizeof(struct rpa_resolver));
+    if (NULL == resolver) {
+        return NULL;
+    }
+
+    resolver->cache = calloc(size, sizeof(rpa_entry_t));
+    if (NULL == resolver->cache) {
+        free(resolver);
+        return NULL;
+    }
+
+    resolver->mask = size - 1;
+    resolver->ttl = ttl ? ttl : RPA_DEFAULT_TTL;
+
+    return resolver;
+}
+
+/* Destroy resolver */
+void rpa_resolver_free(
+    struct rpa_resolver    *resolver) {
+
+    if (NULL == resolver) {
+        return;
+    }
+
+    free(resolver->cache);
+    free(resolver->user_data);
+    free(resolver->schedule);
+    free(resolver->irk);
+    free(resolver);
+}
+
+/* Register IRK */
+int rpa_resolver_add(
+    struct rpa_resolver    *resolver,
+    const uint8_t           irk[RPA_IRK_SIZE],
+    void                   *user_data) {
+
+    aes128_key_t *schedule;
+    const aes128_key_t **view;
+    void **data;
+    size_t size;
+
+    if (NULL == resolver || NULL == irk) {
+        return -EINVAL;
+    }
+
+    if (INT32_MAX <= resolver->count) {
+        return -ENOSPC;
+    }
+
+    if (resolver->count == resolver->size) {
+
+        size = resolver->size ? resolver->size * 2 : 16;
+
+        view = realloc(resolver->schedule, size * sizeof(aes128_key_t *));
+        if (NULL == view) {
+            return -ENOMEM;
+        }
+        resolver->schedule = view;
+
+        data = realloc(resolver->user_data, size * sizeof(void *));
+        if (NULL == data) {
+            return -ENOMEM;
+        }
+        resolver->user_data = data;
+
+        schedule = realloc(resolver->irk, size * sizeof(aes128_key_t));
+        if (NULL == schedule) {
+            return -ENOMEM;
+        }
+        resolver->irk = schedule;
+
+        /* Schedules moved */
+        for (size_t i = 0; resolver->count > i; ++i) {
+            resolver->schedule[i] = &resolver->irk[i];
+        }
+
+        resolver->size = size;
+    }
+
+    /* Key is expanded once, every scan reuses it */
+    aes128_expand(&resolver->irk[resolver->count], irk);
+    resolver->schedule[resolver->count] = &resolver->irk[resolver->count];
+    resolver->user_data[resolver->count] = user_data;
+
+    /* Negative entries carry old generation and are ignored from now on */
+    return (int) resolver->count++;
+}
+
+/* Resolve address */
+int rpa_resolver_resolve(
+    struct rpa_resolver    *resolver,
+    const uint8_t           address[RPA_ADDRESS_SIZE],
+    const uint32_t          now,
+    void                  **user_data) {
+
+    uint64_t key;
+    rpa_entry_t *entry;
+    uint32_t hash, prand;
+    size_t n;
+    int32_t id = -1;
+
+    if (NULL == resolver || NULL == address || !rpa_is_resolvable(address)) {
+        return -EINVAL;
+    }
+
+    key = rpa_address(address);
+    entry = &resolver->cache[(key ^ (key >> 24)) & resolver->mask];
+
+    /* Cached result lives as long as address may */
+    if (key == entry->address && resolver->ttl > now - entry->stamp) {
+
+        if (0 <= entry->id) {
+            resolver->stats.resolved++;
+            if (NULL != user_data) {
+                *user_data = resolver->user_data[entry->id];
+            }
+            return entry->id;
+        }
+
+        if (resolver->count == entry->generation) {
+            resolver->stats.rejected++;
+            return -ENOENT;
+        }
+    }
+
+    resolver->stats.scans++;
+
+    hash = (uint32_t) (key & 0xffffff);
+    prand = (uint32_t) (key >> 24);
+
+    /* Same plain text under every IRK */
+    rpa_block(resolver->in[0], prand);
+    n = (RPA_BATCH < resolver->count) ? RPA_BATCH : resolver->count;
+    for (size_t i = 1; n > i; ++i) {
+        memcpy(resolver->in[i], resolver->in[0], AES128_BLOCK_SIZE);
+    }
+
+    for (size_t base = 0; resolver->count > base && 0 > id; base += n) {
+
+        n = resolver->count - base;
+        if (RPA_BATCH < n) {
+            n = RPA_BATCH;
+        }
+
+        aes128_encrypt_batch(resolver->schedule + base, (const uint8_t (*)[AES128_BLOCK_SIZE]) resolver->in, resolver->out, n);
+        resolver->stats.computed += n;
+
+        for (size_t i = 0; n > i; ++i) {
+            if (hash == rpa_result(resolver->out[i])) {
+                id = (int32_t) (base + i);
+                break;
+            }
+        }
+    }
+
+    entry->address = key;
+    entry->stamp = now;
+    entry->generation = (uint32_t) resolver->count;
+    entry->id = id;
+
+    if (0 > id) {
+        return -ENOENT;
+    }
+
+    if (NULL != user_data) {
+        *user_data = resolver->user_data[id];
+    }
+
+    return id;
+}
+
+/* Number of IRKs */
+size_t rpa_resolver_count(
+    const struct rpa_resolver  *resolver) {
+    return (NULL != resolver) ? resolver->count : 0;
+}
+
+/* Get counters */
+int rpa_resolver_get_stats(
+    const struct rpa_resolver  *resolver,
+    rpa_resolver_stats_t       *stats) {
+
+    if (NULL == resolver || NULL == stats) {
+        return -EINVAL;
+    }
+
+    *stats = resolver->stats;
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
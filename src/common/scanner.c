@@ -0,0 +1,502 @@
+/*!
+ *	\file		scanner.c
+ *	\brief		LE scanner on top of HCI channel
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/reassembly.h"
+#include "beaconizer/scanner.h"
+#include "beaconizer/utility.h"
+
+#include "hci_batch.h"
+#include "loop_private.h"
+
+/* Interval and window limits in 0.625 ms units */
+#define SCAN_INTERVAL_MIN           0x0004
+#define SCAN_INTERVAL_MAX           0x4000
+
+/* Report header: event type, address type, address, data length */
+#define SCAN_REPORT_HDR_SIZE        9
+
+/* Extended report header: event type, address type, address, PHYs, SID,
+ * TX power, RSSI, periodic interval, direct address type and address,
+ * data length */
+#define SCAN_EXT_REPORT_HDR_SIZE    24
+
+/* Scanner */
+struct scanner {
+    hci_batch_t         batch;          /* Commands in flight and controller state */
+    unsigned int        handler;        /* LE Advertising Report handler */
+    unsigned int        ext_handler;    /* LE Extended Advertising Report handler */
+    struct reassembly  *reassembly;     /* Fragmented extended payloads */
+
+    /* Wanted configuration */
+    uint8_t             type;           /* Passive or active */
+    uint16_t            interval;       /* Scan interval */
+    uint16_t            window;         /* Scan window */
+    uint8_t             filter;         /* Duplicate filter */
+    uint8_t             dirty;          /* Parameters not pushed yet */
+
+    /* Reports */
+    scanner_fn_t        report;
+    void               *report_data;
+    uint64_t            count;
+
+    /* Start/stop completion */
+    scanner_done_fn_t   callback;
+    void               *user_data;
+};
+
+/* Parse advertising reports in place */
+int scanner_parse_reports(
+    const uint8_t      *param,
+    const uint8_t       length,
+    scanner_fn_t        callback,
+    void               *user_data) {
+
+    const uint8_t *p = param + 2, *end = param + length;
+    scanner_report_t report;
+    uint8_t count, i;
+
+    if (NULL == param || 2 > length || BT_HCI_EVT_LE_ADV_REPORT != param[0]) {
+        return -EINVAL;
+    }
+
+    count = param[1];
+
+    for (i = 0; count > i; ++i) {
+
+        if (SCAN_REPORT_HDR_SIZE > end - p || SCAN_REPORT_HDR_SIZE + p[8] + 1 > end - p) {
+            return -EBADMSG;
+        }
+
+        report.event_type = p[0];
+        report.extended = 0;
+        report.status = SCANNER_DATA_COMPLETE;
+        report.sid = SCANNER_SID_NONE;
+        report.address_type = p[1];
+        report.address = p + 2;
+        report.length = p[8];
+        report.data = p + SCAN_REPORT_HDR_SIZE;
+        report.rssi = (int8_t) p[SCAN_REPORT_HDR_SIZE + report.length];
+        report.tx_power = SCANNER_TX_POWER_NONE;
+
+        p += SCAN_REPORT_HDR_SIZE + report.length + 1;
+
+        if (NULL != callback) {
+            callback(&report, user_data);
+        }
+    }
+
+    return count;
+}
+
+/* Parse extended advertising reports in place */
+int scanner_parse_ext_reports(
+    const uint8_t      *param,
+    const uint8_t       length,
+    scanner_fn_t        callback,
+    void               *user_data) {
+
+    const uint8_t *p = param + 2, *end = param + length;
+    scanner_report_t report;
+    uint16_t event_type;
+    uint8_t count, i;
+
+    if (NULL == param || 2 > length || BT_HCI_EVT_LE_EXT_ADV_REPORT != param[0]) {
+        return -EINVAL;
+    }
+
+    count = param[1];
+
+    for (i = 0; count > i; ++i) {
+
+        if (SCAN_EXT_REPORT_HDR_SIZE > end - p || SCAN_EXT_REPORT_HDR_SIZE + p[23] > end - p) {
+            return -EBADMSG;
+        }
+
+        /* Data status sits in bits 5 and 6 of event type */
+        event_type = get_le16(p);
+        report.event_type = (uint8_t) (event_type & 0x1f);
+        report.extended = 1;
+        report.status = (uint8_t) ((event_type >> 5) & 0x03);
+        report.address_type = p[2];
+        report.address = p + 3;
+        report.sid = p[11];
+        report.tx_power = (int8_t) p[12];
+        report.rssi = (int8_t) p[13];
+        report.length = p[23];
+        report.data = p + SCAN_EXT_REPORT_HDR_SIZE;
+
+        p += SCAN_EXT_REPORT_HDR_SIZE + report.length;
+
+        if (NULL != callback) {
+            callback(&report, user_data);
+        }
+    }
+
+    return count;
+}
+
+/* Last reference is gone */
+static void scanner_release(
+    void               *owner) {
+
+    struct scanner *scanner = owner;
+
+    reassembly_free(scanner->reassembly);
+    free(scanner);
+}
+
+/* Hand report to owner, nothing goes out once owner freed scanner */
+static void scanner_deliver(
+    const scanner_report_t *report,
+    void                   *user_data) {
+
+    struct scanner *scanner = user_data;
+
+    if (scanner->batch.released) {
+        return;
+    }
+
+    scanner->count++;
+    scanner->report(report, scanner->report_data);
+}
+
+/* LE Advertising Report. Reference keeps scanner alive when a report
+ * callback frees it */
+static void scanner_event(
+    uint8_t             event,
+    const uint8_t      *param,
+    uint8_t             length,
+    void               *user_data) {
+
+    struct scanner *scanner = user_data;
+
+    hci_batch_ref(&scanner->batch);
+    scanner_parse_reports(param, length, scanner_deliver, scanner);
+    hci_batch_unref(&scanner->batch);
+}
+
+/* Extended report or fragment */
+static void scanner_fragment(
+    const scanner_report_t *report,
+    void                   *user_data) {
+
+    struct scanner *scanner = user_data;
+    uint64_t now = 0;
+
+    if (scanner->batch.released) {
+        return;
+    }
+
+    /* Clock is needed only while chains are in flight */
+    if (SCANNER_DATA_COMPLETE != report->status || 0 != reassembly_pending(scanner->reassembly)) {
+        now = clock_ns() / 1000000;
+    }
+
+    reassembly_push(scanner->reassembly, report, now);
+}
+
+/* LE Extended Advertising Report */
+static void scanner_ext_event(
+    uint8_t             event,
+    const uint8_t      *param,
+    uint8_t             length,
+    void               *user_data) {
+
+    struct scanner *scanner = user_data;
+
+    /* Reassembler stays allocated until push returns */
+    hci_batch_ref(&scanner->batch);
+    scanner_parse_ext_reports(param, length, scanner_fragment, scanner);
+    hci_batch_unref(&scanner->batch);
+}
+
+static void scanner_step(
+    struct scanner     *scanner);
+
+/* Report settled state once */
+static void scanner_notify(
+    struct scanner     *scanner,
+    const int           status) {
+
+    scanner_done_fn_t callback = scanner->callback;
+
+    if (NULL == callback) {
+        return;
+    }
+
+    scanner->callback = NULL;
+    callback(scanner, status, scanner->user_data);
+}
+
+/* Report settled state with first error of last batch */
+static void scanner_settle(
+    struct scanner     *scanner) {
+    scanner_notify(scanner, hci_batch_take_status(&scanner->batch));
+}
+
+/* Parameters rejected, retry on next start */
+static void scanner_rejected(
+    void               *owner,
+    const uint16_t      opcode) {
+
+    struct scanner *scanner = owner;
+
+    if (BT_HCI_CMD_LE_SET_SCAN_PARAMETERS == opcode) {
+        scanner->dirty = 1;
+    }
+}
+
+/* Batch answered */
+static void scanner_settled(
+    void               *owner,
+    const uint16_t      opcode,
+    const int           status,
+    const uint8_t      *param,
+    const uint8_t       length) {
+
+    struct scanner *scanner = owner;
+
+    if (hci_batch_rollback(&scanner->batch)) {
+        scanner_settle(scanner);
+        return;
+    }
+
+    scanner_step(scanner);
+}
+
+/* Batch hooks */
+static const hci_batch_ops_t scanner_ops = {
+    .release    = scanner_release,
+    .rejected   = scanner_rejected,
+    .settled    = scanner_settled
+};
+
+/* Enable or disable scanning */
+static int scanner_send_enable(
+    struct scanner     *scanner,
+    const uint8_t       enable) {
+
+    const uint8_t param[2] = { enable, scanner->filter };
+
+    return hci_batch_send_enable(&scanner->batch, BT_HCI_CMD_LE_SET_SCAN_ENABLE, param, sizeof(param), enable);
+}
+
+/* Push scan parameters */
+static int scanner_send_params(
+    struct scanner     *scanner) {
+
+    uint8_t param[7];
+
+    param[0] = scanner->type;
+    put_le16(scanner->interval, param + 1);
+    put_le16(scanner->window, param + 3);
+    param[5] = 0x00;    /* Public own address */
+    param[6] = 0x00;    /* Accept all advertisements */
+
+    scanner->dirty = 0;
+
+    return hci_batch_send(&scanner->batch, BT_HCI_CMD_LE_SET_SCAN_PARAMETERS, param, sizeof(param));
+}
+
+/* Issue next commands towards wanted state, parameters and enable go out
+ * as one batch */
+static void scanner_step(
+    struct scanner     *scanner) {
+
+    hci_batch_t *batch = &scanner->batch;
+    int result = EXIT_SUCCESS;
+
+    if (batch->busy) {
+        return;
+    }
+
+    hci_batch_begin(batch);
+
+    if (batch->wanted) {
+
+        /* Parameters can only change while disabled */
+        if (scanner->dirty && batch->enabled) {
+            result = scanner_send_enable(scanner, 0);
+        } else {
+            if (scanner->dirty) {
+                result = scanner_send_params(scanner);
+            }
+            if (0 <= result && !batch->enabled) {
+                result = scanner_send_enable(scanner, 1);
+            }
+        }
+
+    } else if (batch->enabled) {
+        result = scanner_send_enable(scanner, 0);
+    }
+
+    if (0 > result) {
+        hci_batch_fail(batch, result);
+    }
+
+    /* Nothing to do or nothing could be sent */
+    if (0 == batch->busy) {
+        scanner_settle(scanner);
+    }
+}
+
+/* Create scanner */
+struct scanner *scanner_new(
+    struct hci_channel *hci,
+    scanner_fn_t        callback,
+    void               *user_data) {
+
+    struct scanner *scanner;
+
+    if (NULL == hci || NULL == callback) {
+        return NULL;
+    }
+
+    scanner = calloc(1, sizeof(struct scanner));
+    if (NULL == scanner) {
+        return NULL;
+    }
+
+    hci_batch_init(&scanner->batch, hci, &scanner_ops, scanner);
+    scanner->report = callback;
+    scanner->report_data = user_data;
+
+    /* Passive, continuous: 10 ms window every 10 ms */
+    scanner->type = SCANNER_PASSIVE;
+    scanner->interval = 0x0010;
+    scanner->window = 0x0010;
+    scanner->dirty = 1;
+
+    scanner->reassembly = reassembly_new(REASSEMBLY_DEFAULT_CAPACITY, REASSEMBLY_DEFAULT_TIMEOUT, scanner_deliver, scanner);
+    if (NULL == scanner->reassembly) {
+        free(scanner);
+        return NULL;
+    }
+
+    scanner->handler = hci_channel_register_le(hci, BT_HCI_EVT_LE_ADV_REPORT, scanner_event, scanner, NULL);
+    scanner->ext_handler = hci_channel_register_le(hci, BT_HCI_EVT_LE_EXT_ADV_REPORT, scanner_ext_event, scanner, NULL);
+    if (0 == scanner->handler || 0 == scanner->ext_handler) {
+        hci_channel_unregister(hci, scanner->handler);
+        hci_channel_unregister(hci, scanner->ext_handler);
+        reassembly_free(scanner->reassembly);
+        free(scanner);
+        return NULL;
+    }
+
+    return scanner;
+}
+
+/* Destroy scanner */
+void scanner_free(
+    struct scanner     *scanner) {
+
+    if (NULL == scanner) {
+        return;
+    }
+
+    hci_channel_unregister(scanner->batch.hci, scanner->handler);
+    hci_channel_unregister(scanner->batch.hci, scanner->ext_handler);
+
+    /* Reports of event being dispatched are dropped, reassembler goes with
+     * last reference */
+    scanner->callback = NULL;
+
+    hci_batch_release(&scanner->batch);
+}
+
+/* Set scan parameters */
+int scanner_set_parameters(
+    struct scanner     *scanner,
+    const uint8_t       type,
+    const uint32_t      interval_ms,
+    const uint32_t      window_ms,
+    const uint8_t       filter_duplicates) {
+
+    uint16_t interval, window;
+
+    if (NULL == scanner || SCANNER_ACTIVE < type || window_ms > interval_ms) {
+        return -EINVAL;
+    }
+
+    interval = (uint16_t) hci_interval(interval_ms, SCAN_INTERVAL_MIN, SCAN_INTERVAL_MAX);
+    window = (uint16_t) hci_interval(window_ms, SCAN_INTERVAL_MIN, SCAN_INTERVAL_MAX);
+
+    if (type == scanner->type && interval == scanner->interval && window == scanner->window
+        && !!filter_duplicates == scanner->filter) {
+        return EXIT_SUCCESS;
+    }
+
+    scanner->type = type;
+    scanner->interval = interval;
+    scanner->window = window;
+    scanner->filter = !!filter_duplicates;
+    scanner->dirty = 1;
+
+    if (scanner->batch.wanted) {
+        scanner_step(scanner);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Enable scanning */
+int scanner_start(
+    struct scanner     *scanner,
+    scanner_done_fn_t   callback,
+    void               *user_data) {
+
+    if (NULL == scanner) {
+        return -EINVAL;
+    }
+
+    scanner->batch.wanted = 1;
+    scanner->callback = callback;
+    scanner->user_data = user_data;
+
+    scanner_step(scanner);
+
+    return EXIT_SUCCESS;
+}
+
+/* Disable scanning */
+int scanner_stop(
+    struct scanner     *scanner,
+    scanner_done_fn_t   callback,
+    void               *user_data) {
+
+    if (NULL == scanner) {
+        return -EINVAL;
+    }
+
+    scanner->batch.wanted = 0;
+    scanner->callback = callback;
+    scanner->user_data = user_data;
+
+    scanner_step(scanner);
+
+    return EXIT_SUCCESS;
+}
+
+/* Reports delivered */
+uint64_t scanner_report_count(
+    struct scanner     *scanner) {
+    return (NULL == scanner) ? 0 : scanner->count;
+}
+
+ /* End of file */
@@ -19,6 +19,8 @@
 #include "beaconizer/loop.h"
 #include "beaconizer/signal.h"
 
+#include "loop_private.h"
+
 
 /* Callback */
 typedef struct {
@@ -50,6 +52,12 @@ static int signal_read(
     return 1;
 }
 
+/* Release callback data */
+static void signal_data_free(
+    void            *user_data) {
+    loop_release(loop_default(), user_data, sizeof(signal_data_t));
+}
+
 static struct io *setup_signalfd(
     void            *user_data) {
 
@@ -71,9 +79,13 @@ static struct io *setup_signalfd(
         return NULL;
 
     io = io_new(fd);
+    if (NULL == io) {
+        close(fd);
+        return NULL;
+    }
 
     io_set_close_on_destroy(io, 1);
-    io_set_read_handler(io, signal_read, user_data, free);
+    io_set_read_handler(io, signal_read, user_data, signal_data_free);
 
     return io;
 }
@@ -98,14 +110,17 @@ int loop_run_with_signal(
     if (NULL == func)
         return -EINVAL;
 
-    data = malloc(sizeof(signal_data_t));
+    data = loop_alloc(loop_default(), sizeof(signal_data_t));
+    if (NULL == data)
+        return -ENOMEM;
+
     memset(data, 0, sizeof(signal_data_t));
     data->func = func;
     data->user_data = user_data;
 
     io = setup_signalfd(data);
     if (!io) {
-        free(data);
+        signal_data_free(data);
         return -errno;
     }
 
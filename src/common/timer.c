@@ -1,6 +1,6 @@
 /*!
  *	\file		timer.c
- *	\brief		Simple event loop
+ *	\brief		Loop timers: hierarchical timing wheel and precise timers
  *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
  *	\copyright	GNU GPL v3
  *	\date		25/06/2022
@@ -10,34 +10,596 @@
 #define _GNU_SOURCE
 
 #include <errno.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <time.h>
 #include <sys/epoll.h>
 #include <sys/timerfd.h>
+#include <sys/prctl.h>
 
 #include "beaconizer/config.h"
 #include "beaconizer/loop.h"
 #include "beaconizer/timer.h"
 
-#define ENTRY_CHANGE    4
+#include "loop_private.h"
 
-/* Timeout control structure */
+/* Wheel geometry: 6 levels of 64 buckets cover 2^36 ticks */
+#define WHEEL_BITS          6
+#define WHEEL_SIZE          (1 << WHEEL_BITS)
+#define WHEEL_MASK          (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS        6
+#define WHEEL_TICK_NS       ((uint64_t) __TIMER_WHEEL_TICK_USEC * 1000)
+
+/* Bucket lists: wheel buckets first, then service lists */
+#define BUCKET_EXPIRED      (WHEEL_LEVELS * WHEEL_SIZE)     /* Due, fire on next wake up */
+#define BUCKET_FIRING       (BUCKET_EXPIRED + 1)            /* Being fired right now */
+#define BUCKET_TODO         (BUCKET_EXPIRED + 2)            /* Being cascaded */
+#define BUCKET_COUNT        (BUCKET_EXPIRED + 3)
+#define BUCKET_NONE         UINT16_MAX
+
+/* Timer handle: generation in high bits, slot + 1 in low bits */
+#define SLOT_NONE           UINT32_MAX
+#define SLOT_BITS           24
+#define SLOT_MASK           ((1U << SLOT_BITS) - 1)
+#define GENERATION_MASK     0x7F
+#define SLOT_CHANGE         64
+
+/* Timer flags */
+#define TIMER_USED          0x01
+#define TIMER_PRECISE       0x02
+#define TIMER_PERIODIC      0x04
+
+/* Precise timer control structure */
 typedef struct {
+    struct loop        *loop;           /* Loop         */
+    int                 fd;             /* timerfd      */
     int                 id;             /* Timer ID     */
+} timer_entry_t;
+
+/* Timer slot */
+typedef struct {
+    uint64_t            expires;        /* Expiration tick              */
+    uint64_t            due;            /* Expiration, nanoseconds      */
+    uint64_t            timeout;        /* Timeout or period, ns        */
+    uint64_t            slack;          /* Allowed lateness, ns         */
+    uint32_t            next;           /* Next slot in bucket          */
+    uint32_t            prev;           /* Previous slot in bucket      */
+    uint16_t            bucket;         /* Bucket holding the slot      */
+    uint8_t             generation;     /* Handle generation            */
+    uint8_t             flags;          /* Timer flags                  */
     timer_fn_t          callback;       /* Callback     */
+    periodic_fn_t       periodic;       /* Periodic callback    */
     void               *user_data;      /* User data    */
     destructor_t        destructor;     /* Destructor   */
-} timer_entry_t;
+    timer_entry_t      *precise;        /* Precise timer if any */
+} timer_slot_t;
 
-/* Cascade callback */
-static void timer_callback(
+/* Per-loop timers */
+struct timers {
+    struct loop        *loop;                       /* Owner loop                   */
+    int                 fd;                         /* Wheel timerfd                */
+    int                 dispatching;                /* Firing timers now            */
+    int                 released;                   /* Freed while dispatching      */
+    uint64_t            now;                        /* Last processed tick          */
+    uint64_t            armed;                      /* Tick timerfd is armed for    */
+    uint64_t            pending[WHEEL_LEVELS];      /* Non-empty wheel buckets      */
+    uint32_t            head[BUCKET_COUNT];         /* Bucket heads                 */
+    timer_slot_t       *slot;                       /* Timer table                  */
+    uint32_t            count;                      /* Allocated slots              */
+    uint32_t            top;                        /* Slots ever used              */
+    uint32_t            free;                       /* Free slot list               */
+    uint64_t            slack;                      /* Slack of new timers, ns      */
+};
+
+/* Timeout in nanoseconds */
+static inline uint64_t timeout_ns(
+    const struct timespec  *timeout) {
+    return (uint64_t) timeout->tv_sec * 1000000000ULL + (uint64_t) timeout->tv_nsec;
+}
+
+/* Expiration tick of slot. Never early: due is rounded up to the tick. With
+ * slack the tick is moved late within the window to the one with most
+ * trailing zeros, so timers with overlapping windows share a wake up */
+static inline uint64_t slot_expires(
+    const timer_slot_t     *s) {
+
+    const uint64_t expires = (s->due + WHEEL_TICK_NS - 1) / WHEEL_TICK_NS;
+    const uint64_t limit = (s->due + s->slack) / WHEEL_TICK_NS;
+    uint64_t mask;
+
+    if (limit <= expires) {
+        return expires;
+    }
+
+    mask = (1ULL << (63 - __builtin_clzll(expires ^ limit))) - 1;
+
+    return limit & ~mask;
+}
+
+/* Compose timer handle */
+static inline int slot_id(
+    struct timers      *timers,
+    const uint32_t      i) {
+    return (int) (((uint32_t) timers->slot[i].generation << SLOT_BITS) | (i + 1));
+}
+
+/* Resolve timer handle to slot index */
+static uint32_t slot_find(
+    struct timers      *timers,
+    const int           id) {
+
+    uint32_t i;
+
+    if (NULL == timers || 0 >= id) {
+        return SLOT_NONE;
+    }
+
+    i = ((uint32_t) id & SLOT_MASK) - 1;
+    if (timers->top <= i) {
+        return SLOT_NONE;
+    }
+
+    if (0 == (timers->slot[i].flags & TIMER_USED) ||
+        timers->slot[i].generation != (((uint32_t) id >> SLOT_BITS) & GENERATION_MASK)) {
+        return SLOT_NONE;
+    }
+
+    return i;
+}
+
+/* Link slot into bucket */
+static inline void bucket_push(
+    struct timers      *timers,
+    const uint32_t      bucket,
+    const uint32_t      i) {
+
+    timer_slot_t *s = &timers->slot[i];
+
+    s->bucket = bucket;
+    s->prev = SLOT_NONE;
+    s->next = timers->head[bucket];
+
+    if (SLOT_NONE != s->next) {
+        timers->slot[s->next].prev = i;
+    }
+
+    timers->head[bucket] = i;
+
+    if (BUCKET_EXPIRED > bucket) {
+        timers->pending[bucket >> WHEEL_BITS] |= 1ULL << (bucket & WHEEL_MASK);
+    }
+}
+
+/* Unlink slot from its bucket if any */
+static inline void bucket_unlink(
+    struct timers      *timers,
+    const uint32_t      i) {
+
+    timer_slot_t *s = &timers->slot[i];
+    const uint32_t bucket = s->bucket;
+
+    if (BUCKET_NONE == bucket) {
+        return;
+    }
+
+    if (SLOT_NONE != s->prev) {
+        timers->slot[s->prev].next = s->next;
+    } else {
+        timers->head[bucket] = s->next;
+    }
+
+    if (SLOT_NONE != s->next) {
+        timers->slot[s->next].prev = s->prev;
+    }
+
+    if (BUCKET_EXPIRED > bucket && SLOT_NONE == timers->head[bucket]) {
+        timers->pending[bucket >> WHEEL_BITS] &= ~(1ULL << (bucket & WHEEL_MASK));
+    }
+
+    s->bucket = BUCKET_NONE;
+}
+
+/* Move whole list to the other one */
+static void bucket_move(
+    struct timers      *timers,
+    const uint32_t      from,
+    const uint32_t      to) {
+
+    uint32_t i;
+
+    while (SLOT_NONE != (i = timers->head[from])) {
+        bucket_unlink(timers, i);
+        bucket_push(timers, to, i);
+    }
+}
+
+/* Check wheel is empty */
+static inline int wheel_empty(
+    struct timers      *timers) {
+
+    for (size_t l = 0; WHEEL_LEVELS > l; ++l) {
+        if (0 != timers->pending[l]) {
+            return 0;
+        }
+    }
+
+    return SLOT_NONE == timers->head[BUCKET_EXPIRED];
+}
+
+/* Put slot to the wheel according to its expiration */
+static void wheel_insert(
+    struct timers      *timers,
+    const uint32_t      i) {
+
+    const uint64_t expires = timers->slot[i].expires;
+    size_t level;
+
+    if (expires <= timers->now) {
+        bucket_push(timers, BUCKET_EXPIRED, i);
+        return;
+    }
+
+    /* Level is given by the highest bit differing from now */
+    level = (63 - __builtin_clzll(expires ^ timers->now)) / WHEEL_BITS;
+    if (WHEEL_LEVELS <= level) {
+        level = WHEEL_LEVELS - 1;
+    }
+
+    bucket_push(timers, level * WHEEL_SIZE + ((expires >> (level * WHEEL_BITS)) & WHEEL_MASK), i);
+}
+
+/* Earliest tick the wheel has to be looked at, UINT64_MAX if none */
+static uint64_t wheel_next(
+    struct timers      *timers) {
+
+    uint64_t next = UINT64_MAX;
+
+    if (SLOT_NONE != timers->head[BUCKET_EXPIRED]) {
+        return timers->now;
+    }
+
+    for (size_t l = 0; WHEEL_LEVELS > l; ++l) {
+
+        const uint64_t pending = timers->pending[l];
+        const size_t shift = l * WHEEL_BITS;
+        uint64_t current, rotated, tick;
+        size_t distance;
+
+        if (0 == pending) {
+            continue;
+        }
+
+        /* First non-empty bucket after the current one, wrapping around */
+        current = (timers->now >> shift) & WHEEL_MASK;
+        rotated = (pending >> ((current + 1) & WHEEL_MASK)) | (pending << ((WHEEL_SIZE - current - 1) & WHEEL_MASK));
+        distance = __builtin_ctzll(rotated) + 1;
+
+        tick = (((timers->now >> shift) + distance) << shift);
+        if (tick < next) {
+            next = tick;
+        }
+    }
+
+    return next;
+}
+
+/* Advance wheel to the tick given, due timers go to the firing list */
+static void wheel_advance(
+    struct timers      *timers,
+    const uint64_t      target) {
+
+    uint32_t i;
+
+    if (target <= timers->now) {
+        return;
+    }
+
+    /* Collect buckets passed on every level */
+    for (size_t l = 0; WHEEL_LEVELS > l; ++l) {
+
+        const size_t shift = l * WHEEL_BITS;
+        const uint64_t from = timers->now >> shift;
+        const uint64_t to = target >> shift;
+
+        if (from == to) {
+            break;
+        }
+
+        if (WHEEL_SIZE <= to - from) {
+            for (size_t b = 0; WHEEL_SIZE > b; ++b) {
+                bucket_move(timers, l * WHEEL_SIZE + b, BUCKET_TODO);
+            }
+            continue;
+        }
+
+        for (uint64_t t = from + 1; to >= t; ++t) {
+            bucket_move(timers, l * WHEEL_SIZE + (t & WHEEL_MASK), BUCKET_TODO);
+        }
+    }
+
+    timers->now = target;
+
+    /* Fire due timers and cascade the rest down */
+    while (SLOT_NONE != (i = timers->head[BUCKET_TODO])) {
+        bucket_unlink(timers, i);
+        if (timers->slot[i].expires <= target) {
+            bucket_push(timers, BUCKET_FIRING, i);
+        } else {
+            wheel_insert(timers, i);
+        }
+    }
+}
+
+/* Arm wheel timerfd to the next wake up */
+static void wheel_arm(
+    struct timers      *timers,
+    const int           force) {
+
+    const uint64_t next = wheel_next(timers);
+    struct itimerspec itimer;
+    uint64_t ns;
+
+    /* Already armed early enough */
+    if (!force && 0 != timers->armed && next >= timers->armed) {
+        return;
+    }
+
+    memset(&itimer, 0, sizeof(itimer));
+
+    if (UINT64_MAX == next) {
+        timers->armed = 0;
+    } else {
+        ns = next * WHEEL_TICK_NS;
+        itimer.it_value.tv_sec = ns / 1000000000ULL;
+        itimer.it_value.tv_nsec = ns % 1000000000ULL;
+        timers->armed = next;
+    }
+
+    timerfd_settime(timers->fd, TFD_TIMER_ABSTIME, &itimer, NULL);
+}
+
+/* Release the slot to the free list */
+static void slot_release(
+    struct timers      *timers,
+    const uint32_t      i) {
+
+    timer_slot_t *s = &timers->slot[i];
+
+    bucket_unlink(timers, i);
+
+    s->flags = 0;
+    s->generation = (s->generation + 1) & GENERATION_MASK;
+    s->callback = NULL;
+    s->periodic = NULL;
+    s->user_data = NULL;
+    s->destructor = NULL;
+    s->precise = NULL;
+    s->next = timers->free;
+    timers->free = i;
+}
+
+/* Allocate a slot */
+static uint32_t slot_alloc(
+    struct timers      *timers) {
+
+    timer_slot_t *slot;
+    uint32_t i, count;
+
+    if (SLOT_NONE != timers->free) {
+        i = timers->free;
+        timers->free = timers->slot[i].next;
+    } else {
+
+        if (timers->top == timers->count) {
+
+            if (SLOT_MASK <= timers->count) {
+                return SLOT_NONE;
+            }
+
+            count = (0 == timers->count) ? SLOT_CHANGE : timers->count * 2;
+            if (SLOT_MASK < count) {
+                count = SLOT_MASK;
+            }
+
+            slot = realloc(timers->slot, count * sizeof(timer_slot_t));
+            if (NULL == slot) {
+                return SLOT_NONE;
+            }
+
+            timers->slot = slot;
+            timers->count = count;
+        }
+
+        i = timers->top++;
+        timers->slot[i].generation = 0;
+    }
+
+    timers->slot[i].flags = TIMER_USED;
+    timers->slot[i].bucket = BUCKET_NONE;
+    timers->slot[i].next = SLOT_NONE;
+    timers->slot[i].prev = SLOT_NONE;
+    timers->slot[i].precise = NULL;
+
+    return i;
+}
+
+/* Release timer state for good */
+static void timers_release(
+    struct timers      *timers) {
+
+    for (uint32_t i = 0; timers->top > i; ++i) {
+
+        timer_slot_t *s = &timers->slot[i];
+
+        if (0 != (s->flags & TIMER_USED) && NULL != s->destructor) {
+            s->destructor(s->user_data);
+        }
+    }
+
+    if (0 <= timers->fd) {
+        close(timers->fd);
+    }
+
+    free(timers->slot);
+    free(timers);
+}
+
+/* Move periodic timer to its next period, return periods passed */
+static uint64_t period_next(
+    struct timers      *timers,
+    const uint32_t      i) {
+
+    timer_slot_t *s = &timers->slot[i];
+    const uint64_t now = clock_ns();
+    uint64_t expired = 1;
+
+    /* Keep the phase: skip periods missed under load and count them */
+    if (now >= s->due) {
+        expired += (now - s->due) / s->timeout;
+    }
+
+    s->due += expired * s->timeout;
+    s->expires = slot_expires(s);
+
+    wheel_insert(timers, i);
+
+    return expired;
+}
+
+/* Wheel timerfd callback */
+static void wheel_callback(
     int                 fd,
     uint32_t            events,
     void               *user_data) {
 
-    const uint32_t escape = EPOLLERR | EPOLLHUP;
+    struct timers *timers = user_data;
+    uint64_t expired;
+    uint32_t i;
+    int id;
 
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        return;
+    }
+
+    if (sizeof(expired) != read(fd, &expired, sizeof(expired)) && EAGAIN != errno) {
+        return;
+    }
+
+    /* Collect due timers */
+    bucket_move(timers, BUCKET_EXPIRED, BUCKET_FIRING);
+    wheel_advance(timers, clock_ns() / WHEEL_TICK_NS);
+
+    /* Callbacks may add, modify or remove timers and even stop the loop */
+    timers->dispatching = 1;
+
+    while (SLOT_NONE != (i = timers->head[BUCKET_FIRING])) {
+
+        bucket_unlink(timers, i);
+        id = slot_id(timers, i);
+
+        if (0 != (timers->slot[i].flags & TIMER_PERIODIC)) {
+            expired = period_next(timers, i);
+            timers->slot[i].periodic(id, expired, timers->slot[i].user_data);
+        } else {
+            timers->slot[i].callback(id, timers->slot[i].user_data);
+        }
+
+        if (timers->released) {
+            timers_release(timers);
+            return;
+        }
+    }
+
+    timers->dispatching = 0;
+
+    wheel_arm(timers, 1);
+}
+
+/* Get or create loop timer state */
+static struct timers *timers_get(
+    struct loop        *loop) {
+
+    struct timers **p_timers = loop_get_timers(loop);
+    struct timers *timers = *p_timers;
+
+    if (NULL != timers) {
+        return timers;
+    }
+
+    timers = calloc(1, sizeof(struct timers));
+    if (NULL == timers) {
+        return NULL;
+    }
+
+    memset(timers->head, 0xFF, sizeof(timers->head));
+    timers->loop = loop;
+    timers->free = SLOT_NONE;
+    timers->now = clock_ns() / WHEEL_TICK_NS;
+
+    timers->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (0 > timers->fd) {
+        free(timers);
+        return NULL;
+    }
+
+    if (0 != loop_add_sd_in(loop, timers->fd, EPOLLIN, wheel_callback, timers, NULL)) {
+        close(timers->fd);
+        free(timers);
+        return NULL;
+    }
+
+    *p_timers = timers;
+
+    return timers;
+}
+
+/* Release timer state */
+void timers_free(
+    struct timers      *timers) {
+
+    if (NULL == timers) {
+        return;
+    }
+
+    /* Wheel callback finishes the job */
+    if (timers->dispatching) {
+        timers->released = 1;
+        return;
+    }
+
+    timers_release(timers);
+}
+
+/* Put wheel timer to the wheel */
+static void wheel_schedule(
+    struct timers      *timers,
+    const uint32_t      i) {
+
+    /* Idle wheel may be far behind, catch up for free */
+    if (!timers->dispatching && wheel_empty(timers)) {
+        timers->now = clock_ns() / WHEEL_TICK_NS;
+    }
+
+    bucket_unlink(timers, i);
+
+    /* Never fire early: round expiration up */
+    timers->slot[i].due = clock_ns() + timers->slot[i].timeout;
+    timers->slot[i].expires = slot_expires(&timers->slot[i]);
+
+    wheel_insert(timers, i);
+
+    if (!timers->dispatching) {
+        wheel_arm(timers, 0);
+    }
+}
+
+/* Precise timer callback */
+static void timer_callback(
+    int                 fd,
+    uint32_t            events,
+    void               *user_data) {
 
     if (events & (EPOLLERR | EPOLLHUP)) {
         return;
@@ -46,116 +608,275 @@ static void timer_callback(
     if (NULL != user_data) {
 
         timer_entry_t *p = user_data;
+        struct timers *timers = *loop_get_timers(p->loop);
         uint64_t expired = 0;
+        uint32_t i;
+
+        if (sizeof(expired) == read(p->fd, &expired, sizeof(expired))) {
+            i = slot_find(timers, p->id);
+            if (SLOT_NONE == i) {
+                return;
+            }
 
-        if (sizeof(expired) == read(p->id, &expired, sizeof(expired))) {
-            if (NULL != p->callback) {
-                p->callback(p->id, p->user_data);
+            if (0 != (timers->slot[i].flags & TIMER_PERIODIC)) {
+                timers->slot[i].periodic(p->id, expired, timers->slot[i].user_data);
+            } else {
+                timers->slot[i].callback(p->id, timers->slot[i].user_data);
             }
         }
     }
 }
 
-/* Destructor */
+/* Precise timer destructor */
 static void timer_destructor(
     void                   *user_data) {
 
     if (NULL != user_data) {
 
         timer_entry_t *p = user_data;
+        struct timers *timers = *loop_get_timers(p->loop);
+        destructor_t destructor = NULL;
+        void *data = NULL;
+        uint32_t i;
 
-        close(p->id);
-        p->id = -1;
+        close(p->fd);
+        p->fd = -1;
 
-        if (NULL != p->destructor) {
-            p->destructor(p->user_data);
+        i = slot_find(timers, p->id);
+        if (SLOT_NONE != i) {
+            destructor = timers->slot[i].destructor;
+            data = timers->slot[i].user_data;
+            slot_release(timers, i);
         }
 
-        free(p);
+        loop_release(p->loop, p, sizeof(timer_entry_t));
+
+        if (NULL != destructor) {
+            destructor(data);
+        }
     }
 }
 
-/* Set timeout */
+/* Set timeout, periodic timers repeat it */
 static inline int timeout_set(
     const int           fd,
-    struct timespec    *timeout) {
+    struct timespec    *timeout,
+    const int           periodic) {
 
     struct itimerspec itimer = {
-        .it_interval.tv_sec     = 0,
-        .it_interval.tv_nsec    = 0,
+        .it_interval.tv_sec     = periodic ? timeout->tv_sec : 0,
+        .it_interval.tv_nsec    = periodic ? timeout->tv_nsec : 0,
         .it_value.tv_sec        = timeout->tv_sec,
         .it_value.tv_nsec       = timeout->tv_nsec
     };
 
-    return timerfd_settime(fd, CLOCK_MONOTONIC, &itimer, NULL);
+    return timerfd_settime(fd, 0, &itimer, NULL);
 }
 
-/* Add timeout to event processing */
-int create_timer(
+/* Loop events of precise timer: periodic ones stay armed */
+static inline uint32_t precise_events(
+    const uint8_t       flags) {
+    return (flags & TIMER_PERIODIC) ? EPOLLIN : EPOLLIN | EPOLLONESHOT;
+}
+
+/* Create timer of any kind */
+static int timer_add(
+    struct loop        *loop,
     struct timespec    *timeout,
+    const uint8_t       flags,
     timer_fn_t          callback,
+    periodic_fn_t       periodic,
     void               *user_data,
     destructor_t        destructor) {
 
-    /* No timeout */
-    if (NULL == timeout) {
+    struct timers *timers;
+    timer_entry_t *p_entry;
+    uint32_t i;
+    int result;
+
+    /* No loop or timeout */
+    if (NULL == loop || NULL == timeout) {
         return -EINVAL;
     }
 
-    /* No callback */
-    if ( NULL == callback) {
+    /* No callback or period */
+    if (flags & TIMER_PERIODIC) {
+        if (NULL == periodic || 0 == timeout_ns(timeout)) {
+            return -EINVAL;
+        }
+    } else if (NULL == callback) {
         return -EINVAL;
     }
 
+    timers = timers_get(loop);
+    if (NULL == timers) {
+        return -EIO;
+    }
+
+    i = slot_alloc(timers);
+    if (SLOT_NONE == i) {
+        return -ENOMEM;
+    }
+
+    timers->slot[i].flags      |= flags;
+    timers->slot[i].timeout     = timeout_ns(timeout);
+    timers->slot[i].slack       = (flags & TIMER_PRECISE) ? 0 : timers->slack;
+    timers->slot[i].callback    = callback;
+    timers->slot[i].periodic    = periodic;
+    timers->slot[i].user_data   = user_data;
+    timers->slot[i].destructor  = destructor;
+
+    /* Wheel timer */
+    if (0 == (flags & TIMER_PRECISE)) {
+        wheel_schedule(timers, i);
+        return slot_id(timers, i);
+    }
+
     /* Allocate memory */
-    timer_entry_t *p_entry = malloc(sizeof(timer_entry_t));
+    p_entry = loop_alloc(loop, sizeof(timer_entry_t));
     if (NULL == p_entry) {
+        slot_release(timers, i);
         return -ENOMEM;
     }
 
     /* Initialize */
-    p_entry->callback     = callback;
-    p_entry->destructor   = destructor;
-    p_entry->user_data    = user_data;
+    p_entry->loop   = loop;
+    p_entry->id     = slot_id(timers, i);
 
     /* Create timer */
-    p_entry->id = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
-    if (0 > p_entry->id) {
-        free(p_entry);
-        return errno;
+    p_entry->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (0 > p_entry->fd) {
+        result = -errno;
+        slot_release(timers, i);
+        loop_release(loop, p_entry, sizeof(timer_entry_t));
+        return result;
     }
 
     /* Set timeout */
-    if (NULL != timeout) {
-        if (0 != timeout_set(p_entry->id, timeout)) {
-            close(p_entry->id);
-            free(p_entry);
-            return -EIO;
-        }
+    if (0 != timeout_set(p_entry->fd, timeout, flags & TIMER_PERIODIC)) {
+        slot_release(timers, i);
+        close(p_entry->fd);
+        loop_release(loop, p_entry, sizeof(timer_entry_t));
+        return -EIO;
     }
 
     /* Add descriptor to the loop */
-    if (0 > loop_add_sd(p_entry->id, EPOLLIN | EPOLLONESHOT, timer_callback, p_entry, timer_destructor)) {
-        close(p_entry->id);
-        free(p_entry);
+    if (0 > loop_add_sd_in(loop, p_entry->fd, precise_events(flags), timer_callback, p_entry, timer_destructor)) {
+        slot_release(timers, i);
+        close(p_entry->fd);
+        loop_release(loop, p_entry, sizeof(timer_entry_t));
         return -EIO;
     }
 
+    timers->slot[i].precise = p_entry;
+
     return p_entry->id;
 }
 
+/* Add timeout to event processing */
+int create_timer_in(
+    struct loop        *loop,
+    struct timespec    *timeout,
+    timer_fn_t          callback,
+    void               *user_data,
+    destructor_t        destructor) {
+    return timer_add(loop, timeout, 0, callback, NULL, user_data, destructor);
+}
+
+/* Add timerfd backed timeout to event processing */
+int create_precise_timer_in(
+    struct loop        *loop,
+    struct timespec    *timeout,
+    timer_fn_t          callback,
+    void               *user_data,
+    destructor_t        destructor) {
+    return timer_add(loop, timeout, TIMER_PRECISE, callback, NULL, user_data, destructor);
+}
+
+/* Add periodic timer to event processing */
+int create_periodic_timer_in(
+    struct loop        *loop,
+    struct timespec    *period,
+    periodic_fn_t       callback,
+    void               *user_data,
+    destructor_t        destructor) {
+    return timer_add(loop, period, TIMER_PERIODIC, NULL, callback, user_data, destructor);
+}
+
+/* Add timerfd backed periodic timer to event processing */
+int create_precise_periodic_timer_in(
+    struct loop        *loop,
+    struct timespec    *period,
+    periodic_fn_t       callback,
+    void               *user_data,
+    destructor_t        destructor) {
+    return timer_add(loop, period, TIMER_PRECISE | TIMER_PERIODIC, NULL, callback, user_data, destructor);
+}
+
 /* Modify event processing timeout */
-int modify_timer(
+int modify_timer_in(
+    struct loop            *loop,
     const int               id,
     struct timespec        *timeout) {
 
+    struct timers *timers = (NULL == loop) ? NULL : *loop_get_timers(loop);
+    const uint32_t i = slot_find(timers, id);
+    struct timespec last;
+
+    if (SLOT_NONE == i) {
+        return -ENXIO;
+    }
+
     if (NULL != timeout) {
-        if (0 != timeout_set(id, timeout)) {
-            return -EIO;
+        if (0 != (timers->slot[i].flags & TIMER_PERIODIC) && 0 == timeout_ns(timeout)) {
+            return -EINVAL;
         }
+        timers->slot[i].timeout = timeout_ns(timeout);
+    }
+
+    /* Wheel timer */
+    if (0 == (timers->slot[i].flags & TIMER_PRECISE)) {
+        wheel_schedule(timers, i);
+        return EXIT_SUCCESS;
     }
 
-    if (0 > loop_modify_sd(id, EPOLLIN | EPOLLONESHOT)) {
+    /* Precise timer */
+    last.tv_sec = timers->slot[i].timeout / 1000000000ULL;
+    last.tv_nsec = timers->slot[i].timeout % 1000000000ULL;
+
+    if (0 != timeout_set(timers->slot[i].precise->fd, &last, timers->slot[i].flags & TIMER_PERIODIC)) {
+        return -EIO;
+    }
+
+    if (0 > loop_modify_sd_in(loop, timers->slot[i].precise->fd, precise_events(timers->slot[i].flags))) {
+        return -EIO;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Stop timer, keep it for later modify */
+int cancel_timer_in(
+    struct loop        *loop,
+    const int           id) {
+
+    struct timers *timers = (NULL == loop) ? NULL : *loop_get_timers(loop);
+    const uint32_t i = slot_find(timers, id);
+    struct itimerspec itimer;
+
+    if (SLOT_NONE == i) {
+        return -ENXIO;
+    }
+
+    /* Wheel timer: the timerfd is re-armed lazily */
+    if (0 == (timers->slot[i].flags & TIMER_PRECISE)) {
+        bucket_unlink(timers, i);
+        return EXIT_SUCCESS;
+    }
+
+    /* Precise timer */
+    memset(&itimer, 0, sizeof(itimer));
+    if (0 != timerfd_settime(timers->slot[i].precise->fd, 0, &itimer, NULL)) {
         return -EIO;
     }
 
@@ -163,9 +884,172 @@ int modify_timer(
 }
 
 /* Remove event processing timeout */
+int destroy_timer_in(
+    struct loop        *loop,
+    const int           id) {
+
+    struct timers *timers = (NULL == loop) ? NULL : *loop_get_timers(loop);
+    const uint32_t i = slot_find(timers, id);
+    destructor_t destructor;
+    void *user_data;
+
+    if (SLOT_NONE == i) {
+        return -ENXIO;
+    }
+
+    /* Precise timer: loop entry destructor releases the slot */
+    if (0 != (timers->slot[i].flags & TIMER_PRECISE)) {
+        return loop_remove_sd_in(loop, timers->slot[i].precise->fd);
+    }
+
+    /* Wheel timer */
+    destructor = timers->slot[i].destructor;
+    user_data = timers->slot[i].user_data;
+
+    slot_release(timers, i);
+
+    if (NULL != destructor) {
+        destructor(user_data);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Set timer slack */
+int set_timer_slack_in(
+    struct loop        *loop,
+    const int           id,
+    struct timespec    *slack) {
+
+    struct timers *timers = (NULL == loop) ? NULL : *loop_get_timers(loop);
+    const uint32_t i = slot_find(timers, id);
+
+    if (SLOT_NONE == i) {
+        return -ENXIO;
+    }
+
+    /* Precise timers fire on time */
+    if (NULL == slack || 0 != (timers->slot[i].flags & TIMER_PRECISE)) {
+        return -EINVAL;
+    }
+
+    timers->slot[i].slack = timeout_ns(slack);
+
+    /* Armed timer moves to its new window */
+    if (BUCKET_NONE != timers->slot[i].bucket && BUCKET_FIRING > timers->slot[i].bucket) {
+        bucket_unlink(timers, i);
+        timers->slot[i].expires = slot_expires(&timers->slot[i]);
+        wheel_insert(timers, i);
+        if (!timers->dispatching) {
+            wheel_arm(timers, 0);
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Set slack of timers created later in loop */
+int set_default_timer_slack_in(
+    struct loop        *loop,
+    struct timespec    *slack) {
+
+    struct timers *timers;
+
+    if (NULL == loop || NULL == slack) {
+        return -EINVAL;
+    }
+
+    timers = timers_get(loop);
+    if (NULL == timers) {
+        return -EIO;
+    }
+
+    timers->slack = timeout_ns(slack);
+
+    return EXIT_SUCCESS;
+}
+
+/* Set process timer slack */
+int set_process_timer_slack(
+    struct timespec    *slack) {
+
+    if (NULL == slack) {
+        return -EINVAL;
+    }
+
+    if (0 != prctl(PR_SET_TIMERSLACK, (unsigned long) timeout_ns(slack), 0, 0, 0)) {
+        return -errno;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Add timeout to default loop */
+int create_timer(
+    struct timespec    *timeout,
+    timer_fn_t          callback,
+    void               *user_data,
+    destructor_t        destructor) {
+    return create_timer_in(loop_default(), timeout, callback, user_data, destructor);
+}
+
+/* Add timerfd backed timeout to default loop */
+int create_precise_timer(
+    struct timespec    *timeout,
+    timer_fn_t          callback,
+    void               *user_data,
+    destructor_t        destructor) {
+    return create_precise_timer_in(loop_default(), timeout, callback, user_data, destructor);
+}
+
+/* Add periodic timer to default loop */
+int create_periodic_timer(
+    struct timespec    *period,
+    periodic_fn_t       callback,
+    void               *user_data,
+    destructor_t        destructor) {
+    return create_periodic_timer_in(loop_default(), period, callback, user_data, destructor);
+}
+
+/* Add timerfd backed periodic timer to default loop */
+int create_precise_periodic_timer(
+    struct timespec    *period,
+    periodic_fn_t       callback,
+    void               *user_data,
+    destructor_t        destructor) {
+    return create_precise_periodic_timer_in(loop_default(), period, callback, user_data, destructor);
+}
+
+/* Modify default loop timeout */
+int modify_timer(
+    const int           id,
+    struct timespec    *timeout) {
+    return modify_timer_in(loop_default(), id, timeout);
+}
+
+/* Stop default loop timeout */
+int cancel_timer(
+    const int           id) {
+    return cancel_timer_in(loop_default(), id);
+}
+
+/* Set default loop timer slack */
+int set_timer_slack(
+    const int           id,
+    struct timespec    *slack) {
+    return set_timer_slack_in(loop_default(), id, slack);
+}
+
+/* Set slack of timers created later in default loop */
+int set_default_timer_slack(
+    struct timespec    *slack) {
+    return set_default_timer_slack_in(loop_default(), slack);
+}
+
+/* Remove default loop timeout */
 int destroy_timer(
     const int           id) {
-    return loop_remove_sd(id);
+    return destroy_timer_in(loop_default(), id);
 }
 
- /* End of file */
\ No newline at end of file
+ /* End of file */
@@ -0,0 +1,450 @@
+/*!
+ *	\file		tracker.c
+ *	\brief		Beacon tracking table
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+#include "beaconizer/tracker.h"
+
+#include "loop_private.h"
+#include "tracker_private.h"
+
+/* Tracking table: rows are dense, every field lives in its own array so the
+ * sweep and the update path touch only the lines they need */
+struct tracker {
+    size_t              capacity;           /* Rows allocated */
+    size_t              count;              /* Rows in use */
+
+    /* Rows */
+    tracker_key_t      *key;                /* Identity */
+    uint64_t           *seen;               /* Last report, ms */
+    float              *rssi;               /* Filter state */
+    float              *error;              /* Kalman error covariance */
+    uint32_t           *packets;            /* Reports */
+    int8_t             *power;              /* Measured power */
+    uint32_t           *slot;               /* Index slot of row */
+
+    /* Open addressing index */
+    uint32_t           *index;              /* Row + 1, 0 when free */
+    uint32_t           *tag;                /* Key hash */
+    size_t              mask;               /* Index size - 1 */
+
+    /* Filter */
+    int                 filter;             /* TRACKER_FILTER_* */
+    float               alpha;              /* EMA weight */
+    float               q;                  /* Process noise */
+    float               r;                  /* Measurement noise */
+    float               path_loss;          /* Path loss exponent */
+
+    uint64_t            max_age;            /* Sweep age limit, ms */
+    tracker_stats_t     stats;              /* Counters */
+};
+
+/* Keys are equal, no early exit */
+static inline int tracker_equal(
+    const tracker_key_t    *a,
+    const tracker_key_t    *b) {
+    return 0 == ((a->word[0] ^ b->word[0]) | (a->word[1] ^ b->word[1]) | (a->word[2] ^ b->word[2]));
+}
+
+/* Index slot of key, or the free slot where it belongs */
+static inline size_t tracker_probe(
+    const struct tracker   *tracker,
+    const tracker_key_t    *key,
+    const uint32_t          hash) {
+
+    size_t i = hash & tracker->mask;
+
+    while (0 != tracker->index[i]
+           && !(hash == tracker->tag[i] && tracker_equal(&tracker->key[tracker->index[i] - 1], key))) {
+        i = (i + 1) & tracker->mask;
+    }
+
+    return i;
+}
+
+/* Key hash of row in index slot */
+static uint32_t tracker_slot_hash(
+    const void         *table,
+    const size_t        slot) {
+    return ((const struct tracker *) table)->tag[slot];
+}
+
+/* Row in index slot j moves to slot i */
+static void tracker_slot_move(
+    void               *table,
+    const size_t        i,
+    const size_t        j) {
+
+    struct tracker *tracker = table;
+
+    tracker->tag[i] = tracker->tag[j];
+    tracker->slot[tracker->index[i] - 1] = (uint32_t) i;
+}
+
+/* Remove row: backward shift in index, last row fills the hole */
+static void tracker_remove(
+    struct tracker     *tracker,
+    const size_t        row) {
+
+    const size_t last = tracker->count - 1;
+
+    index_remove(tracker->index, tracker->mask, tracker->slot[row],
+        tracker_slot_hash, tracker_slot_move, tracker);
+
+    if (row != last) {
+        tracker->key[row] = tracker->key[last];
+        tracker->seen[row] = tracker->seen[last];
+        tracker->rssi[row] = tracker->rssi[last];
+        tracker->error[row] = tracker->error[last];
+        tracker->packets[row] = tracker->packets[last];
+        tracker->power[row] = tracker->power[last];
+        tracker->slot[row] = tracker->slot[last];
+        tracker->index[tracker->slot[row]] = (uint32_t) row + 1;
+    }
+
+    tracker->count--;
+}
+
+/* Sweep timer */
+static void tracker_sweep_timer(
+    int                 id,
+    uint64_t            expired,
+    void               *user_data) {
+
+    struct tracker *tracker = user_data;
+
+    tracker_sweep(tracker, clock_ns() / 1000000, tracker->max_age);
+}
+
+/* iBeacon key */
+void tracker_key_ibeacon(
+    tracker_key_t      *key,
+    const uint8_t       uuid[16],
+    const uint16_t      major,
+    const uint16_t      minor) {
+
+    uint8_t *p = (uint8_t *) key->word;
+
+    memset(key, 0, sizeof(tracker_key_t));
+    p[0] = TRACKER_KEY_IBEACON;
+    memcpy(p + 1, uuid, 16);
+    p[17] = (uint8_t) (major >> 8);
+    p[18] = (uint8_t) major;
+    p[19] = (uint8_t) (minor >> 8);
+    p[20] = (uint8_t) minor;
+}
+
+/* Eddystone UID key */
+void tracker_key_eddystone(
+    tracker_key_t      *key,
+    const uint8_t       ns[10],
+    const uint8_t       instance[6]) {
+
+    uint8_t *p = (uint8_t *) key->word;
+
+    memset(key, 0, sizeof(tracker_key_t));
+    p[0] = TRACKER_KEY_EDDYSTONE;
+    memcpy(p + 1, ns, 10);
+    memcpy(p + 11, instance, 6);
+}
+
+/* Create table */
+struct tracker *tracker_new(
+    const size_t        capacity) {
+
+    struct tracker *tracker;
+    size_t size = 16;
+
+    if (0 == capacity || UINT32_MAX / 2 <= capacity) {
+        return NULL;
+    }
+
+    /* Load factor stays below one half */
+    while (size < capacity * 2) {
+        size <<= 1;
+    }
+
+    tracker = calloc(1, sizeof(struct tracker));
+    if (NULL == tracker) {
+        return NULL;
+    }
+
+    tracker->capacity = capacity;
+    tracker->mask = size - 1;
+    tracker->filter = TRACKER_FILTER_KALMAN;
+    tracker->alpha = TRACKER_DEFAULT_ALPHA;
+    tracker->q = TRACKER_DEFAULT_Q;
+    tracker->r = TRACKER_DEFAULT_R;
+    tracker->path_loss = TRACKER_DEFAULT_PATH_LOSS;
+
+    tracker->key = malloc(capacity * sizeof(tracker_key_t));
+    tracker->seen = malloc(capacity * sizeof(uint64_t));
+    tracker->rssi = malloc(capacity * sizeof(float));
+    tracker->error = malloc(capacity * sizeof(float));
+    tracker->packets = malloc(capacity * sizeof(uint32_t));
+    tracker->power = malloc(capacity * sizeof(int8_t));
+    tracker->slot = malloc(capacity * sizeof(uint32_t));
+    tracker->index = calloc(size, sizeof(uint32_t));
+    tracker->tag = malloc(size * sizeof(uint32_t));
+
+    if (NULL == tracker->key || NULL == tracker->seen || NULL == tracker->rssi
+        || NULL == tracker->error || NULL == tracker->packets || NULL == tracker->power
+        || NULL == tracker->slot || NULL == tracker->index || NULL == tracker->tag) {
+        tracker_free(tracker);
+        return NULL;
+    }
+
+    return tracker;
+}
+
+/* Destroy table */
+void tracker_free(
+    struct tracker     *tracker) {
+
+    if (NULL == tracker) {
+        return;
+    }
+
+    free(tracker->key);
+    free(tracker->seen);
+    free(tracker->rssi);
+    free(tracker->error);
+    free(tracker->packets);
+    free(tracker->power);
+    free(tracker->slot);
+    free(tracker->index);
+    free(tracker->tag);
+    free(tracker);
+}
+
+/* Select filter */
+int tracker_set_filter(
+    struct tracker     *tracker,
+    const int           filter,
+    const float         a,
+    const float         b) {
+
+    if (NULL == tracker) {
+        return -EINVAL;
+    }
+
+    switch (filter) {
+
+        case TRACKER_FILTER_EMA:
+            if (0.0f >= a || 1.0f < a) {
+                return -EINVAL;
+            }
+            tracker->alpha = a;
+            break;
+
+        case TRACKER_FILTER_KALMAN:
+            if (0.0f > a || 0.0f >= b) {
+                return -EINVAL;
+            }
+            tracker->q = a;
+            tracker->r = b;
+            break;
+
+        default:
+            return -EINVAL;
+    }
+
+    tracker->filter = filter;
+
+    return EXIT_SUCCESS;
+}
+
+/* Path loss exponent */
+void tracker_set_path_loss(
+    struct tracker     *tracker,
+    const float         exponent) {
+
+    if (NULL != tracker && 0.0f < exponent) {
+        tracker->path_loss = exponent;
+    }
+}
+
+/* Apply report */
+int tracker_update(
+    struct tracker         *tracker,
+    const tracker_key_t    *key,
+    const int8_t            rssi,
+    const int8_t            measured_power,
+    const uint64_t          now) {
+
+    const uint32_t hash = key_hash(key);
+    const size_t i = tracker_probe(tracker, key, hash);
+    const float z = (float) rssi;
+    float p, gain;
+    size_t row;
+
+    if (0 == tracker->index[i]) {
+
+        if (tracker->count == tracker->capacity) {
+            tracker->stats.dropped++;
+            return -ENOSPC;
+        }
+
+        /* First sample is taken as is */
+        row = tracker->count++;
+        tracker->key[row] = *key;
+        tracker->rssi[row] = z;
+        tracker->error[row] = tracker->r;
+        tracker->packets[row] = 0;
+        tracker->slot[row] = (uint32_t) i;
+        tracker->index[i] = (uint32_t) row + 1;
+        tracker->tag[i] = hash;
+        tracker->stats.inserted++;
+    } else {
+        row = tracker->index[i] - 1;
+    }
+
+    /* EMA is Kalman with fixed gain */
+    p = tracker->error[row] + tracker->q;
+    gain = (TRACKER_FILTER_KALMAN == tracker->filter) ? p / (p + tracker->r) : tracker->alpha;
+
+    tracker->rssi[row] += gain * (z - tracker->rssi[row]);
+    tracker->error[row] = (1.0f - gain) * p;
+    tracker->seen[row] = now;
+    tracker->packets[row]++;
+    tracker->power[row] = measured_power;
+    tracker->stats.updates++;
+
+    return (int) row;
+}
+
+/* Row of beacon */
+int tracker_find(
+    const struct tracker   *tracker,
+    const tracker_key_t    *key) {
+
+    const size_t i = tracker_probe(tracker, key, key_hash(key));
+
+    return (0 != tracker->index[i]) ? (int) tracker->index[i] - 1 : -ENOENT;
+}
+
+/* Snapshot of row */
+int tracker_get(
+    const struct tracker   *tracker,
+    const int               row,
+    tracker_entry_t        *entry) {
+
+    if (NULL == tracker || NULL == entry || 0 > row || tracker->count <= (size_t) row) {
+        return -EINVAL;
+    }
+
+    entry->key = tracker->key[row];
+    entry->last_seen = tracker->seen[row];
+    entry->packets = tracker->packets[row];
+    entry->rssi = tracker->rssi[row];
+    entry->measured_power = tracker->power[row];
+
+    /* Log-distance path loss model, computed on demand only */
+    entry->distance = powf(10.0f, ((float) entry->measured_power - entry->rssi) / (10.0f * tracker->path_loss));
+
+    return EXIT_SUCCESS;
+}
+
+/* Drop old beacons */
+size_t tracker_sweep(
+    struct tracker     *tracker,
+    const uint64_t      now,
+    const uint64_t      max_age) {
+
+    size_t row = 0, evicted = 0;
+
+    while (tracker->count > row) {
+
+        /* Row is refilled from the tail, check it again */
+        if (now > tracker->seen[row] + max_age) {
+            tracker_remove(tracker, row);
+            evicted++;
+        } else {
+            row++;
+        }
+    }
+
+    tracker->stats.evicted += evicted;
+
+    return evicted;
+}
+
+/* Sweep periodically */
+int tracker_start_sweep_in(
+    struct loop        *loop,
+    struct tracker     *tracker,
+    const uint32_t      period,
+    const uint64_t      max_age) {
+
+    struct timespec ts = {
+        .tv_sec     = period / 1000,
+        .tv_nsec    = (long) (period % 1000) * 1000000
+    };
+
+    if (NULL == tracker || 0 == period) {
+        return -EINVAL;
+    }
+
+    tracker->max_age = max_age;
+
+    return create_periodic_timer_in(loop, &ts, tracker_sweep_timer, tracker, NULL);
+}
+
+/* Sweep on default loop */
+int tracker_start_sweep(
+    struct tracker     *tracker,
+    const uint32_t      period,
+    const uint64_t      max_age) {
+    return tracker_start_sweep_in(loop_default(), tracker, period, max_age);
+}
+
+/* Beacons tracked */
+size_t tracker_count(
+    const struct tracker   *tracker) {
+    return (NULL != tracker) ? tracker->count : 0;
+}
+
+/* Bytes per beacon */
+size_t tracker_footprint(
+    const struct tracker   *tracker) {
+
+    const size_t row = sizeof(tracker_key_t) + sizeof(uint64_t) + 2 * sizeof(float)
+        + 2 * sizeof(uint32_t) + sizeof(int8_t);
+
+    if (NULL == tracker) {
+        return 0;
+    }
+
+    return row + ((tracker->mask + 1) * 2 * sizeof(uint32_t)) / tracker->capacity;
+}
+
+/* Get counters */
+int tracker_get_stats(
+    const struct tracker   *tracker,
+    tracker_stats_t        *stats) {
+
+    if (NULL == tracker || NULL == stats) {
+        return -EINVAL;
+    }
+
+    *stats = tracker->stats;
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -0,0 +1,68 @@
+/*!
+ *	\file		tracker_private.h
+ *	\brief		Beacon key index helpers shared by tracker and presence engine
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "beaconizer/tracker.h"
+
+#pragma once
+
+#ifndef __BEACONIZER_TRACKER_PRIVATE_H__
+#define __BEACONIZER_TRACKER_PRIVATE_H__
+
+/* Mix beacon key words */
+static inline uint32_t key_hash(
+    const tracker_key_t    *key) {
+
+    uint64_t h = key->word[0] * UINT64_C(0x9e3779b97f4a7c15);
+
+    h ^= key->word[1] * UINT64_C(0xc2b2ae3d27d4eb4f);
+    h ^= key->word[2] * UINT64_C(0x165667b19e3779f9);
+
+    return (uint32_t) (h ^ (h >> 32));
+}
+
+/* Drop slot i of open addressing index with backward shift, no tombstones.
+ * Index holds entry + 1, 0 when free. hash() gives key hash of entry in slot,
+ * move() shifts table data kept beside index from slot j to i, may be NULL */
+static inline void index_remove(
+    uint32_t           *index,
+    const size_t        mask,
+    size_t              i,
+    uint32_t          (*hash)(const void *table, const size_t slot),
+    void              (*move)(void *table, const size_t i, const size_t j),
+    void               *table) {
+
+    size_t j = i, home;
+
+    for (;;) {
+
+        j = (j + 1) & mask;
+        if (0 == index[j]) {
+            break;
+        }
+
+        /* Entry may move to i only if its home is not in (i, j] */
+        home = hash(table, j) & mask;
+        if ((i < j) ? (home <= i || home > j) : (home <= i && home > j)) {
+            index[i] = index[j];
+            if (NULL != move) {
+                move(table, i, j);
+            }
+            i = j;
+        }
+    }
+
+    index[i] = 0;
+}
+
+#endif /* __BEACONIZER_TRACKER_PRIVATE_H__ */
+
+/* End of file */
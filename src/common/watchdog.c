@@ -28,6 +28,8 @@
 #include "beaconizer/watchdog.h"
 #include "beaconizer/utility.h"
 
+#include "loop_private.h"
+
 
 /* Watchdog stuff */
 static int __s_notify_fd = -1;
@@ -48,13 +50,17 @@ static int watchdog_stop(
     return 1;
 }
 
-static void watchdog_callback(int id, void *user_data)
-{
+/* Periodic watchdog tick: keep going while user callback says so */
+static void watchdog_callback(
+    int              id,
+    uint64_t         expired,
+    void            *user_data) {
+
     watchdog_data_t *data = user_data;
 
-    // if (data->func(data->user_data) &&
-    //     !modify_timer(data->id, data->timeout))
-    //     return;
+    if (NULL != data->callback && data->callback(data->user_data)) {
+        return;
+    }
 
     destroy_timer(data->id);
 }
@@ -69,7 +75,7 @@ static void watchdog_destroy(void *user_data)
             p_entry->destructor(p_entry->user_data);
         }
 
-        free(p_entry);
+        loop_release(loop_default(), p_entry, sizeof(watchdog_data_t));
     }
 }
 
@@ -110,11 +116,16 @@ void watchdog_init(void) {
     if (!watchdog_usec)
         return;
 
-    struct timespec ts;
-    ts.tv_nsec = atoi(watchdog_usec);
-    ts.tv_sec = ts.tv_nsec / ( 1000000 * __WATCHDOG_TRIGGER_FREQ );
-    ts.tv_sec = ts.tv_nsec % ( 1000000 * __WATCHDOG_TRIGGER_FREQ );
-    
+    /* Ping few times per watchdog interval */
+    long usec = atol(watchdog_usec) / __WATCHDOG_TRIGGER_FREQ;
+    struct timespec ts = {
+        .tv_sec     = usec / 1000000,
+        .tv_nsec    = (usec % 1000000) * 1000
+    };
+
+    if (0 >= usec)
+        return;
+
     __s_watchdog = watchdog_add(&ts, watchdog_stop, NULL, NULL);
 }
 
@@ -141,14 +152,18 @@ unsigned int watchdog_add(
     void               *user_data,
     destructor_t        destructor) {
 
-    watchdog_data_t *p = malloc(sizeof(watchdog_data_t));
+    watchdog_data_t *p = loop_alloc(loop_default(), sizeof(watchdog_data_t));
+    if (NULL == p) {
+        return 0;
+    }
+
     p->callback     = func;
     p->user_data    = user_data;
     p->destructor   = destructor;
 
-    p->id = create_timer(timeout, watchdog_callback, p, watchdog_destroy);
+    p->id = create_periodic_timer(timeout, watchdog_callback, p, watchdog_destroy);
     if (p->id < 0) {
-        free(p);
+        loop_release(loop_default(), p, sizeof(watchdog_data_t));
         return 0;
     }
 
@@ -1,13 +1,484 @@
+/*!
+ *	\file		eddystone.c
+ *	\brief		Eddystone beacon
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+#include <time.h>
+#include <sys/random.h>
+
 #include <bluetooth/bluetooth.h>
+#include <bluetooth/hci.h>
+#include <bluetooth/hci_lib.h>
+
 #include "beaconizer/config.h"
+#include "beaconizer/advertiser.h"
+#include "beaconizer/eddystone.h"
+#include "beaconizer/eid.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/signal.h"
+#include "beaconizer/timer.h"
+
+#define EDDYSTONE_NAME              "eddystone"
+#define EDDYSTONE_DEFAULT_ADVERTISE 100
+#define EDDYSTONE_DEFAULT_ROTATE    1000
+#define EDDYSTONE_DEFAULT_TX_POWER  -20
+#define EDDYSTONE_DEFAULT_EXPONENT  10
+
+/*! Command line args */
+static const struct option eddystone_long_options[] = {
+    { "advert",     required_argument,  NULL, 'a' },
+    { "clock",      required_argument,  NULL, 'c' },
+    { "eid",        required_argument,  NULL, 'e' },
+    { "exponent",   required_argument,  NULL, 'k' },
+    { "index",      required_argument,  NULL, 'i' },
+    { "namespace",  required_argument,  NULL, 'n' },
+    { "instance",   required_argument,  NULL, 'I' },
+    { "rotate",     required_argument,  NULL, 'r' },
+    { "tlm",        no_argument,        NULL, 'T' },
+    { "tx",         required_argument,  NULL, 't' },
+    { "url",        required_argument,  NULL, 'u' },
+    { "help",       no_argument,        NULL, 'h' },
+    { 0,            0,                  NULL, 0 }
+};
+
+static const char* eddystone_short_options = "a:c:e:k:i:n:I:r:Tt:u:h";
+
+/* Settings */
+static struct {
+    uint16_t    hci;                                    /*! HCI module index */
+    uint32_t    advertize;                              /*! Advertising interval, ms */
+    uint32_t    rotate;                                 /*! Frame rotation interval, ms */
+    int8_t      tx_power;                               /*! Ranging data, dBm at 0 m */
+    uint8_t     uid;                                    /*! UID frame on */
+    uint8_t     tlm;                                    /*! TLM frame on */
+    uint8_t     eid;                                    /*! EID frame on */
+    uint8_t     exponent;                               /*! EID rotation period exponent */
+    uint32_t    clock;                                  /*! EID beacon time counter at start, s */
+    uint8_t     ik[EID_KEY_SIZE];                       /*! EID identity key */
+    const char *url;                                    /*! URL frame, NULL if off */
+    uint8_t     ns[EDDYSTONE_NAMESPACE_SIZE];           /*! UID namespace */
+    uint8_t     instance[EDDYSTONE_INSTANCE_SIZE];      /*! UID instance */
+} eddystone_settings;
+
+static int hci_desc = -1;
+static struct hci_channel  *hci_channel = NULL;
+static struct advertiser   *advertiser = NULL;
+static eddystone_t          beacon;
+static int advertise_status = EXIT_SUCCESS;
+static uint64_t uptime_ms = 0;
+static uint32_t eid_period = UINT32_MAX;
+
+/*! Help */
+static void ed_help() {
+
+    printf(
+        "Beacon test suite %s\n"
+        "---------------------------------------------------------------------------------------------------\n", __BEACONIZER_VERSION_STRING);
+    printf(
+        "%s - Low Energy Eddystone testing tool\n"
+        "---------------------------------------------------------------------------------------------------\n", EDDYSTONE_NAME);
+    printf(
+        "Usage: %s [options]\n"
+        "---------------------------------------------------------------------------------------------------\n", EDDYSTONE_NAME);
+    printf(
+        "Options:\n");
+    printf(
+        "\t-a, --advert <num>      Advertising interval in ms (optional, default is %d ms)\n", EDDYSTONE_DEFAULT_ADVERTISE);
+    printf(
+        "\t-c, --clock <num>       EID beacon time at start in s, resolver registers the same (optional, default is Unix time)\n");
+    printf(
+        "\t-e, --eid <hex>         Add EID frame with identity key, 32 hex digits\n");
+    printf(
+        "\t-k, --exponent <num>    EID rotation period is 2^num s (optional, default is %d)\n", EDDYSTONE_DEFAULT_EXPONENT);
+    printf(
+        "\t-i, --index <num>       Use specified controller (optional, default is 0)\n");
+    printf(
+        "\t-n, --namespace <hex>   UID namespace, 20 hex digits (optional, random by default)\n");
+    printf(
+        "\t-I, --instance <hex>    UID instance, 12 hex digits (optional, random by default)\n");
+    printf(
+        "\t-r, --rotate <num>      Frame rotation interval in ms (optional, default is %d ms)\n", EDDYSTONE_DEFAULT_ROTATE);
+    printf(
+        "\t-T, --tlm               Add TLM frame\n");
+    printf(
+        "\t-t, --tx <num>          Ranging data in dBm at 0 m (optional, default is %d)\n", EDDYSTONE_DEFAULT_TX_POWER);
+    printf(
+        "\t-u, --url <str>         Add URL frame, UID is sent only if namespace or instance is set\n");
+    printf(
+        "\t-h, --help              Show help options\n"
+        "---------------------------------------------------------------------------------------------------\n");
+}
+
+/*! Parse hex string of exact size */
+static int ed_parse_hex(
+    const char     *str,
+    uint8_t        *out,
+    const size_t    size) {
+
+    size_t j = 0;
+    int k = 0;
+    uint8_t v;
+
+    for (const char *p = str; '\0' != *p; ++p) {
+
+        if ('0' <= *p && '9' >= *p) {
+            v = *p - '0';
+        } else if ('a' <= *p && 'f' >= *p) {
+            v = 10 + (*p - 'a');
+        } else if ('A' <= *p && 'F' >= *p) {
+            v = 10 + (*p - 'A');
+        } else if (':' == *p || '-' == *p) {
+            continue;
+        } else {
+            return EXIT_FAILURE;
+        }
+
+        if (size <= j) {
+            return EXIT_FAILURE;
+        }
+
+        if (k) {
+            out[j] = (out[j] << 4) | v;
+            j++;
+        } else {
+            out[j] = v;
+        }
+        k = !k;
+    }
+
+    return (size == j && !k) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/*! Handle command line args */
+static int ed_process_command_line(
+    int             argc,
+    char * const    argv[]) {
+
+    int uid_is_set = 0;
+
+    for (int key = getopt_long(argc, argv, eddystone_short_options, eddystone_long_options, NULL), index = 0;
+             key != -1;
+             key = getopt_long(argc, argv, eddystone_short_options, eddystone_long_options, &index)) {
+
+        char *ep = NULL;
+        long c = 0;
+
+        switch (key) {
 
+            /* Numbers */
+            case 'a':
+            case 'c':
+            case 'i':
+            case 'k':
+            case 'r':
+            case 't': {
+
+                errno = 0;
+                c = strtol(optarg, &ep, 0);
+                if (0 != errno || '\0' != *ep) {
+                    printf("Bad value: %s! Exiting ...\n", optarg);
+                    return EXIT_FAILURE;
+                }
+
+                if ('t' == key) {
+                    if (INT8_MIN > c || INT8_MAX < c) {
+                        printf("TX power must be in %d..%d dBm! Exiting ...\n", INT8_MIN, INT8_MAX);
+                        return EXIT_FAILURE;
+                    }
+                    eddystone_settings.tx_power = (int8_t) c;
+                    break;
+                }
+
+                if (0 > c || ('i' == key && HCI_MAX_DEV <= c) || UINT32_MAX < (unsigned long) c) {
+                    printf("Value out of range: %s! Exiting ...\n", optarg);
+                    return EXIT_FAILURE;
+                }
+
+                if ('k' == key) {
+                    if (EID_EXPONENT_MAX < c) {
+                        printf("Exponent must be in 0..%d! Exiting ...\n", EID_EXPONENT_MAX);
+                        return EXIT_FAILURE;
+                    }
+                    eddystone_settings.exponent = (uint8_t) c;
+                } else if ('c' == key) {
+                    eddystone_settings.clock = (uint32_t) c;
+                } else if ('a' == key) {
+                    eddystone_settings.advertize = (uint32_t) c;
+                } else if ('i' == key) {
+                    eddystone_settings.hci = (uint16_t) c;
+                } else {
+                    eddystone_settings.rotate = (uint32_t) c;
+                }
+
+                } break;
+
+            /* UID */
+            case 'n':
+            case 'I': {
+
+                const int e = ('n' == key)
+                    ? ed_parse_hex(optarg, eddystone_settings.ns, EDDYSTONE_NAMESPACE_SIZE)
+                    : ed_parse_hex(optarg, eddystone_settings.instance, EDDYSTONE_INSTANCE_SIZE);
+
+                if (EXIT_SUCCESS != e) {
+                    printf("Wrong %s format: %s! Exiting ...\n", ('n' == key) ? "namespace" : "instance", optarg);
+                    return EXIT_FAILURE;
+                }
+
+                uid_is_set = 1;
+
+                } break;
+
+            /* EID */
+            case 'e':
+
+                if (EXIT_SUCCESS != ed_parse_hex(optarg, eddystone_settings.ik, EID_KEY_SIZE)) {
+                    printf("Wrong identity key format: %s! Exiting ...\n", optarg);
+                    return EXIT_FAILURE;
+                }
+
+                eddystone_settings.eid = 1;
+                break;
+
+            /* TLM */
+            case 'T':
+                eddystone_settings.tlm = 1;
+                break;
+
+            /* URL */
+            case 'u': {
+
+                uint8_t encoded[1 + EDDYSTONE_URL_MAX];
+
+                if (0 > eddystone_url_encode(optarg, encoded)) {
+                    printf("URL can't be encoded: %s! Exiting ...\n", optarg);
+                    return EXIT_FAILURE;
+                }
+
+                eddystone_settings.url = optarg;
+
+                } break;
+
+            /* Help */
+            default:
+                ed_help();
+                return EXIT_FAILURE;
+        }
+    }
+
+    /* UID is the default frame */
+    eddystone_settings.uid = uid_is_set || (NULL == eddystone_settings.url && !eddystone_settings.eid);
+
+    return EXIT_SUCCESS;
+}
+
+/* Advertising stopped */
+static void ed_stopped(
+    struct advertiser  *adv,
+    int                 status,
+    void               *user_data) {
+
+    if (BT_HCI_SUCCESS != status) {
+        printf("Stop failed (%d)!\n", status);
+        advertise_status = EXIT_FAILURE;
+    }
+
+    loop_quit();
+}
+
+/* Advertising started */
+static void ed_started(
+    struct advertiser  *adv,
+    int                 status,
+    void               *user_data) {
+
+    if (BT_HCI_SUCCESS != status) {
+        printf("Advertising failed (%d)!\n", status);
+        advertise_status = EXIT_FAILURE;
+        loop_quit();
+        return;
+    }
+
+    printf("Advertising, press Ctrl+C to stop ...\n");
+}
+
+/* Recompute EID when rotation period changes */
+static void ed_update_eid() {
+
+    const uint32_t counter = eddystone_settings.clock + (uint32_t) (uptime_ms / 1000);
+    uint8_t eid[EID_SIZE];
+
+    if (!eddystone_settings.eid || eid_period == counter >> eddystone_settings.exponent) {
+        return;
+    }
+
+    eid_period = counter >> eddystone_settings.exponent;
+    eid_compute(eddystone_settings.ik, eddystone_settings.exponent, counter, eid);
+    eddystone_set_eid(&beacon, eddystone_settings.tx_power, eid);
+}
+
+/* Next frame, advertiser drops it if nothing changed */
+static void ed_rotate(
+    int                 id,
+    uint64_t            expired,
+    void               *user_data) {
+
+    const uint64_t before = uptime_ms;
+    const uint32_t advertize = eddystone_settings.advertize ? eddystone_settings.advertize : 1;
+    const uint8_t *data;
+    uint8_t length;
+
+    uptime_ms += expired * eddystone_settings.rotate;
+    ed_update_eid();
+
+    /* Counters follow uptime without accumulating rounding */
+    eddystone_tlm_tick(&beacon,
+        (uint32_t) (uptime_ms / advertize - before / advertize),
+        (uint32_t) (uptime_ms / 100 - before / 100));
+
+    data = eddystone_next(&beacon, &length);
+    if (NULL != data) {
+        advertiser_set_data(advertiser, data, length);
+    }
+}
+
+/* Interrupted */
+static void ed_signal(
+    int                 signum,
+    void               *user_data) {
+
+    printf("Stopping ...\n");
+    advertiser_stop(advertiser, ed_stopped, NULL);
+}
+
+/* Advertise until interrupted */
+static int ed_advertise() {
+
+    struct timespec period = {
+        .tv_sec     = eddystone_settings.rotate / 1000,
+        .tv_nsec    = (eddystone_settings.rotate % 1000) * 1000000
+    };
+    const uint8_t *data;
+    uint8_t length;
+    int e;
+
+    if (EXIT_SUCCESS != loop_init()) {
+        printf("Loop set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    hci_channel = hci_channel_new(hci_desc);
+    advertiser = advertiser_new(hci_channel);
+    if (NULL == hci_channel || NULL == advertiser) {
+        printf("Advertiser set up failed!\n");
+        hci_channel_free(hci_channel);
+        loop_quit();
+        return EXIT_FAILURE;
+    }
+
+    e = hci_channel_set_filter(hci_channel, 1);
+    if (EXIT_SUCCESS != e) {
+        printf("HCI filter set up failed: %s!\n", strerror(-e));
+    }
+
+    /* Frames are built once, rotation only patches TLM counters */
+    eddystone_init(&beacon);
+    if (eddystone_settings.uid) {
+        eddystone_set_uid(&beacon, eddystone_settings.tx_power, eddystone_settings.ns, eddystone_settings.instance);
+    }
+    if (NULL != eddystone_settings.url) {
+        eddystone_set_url(&beacon, eddystone_settings.tx_power, eddystone_settings.url);
+    }
+    if (eddystone_settings.tlm) {
+        eddystone_set_tlm(&beacon, 0, (int16_t) 0x8000);
+    }
+    ed_update_eid();
+
+    data = eddystone_next(&beacon, &length);
+
+    advertiser_set_interval(advertiser, eddystone_settings.advertize, eddystone_settings.advertize);
+    advertiser_set_type(advertiser, ADVERTISER_ADV_NONCONN_IND);
+    advertiser_set_data(advertiser, data, length);
+
+    /* Single static frame never changes */
+    if (0 < eddystone_settings.rotate
+        && (eddystone_settings.eid || 1 < eddystone_settings.uid + eddystone_settings.tlm + (NULL != eddystone_settings.url))) {
+        if (0 >= create_periodic_timer(&period, ed_rotate, NULL, NULL)) {
+            printf("Rotation timer set up failed!\n");
+        }
+    }
+
+    advertiser_start(advertiser, ed_started, NULL);
+    loop_run_with_signal(ed_signal, NULL);
+
+    advertiser_free(advertiser);
+    hci_channel_free(hci_channel);
+    advertiser = NULL;
+    hci_channel = NULL;
+
+    return advertise_status;
+}
+
+/*! Main loop */
 int
-main(
-    const int argc,
-    const char* argv[],
-    const char* env[]) {
+main(int argc, char * const argv[], char * const env[]) {
+
+    int exit_status = EXIT_FAILURE;
+
+    /* Set up defaults */
+    eddystone_settings.advertize = EDDYSTONE_DEFAULT_ADVERTISE;
+    eddystone_settings.rotate = EDDYSTONE_DEFAULT_ROTATE;
+    eddystone_settings.tx_power = EDDYSTONE_DEFAULT_TX_POWER;
+    eddystone_settings.exponent = EDDYSTONE_DEFAULT_EXPONENT;
+    eddystone_settings.clock = (uint32_t) time(NULL);
+    getrandom(eddystone_settings.ns, sizeof(eddystone_settings.ns), 0);
+    getrandom(eddystone_settings.instance, sizeof(eddystone_settings.instance), 0);
+
+    /* Process command line */
+    if (EXIT_SUCCESS != ed_process_command_line(argc, argv)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("Opening HCI %d ... ", eddystone_settings.hci);
+
+    hci_desc = hci_open_dev(eddystone_settings.hci);
+    if (0 > hci_desc) {
+        printf("Failed!\n");
+        return EXIT_FAILURE;
+    }
+    printf("OK!\n");
 
-    return 0;
+    printf("hci%u: UID %s, URL %s, TLM %s, EID %s, adv %u ms, rotate %u ms ...\n",
+        eddystone_settings.hci,
+        eddystone_settings.uid ? "on" : "off",
+        (NULL != eddystone_settings.url) ? eddystone_settings.url : "off",
+        eddystone_settings.tlm ? "on" : "off",
+        eddystone_settings.eid ? "on" : "off",
+        eddystone_settings.advertize,
+        eddystone_settings.rotate);
+
+    if (eddystone_settings.eid) {
+        printf("EID beacon time %u s, period 2^%u s\n", eddystone_settings.clock, eddystone_settings.exponent);
+    }
+
+    exit_status = ed_advertise();
+
+    printf("Closing HCI %d ... ", eddystone_settings.hci);
+    hci_close_dev(hci_desc);
+    printf("OK!\n");
+
+    return exit_status;
 }
+
+ /* End of file */
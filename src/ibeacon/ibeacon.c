@@ -20,14 +20,29 @@
 #include <bluetooth/hci_lib.h>
 
 #include "beaconizer/config.h"
+#include "beaconizer/advertiser.h"
+#include "beaconizer/beacon.h"
+#include "beaconizer/fleet.h"
+#include "beaconizer/hci.h"
 #include "beaconizer/ibeacon.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/signal.h"
+#include "beaconizer/utility.h"
 
+/* Controller must answer every command within, ms */
+#define IB_HCI_TIMEOUT      1000
+
+/* Fleet file line limit */
+#define IB_FLEET_LINE       256
 
 /*! Command line args */
 static const struct option ibeacon_long_options[] = {
     { "advert",     required_argument,  NULL, 'a' },
     { "mode",       required_argument,  NULL, 'c' },
+    { "sets",       required_argument,  NULL, 'e' },
+    { "fleet",      required_argument,  NULL, 'f' },
     { "index",      required_argument,  NULL, 'i' },
+    { "slot",       required_argument,  NULL, 'l' },
     { "major",      required_argument,  NULL, 'M' },
     { "minor",      required_argument,  NULL, 'm' },
     { "name",       required_argument,  NULL, 'n' },
@@ -40,11 +55,22 @@ static const struct option ibeacon_long_options[] = {
     { 0,            0,                  NULL, 0 }
 };
 
-static const char* ibeacon_short_options = "a:c:i:M:m:n:p:s:t:u:vh";
+static const char* ibeacon_short_options = "a:c:e:f:i:l:M:m:n:p:s:t:u:vh";
 
 /* Settings */
 ibeacon_t   ibeacon_settings;    /*! Beacon settings */
 static int hci_desc = -1;
+static struct hci_dev_info hci_info;
+static struct hci_channel  *hci_channel = NULL;
+static struct advertiser   *advertiser = NULL;
+static int advertise_status = EXIT_SUCCESS;
+
+/* Fleet mode */
+static const char          *fleet_file = NULL;
+static fleet_config_t       fleet_config;
+static ibeacon_t           *fleet_identity = NULL;
+static size_t               fleet_size = 0;
+static struct fleet        *fleet = NULL;
 
 /*! Help */
 static void ib_help();
@@ -58,6 +84,15 @@ static int ib_process_command_line(
     char * const    argv[]
 );
 
+/* Parse UUID, returns octets parsed or -1 on bad digit */
+static int ib_parse_uuid(
+    const char     *text,
+    uint8_t         uuid[16]);
+
+/* Load fleet identities */
+static int ib_load_fleet(
+    const char     *path);
+
 /* Printers */
 static void ib_print_dev_common(
     struct hci_dev_info *di,
@@ -72,6 +107,12 @@ static void ib_print_dev_features(
 /* HCI init/open */
 static int ib_open_hci();
 
+/* Advertise until interrupted */
+static int ib_advertise();
+
+/* Rotate fleet until interrupted */
+static int ib_fleet();
+
 /* Clean up on exit */
 static void ib_clean_up();
 
@@ -90,8 +131,28 @@ main(int argc, char * const argv[], char * const env[]) {
         return EXIT_FAILURE;
     }
 
+    /* Identities are loaded before controller is touched */
+    if (NULL != fleet_file && EXIT_SUCCESS != ib_load_fleet(fleet_file)) {
+        return EXIT_FAILURE;
+    }
+
     /* Check HCI */
-    if (0 == ib_open_hci()) {
+    if (0 != ib_open_hci()) {
+        /* Nothing to advertise on */
+    } else if (NULL != fleet_file) {
+        /* Start rotating */
+        printf("hci%u: fleet of %zu identities from %s, slot %u ms, adv %u ms ...\n",
+            ibeacon_settings.hci,
+            fleet_size,
+            fleet_file,
+            fleet_config.slot,
+            ibeacon_settings.advertize);
+
+        exit_status = ib_fleet();
+
+        /* Stop */
+        printf("Done!\n");
+    } else {
         /* Start advertising */
         printf("hci%u (mode: %d): \"%s\" %.2X%.2X%.2X%.2X-%.2X%.2X-%.2X%.2X-%.2X%.2X-%.2X%.2X%.2X%.2X%.2X%.2X/%u:%u (S/N: %c%c%c%c%c, TX %f dBm), adv %u ms ...\n",
             ibeacon_settings.hci,
@@ -108,7 +169,7 @@ main(int argc, char * const argv[], char * const env[]) {
             ibeacon_settings.tx_power,
             ibeacon_settings.advertize);
 
-        /* */
+        exit_status = ib_advertise();
 
         /* Stop */
         printf("Done!\n");
@@ -140,12 +201,18 @@ main(int argc, char * const argv[], char * const env[]) {
         "\t-a, --advert <num>     Advertising interval in ms (optional, default is %d ms)\n", __IBEACON_DEFAULT_ADVERTISE);
     printf(
         "\t-c, --mode <num>       Connection mode (optional, default is %d)\n", __IBEACON_DEFAULT_CONN_MODE);
+    printf(
+        "\t-e, --sets <num>       Extended advertising sets for fleet (optional, default is 0, legacy advertising)\n");
+    printf(
+        "\t-f, --fleet <file>     Rotate identities listed in file, one \"UUID major minor [power]\" per line\n");
     printf(
         "\t-i, --index <num>      Use specified controller (optional, default is %d)\n", __IBEACON_DEFAULT_HCI_CTRL);
     printf(
-        "\t-M, --major <num>      Major (required, default is %d)\n", __IBEACON_DEFAULT_MAJOR);
+        "\t-l, --slot <num>       Time each fleet identity stays on air in ms (optional, default is %d ms)\n", FLEET_DEFAULT_SLOT);
+    printf(
+        "\t-M, --major <num>      Major (required unless fleet is used, default is %d)\n", __IBEACON_DEFAULT_MAJOR);
     printf(
-        "\t-m, --minor <num>      Minor (required, default is %d)\n", __IBEACON_DEFAULT_MINOR);
+        "\t-m, --minor <num>      Minor (required unless fleet is used, default is %d)\n", __IBEACON_DEFAULT_MINOR);
     printf(
         "\t-n, --name <str>       Device name (optional, default is %s)\n", __IBEACON_DEFAULT_NAME);
     printf(
@@ -187,6 +254,7 @@ static void ib_set_defaults() {
         ibeacon_settings.uuid,
         16,
         GRND_RANDOM);
+    fleet_config_init(&fleet_config);
 }
 
 /*! Handle command line args */
@@ -250,6 +318,37 @@ static int ib_process_command_line(
 
                 } break;
 
+            /* Extended advertising sets */
+            case 'e': {
+
+                errno = 0;
+                c = strtol(optarg, &ep, 0);
+                if ((ERANGE == errno && (LONG_MAX == c || LONG_MIN == c)) || (0 != errno && NULL != ep)) {
+                    perror("Bad advertising sets value: ");
+                    return EXIT_FAILURE;
+                }
+
+                if (0 > c) {
+                    printf("Advertising sets value must be positive! Exiting ...\n");
+                    return EXIT_FAILURE;
+                }
+
+                if (FLEET_MAX_SETS < c) {
+                    printf("Advertising sets must be less than %u! Exiting ...\n", FLEET_MAX_SETS + 1);
+                    return EXIT_FAILURE;
+                }
+
+                fleet_config.sets = (uint8_t) c;
+
+                } break;
+
+            /* Fleet file */
+            case 'f': {
+
+                fleet_file = optarg;
+
+                } break;
+
             /* HCI index */
             case 'i': {
 
@@ -274,6 +373,25 @@ static int ib_process_command_line(
 
                 } break;
 
+            /* Fleet slot */
+            case 'l': {
+
+                errno = 0;
+                c = strtol(optarg, &ep, 0);
+                if ((ERANGE == errno && (LONG_MAX == c || LONG_MIN == c)) || (0 != errno && NULL != ep)) {
+                    perror("Bad slot value: ");
+                    return EXIT_FAILURE;
+                }
+
+                if (0 >= c || UINT32_MAX < (unsigned long) c) {
+                    printf("Slot value must be positive! Exiting ...\n");
+                    return EXIT_FAILURE;
+                }
+
+                fleet_config.slot = (uint32_t) c;
+
+                } break;
+
             /* Major */
             case 'M': { 
 
@@ -386,41 +504,9 @@ static int ib_process_command_line(
             /* UUID */
             case 'u': {
                 /* Parse UUID */
-                l = strlen(optarg);
-                for (size_t i = 0, j = 0, k = 0; (i < l) && (j < 16); ++i) {
-                    if (('0' <= optarg[i]) && ('9' >= optarg[i])) {
-                        if (k) {
-                            ibeacon_settings.uuid[j] <<= 4;
-                            ibeacon_settings.uuid[j] |=  (optarg[i] - '0');
-                            j++;
-                        } else {
-                            ibeacon_settings.uuid[j] =  (optarg[i] - '0');
-                        }
-                        k = !k;
-                    } else if (('A' <= optarg[i]) && ('F' >= optarg[i])) {
-                        if (k) {
-                            ibeacon_settings.uuid[j] <<= 4;
-                            ibeacon_settings.uuid[j] |=  10 + (optarg[i] - 'A');
-                            j++;
-                        } else {
-                            ibeacon_settings.uuid[j] =  10 + (optarg[i] - 'A');
-                        }
-                        k = !k;
-                    } else if (('a' <= optarg[i]) && ('f' >= optarg[i])) {
-                        if (k) {
-                            ibeacon_settings.uuid[j] <<= 4;
-                            ibeacon_settings.uuid[j] |=  10 + (optarg[i] - 'a');
-                            j++;
-                        } else {
-                            ibeacon_settings.uuid[j] =  10 + (optarg[i] - 'a');
-                        }
-                        k = !k;
-                    } else if ((':' == optarg[i]) || ('-' == optarg[i])) {
-                        continue;
-                    } else {
-                        printf("Wrong UUID format: %s. Please, use XX:XX:XX:XX:XX:XX:XX:XX:XX:XX:XX:XX:XX:XX:XX:XX or XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX/ Exiting ...\n", optarg);
-                        return EXIT_FAILURE;
-                    }
+                if (0 > ib_parse_uuid(optarg, ibeacon_settings.uuid)) {
+                    printf("Wrong UUID format: %s. Please, use XX:XX:XX:XX:XX:XX:XX:XX:XX:XX:XX:XX:XX:XX:XX:XX or XXXXXXXX-XXXX-XXXX-XXXX-XXXXXXXXXXXX/ Exiting ...\n", optarg);
+                    return EXIT_FAILURE;
                 }
                 } break;
 
@@ -458,6 +544,11 @@ static int ib_process_command_line(
         return EXIT_FAILURE;
     }
 
+    /* Fleet identities come from file */
+    if (NULL != fleet_file) {
+        return EXIT_SUCCESS;
+    }
+
     /* Check major/minor */
     if (!major_is_set) {
         printf("Please, set iBeacon major value! Exiting ...\n\n");
@@ -474,6 +565,122 @@ static int ib_process_command_line(
     return EXIT_SUCCESS;
 }
 
+/* Parse UUID */
+static int ib_parse_uuid(
+    const char     *text,
+    uint8_t         uuid[16]) {
+
+    const size_t l = strlen(text);
+    int digit;
+    size_t j = 0;
+
+    for (size_t i = 0, k = 0; (i < l) && (j < 16); ++i) {
+        if (('0' <= text[i]) && ('9' >= text[i])) {
+            digit = text[i] - '0';
+        } else if (('A' <= text[i]) && ('F' >= text[i])) {
+            digit = 10 + (text[i] - 'A');
+        } else if (('a' <= text[i]) && ('f' >= text[i])) {
+            digit = 10 + (text[i] - 'a');
+        } else if ((':' == text[i]) || ('-' == text[i])) {
+            continue;
+        } else {
+            return -1;
+        }
+
+        if (k) {
+            uuid[j] <<= 4;
+            uuid[j] |= digit;
+            j++;
+        } else {
+            uuid[j] = digit;
+        }
+        k = !k;
+    }
+
+    return (int) j;
+}
+
+/* Load fleet identities: UUID, major, minor and optional measured power per
+ * line, empty lines and lines starting with '#' are skipped */
+static int ib_load_fleet(
+    const char     *path) {
+
+    char line[IB_FLEET_LINE], uuid[IB_FLEET_LINE];
+    ibeacon_t *identity;
+    size_t capacity = 0;
+    unsigned int number = 0;
+    long major, minor;
+    float power;
+    int fields, result = EXIT_SUCCESS;
+    FILE *file;
+
+    file = fopen(path, "r");
+    if (NULL == file) {
+        printf("Can't open fleet file %s: %s! Exiting ...\n", path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    while (NULL != fgets(line, sizeof(line), file)) {
+
+        number++;
+
+        /* Comments and blank lines */
+        if (1 > sscanf(line, "%255s", uuid) || '#' == uuid[0]) {
+            continue;
+        }
+
+        power = ibeacon_settings.measured_power;
+        fields = sscanf(line, "%255s %li %li %f", uuid, &major, &minor, &power);
+        if (3 > fields || 0 > major || UINT16_MAX < major || 0 > minor || UINT16_MAX < minor) {
+            printf("%s:%u: expected \"UUID major minor [power]\"! Exiting ...\n", path, number);
+            result = EXIT_FAILURE;
+            break;
+        }
+
+        if (fleet_size == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            identity = realloc(fleet_identity, capacity * sizeof(ibeacon_t));
+            if (NULL == identity) {
+                printf("Out of memory! Exiting ...\n");
+                result = EXIT_FAILURE;
+                break;
+            }
+            fleet_identity = identity;
+        }
+
+        /* Everything but the identity itself comes from command line */
+        identity = &fleet_identity[fleet_size];
+        *identity = ibeacon_settings;
+        identity->major = (uint16_t) major;
+        identity->minor = (uint16_t) minor;
+        identity->measured_power = power;
+
+        if (16 != ib_parse_uuid(uuid, identity->uuid)) {
+            printf("%s:%u: wrong UUID %s! Exiting ...\n", path, number, uuid);
+            result = EXIT_FAILURE;
+            break;
+        }
+
+        fleet_size++;
+    }
+
+    fclose(file);
+
+    if (EXIT_SUCCESS == result && 0 == fleet_size) {
+        printf("No identities in %s! Exiting ...\n", path);
+        result = EXIT_FAILURE;
+    }
+
+    /* Whole file or nothing */
+    if (EXIT_SUCCESS != result) {
+        free(fleet_identity);
+        fleet_identity = NULL;
+        fleet_size = 0;
+    }
+
+    return result;
+}
+
 /* Print device info */
 static void ib_print_dev_common(
     struct hci_dev_info *di,
@@ -567,12 +774,8 @@ static void ib_print_dev_features(
 static int ib_open_hci(
     ) {
 
-    int e = EXIT_SUCCESS;
-    struct hci_dev_info     _hci_dev_info;
-    struct hci_version      _hci_version;
-
     /* Getting infomration about HCI */
-    if (0 > hci_devinfo(ibeacon_settings.hci, &_hci_dev_info)) {
+    if (0 > hci_devinfo(ibeacon_settings.hci, &hci_info)) {
         return EXIT_FAILURE;
     }
 
@@ -586,27 +789,296 @@ static int ib_open_hci(
     }
     printf("OK!\n");
 
-    /* Get version */
-    if (0 > hci_read_local_version(hci_desc, &_hci_version, 1000)) {
-        return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+/* Local version read, dump controller info */
+static void ib_version(
+    uint16_t            opcode,
+    int                 status,
+    const uint8_t      *param,
+    uint8_t             length,
+    void               *user_data) {
+
+    struct hci_version      _hci_version;
+
+    /* Status, HCI version, revision, LMP version, manufacturer, LMP subversion */
+    if (BT_HCI_SUCCESS != status || 9 > length) {
+        printf("Reading controller version failed (%d)!\n", status);
+        advertise_status = EXIT_FAILURE;
+        loop_quit();
+        return;
     }
 
-    /* Dump controller info */
+    _hci_version.hci_ver = param[1];
+    _hci_version.hci_rev = get_le16(param + 2);
+    _hci_version.lmp_ver = param[4];
+    _hci_version.manufacturer = get_le16(param + 5);
+    _hci_version.lmp_subver = get_le16(param + 7);
+
     printf("\n");
-    ib_print_dev_common(&_hci_dev_info, &_hci_version);
-    ib_print_dev_flags(&_hci_dev_info);
-    if (!hci_test_bit(HCI_RAW, &_hci_dev_info.flags)) {
-        ib_print_dev_features(&_hci_dev_info);
+    ib_print_dev_common(&hci_info, &_hci_version);
+    ib_print_dev_flags(&hci_info);
+    if (!hci_test_bit(HCI_RAW, &hci_info.flags)) {
+        ib_print_dev_features(&hci_info);
     }
     printf("\n");
+}
+
+/* Advertising stopped */
+static void ib_stopped(
+    struct advertiser  *adv,
+    int                 status,
+    void               *user_data) {
+
+    if (BT_HCI_SUCCESS != status) {
+        printf("Stop failed (%d)!\n", status);
+        advertise_status = EXIT_FAILURE;
+    }
+
+    loop_quit();
+}
+
+/* Advertising started */
+static void ib_started(
+    struct advertiser  *adv,
+    int                 status,
+    void               *user_data) {
+
+    if (BT_HCI_SUCCESS != status) {
+        printf("Advertising failed (%d)!\n", status);
+        advertise_status = EXIT_FAILURE;
+        loop_quit();
+        return;
+    }
+
+    printf("Advertising, press Ctrl+C to stop ...\n");
+}
+
+/* Interrupted */
+static void ib_signal(
+    int                 signum,
+    void               *user_data) {
+
+    printf("Stopping ...\n");
+    advertiser_stop(advertiser, ib_stopped, NULL);
+}
+
+/* Loop and HCI channel, version query goes out first */
+static int ib_open_channel(
+    ) {
+
+    int                     e;
+
+    if (EXIT_SUCCESS != loop_init()) {
+        printf("Loop set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    hci_channel = hci_channel_new(hci_desc);
+    if (NULL == hci_channel) {
+        printf("HCI channel set up failed!\n");
+        loop_quit();
+        return EXIT_FAILURE;
+    }
+
+    /* Only command results are of interest */
+    e = hci_channel_set_filter(hci_channel, 1);
+    if (EXIT_SUCCESS != e) {
+        printf("HCI filter set up failed: %s!\n", strerror(-e));
+    }
+
+    /* Dead controller fails commands instead of hanging */
+    e = hci_channel_set_timeout(hci_channel, IB_HCI_TIMEOUT);
+    if (EXIT_SUCCESS != e) {
+        printf("HCI timeout set up failed: %s!\n", strerror(-e));
+    }
+
+    /* Version query and advertising set up are pipelined */
+    hci_channel_send(hci_channel, BT_HCI_CMD_READ_LOCAL_VERSION, NULL, 0, ib_version, NULL, NULL);
 
     return EXIT_SUCCESS;
 }
 
+/* Advertise until interrupted */
+static int ib_advertise(
+    ) {
+
+    ibeacon_payload_t       _payload;
+    const uint8_t          *_data;
+    uint8_t                 _length;
+
+    if (EXIT_SUCCESS != ib_open_channel()) {
+        return EXIT_FAILURE;
+    }
+
+    advertiser = advertiser_new(hci_channel);
+    if (NULL == advertiser) {
+        printf("Advertiser set up failed!\n");
+        hci_channel_free(hci_channel);
+        hci_channel = NULL;
+        loop_quit();
+        return EXIT_FAILURE;
+    }
+
+    /* Payload is built once, advertiser skips unchanged data */
+    ibeacon_payload_init(&_payload);
+    ibeacon_payload_update(&_payload,
+        ibeacon_settings.uuid,
+        ibeacon_settings.major,
+        ibeacon_settings.minor,
+        (int8_t) ibeacon_settings.measured_power);
+    _data = ibeacon_payload_data(&_payload, &_length);
+
+    advertiser_set_interval(advertiser, ibeacon_settings.advertize, ibeacon_settings.advertize);
+    advertiser_set_data(advertiser, _data, _length);
+    if (0 > advertiser_set_type(advertiser, ibeacon_settings.mode)) {
+        printf("Connection mode %u is not supported!\n", ibeacon_settings.mode);
+        advertise_status = EXIT_FAILURE;
+    } else {
+        advertiser_start(advertiser, ib_started, NULL);
+        loop_run_with_signal(ib_signal, NULL);
+    }
+
+    advertiser_free(advertiser);
+    hci_channel_free(hci_channel);
+    advertiser = NULL;
+    hci_channel = NULL;
+
+    return advertise_status;
+}
+
+/* Fleet stopped, report what was achieved */
+static void ib_fleet_stopped(
+    struct fleet       *fleet,
+    int                 status,
+    void               *user_data) {
+
+    if (BT_HCI_SUCCESS != status) {
+        printf("Stop failed (%d)!\n", status);
+        advertise_status = EXIT_FAILURE;
+    }
+
+    loop_quit();
+}
+
+/* Fleet on air */
+static void ib_fleet_started(
+    struct fleet       *fleet,
+    int                 status,
+    void               *user_data) {
+
+    fleet_stats_t           _stats;
+
+    if (BT_HCI_SUCCESS != status) {
+        printf("Fleet failed (%d)!\n", status);
+        advertise_status = EXIT_FAILURE;
+        loop_quit();
+        return;
+    }
+
+    fleet_get_stats(fleet, &_stats);
+    if (0 == _stats.sets) {
+        printf("Rotating on legacy advertising, press Ctrl+C to stop ...\n");
+    } else {
+        printf("Rotating on %u extended advertising sets, press Ctrl+C to stop ...\n", _stats.sets);
+    }
+}
+
+/* Interrupted */
+static void ib_fleet_signal(
+    int                 signum,
+    void               *user_data) {
+
+    printf("Stopping ...\n");
+
+    /* Stop during set up waits for it to settle, one already in flight
+     * quits on its own */
+    fleet_stop(fleet, ib_fleet_stopped, NULL);
+}
+
+/* Rotate fleet until interrupted */
+static int ib_fleet(
+    ) {
+
+    ibeacon_payload_t       _payload;
+    fleet_stats_t           _stats;
+    const uint8_t          *_data;
+    uint8_t                 _length;
+    int                     e;
+
+    if (EXIT_SUCCESS != ib_open_channel()) {
+        return EXIT_FAILURE;
+    }
+
+    fleet_config.interval = ibeacon_settings.advertize;
+    fleet = fleet_new(hci_channel, &fleet_config);
+    if (NULL == fleet) {
+        printf("Fleet set up failed!\n");
+        hci_channel_free(hci_channel);
+        hci_channel = NULL;
+        loop_quit();
+        return EXIT_FAILURE;
+    }
+
+    /* Payloads are built here, fleet turns them into commands on start */
+    ibeacon_payload_init(&_payload);
+    for (size_t i = 0; fleet_size > i; ++i) {
+
+        ibeacon_payload_update(&_payload,
+            fleet_identity[i].uuid,
+            fleet_identity[i].major,
+            fleet_identity[i].minor,
+            (int8_t) fleet_identity[i].measured_power);
+        _data = ibeacon_payload_data(&_payload, &_length);
+
+        e = fleet_add(fleet, _data, _length);
+        if (0 > e) {
+            printf("Identity %zu rejected: %s!\n", i, strerror(-e));
+            advertise_status = EXIT_FAILURE;
+            break;
+        }
+    }
+
+    if (EXIT_SUCCESS == advertise_status) {
+        e = fleet_start(fleet, ib_fleet_started, NULL);
+        if (EXIT_SUCCESS != e) {
+            printf("Fleet start failed: %s!\n", strerror(-e));
+            advertise_status = EXIT_FAILURE;
+        } else {
+            loop_run_with_signal(ib_fleet_signal, NULL);
+        }
+    }
+
+    fleet_get_stats(fleet, &_stats);
+    if (0 != _stats.elapsed) {
+        printf("%llu switches in %.3f s: %.1f identities/sec, slot lateness %llu us (max %llu us), jitter %llu us, %llu overruns, %llu failures\n",
+            (unsigned long long) _stats.rotations,
+            (double) _stats.elapsed / 1e6,
+            (double) _stats.rotations * 1e6 / (double) _stats.elapsed,
+            (unsigned long long) _stats.lateness,
+            (unsigned long long) _stats.lateness_max,
+            (unsigned long long) _stats.jitter,
+            (unsigned long long) _stats.overruns,
+            (unsigned long long) _stats.failures);
+    }
+
+    fleet_free(fleet);
+    hci_channel_free(hci_channel);
+    fleet = NULL;
+    hci_channel = NULL;
+
+    return advertise_status;
+}
+
 static void ib_clean_up() {
 
     int e;
 
+    free(fleet_identity);
+    fleet_identity = NULL;
+    fleet_size = 0;
+
     /* Close HCI anyway */ 
     printf("Closing HCI %d ... ", ibeacon_settings.hci);
     e = hci_close_dev(hci_desc);
@@ -0,0 +1,208 @@
+/*!
+ *	\file		ad00.c
+ *	\brief		AD iterator and decoder registry test and benchmark
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/ad.h"
+#include "beaconizer/beacon.h"
+
+
+#define TEST_ROUNDS         1000000
+
+typedef struct {
+    const char     *name;
+    const uint8_t  *data;
+    uint8_t         length;
+    int             expected;
+} sample_t;
+
+const uint8_t test_uuid[16] = {
+    0xe2, 0xc5, 0x6d, 0xb5, 0xdf, 0xfb, 0x48, 0xd2,
+    0xb0, 0x60, 0xd0, 0xf5, 0xa7, 0x10, 0x96, 0xe0
+};
+
+/* Eddystone UID */
+const uint8_t test_eddystone[] = {
+    0x02, 0x01, 0x06,
+    0x03, 0x03, 0xaa, 0xfe,
+    0x17, 0x16, 0xaa, 0xfe, 0x00, 0xe7,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x00, 0x00
+};
+
+/* AltBeacon from Radius Networks */
+const uint8_t test_altbeacon[] = {
+    0x1b, 0xff, 0x18, 0x01, 0xbe, 0xac,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19,
+    0xc5, 0x00
+};
+
+/* Apple, but not iBeacon, followed by name */
+const uint8_t test_other[] = {
+    0x02, 0x01, 0x1a,
+    0x0a, 0xff, 0x4c, 0x00, 0x10, 0x05, 0x01, 0x18, 0x00, 0x00, 0x00,
+    0x05, 0x09, 't', 'e', 's', 't'
+};
+
+/* Length runs past the end */
+const uint8_t test_broken[] = {
+    0x02, 0x01, 0x06,
+    0x09, 0x09, 'b', 'r', 'o'
+};
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Walk fields of iBeacon payload */
+static int check_iterator(
+    const uint8_t  *data,
+    const uint8_t   length) {
+
+    const uint8_t padded[] = { 0x02, 0x01, 0x06, 0x00, 0xff, 0xff };
+    uint8_t extended[300];
+    ad_iterator_t it;
+    ad_field_t field;
+    int fields = 0;
+
+    ad_iterator_init(&it, data, length);
+
+    if (1 != ad_iterator_next(&it, &field) || AD_TYPE_FLAGS != field.type
+        || 1 != field.length || 0x06 != field.data[0]) {
+        printf("Flags not found!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (1 != ad_iterator_next(&it, &field) || AD_TYPE_MANUFACTURER != field.type
+        || 25 != field.length || data + 5 != field.data) {
+        printf("Manufacturer data not found!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (0 != ad_iterator_next(&it, &field)) {
+        printf("Iteration did not stop!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Zero length ends significant part */
+    ad_iterator_init(&it, padded, sizeof(padded));
+    if (1 != ad_iterator_next(&it, &field) || 0 != ad_iterator_next(&it, &field)) {
+        printf("Padding not handled!\n");
+        return EXIT_FAILURE;
+    }
+
+    ad_iterator_init(&it, test_broken, sizeof(test_broken));
+    if (1 != ad_iterator_next(&it, &field) || -EBADMSG != ad_iterator_next(&it, &field)) {
+        printf("Malformed data accepted!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Extended report longer than 255 bytes is walked to the end */
+    for (size_t i = 0; sizeof(extended) > i; i += 30) {
+        extended[i] = 29;
+        extended[i + 1] = AD_TYPE_MANUFACTURER;
+        memset(extended + i + 2, (int) i / 30, 28);
+    }
+
+    ad_iterator_init(&it, extended, sizeof(extended));
+    while (1 == ad_iterator_next(&it, &field)) {
+        fields++;
+    }
+
+    if (10 != fields || 9 != field.data[0]) {
+        printf("Extended data cut: %d fields!\n", fields);
+        return EXIT_FAILURE;
+    }
+
+    printf("Iterator OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    ibeacon_payload_t payload;
+    struct ad_registry *registry;
+    sample_t samples[5];
+    const uint8_t *data;
+    uint8_t length;
+    uint64_t start, elapsed;
+    int sum = 0;
+    size_t i, j;
+
+    printf("Checking AD decoder registry ...\n");
+    printf("-------------------------------------\n");
+
+    ibeacon_payload_init(&payload);
+    ibeacon_payload_update(&payload, test_uuid, 1, 2, -59);
+    data = ibeacon_payload_data(&payload, &length);
+
+    if (EXIT_SUCCESS != check_iterator(data, length)) {
+        return EXIT_FAILURE;
+    }
+
+    registry = ad_registry_new();
+    if (NULL == registry || EXIT_SUCCESS != beacon_register_decoders(registry)) {
+        printf("Registry set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    samples[0] = (sample_t) { "iBeacon", data, length, BEACON_IBEACON };
+    samples[1] = (sample_t) { "Eddystone", test_eddystone, sizeof(test_eddystone), BEACON_EDDYSTONE };
+    samples[2] = (sample_t) { "AltBeacon", test_altbeacon, sizeof(test_altbeacon), BEACON_ALTBEACON };
+    samples[3] = (sample_t) { "other", test_other, sizeof(test_other), 0 };
+    samples[4] = (sample_t) { "broken", test_broken, sizeof(test_broken), -EBADMSG };
+
+    for (i = 0; 5 > i; ++i) {
+
+        const int result = ad_registry_classify(registry, samples[i].data, samples[i].length, NULL);
+
+        printf("%-12s %d\n", samples[i].name, result);
+        if (samples[i].expected != result) {
+            printf("Expected %d!\n", samples[i].expected);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* Mixed traffic */
+    start = now_ns();
+    for (i = 0; TEST_ROUNDS > i; ++i) {
+        for (j = 0; 4 > j; ++j) {
+            sum += ad_registry_classify(registry, samples[j].data, samples[j].length, NULL);
+        }
+    }
+    elapsed = now_ns() - start;
+
+    printf("%d reports classified: %.1f ns per report (checksum %d)\n",
+        TEST_ROUNDS * 4, (double) elapsed / (TEST_ROUNDS * 4.0), sum);
+
+    ad_registry_free(registry);
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -0,0 +1,340 @@
+/*!
+ *	\file		adv00.c
+ *	\brief		Advertising engine test against fake controller
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/advertiser.h"
+#include "beaconizer/beacon.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+
+
+#define TEST_LOG_SIZE       16
+#define TEST_FAIL_STATUS    0x12
+
+/* Command seen by fake controller */
+typedef struct {
+    uint16_t        opcode;
+    uint8_t         length;
+    uint8_t         param[BT_HCI_MAX_PARAM_SIZE];
+} command_t;
+
+const uint8_t test_uuid[16] = {
+    0xe2, 0xc5, 0x6d, 0xb5, 0xdf, 0xfb, 0x48, 0xd2,
+    0xb0, 0x60, 0xd0, 0xf5, 0xa7, 0x10, 0x96, 0xe0
+};
+
+struct loop *test_loop = NULL;
+struct advertiser *test_adv = NULL;
+ibeacon_payload_t test_payload;
+command_t test_log[TEST_LOG_SIZE];
+size_t test_count = 0;
+int test_phase = 0;
+int test_result = EXIT_FAILURE;
+uint16_t test_fail_opcode = 0;
+
+/* Fake controller: record command and complete it */
+static void controller(
+    int         sd,
+    uint32_t    event_mask,
+    void       *user_data) {
+
+    uint8_t packet[BT_HCI_MAX_PACKET_SIZE];
+    uint8_t reply[7] = { BT_HCI_EVENT_PKT, BT_HCI_EVT_CMD_COMPLETE, 4, 1, 0, 0, BT_HCI_SUCCESS };
+    command_t *c;
+    ssize_t size;
+
+    while (0 < (size = read(sd, packet, sizeof(packet)))) {
+
+        if (BT_HCI_COMMAND_PKT != packet[0] || 4 > size || TEST_LOG_SIZE <= test_count) {
+            continue;
+        }
+
+        c = &test_log[test_count++];
+        c->opcode = packet[1] | (packet[2] << 8);
+        c->length = packet[3];
+        memcpy(c->param, packet + 4, c->length);
+
+        reply[4] = packet[1];
+        reply[5] = packet[2];
+        if (test_fail_opcode == c->opcode) {
+            reply[6] = TEST_FAIL_STATUS;
+            test_fail_opcode = 0;
+        } else {
+            reply[6] = BT_HCI_SUCCESS;
+        }
+
+        if (sizeof(reply) != write(sd, reply, sizeof(reply))) {
+            printf("Controller write error: %s.\n", strerror(errno));
+        }
+    }
+}
+
+/* Compare command log with expected opcodes */
+static int check_log(
+    const char     *name,
+    const uint16_t *opcode,
+    const size_t    count) {
+
+    size_t i;
+
+    printf("%-24s", name);
+    for (i = 0; test_count > i; ++i) {
+        printf(" %04x", test_log[i].opcode);
+    }
+    printf("\n");
+
+    if (count != test_count) {
+        printf("Expected %lu commands, got %lu!\n", count, test_count);
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; count > i; ++i) {
+        if (opcode[i] != test_log[i].opcode) {
+            printf("Command %lu: expected %04x!\n", i, opcode[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Push payload to advertiser */
+static int set_payload(
+    const uint16_t  minor) {
+
+    const uint8_t *data;
+    uint8_t length;
+
+    ibeacon_payload_update(&test_payload, test_uuid, 0x1234, minor, -59);
+    data = ibeacon_payload_data(&test_payload, &length);
+
+    return advertiser_set_data(test_adv, data, length);
+}
+
+static void scenario(
+    struct advertiser  *adv,
+    int                 status,
+    void               *user_data);
+
+/* Start phase checks */
+static int check_start(void) {
+
+    const uint16_t expected[] = {
+        BT_HCI_CMD_LE_SET_ADV_PARAMETERS,
+        BT_HCI_CMD_LE_SET_ADV_DATA,
+        BT_HCI_CMD_LE_SET_ADV_ENABLE
+    };
+    const uint8_t payload[IBEACON_PAYLOAD_SIZE] = {
+        0x02, 0x01, 0x06, 0x1a, 0xff, 0x4c, 0x00, 0x02, 0x15,
+        0xe2, 0xc5, 0x6d, 0xb5, 0xdf, 0xfb, 0x48, 0xd2,
+        0xb0, 0x60, 0xd0, 0xf5, 0xa7, 0x10, 0x96, 0xe0,
+        0x12, 0x34, 0x00, 0x01, 0xc5
+    };
+    const command_t *params = &test_log[0];
+    const command_t *data = &test_log[1];
+
+    if (EXIT_SUCCESS != check_log("start", expected, 3)) {
+        return EXIT_FAILURE;
+    }
+
+    /* 100 ms is 160 slots, non-connectable, all channels */
+    if (15 != params->length || 0xa0 != params->param[0] || 0x00 != params->param[1]
+        || ADVERTISER_ADV_NONCONN_IND != params->param[4] || 0x07 != params->param[13]) {
+        printf("Wrong advertising parameters!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (32 != data->length || IBEACON_PAYLOAD_SIZE != data->param[0]
+        || 0 != memcmp(data->param + 1, payload, sizeof(payload))) {
+        printf("Wrong advertising data!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (1 != test_log[2].param[0] || !advertiser_is_enabled(test_adv)) {
+        printf("Advertising not enabled!\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Scripted sequence, every step resumes on settled state */
+static void scenario(
+    struct advertiser  *adv,
+    int                 status,
+    void               *user_data) {
+
+    const uint16_t data[] = { BT_HCI_CMD_LE_SET_ADV_DATA };
+    const uint16_t params[] = {
+        BT_HCI_CMD_LE_SET_ADV_ENABLE,
+        BT_HCI_CMD_LE_SET_ADV_PARAMETERS,
+        BT_HCI_CMD_LE_SET_ADV_ENABLE
+    };
+    const uint16_t stop[] = { BT_HCI_CMD_LE_SET_ADV_ENABLE };
+
+    switch (test_phase++) {
+
+        case 0:
+            if (BT_HCI_SUCCESS != status || EXIT_SUCCESS != check_start()) {
+                break;
+            }
+
+            /* Same payload: nothing goes to controller */
+            test_count = 0;
+            set_payload(1);
+            if (0 != test_count) {
+                printf("Unchanged payload was sent!\n");
+                break;
+            }
+
+            /* One field changed: single data update */
+            set_payload(2);
+            advertiser_start(test_adv, scenario, NULL);
+            return;
+
+        case 1:
+            if (BT_HCI_SUCCESS != status || EXIT_SUCCESS != check_log("minor changed", data, 1)) {
+                break;
+            }
+
+            if (0x00 != test_log[0].param[28] || 0x02 != test_log[0].param[29]) {
+                printf("Wrong minor!\n");
+                break;
+            }
+
+            /* Parameters change while enabled */
+            test_count = 0;
+            advertiser_set_interval(test_adv, 200, 200);
+            advertiser_start(test_adv, scenario, NULL);
+            return;
+
+        case 2:
+            if (BT_HCI_SUCCESS != status || EXIT_SUCCESS != check_log("interval changed", params, 3)) {
+                break;
+            }
+
+            if (0 != test_log[0].param[0] || 0x40 != test_log[1].param[0]
+                || 0x01 != test_log[1].param[1] || 1 != test_log[2].param[0]) {
+                printf("Wrong re-configuration!\n");
+                break;
+            }
+
+            /* Controller rejects data */
+            test_count = 0;
+            test_fail_opcode = BT_HCI_CMD_LE_SET_ADV_DATA;
+            set_payload(3);
+            advertiser_start(test_adv, scenario, NULL);
+            return;
+
+        case 3:
+            printf("%-24s status 0x%02x\n", "rejected data", status);
+            if (TEST_FAIL_STATUS != status) {
+                printf("Error was not reported!\n");
+                break;
+            }
+
+            test_count = 0;
+            advertiser_stop(test_adv, scenario, NULL);
+            return;
+
+        case 4:
+            if (BT_HCI_SUCCESS != status || EXIT_SUCCESS != check_log("stop", stop, 1)) {
+                break;
+            }
+
+            if (0 != test_log[0].param[0] || advertiser_is_enabled(test_adv)) {
+                printf("Advertising not disabled!\n");
+                break;
+            }
+
+            test_result = EXIT_SUCCESS;
+            break;
+    }
+
+    loop_quit_in(test_loop);
+}
+
+/* Test hangs */
+static void timeout_callback(
+    int         id,
+    void       *user_data) {
+    printf("Timeout in phase %d!\n", test_phase);
+    loop_quit_in(test_loop);
+}
+
+/* Main course */
+int
+main() {
+
+    struct timespec timeout = { .tv_sec = 5, .tv_nsec = 0 };
+    struct hci_channel *hci;
+    int sv[2];
+
+    printf("Checking advertising engine ...\n");
+    printf("-------------------------------------\n");
+
+    if (0 > socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sv)) {
+        printf("Socket pair error: %s.\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    test_loop = loop_new();
+    if (NULL == test_loop) {
+        printf("Loop creation failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (0 != loop_add_sd_in(test_loop, sv[1], EPOLLIN, controller, NULL, NULL)) {
+        printf("Controller set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    hci = hci_channel_new_in(test_loop, sv[0]);
+    test_adv = advertiser_new(hci);
+    if (NULL == hci || NULL == test_adv) {
+        printf("Advertiser creation failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    create_timer_in(test_loop, &timeout, timeout_callback, NULL, NULL);
+
+    ibeacon_payload_init(&test_payload);
+    advertiser_set_interval(test_adv, 100, 100);
+    advertiser_set_type(test_adv, ADVERTISER_ADV_NONCONN_IND);
+    set_payload(1);
+    advertiser_start(test_adv, scenario, NULL);
+
+    loop_run_in(test_loop);
+
+    advertiser_free(test_adv);
+    hci_channel_free(hci);
+    loop_free(test_loop);
+
+    close(sv[0]);
+    close(sv[1]);
+
+    printf("-------------------------------------\n");
+    printf("%s\n", (EXIT_SUCCESS == test_result) ? "Done!" : "Failed!");
+
+    return test_result;
+}
+
+ /* End of file */
@@ -0,0 +1,182 @@
+/*!
+ *	\file		aes00.c
+ *	\brief		AES-128 known answer test and benchmark
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "beaconizer/aes.h"
+
+
+#define TEST_BLOCKS         1024
+#define TEST_ROUNDS         200
+
+/* FIPS-197 appendix A.1 and B */
+const uint8_t test_key_b[AES128_KEY_SIZE] = {
+    0x2b, 0x7e, 0x15, 0x16, 0x28, 0xae, 0xd2, 0xa6,
+    0xab, 0xf7, 0x15, 0x88, 0x09, 0xcf, 0x4f, 0x3c
+};
+
+const uint8_t test_last_round_key[AES128_BLOCK_SIZE] = {
+    0xd0, 0x14, 0xf9, 0xa8, 0xc9, 0xee, 0x25, 0x89,
+    0xe1, 0x3f, 0x0c, 0xc8, 0xb6, 0x63, 0x0c, 0xa6
+};
+
+const uint8_t test_plain_b[AES128_BLOCK_SIZE] = {
+    0x32, 0x43, 0xf6, 0xa8, 0x88, 0x5a, 0x30, 0x8d,
+    0x31, 0x31, 0x98, 0xa2, 0xe0, 0x37, 0x07, 0x34
+};
+
+const uint8_t test_cipher_b[AES128_BLOCK_SIZE] = {
+    0x39, 0x25, 0x84, 0x1d, 0x02, 0xdc, 0x09, 0xfb,
+    0xdc, 0x11, 0x85, 0x97, 0x19, 0x6a, 0x0b, 0x32
+};
+
+/* FIPS-197 appendix C.1 */
+const uint8_t test_key_c[AES128_KEY_SIZE] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+    0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f
+};
+
+const uint8_t test_plain_c[AES128_BLOCK_SIZE] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+
+const uint8_t test_cipher_c[AES128_BLOCK_SIZE] = {
+    0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+    0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a
+};
+
+static aes128_key_t schedule[TEST_BLOCKS];
+static const aes128_key_t *schedule_ptr[TEST_BLOCKS];
+static uint8_t plain[TEST_BLOCKS][AES128_BLOCK_SIZE];
+static uint8_t cipher[2][TEST_BLOCKS][AES128_BLOCK_SIZE];
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Known answers */
+static int check_vectors(
+    const char         *name) {
+
+    aes128_key_t key;
+    uint8_t out[AES128_BLOCK_SIZE];
+
+    aes128_expand(&key, test_key_b);
+    if (0 != memcmp(key.round_key[AES128_ROUNDS], test_last_round_key, AES128_BLOCK_SIZE)) {
+        printf("%s: key expansion failed!\n", name);
+        return EXIT_FAILURE;
+    }
+
+    aes128_encrypt(&key, test_plain_b, out);
+    if (0 != memcmp(out, test_cipher_b, AES128_BLOCK_SIZE)) {
+        printf("%s: appendix B failed!\n", name);
+        return EXIT_FAILURE;
+    }
+
+    /* In place */
+    aes128_expand(&key, test_key_c);
+    memcpy(out, test_plain_c, AES128_BLOCK_SIZE);
+    aes128_encrypt(&key, out, out);
+    if (0 != memcmp(out, test_cipher_c, AES128_BLOCK_SIZE)) {
+        printf("%s: appendix C.1 failed!\n", name);
+        return EXIT_FAILURE;
+    }
+
+    printf("%s: FIPS-197 vectors OK\n", name);
+
+    return EXIT_SUCCESS;
+}
+
+/* Batch throughput */
+static double bench(
+    const size_t        out) {
+
+    uint64_t start = now_ns();
+
+    for (size_t i = 0; TEST_ROUNDS > i; ++i) {
+        aes128_encrypt_batch(schedule_ptr, (const uint8_t (*)[AES128_BLOCK_SIZE]) plain, cipher[out], TEST_BLOCKS);
+    }
+
+    return (double) (now_ns() - start) / (TEST_ROUNDS * (double) TEST_BLOCKS);
+}
+
+/* Main course */
+int
+main() {
+
+    uint8_t key[AES128_KEY_SIZE];
+    uint32_t seed = 0x12345678;
+    double soft, hard;
+    int hw;
+
+    printf("Checking AES-128 ...\n");
+    printf("-------------------------------------\n");
+
+    /* Independent keys and blocks */
+    for (size_t i = 0; TEST_BLOCKS > i; ++i) {
+        for (size_t j = 0; AES128_BLOCK_SIZE > j; ++j) {
+            seed = seed * 1103515245 + 12345;
+            key[j] = (uint8_t) (seed >> 16);
+            seed = seed * 1103515245 + 12345;
+            plain[i][j] = (uint8_t) (seed >> 16);
+        }
+        aes128_expand(&schedule[i], key);
+        schedule_ptr[i] = &schedule[i];
+    }
+
+    aes128_use_hardware(0);
+    if (EXIT_SUCCESS != check_vectors("software")) {
+        return EXIT_FAILURE;
+    }
+    soft = bench(0);
+    printf("software: %.1f ns per block\n", soft);
+
+    hw = aes128_use_hardware(1);
+    if (!hw) {
+        printf("AES-NI not available\n");
+    } else {
+
+        if (EXIT_SUCCESS != check_vectors("AES-NI")) {
+            return EXIT_FAILURE;
+        }
+        hard = bench(1);
+        printf("AES-NI: %.1f ns per block\n", hard);
+
+        /* Interleaved and tail blocks must match software path */
+        if (0 != memcmp(cipher[0], cipher[1], sizeof(cipher[0]))) {
+            printf("AES-NI and software disagree!\n");
+            return EXIT_FAILURE;
+        }
+
+        memset(cipher[1], 0, sizeof(cipher[1]));
+        aes128_encrypt_batch(schedule_ptr, (const uint8_t (*)[AES128_BLOCK_SIZE]) plain, cipher[1], 7);
+        if (0 != memcmp(cipher[0], cipher[1], 7 * AES128_BLOCK_SIZE)) {
+            printf("Short batch failed!\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -0,0 +1,218 @@
+/*!
+ *	\file		dedup00.c
+ *	\brief		Duplicate suppression test and benchmark
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "beaconizer/dedup.h"
+
+
+#define TEST_BEACONS        1000
+#define TEST_REPORTS        2000000
+#define TEST_WINDOW         1000
+
+/* glibc allocator entry points */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+int test_counting = 0;
+size_t test_allocations = 0;
+
+/* Interpose heap allocations to count them */
+void *malloc(
+    size_t      size) {
+
+    if (test_counting) {
+        test_allocations++;
+    }
+
+    return __libc_malloc(size);
+}
+
+void *calloc(
+    size_t      count,
+    size_t      size) {
+
+    if (test_counting) {
+        test_allocations++;
+    }
+
+    return __libc_calloc(count, size);
+}
+
+void *realloc(
+    void       *ptr,
+    size_t      size) {
+
+    if (test_counting) {
+        test_allocations++;
+    }
+
+    return __libc_realloc(ptr, size);
+}
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Window semantics */
+static int check_window(void) {
+
+    const uint8_t address[6] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06 };
+    const uint8_t other[6] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x07 };
+    const uint8_t data[] = { 0x02, 0x01, 0x06, 0x03, 0x03, 0xaa, 0xfe };
+    const uint8_t changed[] = { 0x02, 0x01, 0x06, 0x03, 0x03, 0xaa, 0xff };
+    const int expected[] = { 1, 0, 0, 1, 0, 1 };
+    const uint64_t at[] = { 0, 1, 999, 1000, 1999, 5000 };
+    struct dedup *dedup;
+    dedup_stats_t stats;
+
+    dedup = dedup_new(0, TEST_WINDOW);
+    if (NULL == dedup) {
+        printf("Cache set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; sizeof(at) / sizeof(at[0]) > i; ++i) {
+        if (expected[i] != dedup_check(dedup, 0, address, data, sizeof(data), at[i])) {
+            printf("Report at %llu ms: expected %d!\n", (unsigned long long) at[i], expected[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* Anything else is a new beacon */
+    if (1 != dedup_check(dedup, 0, address, changed, sizeof(changed), 5001)
+        || 1 != dedup_check(dedup, 1, address, data, sizeof(data), 5001)
+        || 1 != dedup_check(dedup, 0, other, data, sizeof(data), 5001)) {
+        printf("Distinct report suppressed!\n");
+        return EXIT_FAILURE;
+    }
+
+    dedup_get_stats(dedup, &stats);
+    if (6 != stats.passed || 3 != stats.suppressed) {
+        printf("Unexpected counters!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* No window, no suppression */
+    dedup_set_window(dedup, 0);
+    if (1 != dedup_check(dedup, 0, address, data, sizeof(data), 5001)) {
+        printf("Disabled cache suppressed report!\n");
+        return EXIT_FAILURE;
+    }
+
+    dedup_set_window(dedup, TEST_WINDOW);
+    dedup_clear(dedup);
+    if (1 != dedup_check(dedup, 0, address, data, sizeof(data), 5002)) {
+        printf("Cleared cache suppressed report!\n");
+        return EXIT_FAILURE;
+    }
+
+    dedup_free(dedup);
+
+    printf("Window OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    struct dedup *dedup;
+    dedup_stats_t stats;
+    uint8_t address[TEST_BEACONS][6];
+    uint8_t data[31] = { 0x02, 0x01, 0x06, 0x1a, 0xff, 0x4c, 0x00, 0x02, 0x15 };
+    uint64_t start, elapsed;
+    size_t beacon;
+
+    printf("Checking duplicate suppression ...\n");
+    printf("-------------------------------------\n");
+
+    if (EXIT_SUCCESS != check_window()) {
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; TEST_BEACONS > i; ++i) {
+        for (size_t j = 0; 6 > j; ++j) {
+            address[i][j] = (uint8_t) ((i * 2654435761u) >> (4 * j));
+        }
+    }
+
+    /* Crowded table keeps working within its memory */
+    dedup = dedup_new(TEST_BEACONS / 4, TEST_WINDOW);
+    if (NULL == dedup) {
+        printf("Cache set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    test_counting = 1;
+    for (size_t i = 0; TEST_BEACONS > i; ++i) {
+        dedup_check(dedup, 0, address[i], data, sizeof(data), 0);
+    }
+    test_counting = 0;
+
+    dedup_get_stats(dedup, &stats);
+    printf("Crowded: %llu passed, %llu evicted, %zu allocations\n",
+        (unsigned long long) stats.passed, (unsigned long long) stats.evicted, test_allocations);
+
+    if (TEST_BEACONS != stats.passed || 0 == stats.evicted || 0 != test_allocations) {
+        return EXIT_FAILURE;
+    }
+
+    dedup_free(dedup);
+
+    /* Every beacon reports each millisecond, one update per window survives */
+    dedup = dedup_new(0, TEST_WINDOW);
+    if (NULL == dedup) {
+        printf("Cache set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    test_counting = 1;
+    start = now_ns();
+    for (size_t i = 0; TEST_REPORTS > i; ++i) {
+        beacon = i % TEST_BEACONS;
+        data[29] = (uint8_t) beacon;
+        dedup_check(dedup, 1, address[beacon], data, sizeof(data), i / TEST_BEACONS);
+    }
+    elapsed = now_ns() - start;
+    test_counting = 0;
+
+    dedup_get_stats(dedup, &stats);
+    printf("%d reports: %.1f ns per report, %llu passed, %llu suppressed, %zu allocations\n",
+        TEST_REPORTS, (double) elapsed / TEST_REPORTS,
+        (unsigned long long) stats.passed, (unsigned long long) stats.suppressed, test_allocations);
+
+    if ((TEST_REPORTS / TEST_BEACONS / TEST_WINDOW) * TEST_BEACONS != stats.passed
+        || TEST_REPORTS != stats.passed + stats.suppressed
+        || 0 != stats.evicted || 0 != test_allocations) {
+        printf("Unexpected counters!\n");
+        return EXIT_FAILURE;
+    }
+
+    dedup_free(dedup);
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
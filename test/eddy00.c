@@ -0,0 +1,227 @@
+/*!
+ *	\file		eddy00.c
+ *	\brief		Eddystone frame builder test
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include "beaconizer/ad.h"
+#include "beaconizer/beacon.h"
+#include "beaconizer/eddystone.h"
+
+
+const uint8_t test_ns[EDDYSTONE_NAMESPACE_SIZE] = {
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09
+};
+
+const uint8_t test_instance[EDDYSTONE_INSTANCE_SIZE] = {
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15
+};
+
+const uint8_t test_eid[EDDYSTONE_EID_SIZE] = {
+    0xa0, 0xa1, 0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7
+};
+
+/* UID frame as seen on air */
+const uint8_t test_uid_pdu[] = {
+    0x02, 0x01, 0x06,
+    0x03, 0x03, 0xaa, 0xfe,
+    0x17, 0x16, 0xaa, 0xfe, 0x00, 0xe7,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09,
+    0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x00, 0x00
+};
+
+/* URL frame for https://www.example.com/ */
+const uint8_t test_url_pdu[] = {
+    0x02, 0x01, 0x06,
+    0x03, 0x03, 0xaa, 0xfe,
+    0x0e, 0x16, 0xaa, 0xfe, 0x10, 0xe7,
+    0x01, 'e', 'x', 'a', 'm', 'p', 'l', 'e', 0x00
+};
+
+/* TLM frame, 3000 mV, 21.5 C, 10 PDUs, 2 s */
+const uint8_t test_tlm_pdu[] = {
+    0x02, 0x01, 0x06,
+    0x03, 0x03, 0xaa, 0xfe,
+    0x11, 0x16, 0xaa, 0xfe, 0x20, 0x00,
+    0x0b, 0xb8, 0x15, 0x80,
+    0x00, 0x00, 0x00, 0x0a,
+    0x00, 0x00, 0x00, 0x14
+};
+
+/* Compare frame with expected bytes */
+static int check_pdu(
+    const char     *name,
+    const uint8_t  *data,
+    const uint8_t   length,
+    const uint8_t  *expected,
+    const size_t    size) {
+
+    if (NULL == data || size != length || 0 != memcmp(data, expected, size)) {
+        printf("%s frame mismatch!\n", name);
+        return EXIT_FAILURE;
+    }
+
+    printf("%s frame OK\n", name);
+
+    return EXIT_SUCCESS;
+}
+
+/* URL compression both ways */
+static int check_url() {
+
+    const char *bad[] = {
+        "ftp://example.com",
+        "https://www.example.com/ space",
+        "https://www.example-very-long-name.com/"
+    };
+    uint8_t encoded[1 + EDDYSTONE_URL_MAX];
+    char decoded[64];
+    int length;
+
+    length = eddystone_url_encode("https://www.example.com/", encoded);
+    if (9 != length || 0x01 != encoded[0] || 0x00 != encoded[8]) {
+        printf("URL encoding failed (%d)!\n", length);
+        return EXIT_FAILURE;
+    }
+
+    length = eddystone_url_decode(encoded, (uint8_t) length, decoded, sizeof(decoded));
+    if (0 > length || 0 != strcmp("https://www.example.com/", decoded)) {
+        printf("URL decoding failed (%d)!\n", length);
+        return EXIT_FAILURE;
+    }
+
+    /* Plain scheme must not swallow www */
+    length = eddystone_url_encode("http://example.org", encoded);
+    if (9 != length || 0x02 != encoded[0] || 0x08 != encoded[8]) {
+        printf("Plain scheme encoding failed (%d)!\n", length);
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; sizeof(bad) / sizeof(bad[0]) > i; ++i) {
+        if (0 <= eddystone_url_encode(bad[i], encoded)) {
+            printf("Bad URL accepted: %s!\n", bad[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (-ENOSPC != eddystone_url_decode(encoded, 9, decoded, 8)) {
+        printf("Short output buffer accepted!\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("URL codec OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    eddystone_t beacon;
+    struct ad_registry *registry;
+    const uint8_t *data;
+    uint8_t length, slot;
+    uint8_t before[EDDYSTONE_PDU_MAX];
+
+    printf("Checking Eddystone frames ...\n");
+    printf("-------------------------------------\n");
+
+    if (EXIT_SUCCESS != check_url()) {
+        return EXIT_FAILURE;
+    }
+
+    eddystone_init(&beacon);
+    if (NULL != eddystone_next(&beacon, &length) || 0 != length) {
+        printf("Empty beacon returned frame!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Frames are built once */
+    if (1 != eddystone_set_uid(&beacon, -25, test_ns, test_instance)
+        || 0 != eddystone_set_uid(&beacon, -25, test_ns, test_instance)
+        || 1 != eddystone_set_url(&beacon, -25, "https://www.example.com/")
+        || 0 != eddystone_set_url(&beacon, -25, "https://www.example.com/")
+        || 1 != eddystone_set_tlm(&beacon, 3000, 0x1580)
+        || 0 != eddystone_set_tlm(&beacon, 3000, 0x1580)) {
+        printf("Change detection failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (-EINVAL != eddystone_set_url(&beacon, -25, "gopher://example.com")) {
+        printf("Bad URL frame accepted!\n");
+        return EXIT_FAILURE;
+    }
+
+    data = eddystone_next(&beacon, &length);
+    if (EXIT_SUCCESS != check_pdu("UID", data, length, test_uid_pdu, sizeof(test_uid_pdu))) {
+        return EXIT_FAILURE;
+    }
+
+    data = eddystone_next(&beacon, &length);
+    if (EXIT_SUCCESS != check_pdu("URL", data, length, test_url_pdu, sizeof(test_url_pdu))) {
+        return EXIT_FAILURE;
+    }
+
+    /* Counters are patched in place, nothing else moves */
+    memcpy(before, beacon.pdu[EDDYSTONE_SLOT_TLM].data, sizeof(before));
+    eddystone_tlm_tick(&beacon, 4, 8);
+    eddystone_tlm_tick(&beacon, 6, 12);
+    data = eddystone_next(&beacon, &length);
+    if (EXIT_SUCCESS != check_pdu("TLM", data, length, test_tlm_pdu, sizeof(test_tlm_pdu))
+        || 0 != memcmp(before, data, 17)) {
+        return EXIT_FAILURE;
+    }
+
+    /* EID joins rotation, cleared URL leaves it */
+    eddystone_set_eid(&beacon, -25, test_eid);
+    eddystone_clear(&beacon, EDDYSTONE_SLOT_URL);
+
+    data = eddystone_next(&beacon, &length);
+    if (NULL == data || 21 != length || EDDYSTONE_EID != data[11] || 0 != memcmp(data + 13, test_eid, EDDYSTONE_EID_SIZE)) {
+        printf("EID frame mismatch!\n");
+        return EXIT_FAILURE;
+    }
+
+    registry = ad_registry_new();
+    if (NULL == registry || EXIT_SUCCESS != beacon_register_decoders(registry)) {
+        printf("Registry set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; 6 > i; ++i) {
+
+        slot = beacon.current;
+        data = eddystone_next(&beacon, &length);
+
+        if (EDDYSTONE_SLOT_URL == beacon.current
+            || (EDDYSTONE_SLOT_TLM == slot && EDDYSTONE_SLOT_EID != beacon.current)) {
+            printf("Rotation order broken!\n");
+            return EXIT_FAILURE;
+        }
+
+        if (BEACON_EDDYSTONE != ad_registry_classify(registry, data, length, NULL)) {
+            printf("Frame in slot %u not classified!\n", beacon.current);
+            return EXIT_FAILURE;
+        }
+    }
+
+    ad_registry_free(registry);
+
+    printf("Rotation OK\n");
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -0,0 +1,224 @@
+/*!
+ *	\file		eid00.c
+ *	\brief		Eddystone-EID resolver test and benchmark
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/aes.h"
+#include "beaconizer/eid.h"
+
+
+#define TEST_BEACONS        10000
+#define TEST_EXPONENT       10
+#define TEST_NOW            100000
+
+const uint8_t test_ik[EID_KEY_SIZE] = {
+    0xe2, 0xc5, 0x6d, 0xb5, 0xdf, 0xfb, 0x48, 0xd2,
+    0xb0, 0x60, 0xd0, 0xf5, 0xa7, 0x10, 0x96, 0xe0
+};
+
+/* Exponent 10, counter 0x12345678 */
+const uint8_t test_eid[EID_SIZE] = {
+    0x4c, 0xea, 0x4a, 0x8f, 0x8b, 0xca, 0xaa, 0xea
+};
+
+static uint8_t ik[TEST_BEACONS][EID_KEY_SIZE];
+static uint32_t clock_base[TEST_BEACONS];
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Known answer on both AES paths */
+static int check_compute(void) {
+
+    uint8_t eid[EID_SIZE];
+
+    for (int hw = 0; 2 > hw; ++hw) {
+
+        aes128_use_hardware(hw);
+
+        /* Lowest exponent bits are ignored */
+        if (EXIT_SUCCESS != eid_compute(test_ik, TEST_EXPONENT, 0x12345678, eid)
+            || 0 != memcmp(eid, test_eid, EID_SIZE)
+            || EXIT_SUCCESS != eid_compute(test_ik, TEST_EXPONENT, 0x12345400, eid)
+            || 0 != memcmp(eid, test_eid, EID_SIZE)) {
+            printf("EID mismatch!\n");
+            return EXIT_FAILURE;
+        }
+
+        if (EXIT_SUCCESS != eid_compute(test_ik, TEST_EXPONENT, 0x12345800, eid)
+            || 0 == memcmp(eid, test_eid, EID_SIZE)) {
+            printf("EID did not rotate!\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    aes128_use_hardware(1);
+
+    if (-EINVAL != eid_compute(test_ik, EID_EXPONENT_MAX + 1, 0, eid)) {
+        printf("Bad exponent accepted!\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("EID computation OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Every beacon resolves in period of now and adjacent ones */
+static int check_lookup(
+    struct eid_engine  *engine,
+    const uint32_t      now) {
+
+    const int32_t skew[] = { -(1 << TEST_EXPONENT), 0, 1 << TEST_EXPONENT };
+    uint8_t eid[EID_SIZE];
+    void *user_data;
+
+    for (size_t i = 0; TEST_BEACONS > i; ++i) {
+        for (size_t j = 0; 3 > j; ++j) {
+
+            eid_compute(ik[i], TEST_EXPONENT, clock_base[i] + now + skew[j], eid);
+
+            user_data = NULL;
+            if ((int) i != eid_engine_lookup(engine, eid, &user_data) || &ik[i] != user_data) {
+                printf("Beacon %zu not resolved at %d s!\n", i, skew[j]);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    struct eid_engine *engine;
+    uint32_t seed = 0x87654321;
+    uint8_t eid[EID_SIZE];
+    uint64_t start, elapsed;
+    int result;
+
+    printf("Checking EID resolver ...\n");
+    printf("-------------------------------------\n");
+
+    if (EXIT_SUCCESS != check_compute()) {
+        return EXIT_FAILURE;
+    }
+
+    engine = eid_engine_new();
+    if (NULL == engine) {
+        printf("Resolver set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; TEST_BEACONS > i; ++i) {
+
+        for (size_t j = 0; EID_KEY_SIZE > j; ++j) {
+            seed = seed * 1103515245 + 12345;
+            ik[i][j] = (uint8_t) (seed >> 16);
+        }
+        clock_base[i] = seed;
+
+        /* Next period crosses temporary key boundary */
+        if (0 == i) {
+            memcpy(ik[0], test_ik, EID_KEY_SIZE);
+            clock_base[0] = 0x1ffff - TEST_NOW;
+        }
+
+        if ((int) i != eid_engine_add(engine, ik[i], TEST_EXPONENT, clock_base[i], &ik[i])) {
+            printf("Beacon %zu not added!\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (-EINVAL != eid_engine_add(engine, test_ik, EID_EXPONENT_MAX + 1, 0, NULL)
+        || TEST_BEACONS != eid_engine_count(engine)) {
+        printf("Bad beacon accepted!\n");
+        return EXIT_FAILURE;
+    }
+
+    start = now_ns();
+    result = eid_engine_update(engine, TEST_NOW);
+    elapsed = now_ns() - start;
+    printf("Initial update: %d EIDs in %.2f ms\n", result, (double) elapsed / 1e6);
+
+    if (3 * TEST_BEACONS != result || EXIT_SUCCESS != check_lookup(engine, TEST_NOW)) {
+        return EXIT_FAILURE;
+    }
+
+    /* Nothing to do within period */
+    if (0 != eid_engine_update(engine, TEST_NOW)) {
+        printf("Unchanged period recomputed!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Window slides, one EID per beacon */
+    start = now_ns();
+    result = eid_engine_update(engine, TEST_NOW + (1 << TEST_EXPONENT));
+    elapsed = now_ns() - start;
+    printf("Rotation update: %d EIDs in %.2f ms\n", result, (double) elapsed / 1e6);
+
+    if (TEST_BEACONS != result || EXIT_SUCCESS != check_lookup(engine, TEST_NOW + (1 << TEST_EXPONENT))) {
+        return EXIT_FAILURE;
+    }
+
+    /* Expired period is gone */
+    eid_compute(ik[1], TEST_EXPONENT, clock_base[1] + TEST_NOW - (1 << TEST_EXPONENT), eid);
+    if (-ENOENT != eid_engine_lookup(engine, eid, NULL)) {
+        printf("Expired EID resolved!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Window slides back, then jumps; index is patched in place */
+    if (TEST_BEACONS != eid_engine_update(engine, TEST_NOW)
+        || EXIT_SUCCESS != check_lookup(engine, TEST_NOW)
+        || 3 * TEST_BEACONS != eid_engine_update(engine, TEST_NOW + (16 << TEST_EXPONENT))
+        || EXIT_SUCCESS != check_lookup(engine, TEST_NOW + (16 << TEST_EXPONENT))) {
+        printf("Window move failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    eid_compute(ik[1], TEST_EXPONENT, clock_base[1] + TEST_NOW, eid);
+    if (-ENOENT != eid_engine_lookup(engine, eid, NULL)) {
+        printf("Retired EID resolved!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Lookup cost */
+    start = now_ns();
+    result = 0;
+    for (uint32_t i = 0; 1000000 > i; ++i) {
+        memcpy(eid, &i, sizeof(i));
+        result += (0 <= eid_engine_lookup(engine, eid, NULL));
+    }
+    elapsed = now_ns() - start;
+    printf("1000000 lookups: %.1f ns per lookup (%d hits)\n", (double) elapsed / 1e6, result);
+
+    eid_engine_free(engine);
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -0,0 +1,263 @@
+/*!
+ *	\file		emu00.c
+ *	\brief		HCI controller emulator test
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/emulator.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/scanner.h"
+#include "beaconizer/timer.h"
+
+
+#define TEST_COMMANDS       8
+#define TEST_CREDITS        4
+#define TEST_LATENCY        20000       /* us */
+#define TEST_RATE           100000      /* reports/s */
+#define TEST_SCAN_TIME      200         /* ms */
+
+struct loop *test_loop = NULL;
+struct scanner *test_scanner = NULL;
+size_t test_completed = 0;
+int test_status[TEST_COMMANDS];
+uint8_t test_version[16];
+uint64_t test_received = 0;
+uint64_t test_done = 0;
+int test_result = EXIT_FAILURE;
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Command completed, stop after the last one */
+static void complete_callback(
+    uint16_t        opcode,
+    int             status,
+    const uint8_t  *param,
+    uint8_t         length,
+    void           *user_data) {
+
+    if (BT_HCI_CMD_READ_LOCAL_VERSION == opcode && sizeof(test_version) >= length) {
+        memcpy(test_version, param, length);
+    }
+
+    test_status[test_completed] = status;
+    if (TEST_COMMANDS == ++test_completed) {
+        test_done = now_ns();
+        loop_quit_in(test_loop);
+    }
+}
+
+/* Test hangs */
+static void timeout_callback(
+    int         id,
+    void       *user_data) {
+    printf("Timeout!\n");
+    loop_quit_in(test_loop);
+}
+
+/* Commands are answered and pipelined up to the credits */
+static int check_commands(void) {
+
+    const uint8_t enable[2] = { 0x01, 0x00 };
+    struct timespec timeout = { .tv_sec = 5, .tv_nsec = 0 };
+    emulator_config_t config;
+    emulator_stats_t stats;
+    struct emulator *emulator;
+    struct hci_channel *hci;
+    uint64_t start, elapsed;
+
+    emulator_config_init(&config);
+    config.credits = TEST_CREDITS;
+    config.latency = TEST_LATENCY;
+
+    test_loop = loop_new();
+    emulator = emulator_new_in(test_loop, &config);
+    if (NULL == test_loop || NULL == emulator) {
+        printf("Emulator set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    hci = hci_channel_new_in(test_loop, emulator_get_descriptor(emulator));
+    if (NULL == hci) {
+        printf("HCI channel set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Channel starts with one credit until the first completion */
+    hci_channel_send(hci, BT_HCI_CMD_READ_LOCAL_VERSION, NULL, 0, complete_callback, NULL, NULL);
+    hci_channel_send(hci, 0xfc00, NULL, 0, complete_callback, NULL, NULL);
+    for (size_t i = 2; TEST_COMMANDS - 1 > i; ++i) {
+        hci_channel_send(hci, BT_HCI_CMD_LE_SET_ADV_PARAMETERS, NULL, 0, complete_callback, NULL, NULL);
+    }
+    hci_channel_send(hci, BT_HCI_CMD_LE_SET_ADV_ENABLE, enable, 1, complete_callback, NULL, NULL);
+
+    create_timer_in(test_loop, &timeout, timeout_callback, NULL, NULL);
+
+    start = now_ns();
+    loop_run_in(test_loop);
+    elapsed = test_done - start;
+
+    emulator_get_stats(emulator, &stats);
+    printf("%d commands with %d credits and %d us latency: %.1f ms, %llu overruns\n",
+        TEST_COMMANDS, TEST_CREDITS, TEST_LATENCY, elapsed / 1e6, (unsigned long long) stats.overruns);
+
+    if (TEST_COMMANDS != test_completed || TEST_COMMANDS != stats.commands || 0 != stats.overruns
+        || 1 != stats.unknown || !emulator_is_advertising(emulator)) {
+        printf("Unexpected counters!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Read Local Version: status, HCI version, revision, LMP version, manufacturer */
+    if (BT_HCI_SUCCESS != test_status[0] || EMULATOR_HCI_VERSION != test_version[1]
+        || (EMULATOR_MANUFACTURER & 0xff) != test_version[5] || 0x01 != test_status[1]) {
+        printf("Unexpected replies!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* One round trip for the first command, then credits limited batches */
+    if ((uint64_t) TEST_LATENCY * 1000 * 3 > elapsed || (uint64_t) TEST_LATENCY * 1000 * TEST_COMMANDS <= elapsed) {
+        printf("Commands were not pipelined!\n");
+        return EXIT_FAILURE;
+    }
+
+    hci_channel_free(hci);
+    emulator_free(emulator);
+    loop_free(test_loop);
+
+    printf("Commands OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Count reports */
+static void report_callback(
+    const scanner_report_t *report,
+    void                   *user_data) {
+
+    if (0x4c == report->data[5] && 0x02 == report->data[7]) {
+        test_received++;
+    }
+}
+
+/* Scanning stopped */
+static void stopped(
+    struct scanner     *scanner,
+    int                 status,
+    void               *user_data) {
+
+    test_result = (BT_HCI_SUCCESS == status) ? EXIT_SUCCESS : EXIT_FAILURE;
+    loop_quit_in(test_loop);
+}
+
+/* Scan time is over */
+static void stop_callback(
+    int         id,
+    void       *user_data) {
+    scanner_stop(test_scanner, stopped, NULL);
+}
+
+/* Scanning started */
+static void started(
+    struct scanner     *scanner,
+    int                 status,
+    void               *user_data) {
+
+    struct timespec scan = { .tv_sec = 0, .tv_nsec = TEST_SCAN_TIME * 1000000L };
+
+    test_done = now_ns();
+
+    if (BT_HCI_SUCCESS != status) {
+        printf("Scan start failed!\n");
+        loop_quit_in(test_loop);
+        return;
+    }
+
+    create_timer_in(test_loop, &scan, stop_callback, NULL, NULL);
+}
+
+/* Reports flow at the configured rate while scanning */
+static int check_scanning(void) {
+
+    struct timespec timeout = { .tv_sec = 5, .tv_nsec = 0 };
+    emulator_config_t config;
+    emulator_stats_t stats;
+    struct emulator *emulator;
+    struct hci_channel *hci;
+    double rate;
+
+    emulator_config_init(&config);
+    config.rate = TEST_RATE;
+    config.per_event = 3;
+
+    test_loop = loop_new();
+    emulator = emulator_new_in(test_loop, &config);
+    hci = (NULL != emulator) ? hci_channel_new_in(test_loop, emulator_get_descriptor(emulator)) : NULL;
+    test_scanner = scanner_new(hci, report_callback, NULL);
+    if (NULL == test_loop || NULL == emulator || NULL == hci || NULL == test_scanner) {
+        printf("Scanner set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    create_timer_in(test_loop, &timeout, timeout_callback, NULL, NULL);
+
+    scanner_start(test_scanner, started, NULL);
+    loop_run_in(test_loop);
+
+    rate = (double) test_received * 1e9 / ((double) (now_ns() - test_done));
+    emulator_get_stats(emulator, &stats);
+    printf("%llu reports in %d ms: %.0f reports/sec, %llu events\n",
+        (unsigned long long) test_received, TEST_SCAN_TIME, rate, (unsigned long long) stats.events);
+
+    if (EXIT_SUCCESS != test_result || emulator_is_scanning(emulator)
+        || stats.reports != test_received || TEST_RATE / 2 > rate || TEST_RATE * 2 < rate) {
+        printf("Scanning failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    scanner_free(test_scanner);
+    hci_channel_free(hci);
+    emulator_free(emulator);
+    loop_free(test_loop);
+
+    printf("Scanning OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    printf("Checking controller emulator ...\n");
+    printf("-------------------------------------\n");
+
+    if (EXIT_SUCCESS != check_commands() || EXIT_SUCCESS != check_scanning()) {
+        return EXIT_FAILURE;
+    }
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
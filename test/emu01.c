@@ -0,0 +1,155 @@
+/*!
+ *	\file		emu01.c
+ *	\brief		Receive path benchmark on emulated controller
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/emulator.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/scanner.h"
+#include "beaconizer/timer.h"
+
+
+#define TEST_REPORTS        2000000
+
+struct loop *test_loop = NULL;
+struct scanner *test_scanner = NULL;
+uint64_t test_received = 0;
+uint64_t test_start = 0;
+uint64_t test_elapsed = 0;
+int test_result = EXIT_FAILURE;
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Scanning stopped */
+static void stopped(
+    struct scanner     *scanner,
+    int                 status,
+    void               *user_data) {
+
+    test_result = (BT_HCI_SUCCESS == status) ? EXIT_SUCCESS : EXIT_FAILURE;
+    loop_quit_in(test_loop);
+}
+
+/* Count reports, stop scanning once enough arrived */
+static void report_callback(
+    const scanner_report_t *report,
+    void                   *user_data) {
+
+    if (TEST_REPORTS == ++test_received) {
+        test_elapsed = now_ns() - test_start;
+        scanner_stop(test_scanner, stopped, NULL);
+    }
+}
+
+/* Scanning started */
+static void started(
+    struct scanner     *scanner,
+    int                 status,
+    void               *user_data) {
+
+    test_start = now_ns();
+
+    if (BT_HCI_SUCCESS != status) {
+        printf("Scan start failed!\n");
+        loop_quit_in(test_loop);
+    }
+}
+
+/* Test hangs */
+static void timeout_callback(
+    int         id,
+    void       *user_data) {
+    printf("Timeout: %llu reports received!\n", (unsigned long long) test_received);
+    loop_quit_in(test_loop);
+}
+
+/* Scan with unlimited report rate */
+static int run_scan(
+    const uint8_t       per_event) {
+
+    struct timespec timeout = { .tv_sec = 30, .tv_nsec = 0 };
+    emulator_config_t config;
+    emulator_stats_t emulator_stats;
+    hci_channel_stats_t hci_stats;
+    struct emulator *emulator;
+    struct hci_channel *hci;
+
+    emulator_config_init(&config);
+    config.per_event = per_event;
+
+    test_loop = loop_new();
+    emulator = emulator_new_in(test_loop, &config);
+    hci = (NULL != emulator) ? hci_channel_new_in(test_loop, emulator_get_descriptor(emulator)) : NULL;
+    test_scanner = scanner_new(hci, report_callback, NULL);
+    if (NULL == test_loop || NULL == emulator || NULL == hci || NULL == test_scanner) {
+        printf("Scanner set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    test_received = 0;
+    test_result = EXIT_FAILURE;
+    create_timer_in(test_loop, &timeout, timeout_callback, NULL, NULL);
+
+    scanner_start(test_scanner, started, NULL);
+    loop_run_in(test_loop);
+
+    emulator_get_stats(emulator, &emulator_stats);
+    hci_channel_get_stats(hci, &hci_stats);
+
+    printf("%u per event: %.0f reports/sec, %.1f reports per wakeup, %llu stalls\n",
+        per_event, TEST_REPORTS * 1e9 / test_elapsed,
+        (double) test_received / (double) (hci_stats.wakeups ? hci_stats.wakeups : 1),
+        (unsigned long long) emulator_stats.stalls);
+
+    scanner_free(test_scanner);
+    hci_channel_free(hci);
+    emulator_free(emulator);
+    loop_free(test_loop);
+
+    if (EXIT_SUCCESS != test_result || TEST_REPORTS > test_received) {
+        printf("Scan failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    printf("Benchmarking receive path on emulated controller ...\n");
+    printf("-------------------------------------\n");
+
+    if (EXIT_SUCCESS != run_scan(1) || EXIT_SUCCESS != run_scan(EMULATOR_MAX_PER_EVENT)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -0,0 +1,361 @@
+/*!
+ *	\file		fleet00.c
+ *	\brief		Virtual beacon fleet rotation on emulated controller
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/beacon.h"
+#include "beaconizer/emulator.h"
+#include "beaconizer/fleet.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+
+
+#define TEST_IDENTITIES     32
+#define TEST_SETS           4
+#define TEST_SLOT           10          /* ms */
+#define TEST_WINDOW         300         /* ms */
+#define TEST_LATENCY        500         /* us */
+
+struct loop *test_loop = NULL;
+struct fleet *test_fleet = NULL;
+int test_started = -1;
+int test_stopped = -1;
+
+/* Test hangs */
+static void timeout_callback(
+    int         id,
+    void       *user_data) {
+    printf("Timeout!\n");
+    loop_quit_in(test_loop);
+}
+
+/* Fleet is off */
+static void stopped_callback(
+    struct fleet       *fleet,
+    int                 status,
+    void               *user_data) {
+
+    test_stopped = status;
+    loop_quit_in(test_loop);
+}
+
+/* Idle fleet stopped */
+static void idle_callback(
+    struct fleet       *fleet,
+    int                 status,
+    void               *user_data) {
+    *(int *) user_data = status;
+}
+
+/* Measurement window is over */
+static void window_callback(
+    int         id,
+    void       *user_data) {
+
+    if (0 > fleet_stop(test_fleet, stopped_callback, NULL)) {
+        loop_quit_in(test_loop);
+    }
+}
+
+/* Fleet is on air */
+static void started_callback(
+    struct fleet       *fleet,
+    int                 status,
+    void               *user_data) {
+
+    struct timespec window = { .tv_sec = 0, .tv_nsec = TEST_WINDOW * 1000000L };
+
+    test_started = status;
+
+    if (BT_HCI_SUCCESS != status) {
+        loop_quit_in(test_loop);
+        return;
+    }
+
+    create_timer_in(test_loop, &window, window_callback, NULL, NULL);
+}
+
+/* Rotate identities on controller with given number of sets */
+static int run_fleet(
+    const uint8_t       sets,
+    const uint8_t       expected,
+    double             *rate) {
+
+    struct timespec timeout = { .tv_sec = 5, .tv_nsec = 0 };
+    emulator_config_t emulator_config;
+    emulator_stats_t emulator_stats;
+    fleet_config_t config;
+    fleet_stats_t stats;
+    ibeacon_payload_t payload;
+    struct emulator *emulator;
+    struct hci_channel *hci;
+    const uint8_t uuid[16] = { 0xe2, 0xc5, 0x6d, 0xb5, 0xdf, 0xfb, 0x48, 0xd2,
+                               0xb0, 0x60, 0xd0, 0xf5, 0xa7, 0x10, 0x96, 0xe0 };
+    const uint8_t *data;
+    uint8_t length;
+    int result = EXIT_SUCCESS;
+
+    emulator_config_init(&emulator_config);
+    emulator_config.latency = TEST_LATENCY;
+    emulator_config.sets = sets;
+
+    fleet_config_init(&config);
+    config.slot = TEST_SLOT;
+    config.sets = TEST_SETS;
+
+    test_loop = loop_new();
+    emulator = emulator_new_in(test_loop, &emulator_config);
+    hci = (NULL != emulator) ? hci_channel_new_in(test_loop, emulator_get_descriptor(emulator)) : NULL;
+    test_fleet = fleet_new_in(test_loop, hci, &config);
+    if (NULL == test_loop || NULL == emulator || NULL == hci || NULL == test_fleet) {
+        printf("Fleet set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Identities differ by minor */
+    ibeacon_payload_init(&payload);
+    for (uint16_t i = 0; TEST_IDENTITIES > i; ++i) {
+
+        ibeacon_payload_update(&payload, uuid, 1, i, -59);
+        data = ibeacon_payload_data(&payload, &length);
+
+        if (i != fleet_add(test_fleet, data, length)) {
+            printf("Identity %u rejected!\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    test_started = -1;
+    test_stopped = -1;
+
+    if (EXIT_SUCCESS != fleet_start(test_fleet, started_callback, NULL)) {
+        printf("Start failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    create_timer_in(test_loop, &timeout, timeout_callback, NULL, NULL);
+    loop_run_in(test_loop);
+
+    fleet_get_stats(test_fleet, &stats);
+    emulator_get_stats(emulator, &emulator_stats);
+
+    *rate = (0 != stats.elapsed) ? (double) stats.rotations * 1e6 / (double) stats.elapsed : 0;
+
+    printf("  %u sets: %llu switches in %llu us, %.0f identities/sec, lateness %llu us (max %llu us), jitter %llu us, %llu overruns\n",
+        stats.sets, (unsigned long long) stats.rotations, (unsigned long long) stats.elapsed, *rate,
+        (unsigned long long) stats.lateness, (unsigned long long) stats.lateness_max,
+        (unsigned long long) stats.jitter, (unsigned long long) stats.overruns);
+
+    if (BT_HCI_SUCCESS != test_started || BT_HCI_SUCCESS != test_stopped) {
+        printf("Start/stop failed: %d/%d!\n", test_started, test_stopped);
+        result = EXIT_FAILURE;
+    }
+
+    if (expected != stats.sets) {
+        printf("Expected %u sets!\n", expected);
+        result = EXIT_FAILURE;
+    }
+
+    /* Every switch reached controller, first identity of each set on top */
+    if (0 == stats.rotations || 0 != stats.failures
+        || stats.rotations + (expected ? expected : 1) != emulator_stats.adv_data) {
+        printf("Switches lost: %llu sent, %llu on controller!\n",
+            (unsigned long long) stats.rotations, (unsigned long long) emulator_stats.adv_data);
+        result = EXIT_FAILURE;
+    }
+
+    if (emulator_is_advertising(emulator) || fleet_is_running(test_fleet)) {
+        printf("Still advertising!\n");
+        result = EXIT_FAILURE;
+    }
+
+    fleet_free(test_fleet);
+    hci_channel_free(hci);
+    emulator_free(emulator);
+    loop_free(test_loop);
+    test_fleet = NULL;
+
+    return result;
+}
+
+/* Stop right after start waits for set up and leaves advertising off */
+static int check_early_stop(
+    const uint8_t       sets) {
+
+    struct timespec timeout = { .tv_sec = 5, .tv_nsec = 0 };
+    emulator_config_t emulator_config;
+    fleet_config_t config;
+    struct emulator *emulator;
+    struct hci_channel *hci;
+    const uint8_t data[3] = { 0x02, 0x01, 0x06 };
+    int result = EXIT_SUCCESS;
+
+    emulator_config_init(&emulator_config);
+    emulator_config.latency = TEST_LATENCY;
+    emulator_config.sets = sets;
+
+    fleet_config_init(&config);
+    config.slot = TEST_SLOT;
+    config.sets = sets;
+
+    test_loop = loop_new();
+    emulator = emulator_new_in(test_loop, &emulator_config);
+    hci = (NULL != emulator) ? hci_channel_new_in(test_loop, emulator_get_descriptor(emulator)) : NULL;
+    test_fleet = fleet_new_in(test_loop, hci, &config);
+    if (NULL == test_loop || NULL == emulator || NULL == hci || NULL == test_fleet) {
+        printf("Fleet set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    test_started = -1;
+    test_stopped = -1;
+
+    if (0 > fleet_add(test_fleet, data, sizeof(data)) || 0 > fleet_add(test_fleet, data, sizeof(data))
+        || EXIT_SUCCESS != fleet_start(test_fleet, started_callback, NULL)
+        || EXIT_SUCCESS != fleet_stop(test_fleet, stopped_callback, NULL)
+        || -EBUSY != fleet_start(test_fleet, started_callback, NULL)) {
+        printf("Early stop refused!\n");
+        return EXIT_FAILURE;
+    }
+
+    create_timer_in(test_loop, &timeout, timeout_callback, NULL, NULL);
+    loop_run_in(test_loop);
+
+    if (-1 != test_started || BT_HCI_SUCCESS != test_stopped) {
+        printf("Early stop failed: %d/%d!\n", test_started, test_stopped);
+        result = EXIT_FAILURE;
+    }
+
+    if (emulator_is_advertising(emulator) || fleet_is_running(test_fleet)) {
+        printf("Still advertising after early stop!\n");
+        result = EXIT_FAILURE;
+    }
+
+    fleet_free(test_fleet);
+    hci_channel_free(hci);
+    emulator_free(emulator);
+    loop_free(test_loop);
+    test_fleet = NULL;
+
+    return result;
+}
+
+/* Arguments are checked */
+static int check_arguments(void) {
+
+    const uint8_t data[FLEET_MAX_DATA + 1] = { 0 };
+    emulator_config_t emulator_config;
+    fleet_config_t config;
+    struct emulator *emulator;
+    struct hci_channel *hci;
+    struct fleet *fleet;
+    struct loop *loop = loop_new();
+    int stopped = -1;
+
+    emulator_config_init(&emulator_config);
+    emulator = emulator_new_in(loop, &emulator_config);
+    hci = (NULL != emulator) ? hci_channel_new_in(loop, emulator_get_descriptor(emulator)) : NULL;
+    if (NULL == loop || NULL == emulator || NULL == hci) {
+        printf("Channel set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    fleet_config_init(&config);
+    config.slot = 0;
+    if (NULL != fleet_new_in(loop, hci, &config)) {
+        printf("Empty slot accepted!\n");
+        return EXIT_FAILURE;
+    }
+
+    fleet_config_init(&config);
+    config.sets = FLEET_MAX_SETS + 1;
+    if (NULL != fleet_new_in(loop, hci, &config) || NULL != fleet_new_in(loop, NULL, &config)) {
+        printf("Bad config accepted!\n");
+        return EXIT_FAILURE;
+    }
+
+    fleet_config_init(&config);
+    fleet = fleet_new_in(loop, hci, &config);
+    if (NULL == fleet) {
+        printf("Fleet set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (-EINVAL != fleet_add(fleet, data, sizeof(data)) || -EINVAL != fleet_add(fleet, NULL, 1)
+        || -EINVAL != fleet_start(fleet, NULL, NULL)) {
+        printf("Bad identity accepted!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Stopping idle fleet settles at once */
+    if (EXIT_SUCCESS != fleet_stop(fleet, idle_callback, &stopped) || BT_HCI_SUCCESS != stopped) {
+        printf("Idle stop failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    fleet_free(fleet);
+    hci_channel_free(hci);
+    emulator_free(emulator);
+    loop_free(loop);
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    double legacy, extended;
+
+    printf("Checking virtual beacon fleet ...\n");
+    printf("-------------------------------------\n");
+
+    if (EXIT_SUCCESS != check_arguments()) {
+        return EXIT_FAILURE;
+    }
+
+    if (EXIT_SUCCESS != check_early_stop(0) || EXIT_SUCCESS != check_early_stop(TEST_SETS)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("Early stop OK\n");
+
+    printf("Legacy only controller:\n");
+    if (EXIT_SUCCESS != run_fleet(0, 0, &legacy)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("Controller with %d sets:\n", TEST_SETS);
+    if (EXIT_SUCCESS != run_fleet(TEST_SETS, TEST_SETS, &extended)) {
+        return EXIT_FAILURE;
+    }
+
+    /* Sets rotate side by side */
+    if (extended < legacy * 2) {
+        printf("Extended sets did not speed up rotation!\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%d identities: legacy %.0f identities/sec, %d sets %.0f identities/sec (x%.2f)\n",
+        TEST_IDENTITIES, legacy, TEST_SETS, extended, extended / legacy);
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
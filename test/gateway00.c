@@ -0,0 +1,257 @@
+/*!
+ *	\file		gateway00.c
+ *	\brief		Multi-adapter scanning on emulated controllers
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/emulator.h"
+#include "beaconizer/gateway.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+
+
+#define TEST_MAX_ADAPTERS   4
+#define TEST_WINDOW         300         /* ms */
+
+/* Emulated controller in own thread */
+typedef struct {
+    pthread_t           thread;
+    struct loop        *loop;
+    struct emulator    *emulator;
+} controller_t;
+
+struct loop *test_loop = NULL;
+uint64_t test_delivered[TEST_MAX_ADAPTERS];
+uint64_t test_malformed = 0;
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Controller thread */
+static void *controller_thread(
+    void       *user_data) {
+
+    controller_t *controller = user_data;
+
+    loop_run_in(controller->loop);
+
+    return NULL;
+}
+
+/* Quit task */
+static void controller_quit(
+    void       *user_data) {
+
+    controller_t *controller = user_data;
+
+    loop_quit_in(controller->loop);
+}
+
+/* Count iBeacon reports by adapter */
+static void report_callback(
+    const gateway_report_t *report,
+    void                   *user_data) {
+
+    if (TEST_MAX_ADAPTERS <= report->adapter || 30 != report->length
+        || 0x4c != report->data[5] || 0x02 != report->data[7]) {
+        test_malformed++;
+        return;
+    }
+
+    test_delivered[report->adapter]++;
+}
+
+/* Measurement window is over */
+static void window_callback(
+    int         id,
+    void       *user_data) {
+    loop_quit_in(test_loop);
+}
+
+/* Scan on several controllers at once */
+static int run_gateway(
+    const size_t        count,
+    double             *rate) {
+
+    struct timespec window = { .tv_sec = 0, .tv_nsec = TEST_WINDOW * 1000000L };
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    controller_t controller[TEST_MAX_ADAPTERS];
+    gateway_adapter_t adapter[TEST_MAX_ADAPTERS];
+    emulator_config_t emulator_config;
+    gateway_config_t config;
+    gateway_stats_t stats;
+    struct gateway *gateway;
+    uint64_t start, delivered = 0;
+    int result = EXIT_SUCCESS;
+
+    emulator_config_init(&emulator_config);
+    emulator_config.per_event = EMULATOR_MAX_PER_EVENT;
+
+    memset(test_delivered, 0, sizeof(test_delivered));
+    test_malformed = 0;
+
+    for (size_t i = 0; count > i; ++i) {
+
+        controller[i].loop = loop_new();
+        controller[i].emulator = emulator_new_in(controller[i].loop, &emulator_config);
+        if (NULL == controller[i].loop || NULL == controller[i].emulator
+            || 0 != pthread_create(&controller[i].thread, NULL, controller_thread, &controller[i])) {
+            printf("Controller set up failed!\n");
+            return EXIT_FAILURE;
+        }
+
+        adapter[i].index = -1;
+        adapter[i].fd = emulator_get_descriptor(controller[i].emulator);
+        adapter[i].cpu = (int) (i % (size_t) (0 < cpus ? cpus : 1));
+    }
+
+    gateway_config_init(&config);
+
+    test_loop = loop_new();
+    start = now_ns();
+    gateway = gateway_new_in(test_loop, &config, adapter, count, report_callback, NULL);
+    if (NULL == test_loop || NULL == gateway) {
+        printf("Gateway set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    create_timer_in(test_loop, &window, window_callback, NULL, NULL);
+    loop_run_in(test_loop);
+
+    *rate = 0;
+    for (size_t i = 0; count > i; ++i) {
+        delivered += test_delivered[i];
+    }
+    *rate = (double) delivered * 1e9 / (double) (now_ns() - start);
+
+    if (count != gateway_ready(gateway)) {
+        printf("Adapters did not settle!\n");
+        result = EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; count > i; ++i) {
+
+        gateway_get_stats(gateway, i, &stats);
+        printf("  adapter %lu: status %d, HCI version 0x%02x, %llu delivered, %llu queued, %llu dropped, %llu oversize\n",
+            i, stats.status, stats.hci_version, (unsigned long long) test_delivered[i],
+            (unsigned long long) stats.reports, (unsigned long long) stats.drops,
+            (unsigned long long) stats.oversize);
+
+        if (BT_HCI_SUCCESS != stats.status || EMULATOR_HCI_VERSION != stats.hci_version
+            || 0 == test_delivered[i] || test_delivered[i] > stats.reports || 0 != stats.oversize) {
+            printf("Adapter %lu failed!\n", i);
+            result = EXIT_FAILURE;
+        }
+    }
+
+    if (0 != test_malformed) {
+        printf("%llu malformed reports!\n", (unsigned long long) test_malformed);
+        result = EXIT_FAILURE;
+    }
+
+    /* Scanning is switched off before threads go */
+    gateway_free(gateway);
+    loop_free(test_loop);
+
+    for (size_t i = 0; count > i; ++i) {
+
+        loop_post_in(controller[i].loop, controller_quit, &controller[i], NULL);
+        pthread_join(controller[i].thread, NULL);
+
+        if (emulator_is_scanning(controller[i].emulator)) {
+            printf("Adapter %lu still scanning!\n", i);
+            result = EXIT_FAILURE;
+        }
+
+        emulator_free(controller[i].emulator);
+        loop_free(controller[i].loop);
+    }
+
+    return result;
+}
+
+/* Arguments are checked */
+static int check_arguments(void) {
+
+    gateway_adapter_t adapter = { .index = -1, .fd = -1, .cpu = GATEWAY_CPU_ANY };
+    gateway_config_t config;
+    struct loop *loop = loop_new();
+    int index[GATEWAY_MAX_ADAPTERS];
+    int count;
+
+    gateway_config_init(&config);
+
+    if (NULL != gateway_new_in(loop, &config, &adapter, 1, report_callback, NULL)
+        || NULL != gateway_new_in(loop, &config, &adapter, 0, report_callback, NULL)
+        || NULL != gateway_new_in(loop, &config, &adapter, 1, NULL, NULL)) {
+        printf("Bad arguments accepted!\n");
+        return EXIT_FAILURE;
+    }
+
+    loop_free(loop);
+
+    /* Machine may have no Bluetooth at all */
+    count = gateway_probe(index, GATEWAY_MAX_ADAPTERS);
+    if (0 > count) {
+        printf("No HCI devices: %s\n", strerror(-count));
+    } else {
+        printf("%d HCI devices up\n", count);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    double single, multiple;
+
+    printf("Checking multi-adapter scanning ...\n");
+    printf("-------------------------------------\n");
+
+    if (EXIT_SUCCESS != check_arguments()) {
+        return EXIT_FAILURE;
+    }
+
+    printf("1 adapter:\n");
+    if (EXIT_SUCCESS != run_gateway(1, &single)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("%d adapters:\n", TEST_MAX_ADAPTERS);
+    if (EXIT_SUCCESS != run_gateway(TEST_MAX_ADAPTERS, &multiple)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("1 adapter: %.0f reports/sec, %d adapters: %.0f reports/sec (x%.2f on %ld CPUs)\n",
+        single, TEST_MAX_ADAPTERS, multiple, multiple / single, sysconf(_SC_NPROCESSORS_ONLN));
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
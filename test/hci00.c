@@ -0,0 +1,155 @@
+/*!
+ *	\file		hci00.c
+ *	\brief		HCI channel event filter and counters test
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+
+
+struct loop *test_loop = NULL;
+struct hci_channel *test_hci = NULL;
+unsigned int test_handler = 0;
+size_t test_calls = 0;
+
+/* Event passes filter */
+static int passes(
+    const hci_filter_t *filter,
+    const uint8_t       event) {
+    return 0 != (filter->event_mask[event >> 5] & (1U << (event & 31)));
+}
+
+/* LE Advertising Report handler, drops itself */
+static void report_handler(
+    uint8_t         event,
+    const uint8_t  *param,
+    uint8_t         length,
+    void           *user_data) {
+
+    test_calls++;
+
+    if (BT_HCI_EVT_LE_META != event || BT_HCI_EVT_LE_ADV_REPORT != param[0]) {
+        printf("Wrong event delivered!\n");
+        test_calls += 100;
+    }
+
+    hci_channel_unregister(test_hci, test_handler);
+}
+
+/* Events had time to arrive */
+static void stop_callback(
+    int         id,
+    void       *user_data) {
+    loop_quit_in(test_loop);
+}
+
+/* Main course */
+int
+main() {
+
+    /* Advertising report, unrelated LE subevent, unrelated event, NOP credits */
+    const uint8_t events[][7] = {
+        { BT_HCI_EVENT_PKT, BT_HCI_EVT_LE_META, 2, BT_HCI_EVT_LE_ADV_REPORT, 0 },
+        { BT_HCI_EVENT_PKT, BT_HCI_EVT_LE_META, 2, 0x0a, 0 },
+        { BT_HCI_EVENT_PKT, 0x05, 4, 0, 0, 0, 0 },
+        { BT_HCI_EVENT_PKT, BT_HCI_EVT_CMD_COMPLETE, 3, 1, 0, 0 }
+    };
+    const size_t sizes[] = { 5, 5, 7, 6 };
+    struct timespec timeout = { .tv_sec = 0, .tv_nsec = 50000000 };
+    hci_channel_stats_t stats;
+    hci_filter_t filter;
+    int sv[2];
+    size_t i;
+
+    printf("Checking HCI event filter ...\n");
+    printf("-------------------------------------\n");
+
+    if (0 > socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sv)) {
+        printf("Socket pair error: %s.\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    test_loop = loop_new();
+    test_hci = hci_channel_new_in(test_loop, sv[0]);
+    if (NULL == test_loop || NULL == test_hci) {
+        printf("Channel creation failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Not an HCI socket */
+    printf("Kernel filter on socket pair: %d\n", hci_channel_set_filter(test_hci, 1));
+
+    hci_channel_get_filter(test_hci, &filter);
+    if (!passes(&filter, BT_HCI_EVT_CMD_COMPLETE) || !passes(&filter, BT_HCI_EVT_CMD_STATUS)
+        || passes(&filter, BT_HCI_EVT_LE_META) || (1U << BT_HCI_EVENT_PKT) != filter.type_mask) {
+        printf("Wrong initial filter!\n");
+        return EXIT_FAILURE;
+    }
+
+    test_handler = hci_channel_register_le(test_hci, BT_HCI_EVT_LE_ADV_REPORT, report_handler, NULL, NULL);
+    if (0 == test_handler) {
+        printf("Handler registration failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    hci_channel_get_filter(test_hci, &filter);
+    if (!passes(&filter, BT_HCI_EVT_LE_META)) {
+        printf("LE Meta not passed!\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; 4 > i; ++i) {
+        if ((ssize_t) sizes[i] != write(sv[1], events[i], sizes[i])) {
+            printf("Write error: %s.\n", strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    create_timer_in(test_loop, &timeout, stop_callback, NULL, NULL);
+    loop_run_in(test_loop);
+
+    hci_channel_get_stats(test_hci, &stats);
+    printf("%lu wakeups, %lu delivered, %lu consumed, %lu handler calls\n",
+        stats.wakeups, stats.delivered, stats.consumed, test_calls);
+
+    if (4 != stats.delivered || 2 != stats.consumed || 1 != test_calls) {
+        printf("Wrong counters!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Handler dropped itself */
+    hci_channel_get_filter(test_hci, &filter);
+    if (passes(&filter, BT_HCI_EVT_LE_META)) {
+        printf("Filter not recomputed!\n");
+        return EXIT_FAILURE;
+    }
+
+    hci_channel_free(test_hci);
+    loop_free(test_loop);
+
+    close(sv[0]);
+    close(sv[1]);
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
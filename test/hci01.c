@@ -0,0 +1,244 @@
+/*!
+ *	\file		hci01.c
+ *	\brief		HCI command deadlines and pipelined start up
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/advertiser.h"
+#include "beaconizer/emulator.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+
+
+#define TEST_SLOW_LATENCY   100000      /* us */
+#define TEST_DEADLINE       30          /* ms */
+#define TEST_LOST           3
+#define TEST_LATENCY        50000       /* us */
+#define TEST_CREDITS        4
+
+struct loop *test_loop = NULL;
+struct hci_channel *test_hci = NULL;
+size_t test_completed = 0;
+int test_status[TEST_LOST + 1];
+uint64_t test_time[TEST_LOST + 1];
+uint64_t test_start = 0;
+uint64_t test_done = 0;
+int test_result = EXIT_FAILURE;
+
+/* Monotonic time in milliseconds */
+static uint64_t now_ms(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+}
+
+/* Record completion */
+static void complete_callback(
+    uint16_t        opcode,
+    int             status,
+    const uint8_t  *param,
+    uint8_t         length,
+    void           *user_data) {
+
+    if (TEST_LOST + 1 > test_completed) {
+        test_status[test_completed] = status;
+        test_time[test_completed] = now_ms() - test_start;
+    }
+
+    if (TEST_LOST + 1 == ++test_completed) {
+        loop_quit_in(test_loop);
+    }
+}
+
+/* Late replies are in, channel must still work */
+static void resend_callback(
+    int         id,
+    void       *user_data) {
+
+    hci_channel_set_timeout(test_hci, 0);
+    hci_channel_send(test_hci, BT_HCI_CMD_NOP, NULL, 0, complete_callback, NULL, NULL);
+}
+
+/* Test hangs */
+static void timeout_callback(
+    int         id,
+    void       *user_data) {
+    printf("Timeout!\n");
+    loop_quit_in(test_loop);
+}
+
+/* Slow controller: commands fail on deadline one after another */
+static int check_deadline(void) {
+
+    struct timespec timeout = { .tv_sec = 5, .tv_nsec = 0 };
+    struct timespec resend = { .tv_sec = 0, .tv_nsec = 500000000L };
+    emulator_config_t config;
+    hci_channel_stats_t stats;
+    struct emulator *emulator;
+
+    emulator_config_init(&config);
+    config.credits = TEST_CREDITS;
+    config.latency = TEST_SLOW_LATENCY;
+
+    test_loop = loop_new();
+    emulator = emulator_new_in(test_loop, &config);
+    test_hci = (NULL != emulator) ? hci_channel_new_in(test_loop, emulator_get_descriptor(emulator)) : NULL;
+    if (NULL == test_loop || NULL == emulator || NULL == test_hci) {
+        printf("Channel set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (EXIT_SUCCESS != hci_channel_set_timeout(test_hci, TEST_DEADLINE)) {
+        printf("Deadline set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    test_start = now_ms();
+    for (size_t i = 0; TEST_LOST > i; ++i) {
+        hci_channel_send(test_hci, BT_HCI_CMD_READ_LOCAL_VERSION, NULL, 0, complete_callback, NULL, NULL);
+    }
+
+    create_timer_in(test_loop, &resend, resend_callback, NULL, NULL);
+    create_timer_in(test_loop, &timeout, timeout_callback, NULL, NULL);
+    loop_run_in(test_loop);
+
+    hci_channel_get_stats(test_hci, &stats);
+
+    for (size_t i = 0; test_completed > i && TEST_LOST + 1 > i; ++i) {
+        printf("Command %lu: status %d after %llu ms\n", i, test_status[i], (unsigned long long) test_time[i]);
+    }
+
+    if (TEST_LOST + 1 != test_completed || TEST_LOST != stats.timeouts || 0 != hci_channel_pending(test_hci)) {
+        printf("Unexpected completions!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Each command gets its own deadline once sent */
+    for (size_t i = 0; TEST_LOST > i; ++i) {
+        if (-ETIMEDOUT != test_status[i] || TEST_DEADLINE * (i + 1) > test_time[i]
+            || TEST_DEADLINE * (i + 1) + TEST_DEADLINE / 2 < test_time[i]) {
+            printf("Command %lu missed deadline!\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (BT_HCI_SUCCESS != test_status[TEST_LOST]) {
+        printf("Channel did not recover!\n");
+        return EXIT_FAILURE;
+    }
+
+    hci_channel_free(test_hci);
+    emulator_free(emulator);
+    loop_free(test_loop);
+
+    printf("Deadlines OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Advertising started */
+static void started(
+    struct advertiser  *adv,
+    int                 status,
+    void               *user_data) {
+
+    test_done = now_ms();
+    test_result = (BT_HCI_SUCCESS == status) ? EXIT_SUCCESS : EXIT_FAILURE;
+    loop_quit_in(test_loop);
+}
+
+/* Advertiser set up goes out in credit limited batches */
+static int check_pipeline(void) {
+
+    const uint8_t data[3] = { 0x02, 0x01, 0x06 };
+    struct timespec timeout = { .tv_sec = 5, .tv_nsec = 0 };
+    emulator_config_t config;
+    emulator_stats_t stats;
+    struct emulator *emulator;
+    struct advertiser *adv;
+    uint64_t elapsed;
+
+    emulator_config_init(&config);
+    config.credits = TEST_CREDITS;
+    config.latency = TEST_LATENCY;
+
+    test_loop = loop_new();
+    emulator = emulator_new_in(test_loop, &config);
+    test_hci = (NULL != emulator) ? hci_channel_new_in(test_loop, emulator_get_descriptor(emulator)) : NULL;
+    adv = advertiser_new(test_hci);
+    if (NULL == test_loop || NULL == emulator || NULL == test_hci || NULL == adv) {
+        printf("Advertiser set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    hci_channel_set_timeout(test_hci, 1000);
+    advertiser_set_data(adv, data, sizeof(data));
+
+    create_timer_in(test_loop, &timeout, timeout_callback, NULL, NULL);
+
+    /* Parameters, data and enable: first one learns credits, rest go together */
+    test_result = EXIT_FAILURE;
+    test_start = now_ms();
+    advertiser_start(adv, started, NULL);
+    loop_run_in(test_loop);
+    elapsed = test_done - test_start;
+
+    emulator_get_stats(emulator, &stats);
+    printf("Advertising started in %llu ms, %llu commands, %llu overruns\n",
+        (unsigned long long) elapsed, (unsigned long long) stats.commands, (unsigned long long) stats.overruns);
+
+    if (EXIT_SUCCESS != test_result || !emulator_is_advertising(emulator)
+        || 3 != stats.commands || 0 != stats.overruns) {
+        printf("Advertising failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Two round trips instead of three */
+    if (TEST_LATENCY / 1000 * 3 <= elapsed) {
+        printf("Commands were not pipelined!\n");
+        return EXIT_FAILURE;
+    }
+
+    advertiser_free(adv);
+    hci_channel_free(test_hci);
+    emulator_free(emulator);
+    loop_free(test_loop);
+
+    printf("Pipeline OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    printf("Checking HCI command deadlines ...\n");
+    printf("-------------------------------------\n");
+
+    if (EXIT_SUCCESS != check_deadline() || EXIT_SUCCESS != check_pipeline()) {
+        return EXIT_FAILURE;
+    }
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -11,11 +11,13 @@
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <unistd.h>
 
 #include <bluetooth/bluetooth.h>
 #include <bluetooth/hci.h>
 #include <bluetooth/hci_lib.h>
 
+#include "beaconizer/emulator.h"
 #include "beaconizer/io.h"
 #include "beaconizer/loop.h"
 
@@ -26,28 +28,41 @@ int descriptor = -1;
 int
 main() {
 
+    struct emulator *emulator = NULL;
+    emulator_config_t config;
     struct io *data = NULL;
 
     printf("Checking I/O channel ...\n");
     printf("-------------------------------------\n");
 
+    loop_init();
+
     hci_device_id = hci_devid("hci0");
     if (0 > hci_device_id) {
-        printf("No HCI device found. Exiting ...\n");
-        return EXIT_FAILURE;
-    }
 
-    printf("HCI %d detected!\n", hci_device_id),
+        /* No adapter, emulated controller stands in */
+        emulator_config_init(&config);
+        emulator = emulator_new(&config);
+        if (NULL == emulator) {
+            printf("No HCI device found. Exiting ...\n");
+            return EXIT_FAILURE;
+        }
 
-    descriptor = hci_open_dev(hci_device_id);
-    if (0 > descriptor) {
-        printf("HCI %d open failed: %s, %d\n", hci_device_id, strerror(errno), errno);
-        return EXIT_FAILURE;
-    }
+        descriptor = dup(emulator_get_descriptor(emulator));
+        printf("No HCI device found, using emulated controller!\n");
+    } else {
 
-    printf("HCI %d opened!\n", hci_device_id),
+        printf("HCI %d detected!\n", hci_device_id),
+
+        descriptor = hci_open_dev(hci_device_id);
+        if (0 > descriptor) {
+            printf("HCI %d open failed: %s, %d\n", hci_device_id, strerror(errno), errno);
+            return EXIT_FAILURE;
+        }
+
+        printf("HCI %d opened!\n", hci_device_id);
+    }
 
-    loop_init();
     data = io_new(descriptor);
 
     if (NULL != data) {
@@ -69,6 +84,7 @@ main() {
     }
     loop_quit();
     hci_close_dev(descriptor);
+    emulator_free(emulator);
 
     printf("HCI %d closed!\n", hci_device_id),
 
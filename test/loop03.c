@@ -25,6 +25,7 @@
 #include <bluetooth/hci.h>
 #include <bluetooth/hci_lib.h>
 
+#include "beaconizer/emulator.h"
 #include "beaconizer/io.h"
 #include "beaconizer/loop.h"
 #include "beaconizer/watchdog.h"
@@ -181,31 +182,43 @@ int
 main() {
 
     int e, i;
+    struct emulator *emulator = NULL;
+    emulator_config_t config;
     struct io *data = NULL;
     sighandler_t sp = NULL;
 
     printf("Checking I/O channel ...\n");
     printf("-------------------------------------\n");
 
+    printf("Creating loop ... ");
+    loop_init();
+    printf("OK!\n");
+
     printf("Detecting %s ... ", hci_dev_name),
     hci_device_id = hci_devid(hci_dev_name);
     if (0 > hci_device_id) {
-        printf("No HCI device found. Exiting ...\n");
-        return EXIT_FAILURE;
-    }
-    printf("OK!\n");
 
-    printf("Opening HCI %d ... ", hci_device_id),
-    descriptor = hci_open_dev(hci_device_id);
-    if (0 > descriptor) {
-        printf("HCI %d open failed: %s, %d\n", hci_device_id, strerror(errno), errno);
-        return EXIT_FAILURE;
-    }
-    printf("OK!\n");
+        /* No adapter, emulated controller stands in */
+        emulator_config_init(&config);
+        emulator = emulator_new(&config);
+        if (NULL == emulator) {
+            printf("No HCI device found. Exiting ...\n");
+            return EXIT_FAILURE;
+        }
 
-    printf("Creating loop ... ");
-    loop_init();
-    printf("OK!\n");
+        descriptor = dup(emulator_get_descriptor(emulator));
+        printf("No HCI device found, using emulated controller!\n");
+    } else {
+        printf("OK!\n");
+
+        printf("Opening HCI %d ... ", hci_device_id),
+        descriptor = hci_open_dev(hci_device_id);
+        if (0 > descriptor) {
+            printf("HCI %d open failed: %s, %d\n", hci_device_id, strerror(errno), errno);
+            return EXIT_FAILURE;
+        }
+        printf("OK!\n");
+    }
 
     printf("Add SIGINT signal handler ...");
     errno = EXIT_SUCCESS;
@@ -261,6 +274,7 @@ main() {
 
     printf("Closing HCI %d ... ", hci_device_id);
     hci_close_dev(descriptor);
+    emulator_free(emulator);
     printf("OK!\n");
 
     printf("-------------------------------------\n");
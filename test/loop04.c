@@ -0,0 +1,158 @@
+/*!
+ *	\file		loop04.c
+ *	\brief		Loop event batch test
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <sys/types.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+
+#include "beaconizer/loop.h"
+
+
+#define TEST_FD_COUNT   600
+
+typedef enum {
+    FD_IDLE = 0,
+    FD_ADDED,
+    FD_HANDLED,
+    FD_REMOVED
+} fd_state_t;
+
+int test_fd[TEST_FD_COUNT];
+fd_state_t test_state[TEST_FD_COUNT];
+size_t test_handled = 0;
+size_t test_removed = 0;
+size_t test_errors = 0;
+
+static void sample_callback(
+    int         sd,
+    uint32_t    event_mask,
+    void        *user_data);
+
+/* Register descriptors in range */
+static int add_range(
+    const size_t    from,
+    const size_t    to) {
+
+    size_t i;
+
+    for (i = from; to > i; ++i) {
+        if (0 != loop_add_sd(test_fd[i], EPOLLIN, &sample_callback, &test_state[i], NULL)) {
+            printf("Adding descriptor %d failed!\n", test_fd[i]);
+            return EXIT_FAILURE;
+        }
+        test_state[i] = FD_ADDED;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Sample callback */
+static void sample_callback(
+    int         sd,
+    uint32_t    event_mask,
+    void        *user_data) {
+
+    fd_state_t *state = user_data;
+    uint64_t value;
+    size_t i;
+
+    /* Add the second half while running */
+    if (0 == test_handled) {
+        if (EXIT_SUCCESS != add_range(TEST_FD_COUNT / 2, TEST_FD_COUNT)) {
+            test_errors++;
+        }
+    }
+
+    if (FD_ADDED != *state) {
+        printf("Descriptor %d dispatched in state %d!\n", sd, *state);
+        test_errors++;
+    }
+
+    if (sizeof(value) != read(sd, &value, sizeof(value))) {
+        test_errors++;
+    }
+
+    *state = FD_HANDLED;
+    test_handled++;
+
+    /* Remove some descriptor which is probably pending in this batch */
+    if (0 == test_handled % 3) {
+        for (i = TEST_FD_COUNT; 0 < i--;) {
+            if (FD_ADDED == test_state[i]) {
+                loop_remove_sd(test_fd[i]);
+                test_state[i] = FD_REMOVED;
+                test_removed++;
+                break;
+            }
+        }
+    }
+
+    loop_remove_sd(sd);
+
+    /* Everything seen */
+    if (TEST_FD_COUNT == test_handled + test_removed) {
+        loop_exit_success();
+    }
+}
+
+/* Main course */
+int
+main() {
+
+    size_t i;
+
+    printf("Checking loop event batch ...\n");
+    printf("-------------------------------------\n");
+
+    for (i = 0; TEST_FD_COUNT > i; ++i) {
+        test_fd[i] = eventfd(1, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (0 > test_fd[i]) {
+            printf("Descriptor creation error: %s.\n", strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("Creating loop ... ");
+    loop_init();
+    printf("OK!\n");
+
+    printf("Adding %d file descriptors ... ", TEST_FD_COUNT / 2);
+    if (EXIT_SUCCESS != add_range(0, TEST_FD_COUNT / 2)) {
+        return EXIT_FAILURE;
+    }
+    printf("OK!\n");
+
+    printf("Start loop!\n");
+    loop_run();
+    printf("Stop loop!\n");
+
+    for (i = 0; TEST_FD_COUNT > i; ++i) {
+        close(test_fd[i]);
+    }
+
+    printf("Handled: %lu, removed: %lu, errors: %lu\n", test_handled, test_removed, test_errors);
+
+    if (0 != test_errors || TEST_FD_COUNT != test_handled + test_removed) {
+        return EXIT_FAILURE;
+    }
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
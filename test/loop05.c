@@ -0,0 +1,159 @@
+/*!
+ *	\file		loop05.c
+ *	\brief		One loop per thread test
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <sys/types.h>
+#include <sys/eventfd.h>
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/io.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+
+
+#define TEST_THREAD_COUNT   4
+#define TEST_TICK_COUNT     10
+
+typedef struct {
+    pthread_t       thread;
+    struct loop    *loop;
+    int             fd;
+    int             timer;
+    size_t          ticks;
+    size_t          reads;
+} worker_t;
+
+worker_t workers[TEST_THREAD_COUNT];
+
+/* Timer callback: poke own descriptor and re-arm */
+static void tick(
+    int         id,
+    void       *user_data) {
+
+    worker_t *w = user_data;
+    struct timespec timeout = { .tv_sec = 0, .tv_nsec = 1000000 };
+    uint64_t value = 1;
+
+    w->ticks++;
+
+    if (sizeof(value) != write(w->fd, &value, sizeof(value))) {
+        return;
+    }
+
+    if (TEST_TICK_COUNT > w->ticks) {
+        modify_timer_in(w->loop, id, &timeout);
+    }
+}
+
+/* Descriptor callback */
+static int readable(
+    struct io  *io,
+    void       *user_data) {
+
+    worker_t *w = user_data;
+    uint64_t value;
+
+    if (sizeof(value) != read(io_get_descriptor(io), &value, sizeof(value))) {
+        return 1;
+    }
+
+    w->reads += value;
+
+    if (TEST_TICK_COUNT <= w->reads) {
+        loop_quit_in(w->loop);
+    }
+
+    return 1;
+}
+
+/* Worker thread */
+static void *worker(
+    void       *data) {
+
+    worker_t *w = data;
+    struct timespec timeout = { .tv_sec = 0, .tv_nsec = 1000000 };
+    struct io *io = NULL;
+
+    io = io_new_in(w->loop, w->fd);
+    if (NULL == io) {
+        return NULL;
+    }
+    io_set_read_handler(io, readable, w, NULL);
+
+    w->timer = create_timer_in(w->loop, &timeout, tick, w, NULL);
+    if (0 > w->timer) {
+        return NULL;
+    }
+
+    loop_run_in(w->loop);
+
+    io_destroy(io);
+
+    return NULL;
+}
+
+/* Main course */
+int
+main() {
+
+    size_t i;
+    int result = EXIT_SUCCESS;
+
+    printf("Checking one loop per thread ...\n");
+    printf("-------------------------------------\n");
+
+    for (i = 0; TEST_THREAD_COUNT > i; ++i) {
+
+        memset(&workers[i], 0, sizeof(worker_t));
+
+        workers[i].loop = loop_new();
+        if (NULL == workers[i].loop) {
+            printf("Loop %lu creation failed!\n", i);
+            return EXIT_FAILURE;
+        }
+
+        workers[i].fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (0 > workers[i].fd) {
+            printf("Descriptor creation error: %s.\n", strerror(errno));
+            return EXIT_FAILURE;
+        }
+
+        if (0 != pthread_create(&workers[i].thread, NULL, worker, &workers[i])) {
+            printf("Thread %lu creation failed!\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (i = 0; TEST_THREAD_COUNT > i; ++i) {
+
+        pthread_join(workers[i].thread, NULL);
+
+        printf("Loop %lu: %lu ticks, %lu reads\n", i, workers[i].ticks, workers[i].reads);
+        if (TEST_TICK_COUNT != workers[i].ticks || TEST_TICK_COUNT != workers[i].reads) {
+            result = EXIT_FAILURE;
+        }
+
+        loop_free(workers[i].loop);
+        close(workers[i].fd);
+    }
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return result;
+}
+
+ /* End of file */
@@ -0,0 +1,203 @@
+/*!
+ *	\file		loop06.c
+ *	\brief		Cross-thread task posting benchmark
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/loop.h"
+
+
+#define TEST_POST_COUNT     1000000
+
+const size_t test_producer_count[] = { 1, 4, 16 };
+
+typedef struct {
+    pthread_t       thread;
+    struct loop    *loop;
+    size_t          count;
+    size_t          id;
+    size_t          errors;
+} producer_t;
+
+struct loop *test_loop = NULL;
+size_t test_total = 0;
+size_t test_done = 0;
+size_t test_sum = 0;
+
+/* Monotonic time in seconds */
+static double now(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+/* Task run in loop thread */
+static void task(
+    void       *user_data) {
+
+    test_sum += (uintptr_t) user_data;
+
+    if (test_total == ++test_done) {
+        loop_quit_in(test_loop);
+    }
+}
+
+/* Destructor of task never run */
+static void task_dropped(
+    void       *user_data) {
+    (*(size_t *) user_data)++;
+}
+
+/* Producer thread */
+static void *producer(
+    void       *data) {
+
+    producer_t *p = data;
+    size_t i;
+
+    for (i = 0; p->count > i; ++i) {
+        if (0 != loop_post_in(p->loop, task, (void *) (uintptr_t) (p->id + 1), NULL)) {
+            p->errors++;
+        }
+    }
+
+    return NULL;
+}
+
+/* Run benchmark with count producers */
+static int benchmark(
+    const size_t count) {
+
+    producer_t *producers;
+    size_t i, expected = 0;
+    double start, elapsed;
+
+    producers = calloc(count, sizeof(producer_t));
+    if (NULL == producers) {
+        printf("Memory allocation error!");
+        return EXIT_FAILURE;
+    }
+
+    test_loop = loop_new();
+    if (NULL == test_loop) {
+        printf("Loop creation failed!\n");
+        free(producers);
+        return EXIT_FAILURE;
+    }
+
+    test_total = TEST_POST_COUNT - TEST_POST_COUNT % count;
+    test_done = 0;
+    test_sum = 0;
+
+    start = now();
+    for (i = 0; count > i; ++i) {
+        producers[i].loop = test_loop;
+        producers[i].count = test_total / count;
+        producers[i].id = i;
+        expected += producers[i].count * (i + 1);
+
+        if (0 != pthread_create(&producers[i].thread, NULL, producer, &producers[i])) {
+            printf("Thread %lu creation failed!\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    loop_run_in(test_loop);
+    elapsed = now() - start;
+
+    for (i = 0; count > i; ++i) {
+        pthread_join(producers[i].thread, NULL);
+        if (0 != producers[i].errors) {
+            printf("Producer %lu failed to post %lu tasks!\n", i, producers[i].errors);
+            test_done = 0;
+        }
+    }
+
+    loop_free(test_loop);
+    free(producers);
+
+    printf("%2lu producers: %10.0f posts/sec (%lu tasks)\n",
+        count,
+        (double) test_total / elapsed,
+        test_done);
+
+    if (test_total != test_done || expected != test_sum) {
+        printf("Lost tasks: %lu of %lu done, checksum %lu of %lu!\n", test_done, test_total, test_sum, expected);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Tasks left when loop is freed are destroyed */
+static int check_dropped(void) {
+
+    struct loop *loop = loop_new();
+    size_t dropped = 0;
+    size_t i;
+
+    if (NULL == loop) {
+        printf("Loop creation failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; 10 > i; ++i) {
+        if (0 != loop_post_in(loop, task, &dropped, task_dropped)) {
+            printf("Post failed!\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    loop_free(loop);
+
+    if (10 != dropped) {
+        printf("%lu of 10 dropped tasks destroyed!\n", dropped);
+        return EXIT_FAILURE;
+    }
+
+    printf("Dropped tasks destroyed\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    size_t i;
+
+    printf("Benchmarking cross-thread task posting ...\n");
+    printf("-------------------------------------\n");
+
+    if (EXIT_SUCCESS != check_dropped()) {
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; sizeof(test_producer_count) / sizeof(test_producer_count[0]) > i; ++i) {
+        if (EXIT_SUCCESS != benchmark(test_producer_count[i])) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -0,0 +1,227 @@
+/*!
+ *	\file		loop07.c
+ *	\brief		Allocation-free steady state test
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <sys/types.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/io.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+#include "beaconizer/watchdog.h"
+
+
+#define TEST_FD_COUNT       64
+#define TEST_CYCLE_COUNT    100
+
+/* glibc allocator entry points */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+int test_counting = 0;
+size_t test_allocations = 0;
+
+/* Interpose heap allocations to count them */
+void *malloc(
+    size_t      size) {
+
+    if (test_counting) {
+        test_allocations++;
+    }
+
+    return __libc_malloc(size);
+}
+
+void *calloc(
+    size_t      count,
+    size_t      size) {
+
+    if (test_counting) {
+        test_allocations++;
+    }
+
+    return __libc_calloc(count, size);
+}
+
+void *realloc(
+    void       *ptr,
+    size_t      size) {
+
+    if (test_counting) {
+        test_allocations++;
+    }
+
+    return __libc_realloc(ptr, size);
+}
+
+int test_fd[TEST_FD_COUNT];
+
+/* Never called */
+static void sample_callback(
+    int         sd,
+    uint32_t    event_mask,
+    void       *user_data) {
+}
+
+static void sample_timer(
+    int         id,
+    void       *user_data) {
+}
+
+static int sample_watchdog(
+    void       *user_data) {
+    return 1;
+}
+
+/* Create and destroy every kind of loop object */
+static int cycle(void) {
+
+    struct timespec timeout = { .tv_sec = 3600, .tv_nsec = 0 };
+    struct io *io[TEST_FD_COUNT];
+    int timer[TEST_FD_COUNT];
+    int precise[TEST_FD_COUNT];
+    unsigned int watchdog;
+    size_t i;
+
+    for (i = 0; TEST_FD_COUNT / 2 > i; ++i) {
+        if (0 != loop_add_sd(test_fd[i], EPOLLIN, sample_callback, NULL, NULL)) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (i = TEST_FD_COUNT / 2; TEST_FD_COUNT > i; ++i) {
+        io[i] = io_new(test_fd[i]);
+        if (NULL == io[i]) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    for (i = 0; TEST_FD_COUNT > i; ++i) {
+        timer[i] = create_timer(&timeout, sample_timer, NULL, NULL);
+        precise[i] = create_precise_timer(&timeout, sample_timer, NULL, NULL);
+        if (0 >= timer[i] || 0 >= precise[i]) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    watchdog = watchdog_add(&timeout, sample_watchdog, NULL, NULL);
+    if (0 == watchdog) {
+        return EXIT_FAILURE;
+    }
+
+    watchdog_remove(watchdog);
+
+    for (i = 0; TEST_FD_COUNT > i; ++i) {
+        destroy_timer(timer[i]);
+        destroy_timer(precise[i]);
+    }
+
+    for (i = TEST_FD_COUNT / 2; TEST_FD_COUNT > i; ++i) {
+        io_destroy(io[i]);
+    }
+
+    for (i = 0; TEST_FD_COUNT / 2 > i; ++i) {
+        loop_remove_sd(test_fd[i]);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Object outliving its loop is released into pools still there */
+static int check_late_release(void) {
+
+    struct loop *loop = loop_new();
+    struct io *io;
+
+    if (NULL == loop) {
+        return EXIT_FAILURE;
+    }
+
+    io = io_new_in(loop, test_fd[0]);
+    if (NULL == io) {
+        loop_free(loop);
+        return EXIT_FAILURE;
+    }
+
+    loop_free(loop);
+    io_destroy(io);
+
+    printf("Late release OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    size_t i;
+    int result = EXIT_SUCCESS;
+
+    printf("Checking allocation-free steady state ...\n");
+    printf("-------------------------------------\n");
+
+    for (i = 0; TEST_FD_COUNT > i; ++i) {
+        test_fd[i] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (0 > test_fd[i]) {
+            printf("Descriptor creation error: %s.\n", strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    loop_init();
+
+    /* Warm up pools */
+    if (EXIT_SUCCESS != cycle()) {
+        printf("Warm up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    test_counting = 1;
+    for (i = 0; TEST_CYCLE_COUNT > i; ++i) {
+        if (EXIT_SUCCESS != cycle()) {
+            test_counting = 0;
+            printf("Cycle %lu failed!\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+    test_counting = 0;
+
+    printf("%d cycles: %lu heap allocations\n", TEST_CYCLE_COUNT, test_allocations);
+    if (0 != test_allocations) {
+        result = EXIT_FAILURE;
+    }
+
+    loop_quit();
+
+    if (EXIT_SUCCESS != check_late_release()) {
+        printf("Late release failed!\n");
+        result = EXIT_FAILURE;
+    }
+
+    for (i = 0; TEST_FD_COUNT > i; ++i) {
+        close(test_fd[i]);
+    }
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return result;
+}
+
+ /* End of file */
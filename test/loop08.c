@@ -0,0 +1,282 @@
+/*!
+ *	\file		loop08.c
+ *	\brief		Loop descriptor table benchmark
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <sys/types.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/loop.h"
+
+
+typedef struct {
+    size_t  count;
+    int*    fd;
+} test_file_t;
+
+
+const size_t test_file_count[] = { 10, 1000, 10000 };
+const size_t test_op_count = 200000;
+test_file_t test = {
+    .count  = 0,
+    .fd     = NULL
+};
+
+/* Monotonic time in seconds */
+static double now(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+/* Raise descriptor limit, return how many descriptors we may open */
+static size_t raise_descriptor_limit(
+    const size_t count) {
+
+    struct rlimit rl;
+
+    if (0 != getrlimit(RLIMIT_NOFILE, &rl)) {
+        return 0;
+    }
+
+    if (rl.rlim_cur < count + 64) {
+        rl.rlim_cur = (rl.rlim_max < count + 64) ? rl.rlim_max : count + 64;
+        setrlimit(RLIMIT_NOFILE, &rl);
+        getrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    return (rl.rlim_cur < count + 64) ? rl.rlim_cur - 64 : count;
+}
+
+/* Allocate and open X event descriptors */
+int create_test_descriptors(
+    const size_t count) {
+
+    test.fd = malloc(count * sizeof(int));
+    if (NULL == test.fd) {
+        printf("Memory allocation error!");
+        return EXIT_FAILURE;
+    }
+
+    for (test.count = 0; count > test.count; ++test.count) {
+        test.fd[test.count] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (0 > test.fd[test.count]) {
+            printf("Descriptor %lu creation error: %s.\n", test.count, strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Close X descriptors */
+void close_test_descriptors() {
+
+    size_t i;
+
+    if (NULL != test.fd) {
+        for (i = 0; test.count > i; i++) {
+            close(test.fd[i]);
+        }
+        free(test.fd);
+        test.fd = NULL;
+    }
+
+    test.count = 0;
+}
+
+/* Sample callback */
+static void sample_callback(
+    int         sd,
+    uint32_t    event_mask,
+    void        *user_data) {
+}
+
+/* Measure registration of count descriptors one by one and in bulk */
+static int benchmark_startup(
+    const size_t count) {
+
+    size_t i;
+    double start, single_time, bulk_time;
+    loop_sd_t *sds = NULL;
+
+    if (EXIT_SUCCESS != create_test_descriptors(count)) {
+        close_test_descriptors();
+        return EXIT_FAILURE;
+    }
+
+    /* One by one */
+    loop_init();
+    start = now();
+    for (i = 0; test.count > i; ++i) {
+        if (0 != loop_add_sd(test.fd[i], EPOLLIN, &sample_callback, NULL, NULL)) {
+            printf("Adding descriptor %d failed!\n", test.fd[i]);
+            loop_quit();
+            close_test_descriptors();
+            return EXIT_FAILURE;
+        }
+    }
+    single_time = now() - start;
+    loop_quit();
+
+    /* In bulk */
+    sds = calloc(test.count, sizeof(loop_sd_t));
+    if (NULL == sds) {
+        printf("Memory allocation error!");
+        close_test_descriptors();
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; test.count > i; ++i) {
+        sds[i].sd           = test.fd[i];
+        sds[i].event_mask   = EPOLLIN;
+        sds[i].callback     = &sample_callback;
+    }
+
+    loop_init();
+    start = now();
+    if (0 != loop_add_many(sds, test.count)) {
+        printf("Adding %lu descriptors failed!\n", test.count);
+        loop_quit();
+        free(sds);
+        close_test_descriptors();
+        return EXIT_FAILURE;
+    }
+    bulk_time = now() - start;
+    loop_quit();
+
+    printf("%6lu descriptors: loop_add_sd() %8.3f ms, loop_add_many() %8.3f ms\n",
+        test.count,
+        single_time * 1e3,
+        bulk_time * 1e3);
+
+    free(sds);
+    close_test_descriptors();
+
+    return EXIT_SUCCESS;
+}
+
+/* Run benchmark over count descriptors */
+static int benchmark(
+    const size_t count) {
+
+    size_t i;
+    double start, modify_time, remove_time;
+    unsigned int seed = 1;
+
+    if (EXIT_SUCCESS != create_test_descriptors(count)) {
+        close_test_descriptors();
+        return EXIT_FAILURE;
+    }
+
+    loop_init();
+
+    for (i = 0; test.count > i; ++i) {
+        if (0 != loop_add_sd(test.fd[i], 0, &sample_callback, NULL, NULL)) {
+            printf("Adding descriptor %d failed!\n", test.fd[i]);
+            loop_quit();
+            close_test_descriptors();
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* Re-arm random descriptors */
+    start = now();
+    for (i = 0; test_op_count > i; ++i) {
+        int sd = test.fd[rand_r(&seed) % test.count];
+        if (0 != loop_modify_sd(sd, (i & 1) ? EPOLLIN : EPOLLOUT)) {
+            printf("Modifying descriptor %d failed!\n", sd);
+            loop_quit();
+            close_test_descriptors();
+            return EXIT_FAILURE;
+        }
+    }
+    modify_time = now() - start;
+
+    /* Remove and add back random descriptors */
+    start = now();
+    for (i = 0; test_op_count > i; i += 2) {
+        int sd = test.fd[rand_r(&seed) % test.count];
+        if (0 != loop_remove_sd(sd) ||
+            0 != loop_add_sd(sd, EPOLLIN, &sample_callback, NULL, NULL)) {
+            printf("Removing descriptor %d failed!\n", sd);
+            loop_quit();
+            close_test_descriptors();
+            return EXIT_FAILURE;
+        }
+    }
+    remove_time = now() - start;
+
+    /* Everything must be still there */
+    for (i = 0; test.count > i; ++i) {
+        if (0 != loop_modify_sd(test.fd[i], EPOLLIN)) {
+            printf("Descriptor %d lost!\n", test.fd[i]);
+            loop_quit();
+            close_test_descriptors();
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("%6lu descriptors: modify %10.0f ops/sec, remove/add %10.0f ops/sec\n",
+        test.count,
+        (double) test_op_count / modify_time,
+        (double) test_op_count / remove_time);
+
+    loop_quit();
+    close_test_descriptors();
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    size_t i, count;
+
+    printf("Benchmarking loop descriptor table ...\n");
+    printf("-------------------------------------\n");
+
+    for (i = 0; sizeof(test_file_count) / sizeof(test_file_count[0]) > i; ++i) {
+
+        count = raise_descriptor_limit(test_file_count[i]);
+        if (count < test_file_count[i]) {
+            printf("Descriptor limit allows %lu of %lu descriptors only!\n", count, test_file_count[i]);
+        }
+
+        if (EXIT_SUCCESS != benchmark(count)) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    printf("-------------------------------------\n");
+
+    count = raise_descriptor_limit(test_file_count[i - 1]);
+    if (EXIT_SUCCESS != benchmark_startup(count)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
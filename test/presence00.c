@@ -0,0 +1,290 @@
+/*!
+ *	\file		presence00.c
+ *	\brief		Presence engine test and benchmark
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/presence.h"
+#include "beaconizer/timer.h"
+
+
+#define TEST_BEACONS        100000
+#define TEST_SIGHTINGS      10000000
+#define TEST_EVENTS         16
+
+const uint8_t test_uuid[16] = {
+    0xe2, 0xc5, 0x6d, 0xb5, 0xdf, 0xfb, 0x48, 0xd2,
+    0xb0, 0x60, 0xd0, 0xf5, 0xa7, 0x10, 0x96, 0xe0
+};
+
+static tracker_key_t keys[TEST_BEACONS];
+struct loop *test_loop = NULL;
+struct presence *test_presence = NULL;
+uint64_t test_start = 0;
+
+/* Recorded events */
+int test_event[TEST_EVENTS];
+uint64_t test_duration[TEST_EVENTS];
+uint64_t test_when[TEST_EVENTS];
+size_t test_count = 0;
+
+/* Monotonic time in milliseconds */
+static uint64_t now_ms(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+}
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Record event */
+static void event_callback(
+    const int               event,
+    const tracker_key_t    *key,
+    const uint64_t          duration,
+    void                   *user_data) {
+
+    if (TEST_EVENTS > test_count) {
+        test_event[test_count] = event;
+        test_duration[test_count] = duration;
+        test_when[test_count] = now_ms();
+        test_count++;
+    }
+}
+
+/* Count events only */
+static void count_callback(
+    const int               event,
+    const tracker_key_t    *key,
+    const uint64_t          duration,
+    void                   *user_data) {
+    (*(size_t *) user_data)++;
+}
+
+/* Thresholds, dwell and lost deadline */
+static int check_events(void) {
+
+    const int8_t rssi[] = { -75, -65, -75, -70, -60, -85 };
+    const uint64_t at[] = { 0, 10, 300, 600, 700, 900 };
+    const int present[] = { 0, 1, 1, 1, 1, 1 };
+    presence_config_t config;
+    presence_stats_t stats;
+    struct presence *presence;
+
+    presence_config_init(&config);
+    config.enter_rssi = -70;
+    config.exit_rssi = -80;
+    config.lost = 1000;
+    config.dwell = 500;
+
+    presence = presence_new_in(NULL, &config, event_callback, NULL);
+    if (NULL == presence) {
+        printf("Engine set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; sizeof(at) / sizeof(at[0]) > i; ++i) {
+        if (present[i] != presence_sighting(presence, &keys[0], rssi[i], at[i])) {
+            printf("Sighting %zu: expected %d!\n", i, present[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* Weak sighting at 900 ms does not extend the deadline */
+    if (0 != presence_expire(presence, 1699) || 1 != presence_expire(presence, 1700)) {
+        printf("Lost deadline missed!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Hysteresis band does not enter */
+    if (0 != presence_sighting(presence, &keys[0], -75, 1800) || 0 != presence_count(presence)) {
+        printf("Beacon entered below threshold!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (3 != test_count
+        || PRESENCE_ENTER != test_event[0] || 0 != test_duration[0]
+        || PRESENCE_DWELL != test_event[1] || 590 != test_duration[1]
+        || PRESENCE_EXIT != test_event[2] || 690 != test_duration[2]) {
+        printf("Unexpected events!\n");
+        return EXIT_FAILURE;
+    }
+
+    presence_get_stats(presence, &stats);
+    if (7 != stats.sightings || 1 != stats.entered || 1 != stats.dwelled || 1 != stats.exited) {
+        printf("Unexpected counters!\n");
+        return EXIT_FAILURE;
+    }
+
+    presence_free(presence);
+
+    /* Full table drops enters */
+    config.capacity = 2;
+    presence = presence_new_in(NULL, &config, event_callback, NULL);
+    if (NULL == presence
+        || 1 != presence_sighting(presence, &keys[0], -50, 0)
+        || 1 != presence_sighting(presence, &keys[1], -50, 0)
+        || -ENOSPC != presence_sighting(presence, &keys[2], -50, 0)
+        || 2 != presence_expire(presence, 1000)
+        || 1 != presence_sighting(presence, &keys[2], -50, 1000)) {
+        printf("Capacity not enforced!\n");
+        return EXIT_FAILURE;
+    }
+
+    presence_free(presence);
+
+    printf("Events OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Keep second beacon present */
+static void sighting_callback(
+    int                 id,
+    uint64_t            expired,
+    void               *user_data) {
+    presence_sighting(test_presence, &keys[1], -50, now_ms());
+}
+
+/* Stop loop */
+static void quit_callback(
+    int                 id,
+    void               *user_data) {
+    loop_quit_in(test_loop);
+}
+
+/* Loop timer emits exits */
+static int check_loop(void) {
+
+    struct timespec period = { .tv_sec = 0, .tv_nsec = 10000000 };
+    struct timespec timeout = { .tv_sec = 0, .tv_nsec = 200000000 };
+    presence_config_t config;
+
+    presence_config_init(&config);
+    config.lost = 50;
+
+    test_loop = loop_new();
+    if (NULL == test_loop) {
+        printf("Loop set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    test_presence = presence_new_in(test_loop, &config, event_callback, NULL);
+    if (NULL == test_presence
+        || 0 >= create_periodic_timer_in(test_loop, &period, sighting_callback, NULL, NULL)
+        || 0 >= create_timer_in(test_loop, &timeout, quit_callback, NULL, NULL)) {
+        printf("Engine set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    test_count = 0;
+    test_start = now_ms();
+    presence_sighting(test_presence, &keys[0], -50, test_start);
+    presence_sighting(test_presence, &keys[1], -50, test_start);
+
+    loop_run_in(test_loop);
+
+    /* Only the beacon seen once is lost, and not before its deadline */
+    if (3 != test_count || PRESENCE_EXIT != test_event[2] || 1 != presence_count(test_presence)
+        || test_start + 50 > test_when[2] || test_start + 150 < test_when[2]) {
+        printf("Loop expiry failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("Exit after %llu ms\n", (unsigned long long) (test_when[2] - test_start));
+
+    presence_free(test_presence);
+    loop_free(test_loop);
+
+    printf("Loop OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    struct presence *presence;
+    presence_config_t config;
+    presence_stats_t stats;
+    uint32_t seed = 0x13579bdf;
+    uint64_t start, elapsed;
+    size_t events = 0;
+
+    printf("Checking presence engine ...\n");
+    printf("-------------------------------------\n");
+
+    for (size_t i = 0; TEST_BEACONS > i; ++i) {
+        tracker_key_ibeacon(&keys[i], test_uuid, (uint16_t) (i >> 16), (uint16_t) i);
+    }
+
+    if (EXIT_SUCCESS != check_events() || EXIT_SUCCESS != check_loop()) {
+        return EXIT_FAILURE;
+    }
+
+    presence_config_init(&config);
+    config.capacity = TEST_BEACONS;
+    config.lost = 100;
+    config.dwell = 1000;
+
+    presence = presence_new_in(NULL, &config, count_callback, &events);
+    if (NULL == presence) {
+        printf("Engine set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Every sighting re-arms a deadline, expiry runs each millisecond */
+    start = now_ns();
+    for (size_t i = 0; TEST_SIGHTINGS > i; ++i) {
+        seed = seed * 1103515245 + 12345;
+        presence_sighting(presence, &keys[seed % TEST_BEACONS], (int8_t) (-50 - (int) (seed >> 27)), i / 1000);
+        if (0 == i % 1000) {
+            presence_expire(presence, i / 1000);
+        }
+    }
+    elapsed = now_ns() - start;
+
+    presence_get_stats(presence, &stats);
+    printf("%d sightings: %.1f ns per sighting, %zu present, %llu entered, %llu exited, %zu events\n",
+        TEST_SIGHTINGS, (double) elapsed / TEST_SIGHTINGS, presence_count(presence),
+        (unsigned long long) stats.entered, (unsigned long long) stats.exited, events);
+
+    if (TEST_SIGHTINGS != stats.sightings || stats.entered != stats.exited + presence_count(presence)
+        || stats.entered + stats.dwelled + stats.exited != events) {
+        printf("Unexpected counters!\n");
+        return EXIT_FAILURE;
+    }
+
+    presence_free(presence);
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
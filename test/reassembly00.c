@@ -0,0 +1,526 @@
+/*!
+ *	\file		reassembly00.c
+ *	\brief		Extended advertising report parsing and reassembly test
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/reassembly.h"
+#include "beaconizer/scanner.h"
+#include "beaconizer/timer.h"
+
+
+#define TEST_FRAGMENT       229         /* Longest data fitting one event */
+#define TEST_PAYLOAD        558         /* Three fragments */
+#define TEST_ITERATIONS     10000000
+
+/* Fragment to put into event */
+typedef struct {
+    uint8_t         address;            /* Last address octet */
+    uint8_t         sid;
+    uint8_t         status;
+    const uint8_t  *data;
+    uint8_t         length;
+} fragment_t;
+
+struct loop *test_loop = NULL;
+uint8_t test_payload[SCANNER_MAX_EXT_DATA + TEST_FRAGMENT];
+uint8_t test_event[2 + BT_HCI_EVENT_HDR_SIZE + 255];
+size_t test_delivered = 0;
+uint16_t test_length = 0;
+uint8_t test_address = 0;
+int test_match = 0;
+const uint8_t *test_data = NULL;
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Build HCI event packet with extended reports, returns packet size */
+static size_t build_event(
+    const fragment_t   *fragment,
+    const size_t        count) {
+
+    uint8_t *p = test_event + 5;
+
+    test_event[0] = BT_HCI_EVENT_PKT;
+    test_event[1] = BT_HCI_EVT_LE_META;
+    test_event[3] = BT_HCI_EVT_LE_EXT_ADV_REPORT;
+    test_event[4] = (uint8_t) count;
+
+    for (size_t i = 0; count > i; ++i) {
+
+        memset(p, 0, 24);
+        p[0] = (uint8_t) (fragment[i].status << 5); /* Non-connectable, non-scannable */
+        p[1] = 0x00;
+        p[2] = 0x01;                                /* Random address */
+        p[3] = fragment[i].address;
+        p[8] = 0xc0;
+        p[9] = 0x01;                                /* LE 1M */
+        p[10] = 0x02;                               /* LE 2M */
+        p[11] = fragment[i].sid;
+        p[12] = (uint8_t) -4;                       /* TX power */
+        p[13] = (uint8_t) -60;                      /* RSSI */
+        p[23] = fragment[i].length;
+        memcpy(p + 24, fragment[i].data, fragment[i].length);
+
+        p += 24 + fragment[i].length;
+    }
+
+    test_event[2] = (uint8_t) (p - test_event - 3);
+
+    return (size_t) (p - test_event);
+}
+
+/* Remember last payload */
+static void payload_callback(
+    const scanner_report_t *report,
+    void                   *user_data) {
+
+    test_delivered++;
+    test_length = report->length;
+    test_address = report->address[0];
+    test_data = report->data;
+    test_match = (0 == memcmp(report->data, test_payload, report->length))
+        && report->extended && SCANNER_DATA_COMPLETE == report->status
+        && -4 == report->tx_power && -60 == report->rssi;
+}
+
+/* Feed event into reassembler */
+static void push_callback(
+    const scanner_report_t *report,
+    void                   *user_data) {
+
+    struct reassembly *reassembly = user_data;
+
+    reassembly_push(reassembly, report, 0);
+}
+
+/* Feed fragment, returns reassembly_push() result */
+static int push(
+    struct reassembly  *reassembly,
+    const uint8_t       address,
+    const uint8_t       status,
+    const size_t        offset,
+    const uint8_t       length,
+    const uint64_t      now) {
+
+    const fragment_t fragment = { address, 0x05, status, test_payload + offset, length };
+    const uint8_t address_data[6] = { address, 0, 0, 0, 0, 0xc0 };
+    scanner_report_t report;
+
+    build_event(&fragment, 1);
+
+    memset(&report, 0, sizeof(report));
+    report.extended = 1;
+    report.status = status;
+    report.sid = 0x05;
+    report.address_type = 0x01;
+    report.address = address_data;
+    report.data = test_payload + offset;
+    report.length = length;
+    report.rssi = -60;
+    report.tx_power = -4;
+
+    return reassembly_push(reassembly, &report, now);
+}
+
+/* Parser reads every field and rejects broken events */
+static int check_parser(void) {
+
+    const fragment_t fragment[2] = {
+        { 0x11, 0x03, SCANNER_DATA_COMPLETE, test_payload, 20 },
+        { 0x22, 0x04, SCANNER_DATA_MORE, test_payload, 100 }
+    };
+    struct reassembly *reassembly;
+    size_t size;
+
+    reassembly = reassembly_new(4, 1000, payload_callback, NULL);
+    if (NULL == reassembly) {
+        printf("Reassembler set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    size = build_event(fragment, 2);
+    test_delivered = 0;
+
+    if (2 != scanner_parse_ext_reports(test_event + 3, test_event[2], push_callback, reassembly)) {
+        printf("Event not parsed!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Complete one went through untouched, fragment waits */
+    if (1 != test_delivered || !test_match || 20 != test_length || 0x11 != test_address
+        || test_event + 5 + 24 != test_data || 1 != reassembly_pending(reassembly)) {
+        printf("Wrong parse!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (0 <= scanner_parse_ext_reports(test_event + 3, (uint8_t) (size - 4), NULL, NULL)
+        || 0 <= scanner_parse_reports(test_event + 3, test_event[2], NULL, NULL)) {
+        printf("Broken event accepted!\n");
+        return EXIT_FAILURE;
+    }
+
+    reassembly_free(reassembly);
+
+    printf("Parser OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Fragments from several advertisers come together */
+static int check_reassembly(void) {
+
+    struct reassembly *reassembly;
+    reassembly_stats_t stats;
+
+    reassembly = reassembly_new(2, 1000, payload_callback, NULL);
+    if (NULL == reassembly) {
+        printf("Reassembler set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    test_delivered = 0;
+
+    /* Two chains interleaved with advertiser sending in one piece */
+    if (0 != push(reassembly, 0xa1, SCANNER_DATA_MORE, 0, TEST_FRAGMENT, 0)
+        || 0 != push(reassembly, 0xa2, SCANNER_DATA_MORE, 0, TEST_FRAGMENT, 1)
+        || 1 != push(reassembly, 0xa3, SCANNER_DATA_COMPLETE, 0, 31, 2)
+        || 0 != push(reassembly, 0xa1, SCANNER_DATA_MORE, TEST_FRAGMENT, TEST_FRAGMENT, 3)
+        || 0 != push(reassembly, 0xa2, SCANNER_DATA_MORE, TEST_FRAGMENT, TEST_FRAGMENT, 4)
+        || 1 != push(reassembly, 0xa1, SCANNER_DATA_COMPLETE, TEST_FRAGMENT * 2, TEST_PAYLOAD - TEST_FRAGMENT * 2, 5)) {
+        printf("Wrong push results!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (2 != test_delivered || TEST_PAYLOAD != test_length || 0xa1 != test_address || !test_match) {
+        printf("Payload not reassembled!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Pool is full: third chain does not fit */
+    if (0 != push(reassembly, 0xa4, SCANNER_DATA_MORE, 0, TEST_FRAGMENT, 6)
+        || -ENOBUFS != push(reassembly, 0xa5, SCANNER_DATA_MORE, 0, TEST_FRAGMENT, 7)) {
+        printf("Pool overflow not detected!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Controller gave up on chain */
+    if (-ECANCELED != push(reassembly, 0xa2, SCANNER_DATA_TRUNCATED, TEST_FRAGMENT * 2, 10, 8)) {
+        printf("Truncated chain delivered!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Rest of chain never came: next fragment of same advertiser starts over */
+    if (0 != push(reassembly, 0xa4, SCANNER_DATA_MORE, 0, TEST_FRAGMENT, 1200)
+        || 1 != push(reassembly, 0xa4, SCANNER_DATA_COMPLETE, TEST_FRAGMENT, 10, 1201)
+        || TEST_FRAGMENT + 10 != test_length || !test_match) {
+        printf("Old chain was not expired!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Chain left behind */
+    if (0 != push(reassembly, 0xa7, SCANNER_DATA_MORE, 0, TEST_FRAGMENT, 1300)) {
+        printf("Chain not started!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Payload longer than extended advertising allows */
+    for (size_t offset = 0; SCANNER_MAX_EXT_DATA >= offset + TEST_FRAGMENT; offset += TEST_FRAGMENT) {
+        if (0 != push(reassembly, 0xa6, SCANNER_DATA_MORE, offset, TEST_FRAGMENT, 1300)) {
+            printf("Chain dropped too early!\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (-EMSGSIZE != push(reassembly, 0xa6, SCANNER_DATA_MORE, 0, TEST_FRAGMENT, 1300)
+        || 1 != reassembly_expire(reassembly, 5000) || 0 != reassembly_pending(reassembly)) {
+        printf("Oversized chain kept!\n");
+        return EXIT_FAILURE;
+    }
+
+    reassembly_get_stats(reassembly, &stats);
+    printf("%llu direct, %llu fragments, %llu reassembled, %llu truncated, %llu timeouts, %llu overflows\n",
+        (unsigned long long) stats.direct, (unsigned long long) stats.fragments,
+        (unsigned long long) stats.reassembled, (unsigned long long) stats.truncated,
+        (unsigned long long) stats.timeouts, (unsigned long long) stats.overflows);
+
+    if (1 != stats.direct || 2 != stats.reassembled || 1 != stats.truncated
+        || 2 != stats.timeouts || 2 != stats.overflows) {
+        printf("Unexpected counters!\n");
+        return EXIT_FAILURE;
+    }
+
+    reassembly_free(reassembly);
+
+    printf("Reassembly OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Reassembled payload arrived through scanner */
+static void scanner_callback(
+    const scanner_report_t *report,
+    void                   *user_data) {
+
+    payload_callback(report, user_data);
+
+    if (TEST_PAYLOAD == report->length) {
+        loop_quit_in(test_loop);
+    }
+}
+
+/* Test hangs */
+static void timeout_callback(
+    int         id,
+    void       *user_data) {
+    printf("Timeout!\n");
+    loop_quit_in(test_loop);
+}
+
+/* Scanner handles extended reports it gets from controller */
+static int check_scanner(void) {
+
+    const fragment_t fragment[3] = {
+        { 0xb1, 0x01, SCANNER_DATA_MORE, test_payload, TEST_FRAGMENT },
+        { 0xb1, 0x01, SCANNER_DATA_MORE, test_payload + TEST_FRAGMENT, TEST_FRAGMENT },
+        { 0xb1, 0x01, SCANNER_DATA_COMPLETE, test_payload + TEST_FRAGMENT * 2, TEST_PAYLOAD - TEST_FRAGMENT * 2 }
+    };
+    struct timespec timeout = { .tv_sec = 5, .tv_nsec = 0 };
+    struct hci_channel *hci;
+    struct scanner *scanner;
+    size_t size;
+    int sv[2];
+
+    if (0 != socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv)) {
+        printf("Socket pair failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    test_loop = loop_new();
+    hci = hci_channel_new_in(test_loop, sv[0]);
+    scanner = scanner_new(hci, scanner_callback, NULL);
+    if (NULL == test_loop || NULL == hci || NULL == scanner) {
+        printf("Scanner set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    test_delivered = 0;
+    test_match = 0;
+
+    for (size_t i = 0; 3 > i; ++i) {
+        size = build_event(&fragment[i], 1);
+        if ((ssize_t) size != write(sv[1], test_event, size)) {
+            printf("Controller write error: %s.\n", strerror(errno));
+            return EXIT_FAILURE;
+        }
+    }
+
+    create_timer_in(test_loop, &timeout, timeout_callback, NULL, NULL);
+    loop_run_in(test_loop);
+
+    if (1 != test_delivered || !test_match || 1 != scanner_report_count(scanner)) {
+        printf("Scanner did not reassemble payload!\n");
+        return EXIT_FAILURE;
+    }
+
+    scanner_free(scanner);
+    hci_channel_free(hci);
+    loop_free(test_loop);
+    close(sv[0]);
+    close(sv[1]);
+
+    printf("Scanner OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Owner drops scanner on first report */
+static void free_callback(
+    const scanner_report_t *report,
+    void                   *user_data) {
+
+    struct scanner **scanner = user_data;
+
+    test_delivered++;
+
+    scanner_free(*scanner);
+    *scanner = NULL;
+    loop_quit_in(test_loop);
+}
+
+/* Scanner freed from report callback: rest of event is dropped, legacy
+ * and extended paths alike */
+static int check_free(void) {
+
+    const fragment_t fragment[3] = {
+        { 0xd1, 0x01, SCANNER_DATA_MORE, test_payload, 20 },
+        { 0xd1, 0x01, SCANNER_DATA_COMPLETE, test_payload + 20, 20 },
+        { 0xd2, 0x02, SCANNER_DATA_COMPLETE, test_payload, 20 }
+    };
+    /* Two legacy reports without data */
+    const uint8_t legacy[5 + 2 * 10] = {
+        BT_HCI_EVENT_PKT, BT_HCI_EVT_LE_META, 2 + 2 * 10, BT_HCI_EVT_LE_ADV_REPORT, 2
+    };
+    struct timespec timeout = { .tv_sec = 5, .tv_nsec = 0 };
+    struct hci_channel *hci;
+    struct scanner *scanner;
+    size_t size;
+    int sv[2];
+
+    for (size_t round = 0; 2 > round; ++round) {
+
+        if (0 != socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv)) {
+            printf("Socket pair failed!\n");
+            return EXIT_FAILURE;
+        }
+
+        test_loop = loop_new();
+        hci = hci_channel_new_in(test_loop, sv[0]);
+        scanner = scanner_new(hci, free_callback, &scanner);
+        if (NULL == test_loop || NULL == hci || NULL == scanner) {
+            printf("Scanner set up failed!\n");
+            return EXIT_FAILURE;
+        }
+
+        test_delivered = 0;
+
+        /* Payload completes in front of another report in the same event */
+        if (0 == round) {
+            size = build_event(&fragment[0], 1);
+            if ((ssize_t) size != write(sv[1], test_event, size)) {
+                printf("Controller write error: %s.\n", strerror(errno));
+                return EXIT_FAILURE;
+            }
+            size = build_event(&fragment[1], 2);
+        } else {
+            memcpy(test_event, legacy, sizeof(legacy));
+            size = sizeof(legacy);
+        }
+
+        if ((ssize_t) size != write(sv[1], test_event, size)) {
+            printf("Controller write error: %s.\n", strerror(errno));
+            return EXIT_FAILURE;
+        }
+
+        create_timer_in(test_loop, &timeout, timeout_callback, NULL, NULL);
+        loop_run_in(test_loop);
+
+        if (1 != test_delivered || NULL != scanner) {
+            printf("%s reports went out after free: %zu!\n", round ? "Legacy" : "Extended", test_delivered);
+            return EXIT_FAILURE;
+        }
+
+        hci_channel_free(hci);
+        loop_free(test_loop);
+        close(sv[0]);
+        close(sv[1]);
+    }
+
+    printf("Free from callback OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Count reports */
+static void count_callback(
+    const scanner_report_t *report,
+    void                   *user_data) {
+    test_delivered++;
+}
+
+/* Feed reassembler without clock */
+static void fast_callback(
+    const scanner_report_t *report,
+    void                   *user_data) {
+    reassembly_push(user_data, report, 0);
+}
+
+/* Per report cost of legacy and unfragmented extended reports */
+static int benchmark(void) {
+
+    const fragment_t fragment = { 0xc1, 0x01, SCANNER_DATA_COMPLETE, test_payload, 30 };
+    uint8_t legacy[4 + 9 + 30 + 1];
+    struct reassembly *reassembly;
+    uint64_t start, legacy_ns, extended_ns;
+
+    /* Legacy event with one iBeacon sized report */
+    memset(legacy, 0, sizeof(legacy));
+    legacy[0] = BT_HCI_EVT_LE_ADV_REPORT;
+    legacy[1] = 1;
+    legacy[2 + 8] = 30;
+
+    reassembly = reassembly_new(0, REASSEMBLY_DEFAULT_TIMEOUT, count_callback, NULL);
+    build_event(&fragment, 1);
+
+    test_delivered = 0;
+    start = now_ns();
+    for (size_t i = 0; TEST_ITERATIONS > i; ++i) {
+        scanner_parse_reports(legacy, (uint8_t) (2 + 9 + 30 + 1), count_callback, NULL);
+    }
+    legacy_ns = now_ns() - start;
+
+    start = now_ns();
+    for (size_t i = 0; TEST_ITERATIONS > i; ++i) {
+        scanner_parse_ext_reports(test_event + 3, test_event[2], fast_callback, reassembly);
+    }
+    extended_ns = now_ns() - start;
+
+    printf("Legacy: %.1f ns/report, extended: %.1f ns/report\n",
+        (double) legacy_ns / TEST_ITERATIONS, (double) extended_ns / TEST_ITERATIONS);
+
+    reassembly_free(reassembly);
+
+    if (TEST_ITERATIONS * 2 != test_delivered) {
+        printf("Reports lost!\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    printf("Checking extended advertising reports ...\n");
+    printf("-------------------------------------\n");
+
+    for (size_t i = 0; sizeof(test_payload) > i; ++i) {
+        test_payload[i] = (uint8_t) (i * 7 + 3);
+    }
+
+    if (EXIT_SUCCESS != check_parser() || EXIT_SUCCESS != check_reassembly()
+        || EXIT_SUCCESS != check_scanner() || EXIT_SUCCESS != check_free()
+        || EXIT_SUCCESS != benchmark()) {
+        return EXIT_FAILURE;
+    }
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -0,0 +1,439 @@
+/*!
+ *	\file		replay00.c
+ *	\brief		HCI capture replay test and benchmark
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/replay.h"
+#include "beaconizer/scanner.h"
+#include "beaconizer/timer.h"
+
+
+#define TEST_EVENTS             10000
+#define TEST_REPORTS_PER_EVENT  4
+#define TEST_DATA_SIZE          30
+#define TEST_REPEAT             50
+#define TEST_PACED_EVENTS       6
+#define TEST_PACED_STEP         20000       /* us */
+
+struct loop *test_loop = NULL;
+uint64_t test_received = 0;
+uint64_t test_expected = 0;
+int test_status = -1;
+uint64_t test_done = 0;
+
+/* Captured packet, H4 framing */
+typedef struct {
+    uint8_t         data[BT_HCI_MAX_PACKET_SIZE];
+    size_t          length;
+    int             received;
+    uint64_t        time;                   /* us */
+} test_packet_t;
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Store big endian word */
+static uint8_t *put_be32(
+    uint8_t        *p,
+    const uint32_t  value) {
+
+    p[0] = (uint8_t) (value >> 24);
+    p[1] = (uint8_t) (value >> 16);
+    p[2] = (uint8_t) (value >> 8);
+    p[3] = (uint8_t) value;
+
+    return p + 4;
+}
+
+/* Store word in chosen byte order */
+static uint8_t *put_u32(
+    uint8_t        *p,
+    const uint32_t  value,
+    const int       swap) {
+
+    if (swap) {
+        return put_be32(p, value);
+    }
+
+    p[0] = (uint8_t) value;
+    p[1] = (uint8_t) (value >> 8);
+    p[2] = (uint8_t) (value >> 16);
+    p[3] = (uint8_t) (value >> 24);
+
+    return p + 4;
+}
+
+/* Build LE Advertising Report event */
+static size_t build_event(
+    uint8_t        *event,
+    const size_t    serial) {
+
+    uint8_t *p = event + 5;
+
+    event[0] = BT_HCI_EVENT_PKT;
+    event[1] = BT_HCI_EVT_LE_META;
+    event[3] = BT_HCI_EVT_LE_ADV_REPORT;
+    event[4] = TEST_REPORTS_PER_EVENT;
+
+    for (size_t i = 0; TEST_REPORTS_PER_EVENT > i; ++i) {
+
+        *p++ = 0x03;                    /* ADV_NONCONN_IND */
+        *p++ = 0x01;                    /* Random address */
+        for (size_t j = 0; 6 > j; ++j) {
+            *p++ = (uint8_t) (serial >> (8 * j)) + (uint8_t) i;
+        }
+
+        *p++ = TEST_DATA_SIZE;
+        for (size_t j = 0; TEST_DATA_SIZE > j; ++j) {
+            *p++ = (uint8_t) j;
+        }
+
+        *p++ = (uint8_t) (-40 - (int) i);
+    }
+
+    event[2] = (uint8_t) (p - event - 3);
+
+    return (size_t) (p - event);
+}
+
+/* Capture: command sent, its completion and advertising reports */
+static size_t build_capture(
+    test_packet_t  *packet,
+    const size_t    events,
+    const uint64_t  step) {
+
+    const uint8_t command[] = { BT_HCI_COMMAND_PKT, 0x0c, 0x20, 0x02, 0x01, 0x00 };
+    const uint8_t complete[] = { BT_HCI_EVENT_PKT, BT_HCI_EVT_CMD_COMPLETE, 0x04, 0x01, 0x0c, 0x20, 0x00 };
+
+    memcpy(packet[0].data, command, sizeof(command));
+    packet[0].length = sizeof(command);
+    packet[0].received = 0;
+    packet[0].time = 63000000000000000ULL;
+
+    memcpy(packet[1].data, complete, sizeof(complete));
+    packet[1].length = sizeof(complete);
+    packet[1].received = 1;
+    packet[1].time = packet[0].time;
+
+    for (size_t i = 0; events > i; ++i) {
+        packet[i + 2].length = build_event(packet[i + 2].data, i);
+        packet[i + 2].received = 1;
+        packet[i + 2].time = packet[0].time + step * (i + 1);
+    }
+
+    return events + 2;
+}
+
+/* Write btsnoop file */
+static int write_btsnoop(
+    const char             *path,
+    const test_packet_t    *packet,
+    const size_t            count,
+    const uint32_t          format) {
+
+    uint8_t header[24], *p;
+    size_t skip = (REPLAY_BTSNOOP_H1 == format) ? 1 : 0;
+    FILE *file = fopen(path, "wb");
+
+    if (NULL == file) {
+        return EXIT_FAILURE;
+    }
+
+    memcpy(header, "btsnoop\0", 8);
+    put_be32(put_be32(header + 8, 1), format);
+    fwrite(header, 1, 16, file);
+
+    for (size_t i = 0; count > i; ++i) {
+        p = put_be32(header, (uint32_t) (packet[i].length - skip));
+        p = put_be32(p, (uint32_t) (packet[i].length - skip));
+        p = put_be32(p, (packet[i].received ? 0x01 : 0x00) | 0x02);
+        p = put_be32(p, 0);
+        p = put_be32(p, (uint32_t) (packet[i].time >> 32));
+        put_be32(p, (uint32_t) packet[i].time);
+        fwrite(header, 1, 24, file);
+        fwrite(packet[i].data + skip, 1, packet[i].length - skip, file);
+    }
+
+    return (0 == fclose(file)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Write pcap file with H4 and direction header */
+static int write_pcap(
+    const char             *path,
+    const test_packet_t    *packet,
+    const size_t            count,
+    const int               swap,
+    const int               nano) {
+
+    uint8_t header[24], *p;
+    FILE *file = fopen(path, "wb");
+
+    if (NULL == file) {
+        return EXIT_FAILURE;
+    }
+
+    p = put_u32(header, nano ? 0xa1b23c4d : 0xa1b2c3d4, swap);
+    p[0] = swap ? 0 : 2;
+    p[1] = swap ? 2 : 0;
+    p[2] = swap ? 0 : 4;
+    p[3] = swap ? 4 : 0;
+    p = put_u32(p + 4, 0, swap);
+    p = put_u32(p, 0, swap);
+    p = put_u32(p, 65535, swap);
+    put_u32(p, REPLAY_PCAP_H4_PHDR, swap);
+    fwrite(header, 1, 24, file);
+
+    for (size_t i = 0; count > i; ++i) {
+        p = put_u32(header, (uint32_t) (packet[i].time / 1000000), swap);
+        p = put_u32(p, (uint32_t) ((packet[i].time % 1000000) * (nano ? 1000 : 1)), swap);
+        p = put_u32(p, (uint32_t) packet[i].length + 4, swap);
+        p = put_u32(p, (uint32_t) packet[i].length + 4, swap);
+        put_be32(p, packet[i].received ? 1 : 0);
+        fwrite(header, 1, 20, file);
+        fwrite(packet[i].data, 1, packet[i].length, file);
+    }
+
+    return (0 == fclose(file)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Count reports, stop on the last one */
+static void report_callback(
+    const scanner_report_t *report,
+    void                   *user_data) {
+
+    if (test_expected == ++test_received) {
+        test_done = now_ns();
+        loop_quit_in(test_loop);
+    }
+}
+
+/* Replay finished, reader may still be behind */
+static void done_callback(
+    struct replay      *replay,
+    int                 status,
+    void               *user_data) {
+
+    test_status = status;
+    if (EXIT_SUCCESS != status) {
+        loop_quit_in(test_loop);
+    }
+}
+
+/* Test hangs */
+static void timeout_callback(
+    int                 id,
+    void               *user_data) {
+    printf("Timeout: %llu reports received!\n", (unsigned long long) test_received);
+    loop_quit_in(test_loop);
+}
+
+/* Replay capture through HCI channel and scanner */
+static int run_replay(
+    const char         *path,
+    const double        speed,
+    const unsigned int  repeat,
+    const uint64_t      expected,
+    replay_stats_t     *stats,
+    uint64_t           *elapsed) {
+
+    struct timespec timeout = { .tv_sec = 10, .tv_nsec = 0 };
+    struct replay *replay;
+    struct hci_channel *hci;
+    struct scanner *scanner;
+    uint64_t start;
+
+    test_loop = loop_new();
+    replay = replay_open_in(test_loop, path);
+    if (NULL == test_loop || NULL == replay) {
+        printf("Replay of %s failed: %s!\n", path, strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    hci = hci_channel_new_in(test_loop, replay_get_descriptor(replay));
+    scanner = scanner_new(hci, report_callback, NULL);
+    if (NULL == hci || NULL == scanner) {
+        printf("Scanner creation failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    test_received = 0;
+    test_expected = expected;
+    test_status = -1;
+
+    create_timer_in(test_loop, &timeout, timeout_callback, NULL, NULL);
+
+    start = now_ns();
+    if (EXIT_SUCCESS != replay_start(replay, speed, repeat, done_callback, NULL)) {
+        printf("Replay start failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    loop_run_in(test_loop);
+
+    scanner_free(scanner);
+    hci_channel_free(hci);
+    replay_get_stats(replay, stats);
+    replay_free(replay);
+    loop_free(test_loop);
+
+    *elapsed = test_done - start;
+
+    return (EXIT_SUCCESS == test_status && expected == test_received) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Every format gives the same reports */
+static int check_formats(
+    const char         *path,
+    test_packet_t      *packet) {
+
+    const size_t count = build_capture(packet, 100, 1000);
+    replay_stats_t stats;
+    uint64_t elapsed;
+    int result;
+
+    for (int format = 0; 4 > format; ++format) {
+
+        switch (format) {
+            case 0: result = write_btsnoop(path, packet, count, REPLAY_BTSNOOP_H4); break;
+            case 1: result = write_btsnoop(path, packet, count, REPLAY_BTSNOOP_H1); break;
+            case 2: result = write_pcap(path, packet, count, 0, 0); break;
+            default: result = write_pcap(path, packet, count, 1, 1); break;
+        }
+
+        if (EXIT_SUCCESS != result || EXIT_SUCCESS != run_replay(path, REPLAY_FAST, 1, 100 * TEST_REPORTS_PER_EVENT, &stats, &elapsed)) {
+            printf("Format %d failed!\n", format);
+            return EXIT_FAILURE;
+        }
+
+        /* Host command is not replayed */
+        if (count - 1 != stats.packets || 100 * TEST_REPORTS_PER_EVENT != test_received) {
+            printf("Format %d: %llu packets, %llu reports!\n", format,
+                (unsigned long long) stats.packets, (unsigned long long) test_received);
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* Not a capture */
+    memset(packet[0].data, 0x55, 64);
+    if (EXIT_SUCCESS != write_btsnoop(path, packet, 0, 2001)) {
+        return EXIT_FAILURE;
+    }
+
+    test_loop = loop_new();
+    if (NULL != replay_open_in(test_loop, path) || ENOTSUP != errno) {
+        printf("Monitor capture accepted!\n");
+        return EXIT_FAILURE;
+    }
+    loop_free(test_loop);
+
+    printf("Formats OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Capture timing is scaled */
+static int check_paced(
+    const char         *path,
+    test_packet_t      *packet) {
+
+    const size_t count = build_capture(packet, TEST_PACED_EVENTS, TEST_PACED_STEP);
+    const uint64_t span = (uint64_t) TEST_PACED_EVENTS * TEST_PACED_STEP * 1000;
+    replay_stats_t stats;
+    uint64_t elapsed;
+
+    if (EXIT_SUCCESS != write_pcap(path, packet, count, 0, 0)
+        || EXIT_SUCCESS != run_replay(path, 2.0, 1, TEST_PACED_EVENTS * TEST_REPORTS_PER_EVENT, &stats, &elapsed)) {
+        printf("Paced replay failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("Capture of %.0f ms replayed at 2x in %.1f ms\n", span / 1e6, elapsed / 1e6);
+
+    if (span / 2 > elapsed || span < elapsed || TEST_PACED_EVENTS * TEST_REPORTS_PER_EVENT != test_received) {
+        printf("Pacing is off!\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("Pacing OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    char path[] = "/tmp/replay00XXXXXX";
+    test_packet_t *packet;
+    replay_stats_t stats;
+    uint64_t elapsed;
+    size_t count;
+    int fd;
+
+    printf("Checking capture replay ...\n");
+    printf("-------------------------------------\n");
+
+    packet = calloc(TEST_EVENTS + 2, sizeof(test_packet_t));
+    fd = mkstemp(path);
+    if (NULL == packet || 0 > fd) {
+        printf("Set up failed!\n");
+        return EXIT_FAILURE;
+    }
+    close(fd);
+
+    if (EXIT_SUCCESS != check_formats(path, packet) || EXIT_SUCCESS != check_paced(path, packet)) {
+        unlink(path);
+        return EXIT_FAILURE;
+    }
+
+    /* Receive path end to end: socket, HCI channel, report parser */
+    count = build_capture(packet, TEST_EVENTS, 1000);
+    if (EXIT_SUCCESS != write_btsnoop(path, packet, count, REPLAY_BTSNOOP_H4)
+        || EXIT_SUCCESS != run_replay(path, REPLAY_FAST, TEST_REPEAT,
+            (uint64_t) TEST_EVENTS * TEST_REPORTS_PER_EVENT * TEST_REPEAT, &stats, &elapsed)) {
+        unlink(path);
+        printf("Benchmark replay failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    unlink(path);
+    free(packet);
+
+    printf("%llu packets, %llu reports in %.3f sec: %.0f reports/sec, %.1f MB/sec, %llu stalls\n",
+        (unsigned long long) stats.packets, (unsigned long long) test_received, elapsed / 1e9,
+        test_received * 1e9 / elapsed, stats.bytes * 1e3 / elapsed, (unsigned long long) stats.stalls);
+
+    if ((uint64_t) TEST_EVENTS * TEST_REPORTS_PER_EVENT * TEST_REPEAT != test_received) {
+        printf("Reports lost!\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -0,0 +1,163 @@
+/*!
+ *	\file		rpa00.c
+ *	\brief		Resolvable Private Address resolver test and benchmark
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/rpa.h"
+
+
+#define TEST_IRKS           10000
+#define TEST_REPORTS        1000000
+#define TEST_TTL            900
+
+/* Core specification sample data */
+const uint8_t test_irk[RPA_IRK_SIZE] = {
+    0xec, 0x02, 0x34, 0xa3, 0x57, 0xc8, 0xad, 0x05,
+    0x34, 0x10, 0x10, 0xa6, 0x0a, 0x39, 0x7d, 0x9b
+};
+
+static uint8_t irk[TEST_IRKS][RPA_IRK_SIZE];
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Main course */
+int
+main() {
+
+    const uint8_t spec_address[RPA_ADDRESS_SIZE] = { 0xaa, 0xfb, 0x0d, 0x94, 0x81, 0x70 };
+    const uint8_t public_address[RPA_ADDRESS_SIZE] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06 };
+    struct rpa_resolver *resolver;
+    rpa_resolver_stats_t stats;
+    uint8_t address[RPA_ADDRESS_SIZE], unknown[RPA_ADDRESS_SIZE];
+    uint32_t seed = 0x13572468;
+    uint64_t start, elapsed;
+    void *user_data;
+    int result;
+
+    printf("Checking RPA resolver ...\n");
+    printf("-------------------------------------\n");
+
+    if (0x0dfbaa != rpa_hash(test_irk, 0x708194)) {
+        printf("ah() mismatch: 0x%06x!\n", rpa_hash(test_irk, 0x708194));
+        return EXIT_FAILURE;
+    }
+
+    rpa_generate(test_irk, 0x308194, address);
+    if (0 != memcmp(address, spec_address, RPA_ADDRESS_SIZE) || rpa_is_resolvable(public_address)) {
+        printf("Address generation failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("ah() OK\n");
+
+    resolver = rpa_resolver_new(TEST_TTL, 0);
+    if (NULL == resolver) {
+        printf("Resolver set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; TEST_IRKS > i; ++i) {
+
+        for (size_t j = 0; RPA_IRK_SIZE > j; ++j) {
+            seed = seed * 1103515245 + 12345;
+            irk[i][j] = (uint8_t) (seed >> 16);
+        }
+
+        if ((int) i != rpa_resolver_add(resolver, irk[i], &irk[i])) {
+            printf("IRK %zu not added!\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (-EINVAL != rpa_resolver_resolve(resolver, public_address, 0, NULL)) {
+        printf("Public address accepted!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Last IRK is the worst case */
+    rpa_generate(irk[TEST_IRKS - 1], 0x1234, address);
+
+    start = now_ns();
+    result = rpa_resolver_resolve(resolver, address, 0, &user_data);
+    elapsed = now_ns() - start;
+    printf("%d IRKs walked in %.1f us\n", TEST_IRKS, (double) elapsed / 1e3);
+
+    if (TEST_IRKS - 1 != result || &irk[TEST_IRKS - 1] != user_data) {
+        printf("Address not resolved (%d)!\n", result);
+        return EXIT_FAILURE;
+    }
+
+    /* Unknown device */
+    rpa_generate(test_irk, 0x5678, unknown);
+    if (-ENOENT != rpa_resolver_resolve(resolver, unknown, 0, NULL)) {
+        printf("Unknown address resolved!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Reports of both devices hit cache */
+    start = now_ns();
+    for (size_t i = 0; TEST_REPORTS > i; ++i) {
+        result = rpa_resolver_resolve(resolver, (i & 1) ? unknown : address, (uint32_t) (i / 10000), NULL);
+        if ((i & 1) ? -ENOENT != result : TEST_IRKS - 1 != result) {
+            printf("Cached result lost!\n");
+            return EXIT_FAILURE;
+        }
+    }
+    elapsed = now_ns() - start;
+
+    rpa_resolver_get_stats(resolver, &stats);
+    printf("%d cached reports: %.1f ns per report\n", TEST_REPORTS, (double) elapsed / TEST_REPORTS);
+
+    if (2 != stats.scans || TEST_REPORTS / 2 != stats.resolved || TEST_REPORTS / 2 != stats.rejected) {
+        printf("Unexpected counters: %llu scans, %llu resolved, %llu rejected!\n",
+            (unsigned long long) stats.scans, (unsigned long long) stats.resolved, (unsigned long long) stats.rejected);
+        return EXIT_FAILURE;
+    }
+
+    /* New IRK makes negative result stale */
+    if (TEST_IRKS != rpa_resolver_add(resolver, test_irk, NULL)
+        || TEST_IRKS != rpa_resolver_resolve(resolver, unknown, 1, NULL)) {
+        printf("Negative result not dropped!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Address expires with RPA rotation */
+    rpa_resolver_get_stats(resolver, &stats);
+    result = (int) stats.scans;
+    rpa_resolver_resolve(resolver, address, TEST_TTL, NULL);
+    rpa_resolver_get_stats(resolver, &stats);
+    if ((uint64_t) result + 1 != stats.scans) {
+        printf("Expired address not resolved again!\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%llu ah() evaluations in total\n", (unsigned long long) stats.computed);
+
+    rpa_resolver_free(resolver);
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
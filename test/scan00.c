@@ -0,0 +1,348 @@
+/*!
+ *	\file		scan00.c
+ *	\brief		Scanner parsing test and report replay benchmark
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/hci.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/scanner.h"
+#include "beaconizer/timer.h"
+
+
+#define TEST_EVENT_COUNT        100000
+#define TEST_REPORTS_PER_EVENT  3
+#define TEST_DATA_SIZE          30
+
+/* glibc allocator entry points */
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+int test_counting = 0;
+size_t test_allocations = 0;
+
+/* Interpose heap allocations to count them */
+void *malloc(
+    size_t      size) {
+
+    if (test_counting) {
+        test_allocations++;
+    }
+
+    return __libc_malloc(size);
+}
+
+void *calloc(
+    size_t      count,
+    size_t      size) {
+
+    if (test_counting) {
+        test_allocations++;
+    }
+
+    return __libc_calloc(count, size);
+}
+
+void *realloc(
+    void       *ptr,
+    size_t      size) {
+
+    if (test_counting) {
+        test_allocations++;
+    }
+
+    return __libc_realloc(ptr, size);
+}
+
+struct loop *test_loop = NULL;
+struct scanner *test_scanner = NULL;
+int test_controller = -1;
+uint8_t test_event[BT_HCI_MAX_PACKET_SIZE];
+size_t test_event_size = 0;
+size_t test_written = 0;
+uint64_t test_received = 0;
+uint64_t test_rssi_sum = 0;
+uint16_t test_commands[8];
+size_t test_command_count = 0;
+double test_start = 0;
+double test_elapsed = 0;
+int test_result = EXIT_FAILURE;
+
+/* Monotonic time in seconds */
+static double now(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+}
+
+/* Build LE Advertising Report event with identical reports */
+static size_t build_event(
+    uint8_t        *event,
+    const uint8_t   count) {
+
+    uint8_t *p = event + 5;
+    uint8_t i, j;
+
+    event[0] = BT_HCI_EVENT_PKT;
+    event[1] = BT_HCI_EVT_LE_META;
+    event[3] = BT_HCI_EVT_LE_ADV_REPORT;
+    event[4] = count;
+
+    for (i = 0; count > i; ++i) {
+
+        *p++ = 0x03;                    /* ADV_NONCONN_IND */
+        *p++ = 0x01;                    /* Random address */
+        for (j = 0; 6 > j; ++j) {
+            *p++ = 0xc0 + i + j;
+        }
+
+        *p++ = TEST_DATA_SIZE;
+        for (j = 0; TEST_DATA_SIZE > j; ++j) {
+            *p++ = j;
+        }
+
+        *p++ = (uint8_t) (-40 - i);     /* RSSI */
+    }
+
+    event[2] = (uint8_t) (p - event - 3);
+
+    return (size_t) (p - event);
+}
+
+/* Report sink for parser check */
+static void check_report(
+    const scanner_report_t *report,
+    void                   *user_data) {
+
+    size_t *count = user_data;
+    const size_t i = (*count)++;
+
+    if (0x03 != report->event_type || 0x01 != report->address_type
+        || 0xc0 + i != report->address[0] || TEST_DATA_SIZE != report->length
+        || TEST_DATA_SIZE - 1 != report->data[TEST_DATA_SIZE - 1] || -40 - (int) i != report->rssi) {
+        printf("Report %lu decoded wrong!\n", i);
+        *count = 1000;
+    }
+}
+
+/* Parse crafted events */
+static int check_parser(void) {
+
+    uint8_t event[BT_HCI_MAX_PACKET_SIZE];
+    size_t count = 0;
+    size_t size = build_event(event, 2);
+
+    if (2 != scanner_parse_reports(event + 3, event[2], check_report, &count) || 2 != count) {
+        printf("Reports were not parsed!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Truncated second report */
+    if (0 <= scanner_parse_reports(event + 3, (uint8_t) (size - 4), NULL, NULL)) {
+        printf("Truncated event accepted!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Report count beyond data */
+    event[4] = 3;
+    if (0 <= scanner_parse_reports(event + 3, event[2], NULL, NULL)) {
+        printf("Bogus report count accepted!\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("Parser OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Count replayed reports */
+static void report_callback(
+    const scanner_report_t *report,
+    void                   *user_data) {
+
+    test_rssi_sum += (uint8_t) -report->rssi;
+    test_received++;
+}
+
+/* Scanning stopped */
+static void stopped(
+    struct scanner     *scanner,
+    int                 status,
+    void               *user_data) {
+
+    test_result = (BT_HCI_SUCCESS == status) ? EXIT_SUCCESS : EXIT_FAILURE;
+    loop_quit_in(test_loop);
+}
+
+/* Scanning started: replay reports */
+static void started(
+    struct scanner     *scanner,
+    int                 status,
+    void               *user_data) {
+
+    if (BT_HCI_SUCCESS != status || 2 != test_command_count
+        || BT_HCI_CMD_LE_SET_SCAN_PARAMETERS != test_commands[0]
+        || BT_HCI_CMD_LE_SET_SCAN_ENABLE != test_commands[1]) {
+        printf("Scan start failed!\n");
+        loop_quit_in(test_loop);
+        return;
+    }
+
+    test_counting = 1;
+    test_start = now();
+    loop_modify_sd_in(test_loop, test_controller, EPOLLIN | EPOLLOUT);
+}
+
+/* Fake controller: completes commands and replays reports */
+static void controller(
+    int         sd,
+    uint32_t    event_mask,
+    void       *user_data) {
+
+    uint8_t packet[BT_HCI_MAX_PACKET_SIZE];
+    uint8_t reply[7] = { BT_HCI_EVENT_PKT, BT_HCI_EVT_CMD_COMPLETE, 4, 1, 0, 0, BT_HCI_SUCCESS };
+
+    if (event_mask & EPOLLIN) {
+        while (0 < read(sd, packet, sizeof(packet))) {
+
+            if (8 > test_command_count) {
+                test_commands[test_command_count++] = packet[1] | (packet[2] << 8);
+            }
+
+            reply[4] = packet[1];
+            reply[5] = packet[2];
+            if (sizeof(reply) != write(sd, reply, sizeof(reply))) {
+                printf("Controller write error: %s.\n", strerror(errno));
+            }
+        }
+    }
+
+    if (event_mask & EPOLLOUT) {
+
+        while (TEST_EVENT_COUNT > test_written) {
+            if (0 > write(sd, test_event, test_event_size)) {
+                return;
+            }
+            test_written++;
+        }
+
+        loop_modify_sd_in(test_loop, sd, EPOLLIN);
+    }
+}
+
+/* Stop when every report arrived */
+static void check_done(
+    int         id,
+    uint64_t    expired,
+    void       *user_data) {
+
+    if ((uint64_t) TEST_EVENT_COUNT * TEST_REPORTS_PER_EVENT > test_received || 0 == test_counting) {
+        return;
+    }
+
+    test_elapsed = now() - test_start;
+    test_counting = 0;
+
+    destroy_timer_in(test_loop, id);
+    scanner_stop(test_scanner, stopped, NULL);
+}
+
+/* Test hangs */
+static void timeout_callback(
+    int         id,
+    void       *user_data) {
+    printf("Timeout: %lu reports received!\n", test_received);
+    loop_quit_in(test_loop);
+}
+
+/* Main course */
+int
+main() {
+
+    struct timespec timeout = { .tv_sec = 10, .tv_nsec = 0 };
+    struct timespec period = { .tv_sec = 0, .tv_nsec = 1000000 };
+    struct hci_channel *hci;
+    int sv[2];
+
+    printf("Checking LE scanner ...\n");
+    printf("-------------------------------------\n");
+
+    if (EXIT_SUCCESS != check_parser()) {
+        return EXIT_FAILURE;
+    }
+
+    if (0 > socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, sv)) {
+        printf("Socket pair error: %s.\n", strerror(errno));
+        return EXIT_FAILURE;
+    }
+
+    test_controller = sv[1];
+    test_event_size = build_event(test_event, TEST_REPORTS_PER_EVENT);
+
+    test_loop = loop_new();
+    if (NULL == test_loop) {
+        printf("Loop creation failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (0 != loop_add_sd_in(test_loop, sv[1], EPOLLIN, controller, NULL, NULL)) {
+        printf("Controller set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    hci = hci_channel_new_in(test_loop, sv[0]);
+    test_scanner = scanner_new(hci, report_callback, NULL);
+    if (NULL == hci || NULL == test_scanner) {
+        printf("Scanner creation failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    create_timer_in(test_loop, &timeout, timeout_callback, NULL, NULL);
+    create_periodic_timer_in(test_loop, &period, check_done, NULL, NULL);
+
+    scanner_start(test_scanner, started, NULL);
+    loop_run_in(test_loop);
+
+    scanner_free(test_scanner);
+    hci_channel_free(hci);
+    loop_free(test_loop);
+
+    close(sv[0]);
+    close(sv[1]);
+
+    if (EXIT_SUCCESS == test_result) {
+
+        printf("%lu reports in %.3f sec: %.0f reports/sec, %lu heap allocations\n",
+            test_received, test_elapsed, (double) test_received / test_elapsed, test_allocations);
+
+        if (0 != test_allocations || (uint64_t) TEST_EVENT_COUNT * TEST_REPORTS_PER_EVENT != test_received) {
+            test_result = EXIT_FAILURE;
+        }
+    }
+
+    printf("-------------------------------------\n");
+    printf("%s\n", (EXIT_SUCCESS == test_result) ? "Done!" : "Failed!");
+
+    return test_result;
+}
+
+ /* End of file */
@@ -0,0 +1,279 @@
+/*!
+ *	\file		timer00.c
+ *	\brief		Timing wheel test and benchmark
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+
+
+#define TEST_TIMER_COUNT        1000
+#define TEST_TIMEOUT_MSEC       200
+#define TEST_LATE_MSEC          20
+#define TEST_BENCH_COUNT        100000
+#define TEST_PRECISE_COUNT      1000
+
+typedef struct {
+    int             id;
+    uint64_t        timeout;
+    uint64_t        deadline;
+    uint64_t        fired;
+    int             cancelled;
+} sample_t;
+
+struct loop *test_loop = NULL;
+sample_t test_sample[TEST_TIMER_COUNT];
+size_t test_expected = 0;
+size_t test_fired = 0;
+size_t test_errors = 0;
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Milliseconds to timespec */
+static struct timespec msec(
+    const uint64_t  value) {
+
+    struct timespec ts = {
+        .tv_sec     = value / 1000,
+        .tv_nsec    = (value % 1000) * 1000000
+    };
+
+    return ts;
+}
+
+/* Sample timer callback */
+static void sample_callback(
+    int         id,
+    void       *user_data) {
+
+    sample_t *s = user_data;
+
+    if (id != s->id || s->cancelled || 0 != s->fired) {
+        test_errors++;
+    }
+
+    s->fired = now_ns();
+
+    if (test_expected == ++test_fired) {
+        loop_quit_in(test_loop);
+    }
+}
+
+/* Guard timer: something never fired */
+static void guard_callback(
+    int         id,
+    void       *user_data) {
+
+    printf("Timers fired: %lu of %lu!\n", test_fired, test_expected);
+    test_errors++;
+    loop_quit_in(test_loop);
+}
+
+/* Fire random timeouts, check nothing is early or lost */
+static int check_expiration(void) {
+
+    struct timespec timeout;
+    uint64_t late, worst = 0;
+    size_t i;
+
+    test_loop = loop_new();
+    if (NULL == test_loop) {
+        printf("Loop creation failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    srand(1);
+    for (i = 0; TEST_TIMER_COUNT > i; ++i) {
+
+        uint64_t ms = 1 + rand() % TEST_TIMEOUT_MSEC;
+
+        memset(&test_sample[i], 0, sizeof(sample_t));
+
+        timeout = msec(ms);
+        test_sample[i].timeout = ms * 1000000;
+        test_sample[i].deadline = now_ns() + ms * 1000000;
+        test_sample[i].id = create_timer_in(test_loop, &timeout, sample_callback, &test_sample[i], NULL);
+        if (0 >= test_sample[i].id) {
+            printf("Timer creation failed: %s!\n", strerror(-test_sample[i].id));
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* Cancel every fourth, re-arm every fifth with the same timeout */
+    for (i = 0; TEST_TIMER_COUNT > i; ++i) {
+        if (0 == i % 4) {
+            test_sample[i].cancelled = 1;
+            cancel_timer_in(test_loop, test_sample[i].id);
+        } else {
+            if (0 == i % 5) {
+                test_sample[i].deadline = now_ns() + test_sample[i].timeout;
+                modify_timer_in(test_loop, test_sample[i].id, NULL);
+            }
+            test_expected++;
+        }
+    }
+
+    timeout = msec(TEST_TIMEOUT_MSEC * 10);
+    if (0 >= create_precise_timer_in(test_loop, &timeout, guard_callback, NULL, NULL)) {
+        printf("Guard timer creation failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    loop_run_in(test_loop);
+    loop_free(test_loop);
+
+    for (i = 0; TEST_TIMER_COUNT > i; ++i) {
+
+        if (test_sample[i].cancelled) {
+            continue;
+        }
+
+        if (test_sample[i].fired < test_sample[i].deadline) {
+            printf("Timer %lu fired %lu ns early!\n", i, test_sample[i].deadline - test_sample[i].fired);
+            test_errors++;
+            continue;
+        }
+
+        late = test_sample[i].fired - test_sample[i].deadline;
+        if (late > worst) {
+            worst = late;
+        }
+    }
+
+    printf("%lu timers fired, worst lateness %.3f ms\n", test_fired, (double) worst / 1e6);
+
+    if (worst > TEST_LATE_MSEC * 1000000ULL) {
+        printf("Timers are too late!\n");
+        test_errors++;
+    }
+
+    return (0 == test_errors) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Arm, re-arm and cancel count timers */
+static int benchmark(
+    const char     *name,
+    const size_t    count,
+    int             (*create)(struct loop *, struct timespec *, timer_fn_t, void *, destructor_t)) {
+
+    struct timespec timeout;
+    uint64_t start, arm, rearm, cancel;
+    int *id;
+    size_t i;
+
+    id = calloc(count, sizeof(int));
+    if (NULL == id) {
+        printf("Memory allocation error!");
+        return EXIT_FAILURE;
+    }
+
+    test_loop = loop_new();
+    if (NULL == test_loop) {
+        printf("Loop creation failed!\n");
+        free(id);
+        return EXIT_FAILURE;
+    }
+
+    /* Spread deadlines from seconds to hours to hit every wheel level */
+    start = now_ns();
+    for (i = 0; count > i; ++i) {
+        timeout = msec(1000 + (i * 7919) % 3600000);
+        id[i] = create(test_loop, &timeout, sample_callback, NULL, NULL);
+        if (0 >= id[i]) {
+            printf("Timer creation failed: %s!\n", strerror(-id[i]));
+            return EXIT_FAILURE;
+        }
+    }
+    arm = now_ns() - start;
+
+    start = now_ns();
+    for (i = 0; count > i; ++i) {
+        timeout = msec(1000 + (i * 104729) % 3600000);
+        if (0 != modify_timer_in(test_loop, id[i], &timeout)) {
+            printf("Timer modification failed!\n");
+            return EXIT_FAILURE;
+        }
+    }
+    rearm = now_ns() - start;
+
+    start = now_ns();
+    for (i = 0; count > i; ++i) {
+        if (0 != cancel_timer_in(test_loop, id[i])) {
+            printf("Timer cancel failed!\n");
+            return EXIT_FAILURE;
+        }
+    }
+    cancel = now_ns() - start;
+
+    for (i = 0; count > i; ++i) {
+        if (0 != destroy_timer_in(test_loop, id[i])) {
+            printf("Timer destruction failed!\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    /* Stale handle must be rejected */
+    if (0 == modify_timer_in(test_loop, id[0], NULL)) {
+        printf("Stale timer handle accepted!\n");
+        return EXIT_FAILURE;
+    }
+
+    loop_free(test_loop);
+    free(id);
+
+    printf("%-8s %6lu timers: arm %7.1f ns, re-arm %7.1f ns, cancel %7.1f ns per timer\n",
+        name,
+        count,
+        (double) arm / count,
+        (double) rearm / count,
+        (double) cancel / count);
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    printf("Checking timing wheel ...\n");
+    printf("-------------------------------------\n");
+
+    if (EXIT_SUCCESS != check_expiration()) {
+        return EXIT_FAILURE;
+    }
+
+    if (EXIT_SUCCESS != benchmark("wheel", TEST_BENCH_COUNT, create_timer_in)) {
+        return EXIT_FAILURE;
+    }
+
+    if (EXIT_SUCCESS != benchmark("precise", TEST_PRECISE_COUNT, create_precise_timer_in)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -0,0 +1,140 @@
+/*!
+ *	\file		timer01.c
+ *	\brief		Periodic timer test
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+
+
+#define TEST_PERIOD_MSEC        5
+#define TEST_TICK_COUNT         40
+#define TEST_STALL_TICK         10
+#define TEST_STALL_MSEC         32
+
+typedef struct {
+    struct loop    *loop;
+    uint64_t        start;
+    uint64_t        ticks;          /* Periods reported */
+    uint64_t        calls;          /* Callbacks run    */
+    uint64_t        overruns;       /* Calls with missed periods */
+    uint64_t        limit;
+} sample_t;
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Periodic callback, stalls once to provoke overrun */
+static void periodic_callback(
+    int         id,
+    uint64_t    expired,
+    void       *user_data) {
+
+    sample_t *s = user_data;
+
+    s->ticks += expired;
+    s->calls++;
+
+    if (1 < expired) {
+        s->overruns++;
+    }
+
+    if (TEST_STALL_TICK == s->calls) {
+        usleep(TEST_STALL_MSEC * 1000);
+    }
+
+    if (s->limit <= s->ticks) {
+        loop_quit_in(s->loop);
+    }
+}
+
+/* Check periodic timer keeps phase and counts missed periods */
+static int check_periodic(
+    const char     *name,
+    int             (*create)(struct loop *, struct timespec *, periodic_fn_t, void *, destructor_t)) {
+
+    struct timespec period = { .tv_sec = 0, .tv_nsec = TEST_PERIOD_MSEC * 1000000 };
+    sample_t sample;
+    uint64_t elapsed, periods;
+    int id;
+
+    memset(&sample, 0, sizeof(sample));
+    sample.limit = TEST_TICK_COUNT;
+
+    sample.loop = loop_new();
+    if (NULL == sample.loop) {
+        printf("Loop creation failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    sample.start = now_ns();
+    id = create(sample.loop, &period, periodic_callback, &sample, NULL);
+    if (0 >= id) {
+        printf("Timer creation failed: %s!\n", strerror(-id));
+        return EXIT_FAILURE;
+    }
+
+    loop_run_in(sample.loop);
+    elapsed = now_ns() - sample.start;
+    loop_free(sample.loop);
+
+    periods = elapsed / (TEST_PERIOD_MSEC * 1000000ULL);
+
+    printf("%-8s %lu periods in %lu calls, %lu overruns, %lu periods elapsed\n",
+        name, sample.ticks, sample.calls, sample.overruns, periods);
+
+    /* Stall must be reported, not lost or replayed */
+    if (0 == sample.overruns || sample.calls >= sample.ticks) {
+        printf("Overrun was not reported!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (sample.ticks > periods || sample.ticks + 2 < periods) {
+        printf("Periods drift from the clock!\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    printf("Checking periodic timers ...\n");
+    printf("-------------------------------------\n");
+
+    if (EXIT_SUCCESS != check_periodic("wheel", create_periodic_timer_in)) {
+        return EXIT_FAILURE;
+    }
+
+    if (EXIT_SUCCESS != check_periodic("precise", create_precise_periodic_timer_in)) {
+        return EXIT_FAILURE;
+    }
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
@@ -0,0 +1,181 @@
+/*!
+ *	\file		timer02.c
+ *	\brief		Timer slack and wake up coalescing test
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+
+
+#define TEST_TIMER_COUNT        2000
+#define TEST_PERIOD_MSEC        100
+#define TEST_SLACK_MSEC         25
+#define TEST_RUN_MSEC           1000
+
+typedef struct {
+    uint64_t        due;            /* Next expected expiration */
+    uint64_t        period;
+} sample_t;
+
+struct loop *test_loop = NULL;
+sample_t test_sample[TEST_TIMER_COUNT];
+uint64_t test_fired = 0;
+uint64_t test_early = 0;
+uint64_t test_late = 0;
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Milliseconds to timespec */
+static struct timespec msec(
+    const uint64_t  value) {
+
+    struct timespec ts = {
+        .tv_sec     = value / 1000,
+        .tv_nsec    = (value % 1000) * 1000000
+    };
+
+    return ts;
+}
+
+/* Staggered periodic timer */
+static void sample_callback(
+    int         id,
+    uint64_t    expired,
+    void       *user_data) {
+
+    sample_t *s = user_data;
+    const uint64_t now = now_ns();
+
+    if (now < s->due) {
+        test_early++;
+    } else if (now - s->due > TEST_SLACK_MSEC * 2000000ULL) {
+        test_late++;
+    }
+
+    s->due += expired * s->period;
+    test_fired++;
+}
+
+/* Stop the run */
+static void stop_callback(
+    int         id,
+    void       *user_data) {
+    loop_quit_in(test_loop);
+}
+
+/* Run staggered timers and measure wake ups */
+static int run(
+    const char     *name,
+    const uint64_t  slack,
+    double         *rate) {
+
+    struct timespec period = msec(TEST_PERIOD_MSEC);
+    struct timespec timeout = msec(TEST_RUN_MSEC);
+    struct timespec allowed = msec(slack);
+    loop_stats_t stats;
+    size_t i;
+    int id;
+
+    test_fired = test_early = test_late = 0;
+
+    test_loop = loop_new();
+    if (NULL == test_loop) {
+        printf("Loop creation failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (0 != set_default_timer_slack_in(test_loop, &allowed)) {
+        printf("Slack set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Slightly different periods keep timers staggered */
+    for (i = 0; TEST_TIMER_COUNT > i; ++i) {
+
+        period.tv_nsec = TEST_PERIOD_MSEC * 1000000ULL + i * 37000;
+
+        test_sample[i].period = period.tv_nsec;
+        test_sample[i].due = now_ns() + period.tv_nsec;
+
+        id = create_periodic_timer_in(test_loop, &period, sample_callback, &test_sample[i], NULL);
+        if (0 >= id) {
+            printf("Timer creation failed!\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (0 >= create_precise_timer_in(test_loop, &timeout, stop_callback, NULL, NULL)) {
+        printf("Timer creation failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    loop_reset_stats_in(test_loop);
+    loop_run_in(test_loop);
+    loop_get_stats_in(test_loop, &stats);
+    loop_free(test_loop);
+
+    printf("%-10s %6lu fired, %5lu wakeups, %7.1f wakeups/sec, %lu early, %lu late\n",
+        name, test_fired, stats.wakeups, stats.wakeup_rate, test_early, test_late);
+
+    *rate = stats.wakeup_rate;
+
+    return (0 == test_early && 0 == test_late) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Main course */
+int
+main() {
+
+    struct timespec slack = msec(1);
+    double exact, relaxed;
+    int result;
+
+    printf("Checking timer slack ...\n");
+    printf("-------------------------------------\n");
+
+    if (EXIT_SUCCESS != run("no slack", 0, &exact)) {
+        return EXIT_FAILURE;
+    }
+
+    if (EXIT_SUCCESS != run("slack", TEST_SLACK_MSEC, &relaxed)) {
+        return EXIT_FAILURE;
+    }
+
+    if (relaxed * 4 > exact) {
+        printf("Wake ups were not coalesced!\n");
+        return EXIT_FAILURE;
+    }
+
+    result = set_process_timer_slack(&slack);
+    if (0 != result) {
+        printf("Process timer slack failed: %s!\n", strerror(-result));
+        return EXIT_FAILURE;
+    }
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */
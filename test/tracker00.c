@@ -0,0 +1,264 @@
+/*!
+ *	\file		tracker00.c
+ *	\brief		Beacon tracking table test and benchmark
+ *	\author		Vladislav "Tanuki" Mikhailikov \<vmikhailikov\@gmail.com\>
+ *	\copyright	GNU GPL v3
+ *	\date		16/10/2026
+ *	\version	1.0
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+
+#include "beaconizer/config.h"
+#include "beaconizer/loop.h"
+#include "beaconizer/timer.h"
+#include "beaconizer/tracker.h"
+
+
+#define TEST_BEACONS        100000
+#define TEST_UPDATES        10000000
+#define TEST_SMALL          1000
+
+const uint8_t test_uuid[16] = {
+    0xe2, 0xc5, 0x6d, 0xb5, 0xdf, 0xfb, 0x48, 0xd2,
+    0xb0, 0x60, 0xd0, 0xf5, 0xa7, 0x10, 0x96, 0xe0
+};
+
+static tracker_key_t keys[TEST_BEACONS];
+struct loop *test_loop = NULL;
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void) {
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/* Filters and distance */
+static int check_filter(void) {
+
+    struct tracker *tracker = tracker_new(4);
+    const uint8_t ns[10] = { 0 };
+    const uint8_t instance[6] = { 1 };
+    tracker_key_t key, other;
+    tracker_entry_t entry;
+    int row = 0;
+
+    tracker_key_ibeacon(&key, test_uuid, 1, 2);
+    tracker_key_eddystone(&other, ns, instance);
+
+    /* Constant signal stays put */
+    for (int i = 0; 50 > i; ++i) {
+        row = tracker_update(tracker, &key, -59, -59, i);
+    }
+
+    if (0 != row || EXIT_SUCCESS != tracker_get(tracker, row, &entry)
+        || 50 != entry.packets || 0.01f < fabsf(entry.rssi + 59.0f) || 0.01f < fabsf(entry.distance - 1.0f)) {
+        printf("Steady state broken!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Step of 20 dB is followed, not jumped to */
+    row = tracker_update(tracker, &key, -79, -59, 50);
+    tracker_get(tracker, row, &entry);
+    if (-59.5f < entry.rssi || -78.5f > entry.rssi) {
+        printf("Kalman gain out of range: %.2f!\n", entry.rssi);
+        return EXIT_FAILURE;
+    }
+
+    for (int i = 0; 500 > i; ++i) {
+        tracker_update(tracker, &key, -79, -59, 51 + i);
+    }
+    tracker_get(tracker, row, &entry);
+    if (0.5f < fabsf(entry.rssi + 79.0f) || 1.0f < fabsf(entry.distance - 10.0f)) {
+        printf("Kalman did not converge: %.2f dBm, %.2f m!\n", entry.rssi, entry.distance);
+        return EXIT_FAILURE;
+    }
+
+    /* EMA with weight one tracks samples exactly */
+    if (EXIT_SUCCESS != tracker_set_filter(tracker, TRACKER_FILTER_EMA, 1.0f, 0.0f)
+        || -EINVAL != tracker_set_filter(tracker, TRACKER_FILTER_EMA, 0.0f, 0.0f)) {
+        printf("Filter selection failed!\n");
+        return EXIT_FAILURE;
+    }
+    tracker_update(tracker, &key, -40, -59, 600);
+    tracker_get(tracker, row, &entry);
+    if (-40.0f != entry.rssi) {
+        printf("EMA failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    if (1 != tracker_update(tracker, &other, -70, -60, 600) || 0 != tracker_find(tracker, &key)) {
+        printf("Keys collide!\n");
+        return EXIT_FAILURE;
+    }
+
+    tracker_free(tracker);
+
+    printf("Filters OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Index survives evictions */
+static int check_sweep(void) {
+
+    struct tracker *tracker = tracker_new(TEST_SMALL);
+    tracker_entry_t entry;
+    int row;
+
+    for (size_t i = 0; TEST_SMALL > i; ++i) {
+        if (0 > tracker_update(tracker, &keys[i], -60, -59, i % 3)) {
+            printf("Beacon %zu not inserted!\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (-ENOSPC != tracker_update(tracker, &keys[TEST_SMALL], -60, -59, 0)) {
+        printf("Full table accepted beacon!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Beacons last seen at 0 and 1 go */
+    if (TEST_SMALL - TEST_SMALL / 3 != tracker_sweep(tracker, 2000, 1998)) {
+        printf("Unexpected eviction count!\n");
+        return EXIT_FAILURE;
+    }
+
+    for (size_t i = 0; TEST_SMALL > i; ++i) {
+
+        row = tracker_find(tracker, &keys[i]);
+
+        if (2 == i % 3) {
+            if (0 > row || EXIT_SUCCESS != tracker_get(tracker, row, &entry)
+                || 0 != memcmp(&entry.key, &keys[i], sizeof(tracker_key_t))) {
+                printf("Beacon %zu lost!\n", i);
+                return EXIT_FAILURE;
+            }
+        } else if (-ENOENT != row) {
+            printf("Beacon %zu not evicted!\n", i);
+            return EXIT_FAILURE;
+        }
+    }
+
+    tracker_free(tracker);
+
+    printf("Sweep OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Stop loop */
+static void quit_callback(
+    int                 id,
+    void               *user_data) {
+    loop_quit_in(test_loop);
+}
+
+/* Loop timer drives sweep */
+static int check_sweep_timer(void) {
+
+    struct tracker *tracker = tracker_new(16);
+    struct timespec timeout = { .tv_sec = 0, .tv_nsec = 100000000 };
+    struct timespec ts;
+    uint64_t now;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    now = (uint64_t) ts.tv_sec * 1000 + (uint64_t) ts.tv_nsec / 1000000;
+
+    tracker_update(tracker, &keys[0], -60, -59, now - 10000);
+    tracker_update(tracker, &keys[1], -60, -59, now + 10000);
+
+    test_loop = loop_new();
+    if (NULL == test_loop
+        || 0 >= tracker_start_sweep_in(test_loop, tracker, 20, 5000)
+        || 0 >= create_timer_in(test_loop, &timeout, quit_callback, NULL, NULL)) {
+        printf("Loop set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    loop_run_in(test_loop);
+    loop_free(test_loop);
+
+    if (1 != tracker_count(tracker) || 0 > tracker_find(tracker, &keys[1])) {
+        printf("Timer sweep failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    tracker_free(tracker);
+
+    printf("Timer sweep OK\n");
+
+    return EXIT_SUCCESS;
+}
+
+/* Main course */
+int
+main() {
+
+    struct tracker *tracker;
+    tracker_stats_t stats;
+    uint32_t seed = 0x2468ace0;
+    uint64_t start, elapsed;
+    size_t beacon;
+
+    printf("Checking beacon tracker ...\n");
+    printf("-------------------------------------\n");
+
+    for (size_t i = 0; TEST_BEACONS > i; ++i) {
+        tracker_key_ibeacon(&keys[i], test_uuid, (uint16_t) (i >> 16), (uint16_t) i);
+    }
+
+    if (EXIT_SUCCESS != check_filter()
+        || EXIT_SUCCESS != check_sweep()
+        || EXIT_SUCCESS != check_sweep_timer()) {
+        return EXIT_FAILURE;
+    }
+
+    tracker = tracker_new(TEST_BEACONS);
+    if (NULL == tracker) {
+        printf("Table set up failed!\n");
+        return EXIT_FAILURE;
+    }
+
+    /* Reports arrive in random beacon order */
+    start = now_ns();
+    for (size_t i = 0; TEST_UPDATES > i; ++i) {
+        seed = seed * 1103515245 + 12345;
+        beacon = seed % TEST_BEACONS;
+        tracker_update(tracker, &keys[beacon], (int8_t) (-50 - (int) (seed >> 27)), -59, i / 1000);
+    }
+    elapsed = now_ns() - start;
+
+    tracker_get_stats(tracker, &stats);
+    printf("%d beacons: %.2f M updates/s, %zu bytes per beacon\n",
+        TEST_BEACONS, TEST_UPDATES * 1e3 / (double) elapsed, tracker_footprint(tracker));
+
+    if (TEST_UPDATES != stats.updates || TEST_BEACONS < tracker_count(tracker)) {
+        printf("Unexpected counters!\n");
+        return EXIT_FAILURE;
+    }
+
+    start = now_ns();
+    tracker_sweep(tracker, TEST_UPDATES / 1000, 50);
+    elapsed = now_ns() - start;
+    printf("Sweep: %zu beacons left in %.2f ms\n", tracker_count(tracker), (double) elapsed / 1e6);
+
+    tracker_free(tracker);
+
+    printf("-------------------------------------\n");
+    printf("Done!\n");
+
+    return EXIT_SUCCESS;
+}
+
+ /* End of file */